@@ -141,6 +141,17 @@
 #define SBC_NO_PCM_CPY_OPTION FALSE
 #endif
 
+/* BK4BTSTACK_CHANGE START */
+/* Set SBC_USE_SIMD to TRUE to use SSE2 or NEON for the windowing in the analysis filter */
+#ifndef SBC_USE_SIMD
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SBC_USE_SIMD TRUE
+#else
+#define SBC_USE_SIMD FALSE
+#endif
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 #define MINIMUM_ENC_VX_BUFFER_SIZE (8*10*2)
 #ifndef ENC_VX_BUFFER_SIZE
 #define ENC_VX_BUFFER_SIZE (MINIMUM_ENC_VX_BUFFER_SIZE + 64)
@@ -196,6 +207,11 @@ typedef struct SBC_ENC_PARAMS_TAG
     UINT16 u16PacketLength;
     /* BK4BTSTACK_CHANGE START */
     UINT8  mSBCEnabled;
+
+    /* analysis filter state, per instance to allow for multiple encoders */
+    SINT32 s32X[ENC_VX_BUFFER_SIZE/2];              /* accessed as SINT16, must be 32 bit aligned */
+    SINT16 s16ShiftCounter;
+    SINT16 s16MaxShiftCounter;
     /* BK4BTSTACK_CHANGE END */
 }SBC_ENC_PARAMS;
 
@@ -153,15 +153,9 @@
 #define WIND_8_SUBBANDS_8_2 (SINT16)0x12CF  /* 40 = 0x12CF6C75 */
 #endif
 
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata = "sbc_s32_analysis_section"
-#endif
-static SINT32   s32DCTY[16]  = {0};
-static SINT32   s32X[ENC_VX_BUFFER_SIZE/2];
-static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata
-#endif
+/* BK4BTSTACK_CHANGE START */
+/* s32X, ShiftCounter and EncMaxShiftCounter moved into SBC_ENC_PARAMS, s32DCTY is a local */
+/* BK4BTSTACK_CHANGE END */
 
 /* This macro is for 4 subbands */
 #define SHIFTUP_X4                                                               \
@@ -893,8 +887,102 @@ static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  S
 #endif
 #endif
 
-static SINT16 ShiftCounter=0;
-extern SINT16 EncMaxShiftCounter;
+/* BK4BTSTACK_CHANGE START */
+#if (SBC_USE_SIMD == TRUE) && (SBC_ARM_ASM_OPT == FALSE) && (SBC_IPAQ_OPT == TRUE) && (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SBC_ANALYSIS_SIMD
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SBC_ANALYSIS_SIMD
+#endif
+#endif
+
+#ifdef SBC_ANALYSIS_SIMD
+/* Window coefficients of WINDOW_PARTIAL_4/8 as a 5 x 2M matrix, so that
+ * s32DCTY[k] = sum(j = 0..4) coeff[j][k] * s16X[ChOffset + j*2M + k]
+ * This is the same sum as computed by the macros above, the results are bit exact. */
+static const SINT16 as16WindowCoeff4[5*2*SUB_BANDS_4] =
+{
+    0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_1_4,
+    WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_3_1,
+    WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3,
+    WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_3_2,
+    WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2,
+    -WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_3_3,
+    WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1,
+    -WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_3_4,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0,
+};
+
+static const SINT16 as16WindowCoeff8[5*2*SUB_BANDS_8] =
+{
+    0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_7_0,
+    WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4,
+    WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_3_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1,
+    WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_1_3,
+    WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_3_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2,
+    WIND_8_SUBBANDS_8_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_1_2,
+    -WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_3_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3,
+    WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_1_1,
+    -WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_3_4,
+    WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4,
+    WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_1_0,
+};
+
+/* s32Stride = 2M = number of outputs */
+static void SbcAnalysisWindow(const SINT16 *ps16X, const SINT16 *ps16Coeff, SINT32 *ps32Y, SINT32 s32Stride)
+{
+    SINT32 k;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (k = 0; k < s32Stride; k += 8)
+    {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)(ps16X + k));
+        __m128i x1 = _mm_loadu_si128((const __m128i *)(ps16X + k + s32Stride));
+        __m128i x2 = _mm_loadu_si128((const __m128i *)(ps16X + k + 2 * s32Stride));
+        __m128i x3 = _mm_loadu_si128((const __m128i *)(ps16X + k + 3 * s32Stride));
+        __m128i x4 = _mm_loadu_si128((const __m128i *)(ps16X + k + 4 * s32Stride));
+        __m128i c0 = _mm_loadu_si128((const __m128i *)(ps16Coeff + k));
+        __m128i c1 = _mm_loadu_si128((const __m128i *)(ps16Coeff + k + s32Stride));
+        __m128i c2 = _mm_loadu_si128((const __m128i *)(ps16Coeff + k + 2 * s32Stride));
+        __m128i c3 = _mm_loadu_si128((const __m128i *)(ps16Coeff + k + 3 * s32Stride));
+        __m128i c4 = _mm_loadu_si128((const __m128i *)(ps16Coeff + k + 4 * s32Stride));
+        /* interleave two rows, pmaddwd then adds both products per output */
+        __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), _mm_unpacklo_epi16(c0, c1)),
+                                   _mm_madd_epi16(_mm_unpacklo_epi16(x2, x3), _mm_unpacklo_epi16(c2, c3)));
+        __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), _mm_unpackhi_epi16(c0, c1)),
+                                   _mm_madd_epi16(_mm_unpackhi_epi16(x2, x3), _mm_unpackhi_epi16(c2, c3)));
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x4, zero), _mm_unpacklo_epi16(c4, zero)));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x4, zero), _mm_unpackhi_epi16(c4, zero)));
+        _mm_storeu_si128((__m128i *)(ps32Y + k), lo);
+        _mm_storeu_si128((__m128i *)(ps32Y + k + 4), hi);
+    }
+#else
+    for (k = 0; k < s32Stride; k += 4)
+    {
+        int32x4_t acc = vmull_s16(vld1_s16(ps16X + k), vld1_s16(ps16Coeff + k));
+        acc = vmlal_s16(acc, vld1_s16(ps16X + k + s32Stride),     vld1_s16(ps16Coeff + k + s32Stride));
+        acc = vmlal_s16(acc, vld1_s16(ps16X + k + 2 * s32Stride), vld1_s16(ps16Coeff + k + 2 * s32Stride));
+        acc = vmlal_s16(acc, vld1_s16(ps16X + k + 3 * s32Stride), vld1_s16(ps16Coeff + k + 3 * s32Stride));
+        acc = vmlal_s16(acc, vld1_s16(ps16X + k + 4 * s32Stride), vld1_s16(ps16Coeff + k + 4 * s32Stride));
+        vst1q_s32(ps32Y + k, acc);
+    }
+#endif
+}
+#endif
+/* BK4BTSTACK_CHANGE END */
+
 /****************************************************************************
 * SbcAnalysisFilter - performs Analysis of the input audio stream
 *
@@ -914,7 +1002,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
-#else
+#elif !defined(SBC_ANALYSIS_SIMD)
 	register SINT32 s32Temp,s32Temp2;
 #endif
 #else
@@ -926,6 +1014,13 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 
+    /* BK4BTSTACK_CHANGE START */
+    SINT32  s32DCTY[16];
+    SINT16 *s16X = (SINT16 *) pstrEncParams->s32X;
+    SINT16  ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16  EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
+
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
 
@@ -961,7 +1056,13 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
         {
             ChOffset=(s32Ch*Offset2)+Offset;
             
+            /* BK4BTSTACK_CHANGE START */
+#ifdef SBC_ANALYSIS_SIMD
+            SbcAnalysisWindow(&s16X[ChOffset], as16WindowCoeff4, s32DCTY, 2*SUB_BANDS_4);
+#else
             WINDOW_PARTIAL_4
+#endif
+            /* BK4BTSTACK_CHANGE END */
 
             SBC_FastIDCT4(s32DCTY, ps32SbBuf);
             ps32SbBuf +=SUB_BANDS_4;
@@ -991,6 +1092,9 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    /* BK4BTSTACK_CHANGE START */
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
 }
 
 /* //////////////////////////////////////////////////////////////////////////////////////////////////////////////////// */
@@ -1009,7 +1113,7 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
-#else
+#elif !defined(SBC_ANALYSIS_SIMD)
 	register SINT32 s32Temp,s32Temp2;
 #endif
 #else
@@ -1019,6 +1123,13 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 
+    /* BK4BTSTACK_CHANGE START */
+    SINT32  s32DCTY[16];
+    SINT16 *s16X = (SINT16 *) pstrEncParams->s32X;
+    SINT16  ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16  EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
+
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
 
@@ -1064,7 +1175,13 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
         {
             ChOffset=(s32Ch*Offset2)+Offset;
 
+            /* BK4BTSTACK_CHANGE START */
+#ifdef SBC_ANALYSIS_SIMD
+            SbcAnalysisWindow(&s16X[ChOffset], as16WindowCoeff8, s32DCTY, 2*SUB_BANDS_8);
+#else
             WINDOW_PARTIAL_8
+#endif
+            /* BK4BTSTACK_CHANGE END */
 
             SBC_FastIDCT8 (s32DCTY, ps32SbBuf);
 
@@ -1095,10 +1212,15 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    /* BK4BTSTACK_CHANGE START */
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
+    /* BK4BTSTACK_CHANGE END */
 }
 
-void SbcAnalysisInit (void)
+/* BK4BTSTACK_CHANGE START */
+void SbcAnalysisInit (SBC_ENC_PARAMS *pstrEncParams)
 {
-    memset(s16X,0,ENC_VX_BUFFER_SIZE*sizeof(SINT16));
-    ShiftCounter=0;
+    memset(pstrEncParams->s32X,0,sizeof(pstrEncParams->s32X));
+    pstrEncParams->s16ShiftCounter=0;
 }
+/* BK4BTSTACK_CHANGE END */
@@ -37,6 +37,9 @@
 
 #define BTSTACK_FILE__ "hci_transport_h2_libusb.c"
 
+// enable POSIX function clock_gettime (needed for -std=c11)
+#define _POSIX_C_SOURCE 200809L
+
 /*
  *  hci_transport_usb.c
  *
@@ -66,6 +69,7 @@
 #endif
 
 #include <poll.h>
+#include <time.h>
 
 #include "btstack_config.h"
 
@@ -74,6 +78,11 @@
 #include "hci_transport.h"
 #include "hci_transport_usb.h"
 
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
 #define DEBUG
 
 // deal with changes in libusb API:
@@ -88,9 +97,21 @@
 #define HAVE_USB_VENDOR_ID_AND_PRODUCT_ID
 #endif
 
-#define ACL_IN_BUFFER_COUNT    3
-#define EVENT_IN_BUFFER_COUNT  3
-#define EVENT_OUT_BUFFER_COUNT 4
+// number of transfers kept in flight, can be increased in btstack_config.h for higher throughput
+#ifndef HCI_TRANSPORT_USB_ACL_IN_BUFFER_COUNT
+#define HCI_TRANSPORT_USB_ACL_IN_BUFFER_COUNT    3
+#endif
+#ifndef HCI_TRANSPORT_USB_EVENT_IN_BUFFER_COUNT
+#define HCI_TRANSPORT_USB_EVENT_IN_BUFFER_COUNT  3
+#endif
+// shared by HCI Commands and outgoing ACL packets
+#ifndef HCI_TRANSPORT_USB_OUT_BUFFER_COUNT
+#define HCI_TRANSPORT_USB_OUT_BUFFER_COUNT       4
+#endif
+
+#define ACL_IN_BUFFER_COUNT    HCI_TRANSPORT_USB_ACL_IN_BUFFER_COUNT
+#define EVENT_IN_BUFFER_COUNT  HCI_TRANSPORT_USB_EVENT_IN_BUFFER_COUNT
+#define EVENT_OUT_BUFFER_COUNT HCI_TRANSPORT_USB_OUT_BUFFER_COUNT
 #define SCO_IN_BUFFER_COUNT   10
 
 #define ASYNC_POLLING_INTERVAL_MS 1
@@ -233,6 +254,8 @@ typedef struct {
     struct libusb_transfer *t;
     uint8_t *data;
     bool in_flight;
+    uint32_t submitted_us;
+    uint32_t completed_us;
 } usb_transfer_list_entry_t;
 
 typedef struct {
@@ -328,13 +351,130 @@ void usb_transfer_list_free( usb_transfer_list_t *list ) {
 
 static usb_transfer_list_t *default_transfer_list = NULL;
 
+// statistics
+static hci_transport_usb_statistics_t usb_statistics;
+static uint32_t usb_out_transfers_in_flight;
+
+static uint32_t usb_time_us(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) (((uint64_t) now.tv_sec * 1000000) + ((uint64_t) now.tv_nsec / 1000));
+}
+
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+
+// completed transfers are passed from the libusb event thread to the main thread
+// via a single-producer/single-consumer ring. it can hold all transfers and cannot overflow
+static usb_transfer_list_entry_t ** usb_completed_ring;
+static uint32_t     usb_completed_ring_mask;
+static atomic_uint  usb_completed_ring_head;    // written by event thread
+static atomic_uint  usb_completed_ring_tail;    // written by main thread
+
+static pthread_t    usb_event_thread;
+static bool         usb_event_thread_running;
+static int          usb_event_thread_stop;
+static bool         usb_event_thread_notify;
+
+// transfer problems seen by event thread, counted and logged by main thread
+static atomic_uint  usb_event_thread_stalls;
+static atomic_uint  usb_event_thread_errors;
+static atomic_uint  usb_event_thread_resubmit_errors;
+
+static void usb_completed_ring_push(usb_transfer_list_entry_t * entry){
+    unsigned int head = atomic_load_explicit(&usb_completed_ring_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&usb_completed_ring_tail, memory_order_acquire);
+    btstack_assert((head - tail) <= usb_completed_ring_mask);
+    UNUSED(tail);
+    usb_completed_ring[head & usb_completed_ring_mask] = entry;
+    atomic_store_explicit(&usb_completed_ring_head, head + 1, memory_order_release);
+}
+
+static usb_transfer_list_entry_t * usb_completed_ring_pop(void){
+    unsigned int tail = atomic_load_explicit(&usb_completed_ring_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&usb_completed_ring_head, memory_order_acquire);
+    if (head == tail) return NULL;
+    usb_transfer_list_entry_t * entry = usb_completed_ring[tail & usb_completed_ring_mask];
+    atomic_store_explicit(&usb_completed_ring_tail, tail + 1, memory_order_release);
+    return entry;
+}
+
+static uint32_t usb_completed_ring_pending(void){
+    unsigned int tail = atomic_load_explicit(&usb_completed_ring_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&usb_completed_ring_head, memory_order_acquire);
+    return head - tail;
+}
+
+// called by main thread
+static void usb_event_thread_merge_statistics(void){
+    unsigned int stalls = atomic_exchange_explicit(&usb_event_thread_stalls, 0, memory_order_relaxed);
+    unsigned int errors = atomic_exchange_explicit(&usb_event_thread_errors, 0, memory_order_relaxed);
+    unsigned int resubmit_errors = atomic_exchange_explicit(&usb_event_thread_resubmit_errors, 0, memory_order_relaxed);
+    if (stalls > 0){
+        log_info("-> %u transfer(s) stalled, halt cleared", stalls);
+        usb_statistics.stalls += stalls;
+    }
+    if (errors > 0){
+        log_info("-> %u transfer(s) without data resubmitted", errors);
+        usb_statistics.errors += errors;
+    }
+    if (resubmit_errors > 0){
+        log_error("Error clearing halt or re-submitting transfer, %u time(s)", resubmit_errors);
+    }
+}
+
+#else
+
 // For (ab)use as a linked list of received packets
 static list_head_t handle_packet_list = LIST_HEAD_INIT(handle_packet_list);
+static uint32_t handle_packet_list_len;
+
+#endif
+
+// transfer problems in async_callback, which runs on the libusb event thread with ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+static void usb_async_callback_stalled(void){
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    atomic_fetch_add_explicit(&usb_event_thread_stalls, 1, memory_order_relaxed);
+#else
+    log_info("-> Transfer stalled, trying again");
+    usb_statistics.stalls++;
+#endif
+}
+
+static void usb_async_callback_error(struct libusb_transfer *transfer){
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    UNUSED(transfer);
+    atomic_fetch_add_explicit(&usb_event_thread_errors, 1, memory_order_relaxed);
+#else
+    log_info("async_callback. not data -> resubmit transfer, endpoint %x, status %x, length %u", transfer->endpoint, transfer->status, transfer->actual_length);
+    usb_statistics.errors++;
+#endif
+}
+
+static void usb_async_callback_resubmit_error(const char * operation, int r){
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    UNUSED(operation);
+    UNUSED(r);
+    atomic_fetch_add_explicit(&usb_event_thread_resubmit_errors, 1, memory_order_relaxed);
+#else
+    log_error("Error %s %d", operation, r);
+#endif
+}
 
 static void enqueue_transfer(struct libusb_transfer *transfer) {
     usb_transfer_list_entry_t *current = (usb_transfer_list_entry_t*)transfer->user_data;
     btstack_assert( current != NULL );
+    current->completed_us = usb_time_us();
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    usb_completed_ring_push( current );
+    // main thread gets notified once libusb_handle_events returns
+    usb_event_thread_notify = true;
+#else
     list_add_tail( &current->list, &handle_packet_list );
+    handle_packet_list_len++;
+    if (handle_packet_list_len > usb_statistics.completed_queue_max){
+        usb_statistics.completed_queue_max = handle_packet_list_len;
+    }
+#endif
 }
 
 static void signal_acknowledge(void);
@@ -425,6 +565,17 @@ void hci_transport_usb_set_path(int len, uint8_t * port_numbers){
     memcpy(usb_path, port_numbers, len);
 }
 
+static void usb_transfer_release_to_pool(struct libusb_transfer *transfer) {
+#ifdef ENABLE_SCO_OVER_HCI
+    if(( transfer->endpoint == sco_in_addr) || (transfer->endpoint == sco_out_addr)) {
+        usb_transfer_list_release( sco_transfer_list, transfer );
+    } else
+#endif
+    {
+        usb_transfer_list_release( default_transfer_list, transfer );
+    }
+}
+
 LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer) {
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) {
         log_info("shutdown, transfer %p", transfer);
@@ -438,30 +589,28 @@ LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer) {
     if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
         enqueue_transfer(transfer);
     } else if (transfer->status == LIBUSB_TRANSFER_STALL){
-        log_info("-> Transfer stalled, trying again");
+        usb_async_callback_stalled();
         r = libusb_clear_halt(handle, transfer->endpoint);
         if (r) {
-            log_error("Error rclearing halt %d", r);
+            usb_async_callback_resubmit_error("clearing halt", r);
         }
         r = libusb_submit_transfer(transfer);
         if (r) {
-            log_error("Error re-submitting transfer %d", r);
+            usb_async_callback_resubmit_error("re-submitting transfer", r);
         }
     } else if ( transfer->status == LIBUSB_TRANSFER_CANCELLED ) {
-#ifdef ENABLE_SCO_OVER_HCI
-        if(( transfer->endpoint == sco_in_addr) || (transfer->endpoint == sco_out_addr)) {
-            usb_transfer_list_release( sco_transfer_list, transfer );
-        } else
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+        // transfer pools are owned by main thread
+        enqueue_transfer(transfer);
+#else
+        usb_transfer_release_to_pool(transfer);
 #endif
-        {
-            usb_transfer_list_release( default_transfer_list, transfer );
-        }
     } else {
-        log_info("async_callback. not data -> resubmit transfer, endpoint %x, status %x, length %u", transfer->endpoint, transfer->status, transfer->actual_length);
+        usb_async_callback_error(transfer);
         // No usable data, just resubmit packet
         r = libusb_submit_transfer(transfer);
         if (r) {
-            log_error("Error re-submitting transfer %d", r);
+            usb_async_callback_resubmit_error("re-submitting transfer", r);
         }
     }
     // log_info("end async_callback");
@@ -548,23 +697,66 @@ static void handle_isochronous_data(uint8_t * buffer, uint16_t size){
 }
 #endif
 
+static void usb_statistics_track_in(struct libusb_transfer *transfer){
+    usb_transfer_list_entry_t *current = (usb_transfer_list_entry_t*)transfer->user_data;
+    uint32_t latency_us = usb_time_us() - current->completed_us;
+    usb_statistics.in_dispatch_latency_us_total += latency_us;
+    if (latency_us > usb_statistics.in_dispatch_latency_us_max){
+        usb_statistics.in_dispatch_latency_us_max = latency_us;
+    }
+}
+
+static void usb_statistics_track_out(struct libusb_transfer *transfer){
+    usb_transfer_list_entry_t *current = (usb_transfer_list_entry_t*)transfer->user_data;
+    uint32_t latency_us = current->completed_us - current->submitted_us;
+    usb_statistics.out_latency_us_total += latency_us;
+    if (latency_us > usb_statistics.out_latency_us_max){
+        usb_statistics.out_latency_us_max = latency_us;
+    }
+    usb_out_transfers_in_flight--;
+}
+
+static void usb_statistics_track_submit(struct libusb_transfer *transfer){
+    usb_transfer_list_entry_t *current = (usb_transfer_list_entry_t*)transfer->user_data;
+    current->submitted_us = usb_time_us();
+    usb_out_transfers_in_flight++;
+    if (usb_out_transfers_in_flight > usb_statistics.out_in_flight_max){
+        usb_statistics.out_in_flight_max = usb_out_transfers_in_flight;
+    }
+}
+
 static void handle_completed_transfer(struct libusb_transfer *transfer){
 
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    if (transfer->status == LIBUSB_TRANSFER_CANCELLED){
+        usb_transfer_release_to_pool(transfer);
+        return;
+    }
+#endif
+
     int resubmit = 0;
     if (transfer->endpoint == event_in_addr) {
+        usb_statistics.event_in_packets++;
+        usb_statistics_track_in(transfer);
         packet_handler(HCI_EVENT_PACKET, transfer->buffer, transfer->actual_length);
         resubmit = 1;
     } else if (transfer->endpoint == acl_in_addr) {
         // log_info("-> acl");
+        usb_statistics.acl_in_packets++;
+        usb_statistics_track_in(transfer);
         packet_handler(HCI_ACL_DATA_PACKET, transfer->buffer, transfer->actual_length);
         resubmit = 1;
     } else if (transfer->endpoint == 0){
         // log_info("command done, size %u", transfer->actual_length);
 //        printf("%s cmd release\n", __FUNCTION__ );
+        usb_statistics.command_out_packets++;
+        usb_statistics_track_out(transfer);
         usb_transfer_list_release( default_transfer_list, transfer );
     } else if (transfer->endpoint == acl_out_addr){
         // log_info("acl out done, size %u", transfer->actual_length);
 //        printf("%s acl release\n", __FUNCTION__ );
+        usb_statistics.acl_out_packets++;
+        usb_statistics_track_out(transfer);
         usb_transfer_list_release( default_transfer_list, transfer );
 #ifdef ENABLE_SCO_OVER_HCI
     } else if (transfer->endpoint == sco_in_addr) {
@@ -632,6 +824,98 @@ void usb_handle_pending_events(void) {
     libusb_handle_events_timeout_completed(NULL, &tv, NULL);
 }
 
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+
+static void * usb_event_thread_main(void * context){
+    UNUSED(context);
+    while (usb_event_thread_stop == 0){
+        struct timeval tv = { 0, 100000 };
+        libusb_handle_events_timeout_completed(NULL, &tv, &usb_event_thread_stop);
+        // wake up main thread once for all transfers completed in this round
+        if (usb_event_thread_notify){
+            usb_event_thread_notify = false;
+            btstack_run_loop_poll_data_sources_from_irq();
+        }
+    }
+    return NULL;
+}
+
+static int usb_event_thread_start(void){
+    // ring size: next power of two that can hold all transfers
+    uint32_t num_transfers = default_transfer_list->nbr;
+#ifdef ENABLE_SCO_OVER_HCI
+    num_transfers += sco_transfer_list->nbr;
+#endif
+    uint32_t ring_size = 1;
+    while (ring_size < num_transfers){
+        ring_size <<= 1;
+    }
+    usb_completed_ring = (usb_transfer_list_entry_t **) malloc(ring_size * sizeof(usb_transfer_list_entry_t *));
+    if (usb_completed_ring == NULL){
+        log_error("Cannot allocate completed transfer ring");
+        return -1;
+    }
+    usb_completed_ring_mask = ring_size - 1;
+    atomic_store(&usb_completed_ring_head, 0);
+    atomic_store(&usb_completed_ring_tail, 0);
+    atomic_store(&usb_event_thread_stalls, 0);
+    atomic_store(&usb_event_thread_errors, 0);
+    atomic_store(&usb_event_thread_resubmit_errors, 0);
+
+    usb_event_thread_stop = 0;
+    usb_event_thread_notify = false;
+    int r = pthread_create(&usb_event_thread, NULL, &usb_event_thread_main, NULL);
+    if (r != 0){
+        log_error("Cannot create libusb event thread %d", r);
+        free(usb_completed_ring);
+        usb_completed_ring = NULL;
+        return -1;
+    }
+    usb_event_thread_running = true;
+    log_info("Async using event thread, ring size %u", ring_size);
+    return 0;
+}
+
+static void usb_event_thread_join(void){
+    if (usb_event_thread_running == false) return;
+    usb_event_thread_stop = 1;
+#if LIBUSB_API_VERSION >= 0x01000105
+    libusb_interrupt_event_handler(NULL);
+#endif
+    pthread_join(usb_event_thread, NULL);
+    usb_event_thread_running = false;
+
+    // return completed transfers to their pools without processing
+    while (true){
+        usb_transfer_list_entry_t * current = usb_completed_ring_pop();
+        if (current == NULL) break;
+        usb_transfer_release_to_pool(current->t);
+    }
+    free(usb_completed_ring);
+    usb_completed_ring = NULL;
+}
+
+static void usb_process_completed_transfers(void){
+    usb_event_thread_merge_statistics();
+    uint32_t pending = usb_completed_ring_pending();
+    if (pending > usb_statistics.completed_queue_max){
+        usb_statistics.completed_queue_max = pending;
+    }
+    // Handle transfers in the order that they were completed
+    while (true){
+        usb_transfer_list_entry_t * current = usb_completed_ring_pop();
+        if (current == NULL) break;
+
+        // buffer is passed to packet handler in place
+        handle_completed_transfer(current->t);
+
+        // handle case where libusb_close might be called by hci packet handler
+        if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+    }
+}
+
+#else
+
 static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
 
     UNUSED(ds);
@@ -649,6 +933,7 @@ static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callba
 
         // pop next transfer
         usb_transfer_list_entry_t *current = (usb_transfer_list_entry_t*)list_pop_front( &handle_packet_list );
+        handle_packet_list_len--;
 
         // handle transfer
         handle_completed_transfer(current->t);
@@ -684,6 +969,8 @@ static void usb_process_ts(btstack_timer_source_t *timer) {
     return;
 }
 
+#endif
+
 
 static int scan_for_bt_endpoints(libusb_device *dev) {
     int r;
@@ -1211,6 +1498,13 @@ static int usb_open(void){
 
      }
 
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    r = usb_event_thread_start();
+    if (r < 0){
+        usb_close();
+        return r;
+    }
+#else
     // Check for pollfds functionality
     doing_pollfds = libusb_pollfds_handle_timeouts(NULL);
 
@@ -1248,6 +1542,7 @@ static int usb_open(void){
         btstack_run_loop_add_timer(&usb_timer);
         usb_timer_active = 1;
     }
+#endif
 
     usb_transport_open = 1;
 
@@ -1270,6 +1565,10 @@ static int usb_close(void) {
             break;
 
         case LIB_USB_TRANSFERS_ALLOCATED:
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+            // stop event thread before changing state, transfers are handled by this thread afterwards
+            usb_event_thread_join();
+#endif
             libusb_state = LIB_USB_INTERFACE_CLAIMED;
 
             if(usb_timer_active) {
@@ -1364,6 +1663,11 @@ static void usb_transport_response_ds(btstack_data_source_t *ds, btstack_data_so
     UNUSED(ds);
     UNUSED(callback_type);
 //    printf("%s packet sent: %d sco can send now: %d\n", __FUNCTION__, acknowledge_count, sco_can_send_now_count);
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    if (libusb_state == LIB_USB_TRANSFERS_ALLOCATED){
+        usb_process_completed_transfers();
+    }
+#endif
     for(; acknowledge_count>0; --acknowledge_count) {
         static const uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0 };
         packet_handler(HCI_EVENT_PACKET, (uint8_t*)&event[0], sizeof(event));
@@ -1392,12 +1696,14 @@ static int usb_send_cmd_packet(uint8_t *packet, int size){
 
     // prepare transfer
     libusb_fill_control_transfer(transfer, handle, data, async_callback, user_data, 0);
+    usb_statistics_track_submit(transfer);
 
     // submit transfer
     r = libusb_submit_transfer(transfer);
 
     if (r < 0) {
         log_error("Error submitting cmd transfer %d", r);
+        usb_out_transfers_in_flight--;
         return -1;
     }
 
@@ -1420,11 +1726,13 @@ static int usb_send_acl_packet(uint8_t *packet, int size){
     memcpy( data, packet, size );
     libusb_fill_bulk_transfer(transfer, handle, acl_out_addr, data, size,
         async_callback, transfer->user_data, 0);
+    usb_statistics_track_submit(transfer);
 
     r = libusb_submit_transfer(transfer);
 
     if (r < 0) {
         log_error("Error submitting acl transfer, %d", r);
+        usb_out_transfers_in_flight--;
         return -1;
     }
 
@@ -1439,6 +1747,7 @@ static int usb_can_send_packet_now(uint8_t packet_type){
             int ret = !usb_transfer_list_empty( default_transfer_list );
             if( !ret ) {
                 log_error("command transfers shouldn't be empty!");
+                usb_statistics.out_buffers_exhausted++;
             }
             return ret;
         }
@@ -1446,6 +1755,7 @@ static int usb_can_send_packet_now(uint8_t packet_type){
             int ret = !usb_transfer_list_empty( default_transfer_list );
             if( !ret ) {
                 log_error("acl transfers shouldn't be empty!");
+                usb_statistics.out_buffers_exhausted++;
             }
             return ret;
         }
@@ -1511,6 +1821,20 @@ static void dummy_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
     UNUSED(size);
 }
 
+void hci_transport_usb_get_statistics(hci_transport_usb_statistics_t * statistics){
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    usb_event_thread_merge_statistics();
+#endif
+    *statistics = usb_statistics;
+}
+
+void hci_transport_usb_reset_statistics(void){
+#ifdef ENABLE_HCI_TRANSPORT_USB_EVENT_THREAD
+    usb_event_thread_merge_statistics();
+#endif
+    memset(&usb_statistics, 0, sizeof(usb_statistics));
+}
+
 // get usb singleton
 const hci_transport_t * hci_transport_usb_instance(void) {
     if (!hci_transport_usb) {
@@ -86,6 +86,26 @@
 
 #define LWIP_TIMER_INTERVAL_MS 25
 
+#define BNEP_LWIP_MTU 1600
+
+// max number of pbufs in outgoing chain that are passed to bnep_send_fragments, longer chains get flattened
+#ifndef BNEP_LWIP_MAX_FRAGMENTS
+#define BNEP_LWIP_MAX_FRAGMENTS 8
+#endif
+
+// Incoming frames are passed to lwIP as PBUF_REF custom pbufs pointing into the HCI buffer.
+// This requires synchronous processing of input (NO_SYS) and no TCP out-of-sequence queue, which keeps pointers
+// into the payload. If lwIP still holds a reference to the pbuf after input, e.g. for a partially received
+// HTTP request, the frame is moved into a spare buffer before the HCI buffer gets reused.
+#if NO_SYS && LWIP_SUPPORT_CUSTOM_PBUF && (TCP_QUEUE_OOSEQ == 0)
+#define BNEP_LWIP_ZERO_COPY_RX
+#ifndef BNEP_LWIP_RX_PBUF_NUM
+#define BNEP_LWIP_RX_PBUF_NUM 4
+#endif
+// ethernet header + VLAN tag
+#define BNEP_LWIP_RX_SPARE_SIZE (BNEP_LWIP_MTU + 18)
+#endif
+
 static void bnep_lwip_outgoing_process(void * arg);
 static bool bnep_lwip_outgoing_packets_empty(void);
 
@@ -115,6 +135,22 @@ static struct pbuf * bnep_lwip_outgoing_next_packet;
 // temp buffer to unchain buffer
 static uint8_t btstack_network_outgoing_buffer[HCI_ACL_PAYLOAD_SIZE];
 
+#ifdef BNEP_LWIP_ZERO_COPY_RX
+typedef struct {
+    // assert: first field
+    struct pbuf_custom pbuf_custom;
+    // HCI buffer during input
+    const uint8_t *    frame;
+    // pbuf holding the frame after it was moved out of the HCI buffer
+    struct pbuf *      storage;
+} bnep_lwip_rx_pbuf_t;
+
+LWIP_MEMPOOL_DECLARE(BNEP_LWIP_RX_PBUF, BNEP_LWIP_RX_PBUF_NUM, sizeof(bnep_lwip_rx_pbuf_t), "BNEP RX PBUF")
+
+// storage for a frame that is still referenced after input, allocated in bnep_lwip_init and again after use
+static struct pbuf * bnep_lwip_rx_spare;
+#endif
+
 // helper functions to hide NO_SYS vs. FreeRTOS implementations
 
 static int bnep_lwip_outgoing_init_queue(void){
@@ -257,7 +293,7 @@ static err_t bnep_lwip_netif_init(struct netif *netif){
     netif->name[1] = IFNAME1;
 
     // mtu
-    netif->mtu = 1600;
+    netif->mtu = BNEP_LWIP_MTU;
 
     /* device capabilities */
     netif->flags |= NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
@@ -312,7 +348,7 @@ static int bnep_lwip_netif_down(void){
  * @param packet
  * @param size
  */
-static void bnep_lwip_netif_process_packet(const uint8_t * packet, uint16_t size){
+static void bnep_lwip_netif_process_packet_copy(const uint8_t * packet, uint16_t size){
 
     /* We allocate a pbuf chain of pbufs from the pool. */
     struct pbuf * p = pbuf_alloc(PBUF_RAW, size, PBUF_POOL);
@@ -344,6 +380,66 @@ static void bnep_lwip_netif_process_packet(const uint8_t * packet, uint16_t size
     }
 }
 
+#ifdef BNEP_LWIP_ZERO_COPY_RX
+static void bnep_lwip_rx_pbuf_free(struct pbuf * p){
+    bnep_lwip_rx_pbuf_t * rx_pbuf = (bnep_lwip_rx_pbuf_t *) p;
+    if (rx_pbuf->storage != NULL){
+        pbuf_free(rx_pbuf->storage);
+    }
+    LWIP_MEMPOOL_FREE(BNEP_LWIP_RX_PBUF, rx_pbuf);
+}
+
+static bool bnep_lwip_netif_process_packet_ref(uint8_t * packet, uint16_t size){
+
+    // spare storage required in case lwIP keeps the frame, replace if used by previous frame
+    if (bnep_lwip_rx_spare == NULL){
+        bnep_lwip_rx_spare = pbuf_alloc(PBUF_RAW, BNEP_LWIP_RX_SPARE_SIZE, PBUF_RAM);
+        if (bnep_lwip_rx_spare == NULL) return false;
+    }
+    if (size > bnep_lwip_rx_spare->len) return false;
+
+    bnep_lwip_rx_pbuf_t * rx_pbuf = (bnep_lwip_rx_pbuf_t *) LWIP_MEMPOOL_ALLOC(BNEP_LWIP_RX_PBUF);
+    if (rx_pbuf == NULL) return false;
+
+    rx_pbuf->pbuf_custom.custom_free_function = &bnep_lwip_rx_pbuf_free;
+    rx_pbuf->frame   = packet;
+    rx_pbuf->storage = NULL;
+    struct pbuf * p = pbuf_alloced_custom(PBUF_RAW, size, PBUF_REF, &rx_pbuf->pbuf_custom, packet, size);
+    log_debug("bnep_lwip_netif_process_packet, pbuf_alloced_custom = %p", p);
+
+    // keep own reference to detect if lwIP still uses the pbuf after input
+    pbuf_ref(p);
+
+    /* pass all packets to ethernet_input, which decides what packets it supports */
+    int res = btstack_netif.input(p, &btstack_netif);
+    if (res != ERR_OK){
+        log_error("bnep_lwip_netif_process_packet: IP input error\n");
+        pbuf_free(p);
+    }
+
+    // still in use: move frame into spare storage, keeping the current payload offset
+    if (p->ref > 1){
+        uint16_t offset = (uint16_t) ((uint8_t *) p->payload - packet);
+        memcpy(bnep_lwip_rx_spare->payload, packet, size);
+        p->payload = (uint8_t *) bnep_lwip_rx_spare->payload + offset;
+        rx_pbuf->frame   = NULL;
+        rx_pbuf->storage = bnep_lwip_rx_spare;
+        bnep_lwip_rx_spare = NULL;
+    }
+
+    // release own reference
+    pbuf_free(p);
+    return true;
+}
+#endif
+
+static void bnep_lwip_netif_process_packet(uint8_t * packet, uint16_t size){
+#ifdef BNEP_LWIP_ZERO_COPY_RX
+    if (bnep_lwip_netif_process_packet_ref(packet, size)) return;
+#endif
+    bnep_lwip_netif_process_packet_copy(packet, size);
+}
+
 
 // BNEP Functions & Handler
 
@@ -380,7 +476,21 @@ static void bnep_lwip_send_packet(void){
         return;
     }
 
-    // flatten into our buffer
+    // pass pbuf chain as fragments
+    bnep_fragment_t fragments[BNEP_LWIP_MAX_FRAGMENTS];
+    uint16_t num_fragments = 0;
+    struct pbuf * q;
+    for (q = bnep_lwip_outgoing_next_packet; (q != NULL) && (num_fragments < BNEP_LWIP_MAX_FRAGMENTS); q = q->next){
+        fragments[num_fragments].data = (const uint8_t *) q->payload;
+        fragments[num_fragments].len  = q->len;
+        num_fragments++;
+    }
+    if (q == NULL){
+        bnep_send_fragments(bnep_cid, fragments, num_fragments);
+        return;
+    }
+
+    // flatten long chains into our buffer
     uint32_t len = btstack_min(sizeof(btstack_network_outgoing_buffer), bnep_lwip_outgoing_next_packet->tot_len);
     pbuf_copy_partial(bnep_lwip_outgoing_next_packet, btstack_network_outgoing_buffer, len, 0);
     bnep_send(bnep_cid, (uint8_t*) btstack_network_outgoing_buffer, len);
@@ -497,6 +607,13 @@ void bnep_lwip_init(void){
     int error = bnep_lwip_outgoing_init_queue();
     if (error) return;
 
+#ifdef BNEP_LWIP_ZERO_COPY_RX
+    LWIP_MEMPOOL_INIT(BNEP_LWIP_RX_PBUF);
+    if (bnep_lwip_rx_spare == NULL){
+        bnep_lwip_rx_spare = pbuf_alloc(PBUF_RAW, BNEP_LWIP_RX_SPARE_SIZE, PBUF_RAM);
+    }
+#endif
+
     ip4_addr_t fsl_netif0_ipaddr, fsl_netif0_netmask, fsl_netif0_gw;
 #if 0
     // when using DHCP Client, no address
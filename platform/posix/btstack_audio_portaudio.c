@@ -42,6 +42,8 @@
 #include <string.h>
 #include "btstack_debug.h"
 #include "btstack_audio.h"
+#include "btstack_bool.h"
+#include "btstack_ring_buffer_spsc.h"
 #include "btstack_run_loop.h"
 
 #ifdef HAVE_PORTAUDIO
@@ -78,18 +80,15 @@ static PaStream * stream_sink;
 static void (*playback_callback)(int16_t * buffer, uint16_t num_samples);
 static void (*recording_callback)(const int16_t * buffer, uint16_t num_samples);
 
-// output buffer
-static int16_t               output_buffer_storage[NUM_OUTPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * output_buffers[NUM_OUTPUT_BUFFERS];
-static int                   output_buffer_to_play;
-static int                   output_buffer_to_fill;
+// output buffers, filled by run loop, played by portaudio callback
+static int16_t                    output_buffer_storage[NUM_OUTPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
+static btstack_ring_buffer_spsc_t output_ring_buffer;
+static uint32_t                   output_buffer_size;
 
-// input buffer
-static int16_t               input_buffer_a[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               input_buffer_b[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * input_buffers[NUM_INPUT_BUFFERS] = { input_buffer_a, input_buffer_b};
-static int                   input_buffer_to_record;
-static int                   input_buffer_to_fill;
+// input buffers, filled by portaudio callback, processed by run loop
+static int16_t                    input_buffer_storage[NUM_INPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
+static btstack_ring_buffer_spsc_t input_ring_buffer;
+static uint32_t                   input_buffer_size;
 
 
 // timer to fill output ring buffer
@@ -113,10 +112,17 @@ static int portaudio_callback_sink( const void *                     inputBuffer
 
     // simplified volume control
     uint16_t index;
-    int16_t * from_buffer = output_buffers[output_buffer_to_play];
     int16_t * to_buffer = (int16_t *) outputBuffer;
     btstack_assert(frames_per_buffer == NUM_FRAMES_PER_PA_BUFFER);
 
+    // buffers are added and removed as a whole, play silence on underrun
+    uint32_t region_length;
+    const int16_t * from_buffer = (const int16_t *) btstack_ring_buffer_spsc_read_reserve(&output_ring_buffer, &region_length);
+    if (region_length < output_buffer_size){
+        memset(to_buffer, 0, output_buffer_size);
+        return 0;
+    }
+
 #if 0
     // up to 8 right shifts
     int right_shift = 8 - btstack_min(8, ((sink_volume + 15) / 16));
@@ -133,7 +139,7 @@ static int portaudio_callback_sink( const void *                     inputBuffer
 #endif
 
     // next
-    output_buffer_to_play = (output_buffer_to_play + 1 ) % NUM_OUTPUT_BUFFERS;
+    btstack_ring_buffer_spsc_read_commit(&output_ring_buffer, output_buffer_size);
 
     return 0;
 }
@@ -153,23 +159,31 @@ static int portaudio_callback_source( const void *                     inputBuff
     (void) samples_per_buffer;
     (void) outputBuffer;
 
-    // store in one of our buffers
-    memcpy(input_buffers[input_buffer_to_fill], inputBuffer, NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source);
+    // store in one of our buffers, drop on overrun
+    uint32_t region_length;
+    uint8_t * buffer = btstack_ring_buffer_spsc_write_reserve(&input_ring_buffer, &region_length);
+    if (region_length < input_buffer_size){
+        return 0;
+    }
+    memcpy(buffer, inputBuffer, input_buffer_size);
 
     // next
-    input_buffer_to_fill = (input_buffer_to_fill + 1 ) % NUM_INPUT_BUFFERS;
+    btstack_ring_buffer_spsc_write_commit(&input_ring_buffer, input_buffer_size);
 
     return 0;
 }
 
 static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 
-    // playback buffer ready to fill
-    while (output_buffer_to_play != output_buffer_to_fill){
-        (*playback_callback)(output_buffers[output_buffer_to_fill], NUM_FRAMES_PER_PA_BUFFER);
+    // playback buffer ready to fill, keep one buffer free as before
+    while (btstack_ring_buffer_spsc_bytes_free(&output_ring_buffer) > output_buffer_size){
+        uint32_t region_length;
+        int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_write_reserve(&output_ring_buffer, &region_length);
+        btstack_assert(region_length >= output_buffer_size);
+        (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
 
         // next
-        output_buffer_to_fill = (output_buffer_to_fill + 1 ) % NUM_OUTPUT_BUFFERS;
+        btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, output_buffer_size);
     }
 
     // re-set timer
@@ -179,14 +193,17 @@ static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 
 static void driver_timer_handler_source(btstack_timer_source_t * ts){
 
-    // recording buffer ready to process
-    if (input_buffer_to_record != input_buffer_to_fill){
+    // recording buffers ready to process
+    while (true){
+        uint32_t region_length;
+        const int16_t * buffer = (const int16_t *) btstack_ring_buffer_spsc_read_reserve(&input_ring_buffer, &region_length);
+        if (region_length < input_buffer_size) break;
 
-        (*recording_callback)(input_buffers[input_buffer_to_record], NUM_FRAMES_PER_PA_BUFFER);
+        (*recording_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
 
         // next
-        input_buffer_to_record = (input_buffer_to_record + 1 ) % NUM_INPUT_BUFFERS;
-    }    
+        btstack_ring_buffer_spsc_read_commit(&input_ring_buffer, input_buffer_size);
+    }
 
     // re-set timer
     btstack_run_loop_set_timer(ts, DRIVER_POLL_INTERVAL_MS);
@@ -203,10 +220,9 @@ static int btstack_audio_portaudio_sink_init(
     num_channels_sink = channels;
     num_bytes_per_sample_sink = 2 * channels;
 
-    uint8_t i;
-    for (i=0;i<NUM_OUTPUT_BUFFERS;i++){
-        output_buffers[i] = &output_buffer_storage[i * NUM_FRAMES_PER_PA_BUFFER * 2];
-    }
+    // storage holds exactly NUM_OUTPUT_BUFFERS buffers, so reserved regions are never split
+    output_buffer_size = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    btstack_ring_buffer_spsc_init(&output_ring_buffer, (uint8_t *) output_buffer_storage, NUM_OUTPUT_BUFFERS * output_buffer_size);
 
     if (!playback){
         log_error("No playback callback");
@@ -275,6 +291,10 @@ static int btstack_audio_portaudio_source_init(
     num_channels_source = channels;
     num_bytes_per_sample_source = 2 * channels;
 
+    // storage holds exactly NUM_INPUT_BUFFERS buffers, so reserved regions are never split
+    input_buffer_size = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source;
+    btstack_ring_buffer_spsc_init(&input_ring_buffer, (uint8_t *) input_buffer_storage, NUM_INPUT_BUFFERS * input_buffer_size);
+
     if (!recording){
         log_error("No recording callback");
         return 1;
@@ -354,12 +374,14 @@ static void btstack_audio_portaudio_sink_start_stream(void){
     if (!playback_callback) return;
 
     // fill buffers once
+    btstack_ring_buffer_spsc_reset(&output_ring_buffer);
     uint8_t i;
     for (i=0;i<NUM_OUTPUT_BUFFERS-1;i++){
-        (*playback_callback)(&output_buffer_storage[i*NUM_FRAMES_PER_PA_BUFFER*2], NUM_FRAMES_PER_PA_BUFFER);
+        uint32_t region_length;
+        int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_write_reserve(&output_ring_buffer, &region_length);
+        (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
+        btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, output_buffer_size);
     }
-    output_buffer_to_play = 0;
-    output_buffer_to_fill = NUM_OUTPUT_BUFFERS-1;
 
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_sink);
@@ -380,6 +402,8 @@ static void btstack_audio_portaudio_source_start_stream(void){
 
     if (!recording_callback) return;
 
+    btstack_ring_buffer_spsc_reset(&input_ring_buffer);
+
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_source);
     if (err != paNoError){
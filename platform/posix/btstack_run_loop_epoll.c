@@ -0,0 +1,544 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_run_loop_epoll.c"
+
+/*
+ *  btstack_run_loop_epoll.c
+ *
+ *  Linux run loop with persistent epoll registration, timers in a binary heap and timerfd wakeups
+ */
+
+// enable Linux functions (needed for -std=c99)
+#define _GNU_SOURCE
+
+#include "btstack_run_loop_epoll.h"
+
+#ifdef __linux__
+
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS 16
+#define BTSTACK_RUN_LOOP_EPOLL_INITIAL_TIMER_CAPACITY 16
+
+// set in data source flags while data source is in run loop, not a callback type
+#define BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED (1u << 15)
+
+// timer heap entry, sequence number keeps timers with same timeout in FIFO order
+typedef struct {
+    btstack_timer_source_t * timer;
+    uint32_t sequence;
+} btstack_run_loop_epoll_timer_entry_t;
+
+// the run loop
+static int  btstack_run_loop_epoll_fd = -1;
+static bool btstack_run_loop_epoll_data_sources_modified;
+static bool btstack_run_loop_epoll_exit_requested;
+
+// timers, stored as binary min-heap. The heap index of an active timer is stored in its (otherwise unused) item.next
+static btstack_run_loop_epoll_timer_entry_t * btstack_run_loop_epoll_timers;
+static uint32_t btstack_run_loop_epoll_timers_count;
+static uint32_t btstack_run_loop_epoll_timers_capacity;
+static uint32_t btstack_run_loop_epoll_timers_sequence;
+
+// timerfd armed for earliest timeout
+static btstack_data_source_t btstack_run_loop_epoll_timer_ds;
+static bool                  btstack_run_loop_epoll_timer_armed;
+static uint32_t              btstack_run_loop_epoll_timer_armed_timeout;
+
+// to trigger process callbacks other thread
+static pthread_mutex_t       btstack_run_loop_epoll_callbacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static btstack_data_source_t btstack_run_loop_epoll_process_callbacks_ds;
+
+// to trigger poll data sources from irq
+static btstack_data_source_t btstack_run_loop_epoll_poll_data_sources_ds;
+
+// start time. tv_nsec = 0
+static struct timespec init_ts;
+
+/**
+ * @brief Queries the current time in ms since start without overflow
+ */
+static uint64_t btstack_run_loop_epoll_get_time_ms_64(void){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    return (((uint64_t) (now_ts.tv_sec - init_ts.tv_sec)) * 1000u) + (((uint64_t) now_ts.tv_nsec) / 1000000u);
+}
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_epoll_get_time_ms(void){
+    return (uint32_t) btstack_run_loop_epoll_get_time_ms_64();
+}
+
+// data sources
+
+static uint32_t btstack_run_loop_epoll_events_for_flags(uint16_t flags){
+    uint32_t events = 0;
+    if (flags & DATA_SOURCE_CALLBACK_READ){
+        events |= EPOLLIN;
+    }
+    if (flags & DATA_SOURCE_CALLBACK_WRITE){
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+// fd is only registered with epoll while read or write callbacks are enabled, as epoll always reports EPOLLHUP
+static void btstack_run_loop_epoll_update_registration(btstack_data_source_t * ds, uint16_t old_flags, uint16_t new_flags){
+    if (ds->source.fd < 0) return;
+    uint32_t old_events = btstack_run_loop_epoll_events_for_flags(old_flags);
+    uint32_t new_events = btstack_run_loop_epoll_events_for_flags(new_flags);
+    if (old_events == new_events) return;
+
+    int op;
+    if (old_events == 0){
+        op = EPOLL_CTL_ADD;
+    } else if (new_events == 0){
+        op = EPOLL_CTL_DEL;
+    } else {
+        op = EPOLL_CTL_MOD;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = new_events;
+    event.data.ptr = ds;
+    int res = epoll_ctl(btstack_run_loop_epoll_fd, op, ds->source.fd, &event);
+    if (res < 0){
+        // fd might have been closed before data source was removed
+        if ((op == EPOLL_CTL_DEL) && ((errno == EBADF) || (errno == ENOENT))) return;
+        log_error("epoll_ctl op %u for fd %d failed, errno %u", op, ds->source.fd, errno);
+    }
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_epoll_add_data_source(btstack_data_source_t *ds){
+    bool added = btstack_linked_list_add(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+    if (!added) return;
+    btstack_run_loop_epoll_data_sources_modified = true;
+    ds->flags |= BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED;
+    btstack_run_loop_epoll_update_registration(ds, 0, ds->flags);
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static bool btstack_run_loop_epoll_remove_data_source(btstack_data_source_t *ds){
+    btstack_run_loop_epoll_data_sources_modified = true;
+    bool removed = btstack_run_loop_base_remove_data_source(ds);
+    if (removed){
+        btstack_run_loop_epoll_update_registration(ds, ds->flags, 0);
+    }
+    ds->flags &= (uint16_t) ~BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED;
+    return removed;
+}
+
+// registered flag avoids list walk, as callbacks get enabled and disabled frequently, e.g. for each UART write
+static void btstack_run_loop_epoll_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_enable_data_source_callbacks(ds, (uint16_t) (callback_types & ~BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED));
+    if ((ds->flags & BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED) != 0u){
+        btstack_run_loop_epoll_update_registration(ds, old_flags, ds->flags);
+    }
+}
+
+static void btstack_run_loop_epoll_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_disable_data_source_callbacks(ds, (uint16_t) (callback_types & ~BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED));
+    if ((ds->flags & BTSTACK_RUN_LOOP_EPOLL_FLAG_REGISTERED) != 0u){
+        btstack_run_loop_epoll_update_registration(ds, old_flags, ds->flags);
+    }
+}
+
+// timer heap
+
+static bool btstack_run_loop_epoll_timer_before(const btstack_run_loop_epoll_timer_entry_t * a, const btstack_run_loop_epoll_timer_entry_t * b){
+    int32_t delta = btstack_time_delta((uint32_t) a->timer->timeout, (uint32_t) b->timer->timeout);
+    if (delta != 0){
+        return delta < 0;
+    }
+    return ((int32_t) (a->sequence - b->sequence)) < 0;
+}
+
+static void btstack_run_loop_epoll_timer_store(uint32_t index, btstack_run_loop_epoll_timer_entry_t entry){
+    btstack_run_loop_epoll_timers[index] = entry;
+    entry.timer->item.next = (btstack_linked_item_t *) (uintptr_t) index;
+}
+
+static void btstack_run_loop_epoll_timer_sift_up(uint32_t index){
+    btstack_run_loop_epoll_timer_entry_t entry = btstack_run_loop_epoll_timers[index];
+    while (index > 0u){
+        uint32_t parent = (index - 1u) / 2u;
+        if (!btstack_run_loop_epoll_timer_before(&entry, &btstack_run_loop_epoll_timers[parent])) break;
+        btstack_run_loop_epoll_timer_store(index, btstack_run_loop_epoll_timers[parent]);
+        index = parent;
+    }
+    btstack_run_loop_epoll_timer_store(index, entry);
+}
+
+static void btstack_run_loop_epoll_timer_sift_down(uint32_t index){
+    btstack_run_loop_epoll_timer_entry_t entry = btstack_run_loop_epoll_timers[index];
+    while (true){
+        uint32_t child = (2u * index) + 1u;
+        if (child >= btstack_run_loop_epoll_timers_count) break;
+        if (((child + 1u) < btstack_run_loop_epoll_timers_count) &&
+            btstack_run_loop_epoll_timer_before(&btstack_run_loop_epoll_timers[child + 1u], &btstack_run_loop_epoll_timers[child])){
+            child++;
+        }
+        if (!btstack_run_loop_epoll_timer_before(&btstack_run_loop_epoll_timers[child], &entry)) break;
+        btstack_run_loop_epoll_timer_store(index, btstack_run_loop_epoll_timers[child]);
+        index = child;
+    }
+    btstack_run_loop_epoll_timer_store(index, entry);
+}
+
+// @return true if timer is in heap, index is set
+static bool btstack_run_loop_epoll_timer_find(btstack_timer_source_t * timer, uint32_t * index){
+    uintptr_t candidate = (uintptr_t) timer->item.next;
+    if (candidate >= btstack_run_loop_epoll_timers_count) return false;
+    if (btstack_run_loop_epoll_timers[candidate].timer != timer) return false;
+    *index = (uint32_t) candidate;
+    return true;
+}
+
+static void btstack_run_loop_epoll_add_timer(btstack_timer_source_t * timer){
+    uint32_t index;
+    if (btstack_run_loop_epoll_timer_find(timer, &index)){
+        log_error("Timer %p already registered! Please see comment in btstack_run_loop_base_add_timer.", (void *) timer);
+        btstack_assert(false);
+        return;
+    }
+    if (btstack_run_loop_epoll_timers_count == btstack_run_loop_epoll_timers_capacity){
+        uint32_t capacity = btstack_run_loop_epoll_timers_capacity * 2u;
+        if (capacity == 0u){
+            capacity = BTSTACK_RUN_LOOP_EPOLL_INITIAL_TIMER_CAPACITY;
+        }
+        btstack_run_loop_epoll_timer_entry_t * timers = (btstack_run_loop_epoll_timer_entry_t *) realloc(btstack_run_loop_epoll_timers, capacity * sizeof(btstack_run_loop_epoll_timer_entry_t));
+        if (timers == NULL){
+            log_error("Cannot grow timer heap to %u entries", capacity);
+            btstack_assert(false);
+            return;
+        }
+        btstack_run_loop_epoll_timers = timers;
+        btstack_run_loop_epoll_timers_capacity = capacity;
+    }
+    btstack_run_loop_epoll_timer_entry_t entry;
+    entry.timer = timer;
+    entry.sequence = btstack_run_loop_epoll_timers_sequence++;
+    index = btstack_run_loop_epoll_timers_count++;
+    btstack_run_loop_epoll_timers[index] = entry;
+    btstack_run_loop_epoll_timer_sift_up(index);
+}
+
+static bool btstack_run_loop_epoll_remove_timer(btstack_timer_source_t * timer){
+    uint32_t index;
+    if (!btstack_run_loop_epoll_timer_find(timer, &index)) return false;
+    timer->item.next = NULL;
+    btstack_run_loop_epoll_timers_count--;
+    if (index < btstack_run_loop_epoll_timers_count){
+        btstack_run_loop_epoll_timers[index] = btstack_run_loop_epoll_timers[btstack_run_loop_epoll_timers_count];
+        btstack_run_loop_epoll_timer_sift_down(index);
+        btstack_run_loop_epoll_timer_sift_up(index);
+    }
+    return true;
+}
+
+static void btstack_run_loop_epoll_process_timers(uint32_t now){
+    // process timers, exit when timeout is in the future
+    while (btstack_run_loop_epoll_timers_count > 0u){
+        btstack_timer_source_t * timer = btstack_run_loop_epoll_timers[0].timer;
+        int32_t delta = btstack_time_delta((uint32_t) timer->timeout, now);
+        if (delta > 0) break;
+        btstack_run_loop_epoll_remove_timer(timer);
+        timer->process(timer);
+    }
+}
+
+static void btstack_run_loop_epoll_dump_timer(void){
+#ifdef ENABLE_LOG_INFO
+    uint32_t i;
+    for (i = 0; i < btstack_run_loop_epoll_timers_count; i++){
+        btstack_timer_source_t * timer = btstack_run_loop_epoll_timers[i].timer;
+        log_info("timer %u (%p): timeout %" PRIbtstack_time_t "\n", i, (void *) timer, timer->timeout);
+    }
+#endif
+}
+
+// set timer
+static void btstack_run_loop_epoll_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint32_t time_ms = btstack_run_loop_epoll_get_time_ms();
+    a->timeout = time_ms + timeout_in_ms;
+    log_debug("btstack_run_loop_epoll_set_timer to %u ms (now %u, timeout %u)", (uint32_t) a->timeout, time_ms, timeout_in_ms);
+}
+
+// timerfd
+
+static void btstack_run_loop_epoll_timer_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    uint64_t expirations;
+    ssize_t bytes_read = read(ds->source.fd, &expirations, sizeof(expirations));
+    UNUSED(bytes_read);
+    btstack_run_loop_epoll_timer_armed = false;
+    // timers are processed at the end of each run loop iteration
+}
+
+static void btstack_run_loop_epoll_arm_timer(uint64_t timeout_ms_64, uint32_t timeout){
+    if (btstack_run_loop_epoll_timer_armed && (btstack_run_loop_epoll_timer_armed_timeout == timeout)) return;
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec  = init_ts.tv_sec + (time_t) (timeout_ms_64 / 1000u);
+    spec.it_value.tv_nsec = (long) ((timeout_ms_64 % 1000u) * 1000000u);
+    int res = timerfd_settime(btstack_run_loop_epoll_timer_ds.source.fd, TFD_TIMER_ABSTIME, &spec, NULL);
+    if (res < 0){
+        log_error("timerfd_settime failed, errno %u", errno);
+        return;
+    }
+    btstack_run_loop_epoll_timer_armed = true;
+    btstack_run_loop_epoll_timer_armed_timeout = timeout;
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_epoll_execute(void) {
+    struct epoll_event events[BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS];
+
+    log_info("Linux run loop with epoll");
+
+    while (btstack_run_loop_epoll_exit_requested == false) {
+
+        // arm timerfd for next timeout or poll if it already expired
+        int timeout_ms = -1;
+        if (btstack_run_loop_epoll_timers_count > 0u){
+            uint64_t now_ms = btstack_run_loop_epoll_get_time_ms_64();
+            uint32_t timeout = (uint32_t) btstack_run_loop_epoll_timers[0].timer->timeout;
+            int32_t delta_ms = btstack_time_delta(timeout, (uint32_t) now_ms);
+            if (delta_ms > 0){
+                btstack_run_loop_epoll_arm_timer(now_ms + (uint64_t) delta_ms, timeout);
+            } else {
+                timeout_ms = 0;
+            }
+        }
+
+        // wait for ready FDs
+        int num_events = epoll_wait(btstack_run_loop_epoll_fd, events, BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS, timeout_ms);
+        if ((num_events < 0) && (errno != EINTR)){
+            log_error("btstack_run_loop_epoll_execute: epoll_wait -> errno %u", errno);
+        }
+
+        // a data source might get removed in a callback, remaining events are reported again
+        btstack_run_loop_epoll_data_sources_modified = false;
+        int i;
+        for (i = 0; (i < num_events) && !btstack_run_loop_epoll_data_sources_modified; i++){
+            btstack_data_source_t * ds = (btstack_data_source_t *) events[i].data.ptr;
+            uint32_t ready = events[i].events;
+            if (((ready & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0u) && ((ds->flags & DATA_SOURCE_CALLBACK_READ) != 0u)){
+                log_debug("btstack_run_loop_epoll_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            if (btstack_run_loop_epoll_data_sources_modified) break;
+            if (((ready & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0u) && ((ds->flags & DATA_SOURCE_CALLBACK_WRITE) != 0u)){
+                log_debug("btstack_run_loop_epoll_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
+        }
+
+        // process timers
+        btstack_run_loop_epoll_process_timers(btstack_run_loop_epoll_get_time_ms());
+    }
+
+    // allow to execute run loop again
+    btstack_run_loop_epoll_exit_requested = false;
+}
+
+static void btstack_run_loop_epoll_trigger_exit(void){
+    btstack_run_loop_epoll_exit_requested = true;
+}
+
+// eventfd to wake up run loop
+
+static void btstack_run_loop_epoll_trigger_eventfd(int fd){
+    if (fd < 0) return;
+    const uint64_t value = 1;
+    ssize_t bytes_written = write(fd, &value, sizeof(value));
+    UNUSED(bytes_written);
+}
+
+static void btstack_run_loop_epoll_clear_eventfd(int fd){
+    uint64_t value;
+    ssize_t bytes_read = read(fd, &value, sizeof(value));
+    UNUSED(bytes_read);
+}
+
+// poll data sources from irq
+
+static void btstack_run_loop_epoll_poll_data_sources_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    btstack_run_loop_epoll_clear_eventfd(ds->source.fd);
+    // poll data sources
+    btstack_run_loop_base_poll_data_sources();
+}
+
+static void btstack_run_loop_epoll_poll_data_sources_from_irq(void){
+    // trigger run loop
+    btstack_run_loop_epoll_trigger_eventfd(btstack_run_loop_epoll_poll_data_sources_ds.source.fd);
+}
+
+// execute on main thread from same or different thread
+
+static void btstack_run_loop_epoll_process_callbacks_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    btstack_run_loop_epoll_clear_eventfd(ds->source.fd);
+    // execute callbacks - protect list with mutex
+    while (1){
+        pthread_mutex_lock(&btstack_run_loop_epoll_callbacks_mutex);
+        btstack_context_callback_registration_t * callback_registration = (btstack_context_callback_registration_t *) btstack_linked_list_pop(&btstack_run_loop_base_callbacks);
+        pthread_mutex_unlock(&btstack_run_loop_epoll_callbacks_mutex);
+        if (callback_registration == NULL){
+            break;
+        }
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_epoll_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    // protect list with mutex
+    pthread_mutex_lock(&btstack_run_loop_epoll_callbacks_mutex);
+    btstack_run_loop_base_add_callback(callback_registration);
+    pthread_mutex_unlock(&btstack_run_loop_epoll_callbacks_mutex);
+    // trigger run loop
+    btstack_run_loop_epoll_trigger_eventfd(btstack_run_loop_epoll_process_callbacks_ds.source.fd);
+}
+
+//init
+
+static void btstack_run_loop_epoll_register_internal_data_source(btstack_data_source_t * data_source, int fd,
+    void (*process)(btstack_data_source_t *_data_source,  btstack_data_source_callback_type_t callback_type)){
+    if (fd < 0){
+        log_error("Creating fd for internal data source failed, errno %u", errno);
+    }
+    data_source->source.fd = fd;
+    data_source->flags = DATA_SOURCE_CALLBACK_READ;
+    data_source->process = process;
+    btstack_run_loop_epoll_add_data_source(data_source);
+}
+
+static void btstack_run_loop_epoll_close_fds(void){
+    if (btstack_run_loop_epoll_fd < 0) return;
+    close(btstack_run_loop_epoll_timer_ds.source.fd);
+    close(btstack_run_loop_epoll_process_callbacks_ds.source.fd);
+    close(btstack_run_loop_epoll_poll_data_sources_ds.source.fd);
+    close(btstack_run_loop_epoll_fd);
+    btstack_run_loop_epoll_fd = -1;
+}
+
+static void btstack_run_loop_epoll_init(void){
+    // init after deinit, e.g. in unit tests
+    btstack_run_loop_epoll_close_fds();
+
+    btstack_run_loop_base_init();
+
+    btstack_run_loop_epoll_timers_count = 0;
+    btstack_run_loop_epoll_timer_armed = false;
+    btstack_run_loop_epoll_exit_requested = false;
+
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+
+    btstack_run_loop_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (btstack_run_loop_epoll_fd < 0){
+        log_error("epoll_create1 failed, errno %u", errno);
+        return;
+    }
+
+    // setup timerfd for next timeout
+    btstack_run_loop_epoll_register_internal_data_source(&btstack_run_loop_epoll_timer_ds,
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), &btstack_run_loop_epoll_timer_handler);
+
+    // setup eventfd to trigger process callbacks
+    btstack_run_loop_epoll_register_internal_data_source(&btstack_run_loop_epoll_process_callbacks_ds,
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), &btstack_run_loop_epoll_process_callbacks_handler);
+
+    // setup eventfd to poll data sources
+    btstack_run_loop_epoll_register_internal_data_source(&btstack_run_loop_epoll_poll_data_sources_ds,
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), &btstack_run_loop_epoll_poll_data_sources_handler);
+}
+
+static const btstack_run_loop_t btstack_run_loop_epoll = {
+    &btstack_run_loop_epoll_init,
+    &btstack_run_loop_epoll_add_data_source,
+    &btstack_run_loop_epoll_remove_data_source,
+    &btstack_run_loop_epoll_enable_data_source_callbacks,
+    &btstack_run_loop_epoll_disable_data_source_callbacks,
+    &btstack_run_loop_epoll_set_timer,
+    &btstack_run_loop_epoll_add_timer,
+    &btstack_run_loop_epoll_remove_timer,
+    &btstack_run_loop_epoll_execute,
+    &btstack_run_loop_epoll_dump_timer,
+    &btstack_run_loop_epoll_get_time_ms,
+    &btstack_run_loop_epoll_poll_data_sources_from_irq,
+    &btstack_run_loop_epoll_execute_on_main_thread,
+    &btstack_run_loop_epoll_trigger_exit,
+};
+
+/**
+ * Provide btstack_run_loop_epoll instance
+ */
+const btstack_run_loop_t * btstack_run_loop_epoll_get_instance(void){
+    return &btstack_run_loop_epoll;
+}
+
+#endif
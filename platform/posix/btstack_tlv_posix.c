@@ -31,6 +31,9 @@
 
 #define BTSTACK_FILE__ "btstack_tlv_posix.c"
 
+// enable POSIX functions fileno, fsync and strndup (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809L
+
 #include "btstack_tlv.h"
 #include "btstack_tlv_posix.h"
 #include "btstack_debug.h"
@@ -40,6 +43,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 
 // Header:
@@ -53,48 +59,274 @@
 // - Len: 32 bit
 // - Value: Len in bytes
 
+// Updates are appended to the file. When more than half of the file is taken up by overwritten or deleted
+// entries, the current entries are written to a new file, which then replaces the old one via rename.
+
 #define BTSTACK_TLV_HEADER_LEN 8
+#define BTSTACK_TLV_ENTRY_HEADER_LEN 8
 
 #define MAX_TLV_VALUE_SIZE 2048
 
+// don't compact files smaller than this
+#ifndef BTSTACK_TLV_POSIX_COMPACTION_MIN_SIZE
+#define BTSTACK_TLV_POSIX_COMPACTION_MIN_SIZE 4096
+#endif
+
+// compact when more than this percentage of the file is stale
+#ifndef BTSTACK_TLV_POSIX_COMPACTION_STALE_PERCENT
+#define BTSTACK_TLV_POSIX_COMPACTION_STALE_PERCENT 50
+#endif
+
+#define BTSTACK_TLV_POSIX_INDEX_MIN_SIZE 16
+
 static const char * btstack_tlv_header_magic = "BTstack";
 
 #define DUMMY_SIZE 4
 typedef struct tlv_entry {
-	void   * next;
+	struct tlv_entry * next;	// next entry in same hash bucket
 	uint32_t tag;
 	uint32_t len;
 	uint8_t  value[DUMMY_SIZE];	// dummy size
 } tlv_entry_t;
 
-static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
+// hash index
 
-	if (!self->file) return 1;
+static uint32_t btstack_tlv_posix_bucket_for_tag(uint32_t tag, uint32_t index_size){
+	// integer hash, index_size is power of two
+	uint32_t hash = tag;
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bu;
+	hash ^= hash >> 16;
+	return hash & (index_size - 1u);
+}
 
-	log_info("append tag %04x, len %u", tag, data_size);
+static void btstack_tlv_posix_index_insert(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	tlv_entry_t ** buckets = (tlv_entry_t **) self->index;
+	uint32_t bucket = btstack_tlv_posix_bucket_for_tag(entry->tag, self->index_size);
+	entry->next = buckets[bucket];
+	buckets[bucket] = entry;
+}
+
+// grow index to keep load factor <= 1, returns 0 on success
+static int btstack_tlv_posix_index_reserve(btstack_tlv_posix_t * self, uint32_t num_entries){
+	if ((self->index != NULL) && (num_entries <= self->index_size)) return 0;
+	uint32_t new_size = (self->index_size == 0u) ? BTSTACK_TLV_POSIX_INDEX_MIN_SIZE : self->index_size;
+	while (new_size < num_entries){
+		new_size *= 2u;
+	}
+	tlv_entry_t ** new_buckets = (tlv_entry_t **) calloc(new_size, sizeof(tlv_entry_t *));
+	if (new_buckets == NULL) return 1;
+	// rehash existing entries
+	tlv_entry_t ** old_buckets = (tlv_entry_t **) self->index;
+	uint32_t old_size = self->index_size;
+	self->index = (void **) new_buckets;
+	self->index_size = new_size;
+	uint32_t i;
+	for (i = 0; i < old_size; i++){
+		tlv_entry_t * entry = old_buckets[i];
+		while (entry != NULL){
+			tlv_entry_t * next = entry->next;
+			btstack_tlv_posix_index_insert(self, entry);
+			entry = next;
+		}
+	}
+	free(old_buckets);
+	return 0;
+}
+
+static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
+	if (self->index == NULL) return NULL;
+	tlv_entry_t ** buckets = (tlv_entry_t **) self->index;
+	tlv_entry_t * entry = buckets[btstack_tlv_posix_bucket_for_tag(tag, self->index_size)];
+	while (entry != NULL){
+		if (entry->tag == tag) return entry;
+		entry = entry->next;
+	}
+	return NULL;
+}
+
+// remove and free entry, returns true if found
+static bool btstack_tlv_posix_remove_entry(btstack_tlv_posix_t * self, uint32_t tag){
+	if (self->index == NULL) return false;
+	tlv_entry_t ** buckets = (tlv_entry_t **) self->index;
+	tlv_entry_t ** link = &buckets[btstack_tlv_posix_bucket_for_tag(tag, self->index_size)];
+	while (*link != NULL){
+		tlv_entry_t * entry = *link;
+		if (entry->tag == tag){
+			*link = entry->next;
+			self->num_entries--;
+			self->live_size -= BTSTACK_TLV_ENTRY_HEADER_LEN + entry->len;
+			free(entry);
+			return true;
+		}
+		link = &entry->next;
+	}
+	return false;
+}
+
+// takes ownership of entry, replaces existing entry with same tag
+static int btstack_tlv_posix_add_entry(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	btstack_tlv_posix_remove_entry(self, entry->tag);
+	if (btstack_tlv_posix_index_reserve(self, self->num_entries + 1u) != 0){
+		free(entry);
+		return 1;
+	}
+	btstack_tlv_posix_index_insert(self, entry);
+	self->num_entries++;
+	self->live_size += BTSTACK_TLV_ENTRY_HEADER_LEN + entry->len;
+	return 0;
+}
+
+static void btstack_tlv_posix_free_entries(btstack_tlv_posix_t * self){
+	tlv_entry_t ** buckets = (tlv_entry_t **) self->index;
+	uint32_t i;
+	for (i = 0; i < self->index_size; i++){
+		tlv_entry_t * entry = buckets[i];
+		while (entry != NULL){
+			tlv_entry_t * next = entry->next;
+			free(entry);
+			entry = next;
+		}
+	}
+	free(buckets);
+	self->index = NULL;
+	self->index_size = 0;
+	self->num_entries = 0;
+	self->live_size = 0;
+}
+
+// file
+
+static void btstack_tlv_posix_sync_file(FILE * file){
+	fflush(file);
+	fsync(fileno(file));
+}
 
-	uint8_t header[8];
+static int btstack_tlv_posix_write_entry(FILE * file, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	uint8_t header[BTSTACK_TLV_ENTRY_HEADER_LEN];
 	big_endian_store_32(header, 0, tag);
 	big_endian_store_32(header, 4, data_size);
-	size_t written_header = fwrite(header, 1, sizeof(header), self->file);
+	size_t written_header = fwrite(header, 1, sizeof(header), file);
 	if (written_header != sizeof(header)) return 1;
 	if (data_size > 0) {
-		size_t written_value = fwrite(data, 1, data_size, self->file);
+		size_t written_value = fwrite(data, 1, data_size, file);
 		if (written_value != data_size) return 1;
 	}
-	fflush(self->file);
-	return 1;
+	return 0;
 }
 
-static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		return entry;
+// make rename in directory of given file durable
+static void btstack_tlv_posix_sync_dir(const char * path){
+	const char * separator = strrchr(path, '/');
+	char * dir_path;
+	if (separator == NULL){
+		dir_path = strdup(".");
+	} else if (separator == path){
+		dir_path = strdup("/");
+	} else {
+		dir_path = strndup(path, (size_t) (separator - path));
 	}
-	return NULL;
+	if (dir_path == NULL) return;
+	int fd = open(dir_path, O_RDONLY);
+	if (fd >= 0){
+		fsync(fd);
+		close(fd);
+	} else {
+		log_error("cannot open directory %s for sync", dir_path);
+	}
+	free(dir_path);
+}
+
+// write header and all current entries, returns 0 on success
+static int btstack_tlv_posix_write_db(btstack_tlv_posix_t * self, FILE * file){
+	uint8_t header[BTSTACK_TLV_HEADER_LEN];
+	memset(header, 0, sizeof(header));
+	strcpy((char *)header, btstack_tlv_header_magic);
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) return 1;
+	tlv_entry_t ** buckets = (tlv_entry_t **) self->index;
+	uint32_t i;
+	for (i = 0; i < self->index_size; i++){
+		tlv_entry_t * entry;
+		for (entry = buckets[i]; entry != NULL; entry = entry->next){
+			if (btstack_tlv_posix_write_entry(file, entry->tag, &entry->value[0], entry->len) != 0) return 1;
+		}
+	}
+	self->file_size = BTSTACK_TLV_HEADER_LEN + self->live_size;
+	return 0;
+}
+
+// write current entries to new file and replace db file with it
+static void btstack_tlv_posix_compact(btstack_tlv_posix_t * self){
+	log_info("compact db %s: file size %u, live %u", self->db_path, self->file_size, self->live_size);
+
+	size_t path_len = strlen(self->db_path);
+	char * tmp_path = (char *) malloc(path_len + 5);
+	if (tmp_path == NULL) return;
+	memcpy(tmp_path, self->db_path, path_len);
+	memcpy(&tmp_path[path_len], ".tmp", 5);
+
+	uint32_t old_file_size = self->file_size;
+	FILE * tmp_file = fopen(tmp_path, "w+");
+	int err = (tmp_file == NULL) ? 1 : 0;
+	if (err == 0){
+		err = btstack_tlv_posix_write_db(self, tmp_file);
+	}
+	if (err == 0){
+		// new file has to be on disk before it replaces the old one
+		btstack_tlv_posix_sync_file(tmp_file);
+		err = rename(tmp_path, self->db_path);
+	}
+	if (err == 0){
+		// rename is only durable after directory entry is on disk
+		btstack_tlv_posix_sync_dir(self->db_path);
+	}
+	if (err != 0){
+		log_error("compaction of %s failed", self->db_path);
+		if (tmp_file != NULL){
+			fclose(tmp_file);
+		}
+		remove(tmp_path);
+		self->file_size = old_file_size;
+		free(tmp_path);
+		return;
+	}
+	free(tmp_path);
+
+	// continue appending to new file
+	if (self->file != NULL){
+		fclose(self->file);
+	}
+	self->file = tmp_file;
+	fseek(self->file, 0, SEEK_END);
+	self->writes_since_sync = 0;
+}
+
+static void btstack_tlv_posix_compact_if_needed(btstack_tlv_posix_t * self){
+	if (self->file_size < BTSTACK_TLV_POSIX_COMPACTION_MIN_SIZE) return;
+	uint32_t stale_size = self->file_size - BTSTACK_TLV_HEADER_LEN - self->live_size;
+	if ((stale_size * 100u) <= (self->file_size * BTSTACK_TLV_POSIX_COMPACTION_STALE_PERCENT)) return;
+	btstack_tlv_posix_compact(self);
+}
+
+static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
+
+	if (!self->file) return 1;
+
+	log_info("append tag %04x, len %u", tag, data_size);
+
+	if (btstack_tlv_posix_write_entry(self->file, tag, data, data_size) != 0) return 1;
+	self->file_size += BTSTACK_TLV_ENTRY_HEADER_LEN + data_size;
+
+	self->writes_since_sync++;
+	if ((self->writes_per_sync > 0u) && (self->writes_since_sync >= self->writes_per_sync)){
+		btstack_tlv_posix_sync_file(self->file);
+		self->writes_since_sync = 0;
+	} else {
+		fflush(self->file);
+	}
+
+	btstack_tlv_posix_compact_if_needed(self);
+	return 1;
 }
 
 /**
@@ -103,15 +335,8 @@ static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, ui
  */
 static void btstack_tlv_posix_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) context;
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		btstack_linked_list_iterator_remove(&it);
-		free(entry);
+	if (btstack_tlv_posix_remove_entry(self, tag)){
 		btstack_tlv_posix_append_tag(self, tag, NULL, 0);
-		return;
 	}
 }
 
@@ -147,13 +372,6 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	// enforce arbitrary max value size
 	btstack_assert(data_size <= MAX_TLV_VALUE_SIZE);
 
-	// remove old entry
-	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
-	if (old_entry){
-		btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-		free(old_entry);
-	}
-
 	// create new entry
 	uint32_t entry_size = sizeof(tlv_entry_t) - DUMMY_SIZE + data_size;
 	tlv_entry_t * new_entry = (tlv_entry_t *) malloc(entry_size);
@@ -163,8 +381,8 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	new_entry->len = data_size;
 	memcpy(&new_entry->value[0], data, data_size);
 
-	// append new entry
-	btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+	// replace old entry
+	if (btstack_tlv_posix_add_entry(self, new_entry) != 0) return 0;
 
 	// write new tag
 	btstack_tlv_posix_append_tag(self, tag, data, data_size);
@@ -185,9 +403,10 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
 	    if (objects_read == BTSTACK_TLV_HEADER_LEN){
 	    	if (memcmp(header, btstack_tlv_header_magic, strlen(btstack_tlv_header_magic)) == 0){
 		    	log_info("BTstack Magic Header found");
+		    	self->file_size = BTSTACK_TLV_HEADER_LEN;
 		    	// read entries
 		    	while (true){
-					uint8_t entry[8];
+					uint8_t entry[BTSTACK_TLV_ENTRY_HEADER_LEN];
 					size_t 	entries_read = fread(entry, 1, sizeof(entry), self->file);
 					if (entries_read == 0){
 						// EOF, we're good
@@ -212,19 +431,19 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
 
                         // read
                         size_t value_read = fread(&new_entry->value[0], 1, len, self->file);
-                        if (value_read != len) break;
+                        if (value_read != len) {
+                            free(new_entry);
+                            break;
+                        }
                     }
 
-                    // remove old entry
-                    tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
-                    if (old_entry){
-                        btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-                        free(old_entry);
-                    }
+                    self->file_size += BTSTACK_TLV_ENTRY_HEADER_LEN + len;
 
-                    // append new entry
+                    // replace or remove old entry
                     if (new_entry){
-	                    btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+                        btstack_tlv_posix_add_entry(self, new_entry);
+                    } else {
+                        btstack_tlv_posix_remove_entry(self, tag);
                     }
 		    	}
 	    	}
@@ -242,16 +461,11 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
             log_error("failed to create file");
             return -1;
         }
-	    memset(header, 0, sizeof(header));
-	    strcpy((char *)header, btstack_tlv_header_magic);
-	    fwrite(header, 1, sizeof(header), self->file);
 	    // write out all valid entries (if any)
-		btstack_linked_list_iterator_t it;
-		btstack_linked_list_iterator_init(&it, &self->entry_list);
-		while (btstack_linked_list_iterator_has_next(&it)){
-			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-			btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
-		}
+	    btstack_tlv_posix_write_db(self, self->file);
+	    fflush(self->file);
+    } else {
+        btstack_tlv_posix_compact_if_needed(self);
     }
 	return 0;
 }
@@ -274,17 +488,27 @@ const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * self
 	return &btstack_tlv_posix;
 }
 
+/**
+ * Sync updates to disk after given number of writes
+ */
+void btstack_tlv_posix_set_writes_per_sync(btstack_tlv_posix_t * self, uint32_t writes_per_sync){
+	self->writes_per_sync = writes_per_sync;
+}
+
+/**
+ * Sync pending updates to disk
+ */
+void btstack_tlv_posix_sync(btstack_tlv_posix_t * self){
+	if (!self->file) return;
+	btstack_tlv_posix_sync_file(self->file);
+	self->writes_since_sync = 0;
+}
+
 /**
  * Free TLV entries
  * @param self
  */
 void btstack_tlv_posix_deinit(btstack_tlv_posix_t * self){
     // free all entries
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &self->entry_list);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		btstack_linked_list_iterator_remove(&it);
-		free(entry);
-    }
+    btstack_tlv_posix_free_entries(self);
 }
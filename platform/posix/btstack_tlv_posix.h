@@ -33,7 +33,7 @@
  *  btstack_tlv_posix.h
  *
  *  Implementation for BTstack's Tag Value Length Persistent Storage implementations
- *  using in-memory storage (RAM & malloc) and append-only log files on disc
+ *  using in-memory storage (RAM & malloc) and append-only log files on disc, which are compacted when needed
  */
 
 #ifndef BTSTACK_TLV_POSIX_H
@@ -49,9 +49,18 @@ extern "C" {
 #endif
 
 typedef struct {
-	btstack_linked_list_t entry_list;
+	// hash index of entries
+	void ** index;
+	uint32_t index_size;
+	uint32_t num_entries;
 	const char * db_path;
 	FILE * file;
+	// file size and size of current entries in file, used to trigger compaction
+	uint32_t file_size;
+	uint32_t live_size;
+	// fsync
+	uint32_t writes_per_sync;
+	uint32_t writes_since_sync;
 } btstack_tlv_posix_t;
 
 /**
@@ -61,6 +70,19 @@ typedef struct {
  */
 const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * context, const char * db_path);
 
+/**
+ * Sync updates to disk with fsync after given number of writes. Default: 0 = only flush to OS after each write
+ * @param self
+ * @param writes_per_sync
+ */
+void btstack_tlv_posix_set_writes_per_sync(btstack_tlv_posix_t * self, uint32_t writes_per_sync);
+
+/**
+ * Sync pending updates to disk, e.g. from a timer or before shutdown
+ * @param self
+ */
+void btstack_tlv_posix_sync(btstack_tlv_posix_t * self);
+
 /**
  * Free TLV entries
  * @param self
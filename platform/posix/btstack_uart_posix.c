@@ -76,9 +76,13 @@ static const uint8_t * btstack_uart_block_write_bytes_data;
 static uint16_t  btstack_uart_block_read_bytes_len;
 static uint8_t * btstack_uart_block_read_bytes_data;
 
+// streaming read
+static int       btstack_uart_bytes_read_active;
+
 // callbacks
 static void (*block_sent)(void);
 static void (*block_received)(void);
+static void (*bytes_received)(uint16_t num_bytes);
 
 
 static int btstack_uart_posix_init(const btstack_uart_config_t * config){
@@ -162,6 +166,34 @@ static void btstack_uart_block_posix_process_read(btstack_data_source_t *ds) {
     }
 }
 
+static void btstack_uart_bytes_posix_process_read(btstack_data_source_t *ds) {
+
+    // read as many bytes as available, up to buffer size
+    ssize_t bytes_read = read(ds->source.fd, btstack_uart_block_read_bytes_data, btstack_uart_block_read_bytes_len);
+    if (bytes_read == 0){
+        log_error("read zero bytes\n");
+        return;
+    }
+    if (bytes_read < 0) {
+        if (errno != EAGAIN){
+            log_error("read returned error\n");
+        }
+        return;
+    }
+
+    btstack_uart_bytes_read_active = 0;
+    btstack_uart_block_read_bytes_len = 0;
+
+    if (bytes_received){
+        bytes_received((uint16_t) bytes_read);
+    }
+
+    // keep read callback enabled if handler requested more data
+    if (btstack_uart_bytes_read_active == 0){
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+    }
+}
+
 static int btstack_uart_posix_set_baudrate(uint32_t baudrate){
 
     int fd = transport_data_source.source.fd;
@@ -376,6 +408,12 @@ static void btstack_uart_posix_set_block_received( void (*block_handler)(void)){
     block_received = block_handler;
 }
 
+static void btstack_uart_posix_set_bytes_received( void (*bytes_handler)(uint16_t num_bytes)){
+    btstack_uart_block_read_bytes_len = 0;
+    btstack_uart_bytes_read_active = 0;
+    bytes_received = bytes_handler;
+}
+
 static void btstack_uart_posix_set_block_sent( void (*block_handler)(void)){
     btstack_uart_block_write_bytes_len = 0;
     block_sent = block_handler;
@@ -399,6 +437,17 @@ static void btstack_uart_posix_receive_block(uint8_t *buffer, uint16_t len){
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
 }
 
+static void btstack_uart_posix_receive_bytes(uint8_t *buffer, uint16_t max_len){
+    btstack_assert(btstack_uart_block_read_bytes_len == 0);
+    btstack_assert(max_len > 0);
+
+    // setup async read, completes as soon as at least one byte was received
+    btstack_uart_block_read_bytes_data = buffer;
+    btstack_uart_block_read_bytes_len = max_len;
+    btstack_uart_bytes_read_active = 1;
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
+}
+
 #ifdef ENABLE_H5
 
 // SLIP Implementation Start
@@ -468,8 +517,9 @@ static uint16_t btstack_uart_slip_posix_process_buffer(void){
     log_debug("process buffer: pos %u, len %u", btstack_uart_slip_receive_pos, btstack_uart_slip_receive_len);
 
     uint16_t frame_size = 0;
-    while (btstack_uart_slip_receive_pos < btstack_uart_slip_receive_len && frame_size == 0){
-        btstack_slip_decoder_process(btstack_uart_slip_receive_buffer[btstack_uart_slip_receive_pos++]);
+    if (btstack_uart_slip_receive_pos < btstack_uart_slip_receive_len){
+        btstack_uart_slip_receive_pos += btstack_slip_decoder_process_block(&btstack_uart_slip_receive_buffer[btstack_uart_slip_receive_pos],
+                                                                            btstack_uart_slip_receive_len - btstack_uart_slip_receive_pos);
         frame_size = btstack_slip_decoder_frame_size();
     }
 
@@ -526,10 +576,7 @@ static void btstack_uart_slip_posix_process_read(btstack_data_source_t *ds) {
 // SLIP ENCODING
 
 static void btstack_uart_slip_posix_encode_chunk_and_send(void){
-    uint16_t pos = 0;
-    while (btstack_slip_encoder_has_data() & (pos < SLIP_TX_CHUNK_LEN)) {
-        btstack_uart_slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    uint16_t pos = btstack_slip_encoder_encode_block(btstack_uart_slip_outgoing_buffer, SLIP_TX_CHUNK_LEN);
 
     // setup async write and start sending
     log_debug("slip: send %d bytes", pos);
@@ -614,7 +661,9 @@ static void hci_uart_posix_process(btstack_data_source_t *ds, btstack_data_sourc
                 btstack_uart_slip_posix_process_read(ds);
             } else
 #endif
-            {
+            if (btstack_uart_bytes_read_active){
+                btstack_uart_bytes_posix_process_read(ds);
+            } else {
                 btstack_uart_block_posix_process_read(ds);
             }
             break;
@@ -656,6 +705,8 @@ static const btstack_uart_t btstack_uart_posix = {
 #else
     NULL, NULL, NULL, NULL,
 #endif
+    /* void (*set_bytes_received)(void (*handler)(uint16_t num_bytes)); */ &btstack_uart_posix_set_bytes_received,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */       &btstack_uart_posix_receive_bytes,
 };
 
 const btstack_uart_t * btstack_uart_posix_instance(void){
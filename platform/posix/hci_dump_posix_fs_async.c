@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_dump_posix_fs_async.c"
+
+/*
+ *  hci_dump_posix_fs_async.c
+ *
+ *  Dump HCI trace into a file without blocking the caller:
+ *
+ *  - BlueZ's hcidump format
+ *  - Apple's PacketLogger
+ *  - BTSnoop
+ *
+ *  hci_dump_packet runs on the TX and RX paths of the stack. Instead of two blocking write calls
+ *  per packet, the record header and the (optionally truncated) packet are copied into a lock-free
+ *  SPSC ring buffer. A writer thread collects all pending records and writes them with a single
+ *  writev call. It wakes up periodically or once the ring buffer is half full.
+ *
+ *  Each record in the ring buffer is prefixed by its length and padded to 4 bytes. Records are
+ *  never split at the end of the storage, instead, a wrap marker tells the writer to continue at
+ *  the start. If there's no space left or if a second thread tries to log at the same time, the
+ *  record is dropped and counted. A reset is queued as a marker, so that the writer truncates the
+ *  file after all previous records and before all following ones.
+ */
+
+#include "btstack_config.h"
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "hci_dump_posix_fs_async.h"
+
+#include "btstack_debug.h"
+#include "btstack_ring_buffer_spsc.h"
+#include "btstack_util.h"
+#include "hci_cmd.h"
+
+#include <errno.h>        // errno
+#include <fcntl.h>        // open
+#include <limits.h>       // IOV_MAX
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>        // printf, snprintf, rename
+#include <stdlib.h>       // malloc
+#include <string.h>
+#include <sys/stat.h>     // file modes
+#include <sys/time.h>     // for timestamps
+#include <sys/uio.h>      // writev
+#include <time.h>         // nanosleep
+#include <unistd.h>       // write
+
+#define HCI_DUMP_ASYNC_DEFAULT_BUFFER_SIZE  (256 * 1024)
+#define HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS    50
+#define HCI_DUMP_ASYNC_RECORD_WRAP          0xffffffffu
+#define HCI_DUMP_ASYNC_RECORD_RESET         0xfffffffeu
+#define HCI_DUMP_ASYNC_MAX_FILENAME_LEN     256
+
+#if defined(IOV_MAX) && (IOV_MAX < 256)
+#define HCI_DUMP_ASYNC_MAX_IOVECS           IOV_MAX
+#else
+#define HCI_DUMP_ASYNC_MAX_IOVECS           256
+#endif
+
+static const uint8_t btsnoop_file_header[] = {
+    // Identification Pattern: "btsnoop\0"
+    0x62, 0x74, 0x73, 0x6E, 0x6F, 0x6F, 0x70, 0x00,
+    // Version: 1
+    0x00, 0x00, 0x00, 0x01,
+    // Datalink Type: 1002 - H4
+    0x00, 0x00, 0x03, 0xEA,
+};
+
+// configuration
+static hci_dump_format_t dump_format;
+static char     dump_filename[HCI_DUMP_ASYNC_MAX_FILENAME_LEN];
+static uint32_t dump_max_file_size;
+static uint8_t  dump_max_files;
+static uint16_t dump_snaplen;
+
+// producer
+static bool        dump_active;
+static atomic_flag producer_busy = ATOMIC_FLAG_INIT;
+static char        log_message_buffer[HCI_DUMP_MAX_MESSAGE_LEN];
+static atomic_uint dropped_records;
+
+// ring buffer
+static btstack_ring_buffer_spsc_t ring_buffer;
+static uint8_t *   ring_storage;
+static uint32_t    ring_size;
+
+// writer thread
+static pthread_t       writer_thread;
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  writer_cond  = PTHREAD_COND_INITIALIZER;
+static atomic_bool     writer_stop;
+static int             dump_file = -1;
+static uint32_t        dump_file_size;
+static uint32_t        dump_file_header_size;
+
+static uint32_t hci_dump_async_padded_size(uint32_t size){
+    return (size + 3u) & ~3u;
+}
+
+static void hci_dump_async_wake_writer(void){
+    // signal without mutex: a lost wakeup only delays writing until the next flush interval
+    pthread_cond_signal(&writer_cond);
+}
+
+// writer thread: file handling
+
+static void hci_dump_async_write_file_header(void){
+    dump_file_size = 0;
+    if (dump_format == HCI_DUMP_BTSNOOP){
+        ssize_t bytes_written = write(dump_file, btsnoop_file_header, sizeof(btsnoop_file_header));
+        if (bytes_written > 0){
+            dump_file_size = (uint32_t) bytes_written;
+        }
+    }
+    dump_file_header_size = dump_file_size;
+}
+
+static int hci_dump_async_open_file(void){
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+    dump_file = open(dump_filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    if (dump_file < 0){
+        return errno;
+    }
+    hci_dump_async_write_file_header();
+    return 0;
+}
+
+static void hci_dump_async_rotate_file(void){
+    close(dump_file);
+    dump_file = -1;
+    // filename.(n-2) -> filename.(n-1), ..., filename -> filename.1
+    char from[HCI_DUMP_ASYNC_MAX_FILENAME_LEN + 4];
+    char to[HCI_DUMP_ASYNC_MAX_FILENAME_LEN + 4];
+    int i;
+    for (i = ((int) dump_max_files) - 1; i > 0; i--){
+        if (i == 1){
+            btstack_strcpy(from, sizeof(from), dump_filename);
+        } else {
+            snprintf(from, sizeof(from), "%s.%u", dump_filename, i - 1);
+        }
+        snprintf(to, sizeof(to), "%s.%u", dump_filename, i);
+        (void) rename(from, to);
+    }
+    (void) hci_dump_async_open_file();
+}
+
+static void hci_dump_async_reset_file(void){
+    (void) lseek(dump_file, 0, SEEK_SET);
+    int err = ftruncate(dump_file, 0);
+    UNUSED(err);
+    hci_dump_async_write_file_header();
+}
+
+// writer thread: write all complete records from contiguous region with single writev call
+// returns number of bytes consumed from the ring buffer
+static uint32_t hci_dump_async_write_batch(void){
+    struct iovec iov[HCI_DUMP_ASYNC_MAX_IOVECS];
+    int num_iovecs = 0;
+    uint32_t batch_size = 0;
+    uint32_t consumed = 0;
+    bool rotate = false;
+    bool reset = false;
+
+    uint32_t region_length;
+    const uint8_t * region = btstack_ring_buffer_spsc_read_reserve(&ring_buffer, &region_length);
+
+    while (((consumed + 4u) <= region_length) && (num_iovecs < HCI_DUMP_ASYNC_MAX_IOVECS)){
+        uint32_t record_len;
+        (void) memcpy(&record_len, &region[consumed], 4);
+        if (record_len == HCI_DUMP_ASYNC_RECORD_WRAP){
+            // rest of storage is unused, producer continues at start
+            consumed = region_length;
+            break;
+        }
+        if (record_len == HCI_DUMP_ASYNC_RECORD_RESET){
+            // records before reset are discarded
+            num_iovecs = 0;
+            consumed += 4u;
+            reset = true;
+            break;
+        }
+        // start new file if record doesn't fit, but keep at least one record per file
+        if (dump_max_file_size > 0){
+            uint32_t file_size = dump_file_size + batch_size;
+            if (((file_size + record_len) > dump_max_file_size) && (file_size > dump_file_header_size)){
+                rotate = true;
+                break;
+            }
+        }
+        iov[num_iovecs].iov_base = (void *) &region[consumed + 4u];
+        iov[num_iovecs].iov_len  = record_len;
+        num_iovecs++;
+        batch_size += record_len;
+        consumed += 4u + hci_dump_async_padded_size(record_len);
+    }
+
+    if (num_iovecs > 0){
+        ssize_t bytes_written = writev(dump_file, iov, num_iovecs);
+        if (bytes_written > 0){
+            dump_file_size += (uint32_t) bytes_written;
+        }
+    }
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, consumed);
+
+    if (reset){
+        hci_dump_async_reset_file();
+        // records might be pending
+        return 1;
+    }
+    if (rotate){
+        hci_dump_async_rotate_file();
+        // records are pending
+        return 1;
+    }
+    return consumed;
+}
+
+static void * hci_dump_async_writer_main(void * context){
+    UNUSED(context);
+    while (true){
+        if (dump_file < 0){
+            // file could not be re-opened on rotation, discard records
+            uint32_t region_length;
+            (void) btstack_ring_buffer_spsc_read_reserve(&ring_buffer, &region_length);
+            btstack_ring_buffer_spsc_read_commit(&ring_buffer, region_length);
+        } else if (hci_dump_async_write_batch() > 0){
+            continue;
+        }
+        // all records written, producer doesn't add new records after stop
+        if (atomic_load(&writer_stop)){
+            if (btstack_ring_buffer_spsc_bytes_available(&ring_buffer) == 0) break;
+            continue;
+        }
+        // wait for next flush interval or wake-up by producer
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        uint64_t deadline_us = ((uint64_t) now.tv_sec * 1000000u) + (uint64_t) now.tv_usec + (HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS * 1000u);
+        struct timespec deadline;
+        deadline.tv_sec  = (time_t) (deadline_us / 1000000u);
+        deadline.tv_nsec = (long) ((deadline_us % 1000000u) * 1000u);
+        pthread_mutex_lock(&writer_mutex);
+        if ((btstack_ring_buffer_spsc_bytes_available(&ring_buffer) == 0) && !atomic_load(&writer_stop)){
+            (void) pthread_cond_timedwait(&writer_cond, &writer_mutex, &deadline);
+        }
+        pthread_mutex_unlock(&writer_mutex);
+    }
+    return NULL;
+}
+
+// producer
+
+// provide summary for ISO Data Packets if not supported by fileformat/viewer yet
+static uint16_t hci_dump_iso_summary(uint8_t in,  uint8_t *packet, uint16_t len){
+    UNUSED(len);
+    uint16_t conn_handle = little_endian_read_16(packet, 0) & 0xfff;
+    uint8_t pb = (packet[1] >> 4) & 3;
+    uint8_t ts = (packet[1] >> 6) & 1;
+    uint16_t pos = 4;
+    uint32_t time_stamp = 0;
+    if (ts){
+        time_stamp = little_endian_read_32(packet, pos);
+        pos += 4;
+    }
+    uint16_t packet_sequence = little_endian_read_16(packet, pos);
+    pos += 2;
+    uint16_t iso_sdu_len = little_endian_read_16(packet, pos);
+    uint8_t packet_status_flag = packet[pos+1] >> 6;
+    return snprintf(log_message_buffer,sizeof(log_message_buffer), "ISO %s, handle %04x, pb %u, ts 0x%08x, sequence 0x%04x, packet status %u, iso len %u",
+                    in ? "IN" : "OUT", conn_handle, pb, time_stamp, packet_sequence, packet_status_flag, iso_sdu_len);
+}
+
+// get contiguous space for record, insert wrap marker if needed
+static uint8_t * hci_dump_async_reserve(uint32_t size){
+    uint32_t region_length;
+    uint8_t * region = btstack_ring_buffer_spsc_write_reserve(&ring_buffer, &region_length);
+    if (region_length >= size) {
+        return region;
+    }
+    // region limited by consumer -> ring buffer full
+    uint32_t position = (uint32_t) (region - ring_storage);
+    if ((position + region_length) < ring_size) {
+        return NULL;
+    }
+    // not enough space at end of storage, continue at start if there's enough space
+    if (btstack_ring_buffer_spsc_bytes_free(&ring_buffer) < (region_length + size)) {
+        return NULL;
+    }
+    uint32_t wrap_marker = HCI_DUMP_ASYNC_RECORD_WRAP;
+    (void) memcpy(region, &wrap_marker, 4);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, region_length);
+    return btstack_ring_buffer_spsc_write_reserve(&ring_buffer, &region_length);
+}
+
+static void hci_dump_async_store_record(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len){
+    static union {
+        uint8_t header_bluez[HCI_DUMP_HEADER_SIZE_BLUEZ];
+        uint8_t header_packetlogger[HCI_DUMP_HEADER_SIZE_PACKETLOGGER];
+        uint8_t header_btsnoop[HCI_DUMP_HEADER_SIZE_BTSNOOP+1];
+    } header;
+
+    // get time
+    struct timeval curr_time;
+    gettimeofday(&curr_time, NULL);
+    uint32_t tv_sec = curr_time.tv_sec;
+    uint32_t tv_us  = curr_time.tv_usec;
+    uint64_t ts_usec;
+
+    // ISO packets not supported by BlueZ and PacketLogger
+    if ((packet_type == HCI_ISO_DATA_PACKET) && (dump_format != HCI_DUMP_BTSNOOP)){
+        len = hci_dump_iso_summary(in, packet, len);
+        packet_type = LOG_MESSAGE_PACKET;
+        packet = (uint8_t*) log_message_buffer;
+    }
+
+    uint16_t original_len = len;
+    if ((dump_snaplen > 0) && (len > dump_snaplen)){
+        len = dump_snaplen;
+    }
+
+    uint16_t header_len = 0;
+    switch (dump_format){
+        case HCI_DUMP_BLUEZ:
+            hci_dump_setup_header_bluez(header.header_bluez, tv_sec, tv_us, packet_type, in, len);
+            header_len = HCI_DUMP_HEADER_SIZE_BLUEZ;
+            break;
+        case HCI_DUMP_PACKETLOGGER:
+            hci_dump_setup_header_packetlogger(header.header_packetlogger, tv_sec, tv_us, packet_type, in, len);
+            header_len = HCI_DUMP_HEADER_SIZE_PACKETLOGGER;
+            break;
+        case HCI_DUMP_BTSNOOP:
+            // log messages not supported
+            if (packet_type == LOG_MESSAGE_PACKET) return;
+            ts_usec = 0xdcddb30f2f8000LLU + 1000000LLU * curr_time.tv_sec + curr_time.tv_usec;
+            // append packet type to pcap header, report dropped records as cumulative drops
+            hci_dump_setup_header_btsnoop(header.header_btsnoop, ts_usec >> 32, ts_usec & 0xFFFFFFFF,
+                                          atomic_load_explicit(&dropped_records, memory_order_relaxed), packet_type, in, len+1);
+            big_endian_store_32(header.header_btsnoop, 0, original_len + 1u);
+            header.header_btsnoop[HCI_DUMP_HEADER_SIZE_BTSNOOP] = packet_type;
+            header_len = HCI_DUMP_HEADER_SIZE_BTSNOOP + 1;
+            break;
+        default:
+            btstack_unreachable();
+            return;
+    }
+
+    uint32_t record_len = header_len + len;
+    uint8_t * record = hci_dump_async_reserve(4u + hci_dump_async_padded_size(record_len));
+    if (record == NULL){
+        atomic_fetch_add_explicit(&dropped_records, 1, memory_order_relaxed);
+        return;
+    }
+    (void) memcpy(record, &record_len, 4);
+    (void) memcpy(&record[4], &header, header_len);
+    (void) memcpy(&record[4 + header_len], packet, len);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 4u + hci_dump_async_padded_size(record_len));
+
+    if (btstack_ring_buffer_spsc_bytes_free(&ring_buffer) < (ring_size / 2u)){
+        hci_dump_async_wake_writer();
+    }
+}
+
+static void hci_dump_posix_fs_async_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
+    if (dump_active == false) return;
+    // single producer, don't wait for other thread
+    if (atomic_flag_test_and_set_explicit(&producer_busy, memory_order_acquire)){
+        atomic_fetch_add_explicit(&dropped_records, 1, memory_order_relaxed);
+        return;
+    }
+    hci_dump_async_store_record(packet_type, in, packet, len);
+    atomic_flag_clear_explicit(&producer_busy, memory_order_release);
+}
+
+static void hci_dump_posix_fs_async_log_message(int log_level, const char * format, va_list argptr){
+    UNUSED(log_level);
+    if (dump_active == false) return;
+    if (atomic_flag_test_and_set_explicit(&producer_busy, memory_order_acquire)){
+        atomic_fetch_add_explicit(&dropped_records, 1, memory_order_relaxed);
+        return;
+    }
+    int len = vsnprintf(log_message_buffer, sizeof(log_message_buffer), format, argptr);
+    if (len >= (int) sizeof(log_message_buffer)){
+        len = sizeof(log_message_buffer) - 1;
+    }
+    if (len > 0){
+        hci_dump_async_store_record(LOG_MESSAGE_PACKET, 0, (uint8_t*) log_message_buffer, (uint16_t) len);
+    }
+    atomic_flag_clear_explicit(&producer_busy, memory_order_release);
+}
+
+static void hci_dump_posix_fs_async_reset(void){
+    if (dump_active == false) return;
+    // reset must not get lost, wait for other thread and for writer to make space
+    const struct timespec retry_interval = { 0, 1000000 };
+    while (atomic_flag_test_and_set_explicit(&producer_busy, memory_order_acquire)){
+        (void) nanosleep(&retry_interval, NULL);
+    }
+    uint8_t * marker = hci_dump_async_reserve(4);
+    while (marker == NULL){
+        hci_dump_async_wake_writer();
+        (void) nanosleep(&retry_interval, NULL);
+        marker = hci_dump_async_reserve(4);
+    }
+    uint32_t reset_marker = HCI_DUMP_ASYNC_RECORD_RESET;
+    (void) memcpy(marker, &reset_marker, 4);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 4);
+    atomic_flag_clear_explicit(&producer_busy, memory_order_release);
+    hci_dump_async_wake_writer();
+}
+
+// returns system errno
+int hci_dump_posix_fs_async_open(const char *filename, hci_dump_format_t format, const hci_dump_posix_fs_async_config_t * config){
+    btstack_assert(format == HCI_DUMP_BLUEZ || format == HCI_DUMP_PACKETLOGGER || format == HCI_DUMP_BTSNOOP);
+    btstack_assert(dump_active == false);
+
+    uint32_t buffer_size = HCI_DUMP_ASYNC_DEFAULT_BUFFER_SIZE;
+    dump_max_file_size = 0;
+    dump_max_files = 1;
+    dump_snaplen = 0;
+    if (config != NULL){
+        if (config->buffer_size > 0){
+            buffer_size = config->buffer_size;
+        }
+        dump_max_file_size = config->max_file_size;
+        dump_max_files = btstack_max(1, config->max_files);
+        dump_snaplen = config->snaplen;
+    }
+
+    dump_format = format;
+    btstack_strcpy(dump_filename, sizeof(dump_filename), filename);
+    int err = hci_dump_async_open_file();
+    if (err != 0){
+        printf("failed to open file %s, errno = %d\n", filename, err);
+        return err;
+    }
+
+    // records are 4-byte aligned
+    ring_size = buffer_size & ~3u;
+    ring_storage = (uint8_t *) malloc(ring_size);
+    if (ring_storage == NULL){
+        close(dump_file);
+        dump_file = -1;
+        return ENOMEM;
+    }
+    btstack_ring_buffer_spsc_init(&ring_buffer, ring_storage, ring_size);
+    atomic_store(&dropped_records, 0);
+    atomic_store(&writer_stop, false);
+
+    err = pthread_create(&writer_thread, NULL, &hci_dump_async_writer_main, NULL);
+    if (err != 0){
+        free(ring_storage);
+        ring_storage = NULL;
+        close(dump_file);
+        dump_file = -1;
+        return err;
+    }
+    dump_active = true;
+    return 0;
+}
+
+void hci_dump_posix_fs_async_close(void){
+    if (dump_active == false) return;
+    dump_active = false;
+    atomic_store(&writer_stop, true);
+    hci_dump_async_wake_writer();
+    pthread_join(writer_thread, NULL);
+    if (dump_file >= 0){
+        close(dump_file);
+        dump_file = -1;
+    }
+    free(ring_storage);
+    ring_storage = NULL;
+}
+
+uint32_t hci_dump_posix_fs_async_get_dropped_records(void){
+    return atomic_load(&dropped_records);
+}
+
+const hci_dump_t * hci_dump_posix_fs_async_get_instance(void){
+    static const hci_dump_t hci_dump_instance = {
+        // void (*reset)(void);
+        &hci_dump_posix_fs_async_reset,
+        // void (*log_packet)(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len);
+        &hci_dump_posix_fs_async_log_packet,
+        // void (*log_message)(int log_level, const char * format, va_list argptr);
+        &hci_dump_posix_fs_async_log_message,
+    };
+    return &hci_dump_instance;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  Dump HCI trace in binary formats like PacketLogger, BlueZ (hcidump) or BTSnoop into file
+ *  without blocking the caller. Records are copied into a ring buffer and written by a
+ *  background thread in batches.
+ */
+
+#ifndef HCI_DUMP_POSIX_FS_ASYNC_H
+#define HCI_DUMP_POSIX_FS_ASYNC_H
+
+#include <stdint.h>
+#include "hci_dump.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // size of ring buffer between BTstack and writer thread in bytes, 0 = default (256 kB)
+    uint32_t buffer_size;
+    // start new file when this size would be exceeded, 0 = unlimited
+    uint32_t max_file_size;
+    // number of files kept on rotation: filename, filename.1, ..., filename.(max_files-1)
+    // 0 or 1 = restart single file
+    uint8_t  max_files;
+    // max number of bytes logged per packet, 0 = complete packet
+    uint16_t snaplen;
+} hci_dump_posix_fs_async_config_t;
+
+/* API_START */
+
+/**
+ * @brief Get HCI Dump POSIX FS Async Instance
+ * @return hci_dump_impl
+ */
+const hci_dump_t * hci_dump_posix_fs_async_get_instance(void);
+
+/*
+ * @brief Open log file and start writer thread
+ * @param filename or path
+ * @param format
+ * @param config or NULL for default configuration
+ * @returns 0 if ok, errno otherwise
+ */
+int hci_dump_posix_fs_async_open(const char *filename, hci_dump_format_t format, const hci_dump_posix_fs_async_config_t * config);
+
+/*
+ * @brief Write pending records, stop writer thread and close log file
+ */
+void hci_dump_posix_fs_async_close(void);
+
+/*
+ * @brief Get number of records that were dropped as ring buffer was full or another thread was logging
+ * @returns number of dropped records
+ */
+uint32_t hci_dump_posix_fs_async_get_dropped_records(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+#endif // HCI_DUMP_POSIX_FS_ASYNC_H
@@ -0,0 +1,993 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_virtual.c"
+
+/*
+ *  hci_transport_virtual.c
+ *
+ *  Simulated Controller that exchanges ACL data with a peer over a stream socket
+ */
+
+#include "btstack_config.h"
+#include "hci_transport_virtual.h"
+
+#include "bluetooth_company_id.h"
+#include "btstack_aes128.h"
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define VIRTUAL_CON_HANDLE_CLASSIC 0x0001
+#define VIRTUAL_CON_HANDLE_LE      0x0040
+
+// link message: type, flags, ACL payload - framed with 16-bit length
+#define VIRTUAL_LINK_MESSAGE_MAX_SIZE (2 + HCI_ACL_PAYLOAD_SIZE)
+#define VIRTUAL_LINK_FRAME_MAX_SIZE   (2 + VIRTUAL_LINK_MESSAGE_MAX_SIZE)
+#define VIRTUAL_LINK_CONTROL_MAX_SIZE 12
+#define VIRTUAL_LINK_CONTROL_QUEUE_SIZE 4
+
+// packets for the host, a link message results in up to two of them
+#define VIRTUAL_HOST_QUEUE_SIZE 16
+#define VIRTUAL_HOST_QUEUE_MIN_FREE_FOR_LINK 4
+#if HCI_ACL_BUFFER_SIZE > HCI_EVENT_BUFFER_SIZE
+#define VIRTUAL_HOST_PACKET_MAX_SIZE HCI_ACL_BUFFER_SIZE
+#else
+#define VIRTUAL_HOST_PACKET_MAX_SIZE HCI_EVENT_BUFFER_SIZE
+#endif
+
+typedef enum {
+    VIRTUAL_LINK_IDLE,
+    VIRTUAL_LINK_W4_CONNECT_RESPONSE,
+    VIRTUAL_LINK_W4_ACCEPT,
+    VIRTUAL_LINK_CONNECTED,
+} virtual_link_state_t;
+
+typedef struct {
+    uint8_t  packet_type;
+    uint16_t size;
+    uint8_t  buffer[HCI_INCOMING_PRE_BUFFER_SIZE + VIRTUAL_HOST_PACKET_MAX_SIZE];
+} virtual_host_packet_t;
+
+typedef struct {
+    uint32_t due_ms;
+    uint16_t size;
+    uint8_t  message[VIRTUAL_LINK_MESSAGE_MAX_SIZE];
+} virtual_acl_buffer_t;
+
+typedef struct {
+    uint16_t size;
+    uint8_t  message[VIRTUAL_LINK_CONTROL_MAX_SIZE];
+} virtual_control_message_t;
+
+// LE, 3/5 slot packets, EDR 2/3 Mbps, no SSP
+static const uint8_t virtual_supported_features[8] = { 0x03, 0x00, 0x00, 0x06, 0xC0, 0x01, 0x00, 0x00 };
+
+static void (*virtual_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static hci_transport_config_virtual_t virtual_config;
+static btstack_data_source_t          virtual_link_data_source;
+static btstack_timer_source_t         virtual_timer;
+static bool                           virtual_link_open;
+static bool                           virtual_link_write_blocked;
+static uint32_t                       virtual_random_state;
+
+// packets for the host
+static virtual_host_packet_t virtual_host_queue[VIRTUAL_HOST_QUEUE_SIZE];
+static uint16_t              virtual_host_queue_head;
+static uint16_t              virtual_host_queue_count;
+
+// Controller ACL buffers
+static virtual_acl_buffer_t virtual_acl_buffers[HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS];
+static uint16_t             virtual_acl_head;
+static uint16_t             virtual_acl_count;
+static uint16_t             virtual_acl_completed;
+
+// link control messages take precedence over ACL
+static virtual_control_message_t virtual_control_queue[VIRTUAL_LINK_CONTROL_QUEUE_SIZE];
+static uint16_t                  virtual_control_head;
+static uint16_t                  virtual_control_count;
+
+// link framing
+static uint8_t  virtual_tx_frame[VIRTUAL_LINK_FRAME_MAX_SIZE];
+static uint16_t virtual_tx_len;
+static uint16_t virtual_tx_pos;
+static uint8_t  virtual_rx_frame[VIRTUAL_LINK_FRAME_MAX_SIZE];
+static uint16_t virtual_rx_pos;
+
+// connection
+static virtual_link_state_t virtual_link_state;
+static bool                 virtual_link_le;
+static hci_con_handle_t     virtual_link_con_handle;
+static bd_addr_t            virtual_link_peer_addr;
+static bool                 virtual_advertising_enabled;
+static bool                 virtual_page_scan_enabled;
+
+// connection request from peer that waits for advertising or page scan
+static bool      virtual_incoming_pending;
+static bool      virtual_incoming_le;
+static bd_addr_t virtual_incoming_addr;
+static uint32_t  virtual_incoming_cod;
+
+static hci_transport_virtual_statistics_t virtual_statistics;
+static uint64_t virtual_event_timestamp_us;
+static bool     virtual_event_active;
+
+static void virtual_schedule(void);
+static void virtual_link_send_control(const uint8_t * message, uint16_t size);
+
+static uint64_t virtual_time_us(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000u) + ((uint64_t) now.tv_nsec / 1000u);
+}
+
+// xorshift32, reproducible for a given seed
+static uint32_t virtual_random(void){
+    uint32_t x = virtual_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    virtual_random_state = x;
+    return x;
+}
+
+// host queue
+
+static uint8_t * virtual_host_queue_reserve(void){
+    if (virtual_host_queue_count == VIRTUAL_HOST_QUEUE_SIZE){
+        log_error("host queue full, drop packet");
+        return NULL;
+    }
+    uint16_t index = (virtual_host_queue_head + virtual_host_queue_count) % VIRTUAL_HOST_QUEUE_SIZE;
+    uint8_t * packet = &virtual_host_queue[index].buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    // hci may read past the end of short events, e.g. local name
+    memset(packet, 0, HCI_EVENT_BUFFER_SIZE);
+    return packet;
+}
+
+static void virtual_host_queue_commit(uint8_t packet_type, uint16_t size){
+    uint16_t index = (virtual_host_queue_head + virtual_host_queue_count) % VIRTUAL_HOST_QUEUE_SIZE;
+    virtual_host_queue[index].packet_type = packet_type;
+    virtual_host_queue[index].size = size;
+    virtual_host_queue_count++;
+    virtual_schedule();
+}
+
+static void virtual_emit_event(const uint8_t * event, uint16_t size){
+    uint8_t * packet = virtual_host_queue_reserve();
+    if (packet == NULL) return;
+    memcpy(packet, event, size);
+    virtual_host_queue_commit(HCI_EVENT_PACKET, size);
+}
+
+static void virtual_emit_command_complete(uint16_t opcode, const uint8_t * return_parameters, uint8_t len){
+    uint8_t * event = virtual_host_queue_reserve();
+    if (event == NULL) return;
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    memcpy(&event[5], return_parameters, len);
+    virtual_host_queue_commit(HCI_EVENT_PACKET, 5 + len);
+}
+
+static void virtual_emit_command_complete_status(uint16_t opcode, uint8_t status){
+    virtual_emit_command_complete(opcode, &status, 1);
+}
+
+static void virtual_emit_command_status(uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_connection_complete(uint8_t status){
+    uint8_t event[13];
+    if (virtual_link_le){
+        uint8_t le_event[21];
+        le_event[0] = HCI_EVENT_LE_META;
+        le_event[1] = 19;
+        le_event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+        le_event[3] = status;
+        little_endian_store_16(le_event, 4, virtual_link_con_handle);
+        // role: central if we've sent the request
+        le_event[6] = (virtual_link_state == VIRTUAL_LINK_W4_CONNECT_RESPONSE) ? HCI_ROLE_MASTER : HCI_ROLE_SLAVE;
+        le_event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+        reverse_bd_addr(virtual_link_peer_addr, &le_event[8]);
+        little_endian_store_16(le_event, 14, 0x0018);
+        little_endian_store_16(le_event, 16, 0);
+        little_endian_store_16(le_event, 18, 0x0048);
+        le_event[20] = 0;
+        virtual_emit_event(le_event, sizeof(le_event));
+        return;
+    }
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = status;
+    little_endian_store_16(event, 3, virtual_link_con_handle);
+    reverse_bd_addr(virtual_link_peer_addr, &event[5]);
+    event[11] = 1;  // ACL
+    event[12] = 0;  // encryption disabled
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_disconnection_complete(uint8_t reason){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, virtual_link_con_handle);
+    event[5] = reason;
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_number_of_completed_packets(void){
+    if (virtual_acl_completed == 0) return;
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, virtual_link_con_handle);
+    little_endian_store_16(event, 5, virtual_acl_completed);
+    virtual_acl_completed = 0;
+    virtual_emit_event(event, sizeof(event));
+}
+
+// connection handling
+
+static void virtual_link_set_connected(bool le){
+    virtual_link_le = le;
+    virtual_link_con_handle = le ? VIRTUAL_CON_HANDLE_LE : VIRTUAL_CON_HANDLE_CLASSIC;
+}
+
+static void virtual_link_closed(void){
+    // host releases its ACL buffers for the connection on disconnect
+    virtual_link_state = VIRTUAL_LINK_IDLE;
+    virtual_acl_head = 0;
+    virtual_acl_count = 0;
+    virtual_acl_completed = 0;
+}
+
+static void virtual_link_send_connect_response(uint8_t status){
+    uint8_t message[8];
+    message[0] = HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_RESPONSE;
+    message[1] = status;
+    memcpy(&message[2], virtual_config.bd_addr, 6);
+    virtual_link_send_control(message, sizeof(message));
+}
+
+static void virtual_link_send_disconnect(uint8_t reason){
+    uint8_t message[2];
+    message[0] = HCI_TRANSPORT_VIRTUAL_LINK_DISCONNECT;
+    message[1] = reason;
+    virtual_link_send_control(message, sizeof(message));
+}
+
+static void virtual_handle_incoming_request(void){
+    if (virtual_incoming_pending == false) return;
+    if (virtual_link_state != VIRTUAL_LINK_IDLE) return;
+    if (virtual_incoming_le){
+        if (virtual_advertising_enabled == false) return;
+        // Controller stops advertising when connected
+        virtual_advertising_enabled = false;
+        virtual_incoming_pending = false;
+        memcpy(virtual_link_peer_addr, virtual_incoming_addr, 6);
+        virtual_link_set_connected(true);
+        virtual_link_state = VIRTUAL_LINK_CONNECTED;
+        virtual_link_send_connect_response(ERROR_CODE_SUCCESS);
+        virtual_emit_connection_complete(ERROR_CODE_SUCCESS);
+    } else {
+        if (virtual_page_scan_enabled == false) return;
+        virtual_incoming_pending = false;
+        memcpy(virtual_link_peer_addr, virtual_incoming_addr, 6);
+        virtual_link_set_connected(false);
+        virtual_link_state = VIRTUAL_LINK_W4_ACCEPT;
+        uint8_t event[12];
+        event[0] = HCI_EVENT_CONNECTION_REQUEST;
+        event[1] = 10;
+        reverse_bd_addr(virtual_link_peer_addr, &event[2]);
+        little_endian_store_24(event, 8, virtual_incoming_cod);
+        event[11] = 1;  // ACL
+        virtual_emit_event(event, sizeof(event));
+    }
+}
+
+static void virtual_link_create_connection(uint16_t opcode, bool le, const uint8_t * address){
+    if (virtual_link_state != VIRTUAL_LINK_IDLE){
+        virtual_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+        return;
+    }
+    virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+    reverse_bd_addr(address, virtual_link_peer_addr);
+    virtual_link_set_connected(le);
+    virtual_link_state = VIRTUAL_LINK_W4_CONNECT_RESPONSE;
+    uint8_t message[11];
+    message[0] = HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_REQUEST;
+    message[1] = le ? 1 : 0;
+    memcpy(&message[2], virtual_config.bd_addr, 6);
+    little_endian_store_24(message, 8, 0);
+    virtual_link_send_control(message, sizeof(message));
+}
+
+static void virtual_link_cancel_connection(uint16_t opcode){
+    if (virtual_link_state != VIRTUAL_LINK_W4_CONNECT_RESPONSE){
+        virtual_emit_command_complete_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+        return;
+    }
+    uint8_t message = HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_CANCEL;
+    virtual_link_send_control(&message, 1);
+    virtual_emit_command_complete_status(opcode, ERROR_CODE_SUCCESS);
+    virtual_emit_connection_complete(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+    virtual_link_closed();
+}
+
+static void virtual_link_handle_message(const uint8_t * message, uint16_t size){
+    uint8_t * packet;
+    uint8_t status;
+    switch (message[0]){
+        case HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_REQUEST:
+            if (size < 11) break;
+            if ((virtual_link_state != VIRTUAL_LINK_IDLE) || virtual_incoming_pending){
+                virtual_link_send_connect_response(ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES);
+                break;
+            }
+            virtual_incoming_pending = true;
+            virtual_incoming_le = message[1] != 0;
+            memcpy(virtual_incoming_addr, &message[2], 6);
+            virtual_incoming_cod = little_endian_read_24(message, 8);
+            virtual_handle_incoming_request();
+            break;
+        case HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_RESPONSE:
+            if (size < 8) break;
+            status = message[1];
+            if (virtual_link_state != VIRTUAL_LINK_W4_CONNECT_RESPONSE){
+                // cancelled locally
+                if (status == ERROR_CODE_SUCCESS){
+                    virtual_link_send_disconnect(ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST);
+                }
+                break;
+            }
+            memcpy(virtual_link_peer_addr, &message[2], 6);
+            virtual_emit_connection_complete(status);
+            if (status == ERROR_CODE_SUCCESS){
+                virtual_link_state = VIRTUAL_LINK_CONNECTED;
+            } else {
+                virtual_link_closed();
+            }
+            break;
+        case HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_CANCEL:
+            virtual_incoming_pending = false;
+            if (virtual_link_state == VIRTUAL_LINK_W4_ACCEPT){
+                virtual_emit_connection_complete(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                virtual_link_closed();
+            }
+            break;
+        case HCI_TRANSPORT_VIRTUAL_LINK_DISCONNECT:
+            if (size < 2) break;
+            if (virtual_link_state != VIRTUAL_LINK_CONNECTED) break;
+            virtual_emit_disconnection_complete(message[1]);
+            virtual_link_closed();
+            break;
+        case HCI_TRANSPORT_VIRTUAL_LINK_ACL:
+            if (size < 2) break;
+            if (virtual_link_state != VIRTUAL_LINK_CONNECTED) break;
+            packet = virtual_host_queue_reserve();
+            if (packet == NULL) break;
+            {
+                uint16_t payload_len = size - 2;
+                // first non-flushable packets from the host are delivered as first automatically flushable
+                uint8_t flags = message[1] & 0x0f;
+                if ((flags & 0x03) == 0x00){
+                    flags |= 0x02;
+                }
+                little_endian_store_16(packet, 0, virtual_link_con_handle | (flags << 12));
+                little_endian_store_16(packet, 2, payload_len);
+                memcpy(&packet[4], &message[2], payload_len);
+                virtual_statistics.acl_packets_received++;
+                virtual_statistics.acl_bytes_received += payload_len;
+                virtual_host_queue_commit(HCI_ACL_DATA_PACKET, 4 + payload_len);
+            }
+            break;
+        default:
+            log_error("unknown link message 0x%02x", message[0]);
+            break;
+    }
+}
+
+static void virtual_link_lost(void){
+    log_info("link closed by peer");
+    virtual_link_open = false;
+    btstack_run_loop_disable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_READ | DATA_SOURCE_CALLBACK_WRITE);
+    btstack_run_loop_remove_data_source(&virtual_link_data_source);
+    switch (virtual_link_state){
+        case VIRTUAL_LINK_CONNECTED:
+            virtual_emit_disconnection_complete(ERROR_CODE_CONNECTION_TIMEOUT);
+            break;
+        case VIRTUAL_LINK_W4_CONNECT_RESPONSE:
+        case VIRTUAL_LINK_W4_ACCEPT:
+            virtual_emit_connection_complete(ERROR_CODE_PAGE_TIMEOUT);
+            break;
+        default:
+            break;
+    }
+    virtual_link_closed();
+    virtual_control_count = 0;
+    virtual_tx_len = 0;
+    virtual_tx_pos = 0;
+}
+
+// link I/O
+
+static void virtual_link_send_control(const uint8_t * message, uint16_t size){
+    if (virtual_control_count == VIRTUAL_LINK_CONTROL_QUEUE_SIZE){
+        log_error("link control queue full, drop message 0x%02x", message[0]);
+        return;
+    }
+    uint16_t index = (virtual_control_head + virtual_control_count) % VIRTUAL_LINK_CONTROL_QUEUE_SIZE;
+    memcpy(virtual_control_queue[index].message, message, size);
+    virtual_control_queue[index].size = size;
+    virtual_control_count++;
+    virtual_schedule();
+}
+
+// prepare next frame, returns false if nothing to send
+static bool virtual_link_prepare_frame(void){
+    if (virtual_control_count > 0){
+        virtual_control_message_t * control = &virtual_control_queue[virtual_control_head];
+        little_endian_store_16(virtual_tx_frame, 0, control->size);
+        memcpy(&virtual_tx_frame[2], control->message, control->size);
+        virtual_tx_len = 2 + control->size;
+        virtual_control_head = (virtual_control_head + 1) % VIRTUAL_LINK_CONTROL_QUEUE_SIZE;
+        virtual_control_count--;
+        return true;
+    }
+    if (virtual_acl_count == 0) return false;
+    virtual_acl_buffer_t * acl_buffer = &virtual_acl_buffers[virtual_acl_head];
+    uint32_t now = btstack_run_loop_get_time_ms();
+    if ((int32_t)(acl_buffer->due_ms - now) > 0) return false;
+    // retransmit after another latency period, packets stay in order
+    if ((virtual_config.loss_per_mille > 0) && ((virtual_random() % 1000u) < virtual_config.loss_per_mille)){
+        virtual_statistics.retransmissions++;
+        acl_buffer->due_ms = now + btstack_max(virtual_config.latency_ms, 1);
+        return false;
+    }
+    little_endian_store_16(virtual_tx_frame, 0, acl_buffer->size);
+    memcpy(&virtual_tx_frame[2], acl_buffer->message, acl_buffer->size);
+    virtual_tx_len = 2 + acl_buffer->size;
+    virtual_statistics.acl_packets_sent++;
+    virtual_statistics.acl_bytes_sent += acl_buffer->size - 2;
+    virtual_acl_head = (virtual_acl_head + 1) % HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS;
+    virtual_acl_count--;
+    virtual_acl_completed++;
+    return true;
+}
+
+static void virtual_link_write(void){
+    while (virtual_link_open && (virtual_link_write_blocked == false)){
+        if (virtual_tx_pos == virtual_tx_len){
+            virtual_tx_pos = 0;
+            virtual_tx_len = 0;
+            if (virtual_link_prepare_frame() == false) return;
+        }
+        ssize_t res = send(virtual_config.link_fd, &virtual_tx_frame[virtual_tx_pos], virtual_tx_len - virtual_tx_pos, MSG_NOSIGNAL);
+        if (res < 0){
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)){
+                virtual_link_write_blocked = true;
+                btstack_run_loop_enable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_WRITE);
+                return;
+            }
+            virtual_link_lost();
+            return;
+        }
+        virtual_tx_pos += (uint16_t) res;
+    }
+}
+
+static void virtual_link_read(void){
+    while (virtual_link_open){
+        if ((VIRTUAL_HOST_QUEUE_SIZE - virtual_host_queue_count) < VIRTUAL_HOST_QUEUE_MIN_FREE_FOR_LINK){
+            // resume when host queue has been processed
+            btstack_run_loop_disable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_READ);
+            return;
+        }
+        uint16_t bytes_to_read;
+        if (virtual_rx_pos < 2){
+            bytes_to_read = 2 - virtual_rx_pos;
+        } else {
+            bytes_to_read = 2 + little_endian_read_16(virtual_rx_frame, 0) - virtual_rx_pos;
+        }
+        ssize_t res = recv(virtual_config.link_fd, &virtual_rx_frame[virtual_rx_pos], bytes_to_read, 0);
+        if (res == 0){
+            virtual_link_lost();
+            return;
+        }
+        if (res < 0){
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) return;
+            virtual_link_lost();
+            return;
+        }
+        virtual_rx_pos += (uint16_t) res;
+        if (virtual_rx_pos < 2) continue;
+        uint16_t message_len = little_endian_read_16(virtual_rx_frame, 0);
+        if ((message_len == 0) || (message_len > VIRTUAL_LINK_MESSAGE_MAX_SIZE)){
+            log_error("invalid link message len %u", message_len);
+            virtual_link_lost();
+            return;
+        }
+        if (virtual_rx_pos < (2 + message_len)) continue;
+        virtual_rx_pos = 0;
+        virtual_link_handle_message(&virtual_rx_frame[2], message_len);
+    }
+}
+
+// main processing: send link frames, report completed packets, deliver packets to host
+
+static void virtual_process(void){
+    virtual_link_write();
+    virtual_emit_number_of_completed_packets();
+
+    // only deliver packets that have been queued before, packet handler may queue more
+    uint16_t num_packets = virtual_host_queue_count;
+    while (num_packets > 0){
+        num_packets--;
+        virtual_host_packet_t * host_packet = &virtual_host_queue[virtual_host_queue_head];
+        virtual_event_timestamp_us = virtual_time_us();
+        virtual_event_active = true;
+        (*virtual_packet_handler)(host_packet->packet_type, &host_packet->buffer[HCI_INCOMING_PRE_BUFFER_SIZE], host_packet->size);
+        virtual_event_active = false;
+        virtual_host_queue_head = (virtual_host_queue_head + 1) % VIRTUAL_HOST_QUEUE_SIZE;
+        virtual_host_queue_count--;
+    }
+
+    if (virtual_link_open && ((VIRTUAL_HOST_QUEUE_SIZE - virtual_host_queue_count) >= VIRTUAL_HOST_QUEUE_MIN_FREE_FOR_LINK)){
+        btstack_run_loop_enable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_READ);
+    }
+    virtual_schedule();
+}
+
+static void virtual_timer_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    virtual_process();
+}
+
+static void virtual_link_process(btstack_data_source_t * data_source, btstack_data_source_callback_type_t callback_type){
+    UNUSED(data_source);
+    switch (callback_type){
+        case DATA_SOURCE_CALLBACK_READ:
+            virtual_link_read();
+            break;
+        case DATA_SOURCE_CALLBACK_WRITE:
+            virtual_link_write_blocked = false;
+            btstack_run_loop_disable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_WRITE);
+            break;
+        default:
+            break;
+    }
+    virtual_process();
+}
+
+static void virtual_schedule(void){
+    uint32_t timeout_ms;
+    bool can_write = virtual_link_open && (virtual_link_write_blocked == false);
+    if ((virtual_host_queue_count > 0) || (virtual_acl_completed > 0) || (can_write && (virtual_control_count > 0))){
+        timeout_ms = 0;
+    } else if (can_write && (virtual_acl_count > 0)){
+        int32_t delta_ms = (int32_t)(virtual_acl_buffers[virtual_acl_head].due_ms - btstack_run_loop_get_time_ms());
+        timeout_ms = (delta_ms > 0) ? (uint32_t) delta_ms : 0;
+    } else {
+        return;
+    }
+    btstack_run_loop_remove_timer(&virtual_timer);
+    btstack_run_loop_set_timer(&virtual_timer, timeout_ms);
+    btstack_run_loop_add_timer(&virtual_timer);
+}
+
+// HCI commands
+
+static void virtual_reset(void){
+    switch (virtual_link_state){
+        case VIRTUAL_LINK_CONNECTED:
+            virtual_link_send_disconnect(ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+            break;
+        case VIRTUAL_LINK_W4_CONNECT_RESPONSE:
+            {
+                uint8_t message = HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_CANCEL;
+                virtual_link_send_control(&message, 1);
+            }
+            break;
+        case VIRTUAL_LINK_W4_ACCEPT:
+            virtual_link_send_connect_response(ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES);
+            break;
+        default:
+            break;
+    }
+    virtual_link_closed();
+    virtual_advertising_enabled = false;
+    virtual_page_scan_enabled = false;
+}
+
+static void virtual_handle_command(const uint8_t * packet, uint16_t size){
+    if (size < 3) return;
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+    uint8_t return_parameters[65];
+    uint8_t event[21];
+    hci_con_handle_t con_handle = (size >= 5) ? (little_endian_read_16(params, 0) & 0x0fff) : HCI_CON_HANDLE_INVALID;
+    bool connected = (virtual_link_state == VIRTUAL_LINK_CONNECTED) && (con_handle == virtual_link_con_handle);
+    memset(return_parameters, 0, sizeof(return_parameters));
+
+    switch (opcode){
+        case HCI_OPCODE_HCI_RESET:
+            virtual_reset();
+            virtual_emit_command_complete_status(opcode, ERROR_CODE_SUCCESS);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            return_parameters[1] = 0x0c;    // HCI 5.3
+            return_parameters[4] = 0x0c;    // LMP 5.3
+            little_endian_store_16(return_parameters, 5, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            virtual_emit_command_complete(opcode, return_parameters, 9);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            // Read Buffer Size, Write LE Host Supported
+            return_parameters[1 + 14] = 1 << 7;
+            return_parameters[1 + 24] = 1 << 6;
+            virtual_emit_command_complete(opcode, return_parameters, 65);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            memcpy(&return_parameters[1], virtual_supported_features, 8);
+            virtual_emit_command_complete(opcode, return_parameters, 9);
+            break;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            reverse_bd_addr(virtual_config.bd_addr, &return_parameters[1]);
+            virtual_emit_command_complete(opcode, return_parameters, 7);
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(return_parameters, 1, virtual_config.acl_data_packet_length);
+            little_endian_store_16(return_parameters, 4, virtual_config.num_acl_packets);
+            virtual_emit_command_complete(opcode, return_parameters, 8);
+            break;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_parameters, 1, virtual_config.acl_data_packet_length);
+            return_parameters[3] = virtual_config.num_acl_packets;
+            virtual_emit_command_complete(opcode, return_parameters, 4);
+            break;
+        case HCI_OPCODE_HCI_LE_RAND:
+            little_endian_store_32(return_parameters, 1, virtual_random());
+            little_endian_store_32(return_parameters, 5, virtual_random());
+            virtual_emit_command_complete(opcode, return_parameters, 9);
+            break;
+        case HCI_OPCODE_HCI_LE_ENCRYPT:
+            if (size < (3 + 32)) break;
+            {
+                // key and plaintext are little endian
+                uint8_t key[16];
+                uint8_t block[16];
+                btstack_aes128_t aes128;
+                reverse_128(&params[0], key);
+                reverse_128(&params[16], block);
+                btstack_aes128_init(&aes128, key);
+                btstack_aes128_encrypt_block(&aes128, block, block);
+                reverse_128(block, &return_parameters[1]);
+            }
+            virtual_emit_command_complete(opcode, return_parameters, 17);
+            break;
+        case HCI_OPCODE_HCI_WRITE_SCAN_ENABLE:
+            virtual_page_scan_enabled = (params[0] & 0x02) != 0;
+            virtual_emit_command_complete_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_handle_incoming_request();
+            break;
+        case HCI_OPCODE_HCI_LE_SET_ADVERTISE_ENABLE:
+            virtual_advertising_enabled = params[0] != 0;
+            virtual_emit_command_complete_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_handle_incoming_request();
+            break;
+        case HCI_OPCODE_HCI_CREATE_CONNECTION:
+            virtual_link_create_connection(opcode, false, &params[0]);
+            break;
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION:
+            // scan interval, scan window, filter policy, peer address type, peer address
+            virtual_link_create_connection(opcode, true, &params[6]);
+            break;
+        case HCI_OPCODE_HCI_LE_EXTENDED_CREATE_CONNECTION:
+            // filter policy, own address type, peer address type, peer address
+            virtual_link_create_connection(opcode, true, &params[3]);
+            break;
+        case HCI_OPCODE_HCI_CREATE_CONNECTION_CANCEL:
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION_CANCEL:
+            virtual_link_cancel_connection(opcode);
+            break;
+        case HCI_OPCODE_HCI_ACCEPT_CONNECTION_REQUEST:
+            if (virtual_link_state != VIRTUAL_LINK_W4_ACCEPT){
+                virtual_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_link_state = VIRTUAL_LINK_CONNECTED;
+            virtual_link_send_connect_response(ERROR_CODE_SUCCESS);
+            virtual_emit_connection_complete(ERROR_CODE_SUCCESS);
+            break;
+        case HCI_OPCODE_HCI_REJECT_CONNECTION_REQUEST:
+            if (virtual_link_state != VIRTUAL_LINK_W4_ACCEPT){
+                virtual_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_link_send_connect_response(params[6]);
+            virtual_emit_connection_complete(params[6]);
+            virtual_link_closed();
+            break;
+        case HCI_OPCODE_HCI_DISCONNECT:
+            if (!connected){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_link_send_disconnect(params[2]);
+            virtual_emit_disconnection_complete(ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST);
+            virtual_link_closed();
+            break;
+        case HCI_OPCODE_HCI_READ_REMOTE_SUPPORTED_FEATURES_COMMAND:
+            if (!connected){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+            event[1] = 11;
+            event[2] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 3, con_handle);
+            memcpy(&event[5], virtual_supported_features, 8);
+            virtual_emit_event(event, 13);
+            break;
+        case HCI_OPCODE_HCI_READ_REMOTE_VERSION_INFORMATION:
+            if (!connected){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = HCI_EVENT_READ_REMOTE_VERSION_INFORMATION_COMPLETE;
+            event[1] = 8;
+            event[2] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 3, con_handle);
+            event[5] = 0x0c;
+            little_endian_store_16(event, 6, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            little_endian_store_16(event, 8, 0);
+            virtual_emit_event(event, 10);
+            break;
+        case HCI_OPCODE_HCI_REMOTE_NAME_REQUEST:
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            {
+                uint8_t * name_event = virtual_host_queue_reserve();
+                if (name_event == NULL) break;
+                name_event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+                name_event[1] = 255;
+                name_event[2] = ERROR_CODE_SUCCESS;
+                memcpy(&name_event[3], &params[0], 6);
+                const char * name = "BTstack Virtual";
+                memcpy(&name_event[9], name, strlen(name));
+                virtual_host_queue_commit(HCI_EVENT_PACKET, 257);
+            }
+            break;
+        case HCI_OPCODE_HCI_LE_READ_REMOTE_USED_FEATURES:
+            if (!connected){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = HCI_EVENT_LE_META;
+            event[1] = 12;
+            event[2] = HCI_SUBEVENT_LE_READ_REMOTE_FEATURES_COMPLETE;
+            event[3] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 4, con_handle);
+            memset(&event[6], 0, 8);
+            virtual_emit_event(event, 14);
+            break;
+        case HCI_OPCODE_HCI_LE_CONNECTION_UPDATE:
+            if (!connected){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            // handle, interval min, interval max, latency, supervision timeout
+            event[0] = HCI_EVENT_LE_META;
+            event[1] = 10;
+            event[2] = HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE;
+            event[3] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 4, con_handle);
+            little_endian_store_16(event, 6, little_endian_read_16(params, 4));
+            little_endian_store_16(event, 8, little_endian_read_16(params, 6));
+            little_endian_store_16(event, 10, little_endian_read_16(params, 8));
+            virtual_emit_event(event, 12);
+            break;
+        case HCI_OPCODE_HCI_AUTHENTICATION_REQUESTED:
+        case HCI_OPCODE_HCI_SET_CONNECTION_ENCRYPTION:
+        case HCI_OPCODE_HCI_LE_START_ENCRYPTION:
+        case HCI_OPCODE_HCI_INQUIRY:
+            // not simulated
+            virtual_emit_command_status(opcode, ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE);
+            break;
+        default:
+            virtual_emit_command_complete_status(opcode, ERROR_CODE_SUCCESS);
+            break;
+    }
+}
+
+static void virtual_handle_acl_packet(const uint8_t * packet, uint16_t size){
+    if (virtual_event_active){
+        uint32_t delta_us = (uint32_t) (virtual_time_us() - virtual_event_timestamp_us);
+        virtual_event_active = false;
+        virtual_statistics.event_to_send_count++;
+        virtual_statistics.event_to_send_sum_us += delta_us;
+        virtual_statistics.event_to_send_max_us = btstack_max(virtual_statistics.event_to_send_max_us, delta_us);
+    }
+    if (size < 4) return;
+    hci_con_handle_t con_handle = little_endian_read_16(packet, 0) & 0x0fff;
+    uint16_t payload_len = little_endian_read_16(packet, 2);
+    if ((virtual_link_state != VIRTUAL_LINK_CONNECTED) || (con_handle != virtual_link_con_handle)){
+        log_error("ACL packet for unknown handle 0x%04x", con_handle);
+        return;
+    }
+    if ((payload_len > HCI_ACL_PAYLOAD_SIZE) || ((4u + payload_len) > size)){
+        log_error("invalid ACL packet len %u", payload_len);
+        return;
+    }
+    if (virtual_acl_count == virtual_config.num_acl_packets){
+        log_error("no Controller buffer available");
+        return;
+    }
+    uint16_t index = (virtual_acl_head + virtual_acl_count) % HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS;
+    virtual_acl_buffer_t * acl_buffer = &virtual_acl_buffers[index];
+    acl_buffer->message[0] = HCI_TRANSPORT_VIRTUAL_LINK_ACL;
+    acl_buffer->message[1] = packet[1] >> 4;
+    memcpy(&acl_buffer->message[2], &packet[4], payload_len);
+    acl_buffer->size = 2 + payload_len;
+    acl_buffer->due_ms = btstack_run_loop_get_time_ms() + virtual_config.latency_ms;
+    virtual_acl_count++;
+    virtual_schedule();
+}
+
+// HCI Transport implementation
+
+static void hci_transport_virtual_init(const void * transport_config){
+    if (((const hci_transport_config_t *) transport_config)->type != HCI_TRANSPORT_CONFIG_VIRTUAL){
+        log_error("hci_transport_virtual: config not of type HCI_TRANSPORT_CONFIG_VIRTUAL!");
+        return;
+    }
+    virtual_config = *(const hci_transport_config_virtual_t *) transport_config;
+    virtual_config.num_acl_packets = btstack_min(virtual_config.num_acl_packets, HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS);
+    virtual_config.acl_data_packet_length = btstack_min(virtual_config.acl_data_packet_length, HCI_ACL_PAYLOAD_SIZE);
+    virtual_random_state = (virtual_config.seed != 0) ? virtual_config.seed : 0x42u;
+}
+
+static int hci_transport_virtual_open(void){
+    int flags = fcntl(virtual_config.link_fd, F_GETFL, 0);
+    if ((flags < 0) || (fcntl(virtual_config.link_fd, F_SETFL, flags | O_NONBLOCK) < 0)){
+        log_error("hci_transport_virtual: cannot set link socket non-blocking");
+        return -1;
+    }
+    virtual_host_queue_head = 0;
+    virtual_host_queue_count = 0;
+    virtual_control_head = 0;
+    virtual_control_count = 0;
+    virtual_tx_len = 0;
+    virtual_tx_pos = 0;
+    virtual_rx_pos = 0;
+    virtual_incoming_pending = false;
+    virtual_link_write_blocked = false;
+    virtual_event_active = false;
+    virtual_reset();
+    hci_transport_virtual_reset_statistics();
+
+    btstack_run_loop_set_timer_handler(&virtual_timer, &virtual_timer_handler);
+    btstack_run_loop_set_data_source_fd(&virtual_link_data_source, virtual_config.link_fd);
+    btstack_run_loop_set_data_source_handler(&virtual_link_data_source, &virtual_link_process);
+    btstack_run_loop_enable_data_source_callbacks(&virtual_link_data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&virtual_link_data_source);
+    virtual_link_open = true;
+    return 0;
+}
+
+static int hci_transport_virtual_close(void){
+    btstack_run_loop_remove_timer(&virtual_timer);
+    if (virtual_link_open){
+        virtual_link_open = false;
+        btstack_run_loop_remove_data_source(&virtual_link_data_source);
+    }
+    return 0;
+}
+
+static void hci_transport_virtual_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    virtual_packet_handler = handler;
+}
+
+static int hci_transport_virtual_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            virtual_handle_command(packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            virtual_handle_acl_packet(packet, (uint16_t) size);
+            break;
+        default:
+            log_error("packet type 0x%02x not supported", packet_type);
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t hci_transport_virtual = {
+        /* const char * name; */                                        "Virtual",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_virtual_init,
+        /* int    (*open)(void); */                                     &hci_transport_virtual_open,
+        /* int    (*close)(void); */                                    &hci_transport_virtual_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_virtual_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+        /* int    (*send_packet)(...); */                               &hci_transport_virtual_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+const hci_transport_t * hci_transport_virtual_instance(void){
+    return &hci_transport_virtual;
+}
+
+void hci_transport_virtual_get_statistics(hci_transport_virtual_statistics_t * statistics){
+    *statistics = virtual_statistics;
+}
+
+void hci_transport_virtual_reset_statistics(void){
+    memset(&virtual_statistics, 0, sizeof(virtual_statistics));
+}
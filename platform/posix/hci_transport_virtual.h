@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title HCI Transport Virtual
+ *
+ * Simulated Controller that runs inside the BTstack process. It answers the HCI init sequence, Classic and LE
+ * connection setup as well as Number Of Completed Packets and exchanges ACL data with a single peer over a
+ * stream socket, e.g. one end of a socketpair. The peer can be a second BTstack instance using this transport
+ * in another process or a scripted peer that implements the link protocol below.
+ *
+ * Link messages are prefixed by a 16-bit little endian length, followed by the message type and its parameters:
+ * - HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_REQUEST: link type (0 = Classic, 1 = LE), initiator address (6, bd_addr_t),
+ *   class of device (3, little endian)
+ * - HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_RESPONSE: status, responder address
+ * - HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_CANCEL: -
+ * - HCI_TRANSPORT_VIRTUAL_LINK_DISCONNECT: reason
+ * - HCI_TRANSPORT_VIRTUAL_LINK_ACL: packet boundary + broadcast flags, ACL payload
+ *
+ * An incoming connection request is accepted once the host enables advertising (LE) or page scan (Classic).
+ * Outgoing ACL packets stay in the Controller for the configured latency and occupy a Controller buffer until
+ * they have been passed to the socket. With a loss rate, a packet is retransmitted after another latency period.
+ * Pairing and encryption are not simulated, use security level 0.
+ */
+
+#ifndef HCI_TRANSPORT_VIRTUAL_H
+#define HCI_TRANSPORT_VIRTUAL_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS 16
+
+typedef enum {
+    HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_REQUEST = 1,
+    HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_RESPONSE,
+    HCI_TRANSPORT_VIRTUAL_LINK_CONNECT_CANCEL,
+    HCI_TRANSPORT_VIRTUAL_LINK_DISCONNECT,
+    HCI_TRANSPORT_VIRTUAL_LINK_ACL,
+} hci_transport_virtual_link_message_t;
+
+typedef struct {
+    hci_transport_config_type_t type; // == HCI_TRANSPORT_CONFIG_VIRTUAL
+    bd_addr_t bd_addr;                // public address reported by Read BD_ADDR
+    int       link_fd;                // connected stream socket to peer
+    uint16_t  acl_data_packet_length; // max ACL payload for Classic and LE
+    uint8_t   num_acl_packets;        // Controller buffers for Classic and LE, up to HCI_TRANSPORT_VIRTUAL_MAX_ACL_BUFFERS
+    uint16_t  latency_ms;             // time an ACL packet spends in the Controller before it is sent
+    uint16_t  loss_per_mille;         // probability that a transmission has to be repeated
+    uint32_t  seed;                   // seed for loss simulation and LE Rand
+} hci_transport_config_virtual_t;
+
+typedef struct {
+    uint32_t acl_packets_sent;
+    uint32_t acl_packets_received;
+    uint32_t acl_bytes_sent;
+    uint32_t acl_bytes_received;
+    uint32_t retransmissions;
+    // time from Number Of Completed Packets event until the host sends the next ACL packet
+    uint32_t event_to_send_count;
+    uint64_t event_to_send_sum_us;
+    uint32_t event_to_send_max_us;
+} hci_transport_virtual_statistics_t;
+
+/* API_START */
+
+/*
+ * @brief Get virtual HCI Transport instance, configure with hci_transport_config_virtual_t
+ * @return hci_transport
+ */
+const hci_transport_t * hci_transport_virtual_instance(void);
+
+/*
+ * @brief Get ACL and timing statistics since hci_transport_virtual_reset_statistics or open
+ * @param statistics
+ */
+void hci_transport_virtual_get_statistics(hci_transport_virtual_statistics_t * statistics);
+
+/*
+ * @brief Reset statistics
+ */
+void hci_transport_virtual_reset_statistics(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_TRANSPORT_VIRTUAL_H
@@ -96,6 +96,7 @@ const  char * csv_header = "# addr_type, addr, irk, ltk, ediv, rand[8], key_size
 static char db_path[sizeof(DB_PATH_TEMPLATE) - 2 + 17 + 1];
 
 static le_device_memory_db_t le_devices[LE_DEVICE_MEMORY_SIZE];
+static uint32_t le_device_db_fs_generation;
 
 static char * bd_addr_to_dash_str(bd_addr_t addr){
     return bd_addr_to_str_with_delimiter(addr, '-');
@@ -244,6 +245,7 @@ static void le_device_db_read(void){
     }
 exit:
     fclose(wFile);
+    le_device_db_fs_generation++;
 }
 
 void le_device_db_init(void){
@@ -252,6 +254,7 @@ void le_device_db_init(void){
         le_devices[i].addr_type = BD_ADDR_TYPE_UNKNOWN;
     }
     sprintf(db_path, DB_PATH_TEMPLATE, "00-00-00-00-00-00");
+    le_device_db_fs_generation++;
 }
 
 void le_device_db_set_local_bd_addr(bd_addr_t addr){
@@ -275,9 +278,14 @@ int le_device_db_max_count(void){
     return LE_DEVICE_MEMORY_SIZE;
 }
 
+uint32_t le_device_db_generation(void){
+    return le_device_db_fs_generation;
+}
+
 // free device
 void le_device_db_remove(int index){
     le_devices[index].addr_type = BD_ADDR_TYPE_UNKNOWN;
+    le_device_db_fs_generation++;
     le_device_db_store();
 }
 
@@ -304,6 +312,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 #ifdef ENABLE_LE_SIGNED_WRITE
     le_devices[index].remote_counter = 0; 
 #endif
+    le_device_db_fs_generation++;
     le_device_db_store();
 
     return index;
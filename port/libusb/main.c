@@ -72,6 +72,7 @@
 #include "hci.h"
 #include "hci_dump.h"
 #include "hci_dump_posix_fs.h"
+#include "hci_dump_posix_fs_async.h"
 #include "hci_transport.h"
 #include "hci_transport_usb.h"
 
@@ -226,11 +227,12 @@ void hal_led_toggle(void){
     printf("LED State %u\n", led_state);
 }
 
-static char short_options[] = "hu:l:r";
+static char short_options[] = "hu:l:ar";
 
 static struct option long_options[] = {
     {"help",        no_argument,        NULL,   'h'},
     {"logfile",    required_argument,  NULL,   'l'},
+    {"async-log",  no_argument,        NULL,   'a'},
     {"reset-tlv",    no_argument,       NULL,   'r'},
     {"usbpath",    required_argument,  NULL,   'u'},
     {0, 0, 0, 0}
@@ -239,6 +241,7 @@ static struct option long_options[] = {
 static char *help_options[] = {
     "print (this) help.",
     "set file to store debug output and HCI trace.",
+    "write HCI trace from background thread.",
     "reset bonding information stored in TLV.",
     "set USB path to Bluetooth Controller.",
 };
@@ -247,6 +250,7 @@ static char *option_arg_name[] = {
     "",
     "LOGFILE",
     "",
+    "",
     "USBPATH",
 };
 
@@ -266,6 +270,7 @@ int main(int argc, const char * argv[]){
     int usb_path_len = 0;
     const char * usb_path_string = NULL;
     const char * log_file_path = NULL;
+    bool log_async = false;
 
     // parse command line parameters
     while(true){
@@ -283,6 +288,9 @@ int main(int argc, const char * argv[]){
             case 'l':
                 log_file_path = optarg;
                 break;
+            case 'a':
+                log_async = true;
+                break;
             case 'r':
                 tlv_reset = true;
                 break;
@@ -329,8 +337,16 @@ int main(int argc, const char * argv[]){
         log_file_path = pklg_path;
     }
 
-    hci_dump_posix_fs_open(log_file_path, HCI_DUMP_PACKETLOGGER);
-    const hci_dump_t * hci_dump_impl = hci_dump_posix_fs_get_instance();
+    const hci_dump_t * hci_dump_impl;
+    if (log_async){
+        // packets are written by background thread, pending packets are written on exit
+        hci_dump_posix_fs_async_open(log_file_path, HCI_DUMP_PACKETLOGGER, NULL);
+        hci_dump_impl = hci_dump_posix_fs_async_get_instance();
+        atexit(&hci_dump_posix_fs_async_close);
+    } else {
+        hci_dump_posix_fs_open(log_file_path, HCI_DUMP_PACKETLOGGER);
+        hci_dump_impl = hci_dump_posix_fs_get_instance();
+    }
     hci_dump_init(hci_dump_impl);
     printf("Packet Log: %s\n", log_file_path);
 
@@ -22,6 +22,7 @@
 #define ENABLE_CLASSIC
 #define ENABLE_CROSS_TRANSPORT_KEY_DERIVATION
 #define ENABLE_GOEP_L2CAP
+#define ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
 #define ENABLE_HFP_WIDE_BAND_SPEECH
 #define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 #define ENABLE_L2CAP_LE_CREDIT_BASED_FLOW_CONTROL_MODE
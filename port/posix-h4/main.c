@@ -67,6 +67,9 @@
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_posix.h"
+#ifdef HAVE_BTSTACK_RUN_LOOP_EPOLL
+#include "btstack_run_loop_epoll.h"
+#endif
 #include "btstack_signal.h"
 #include "btstack_stdin.h"
 #include "btstack_tlv_posix.h"
@@ -317,7 +320,11 @@ int main(int argc, const char * argv[]){
     }
     /// GET STARTED with BTstack ///
 	btstack_memory_init();
+#ifdef HAVE_BTSTACK_RUN_LOOP_EPOLL
+    btstack_run_loop_init(btstack_run_loop_epoll_get_instance());
+#else
     btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+#endif
 	    
     // log into file using HCI_DUMP_PACKETLOGGER format
     if (log_file_path == NULL){
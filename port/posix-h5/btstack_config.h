@@ -18,6 +18,7 @@
 #define ENABLE_AVRCP_COVER_ART
 #define ENABLE_BLE
 #define ENABLE_CLASSIC
+#define ENABLE_CRC_SLICE_BY_8
 #define ENABLE_GOEP_L2CAP
 #define ENABLE_H5
 #define ENABLE_HFP_WIDE_BAND_SPEECH
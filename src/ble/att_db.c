@@ -86,6 +86,7 @@ static uint16_t uuid16_from_uuid(uint16_t uuid_len, uint8_t * uuid){
 typedef struct att_iterator {
     // private
     uint8_t const * att_ptr;
+    uint16_t index;
     // public
     uint16_t size;
     uint16_t flags;
@@ -107,8 +108,150 @@ static uint16_t att_prepare_write_error_handle = 0x0000;
 static uint16_t att_persistent_ccc_handle;
 static uint16_t att_persistent_ccc_uuid16;
 
+#ifdef MAX_ATT_DB_INDEX_SIZE
+// ATT DB index: handle, offset into att_database and 16-bit UUID (0 for non-SIG 128-bit UUIDs) of each attribute,
+// stored as separate arrays to allow for tight scan loops. att_db_index_offset[att_db_index_count] points to end tag
+static uint16_t att_db_index_handle[MAX_ATT_DB_INDEX_SIZE];
+static uint16_t att_db_index_uuid16[MAX_ATT_DB_INDEX_SIZE];
+static uint16_t att_db_index_offset[MAX_ATT_DB_INDEX_SIZE + 1];
+static uint16_t att_db_index_count;
+static bool     att_db_index_valid;
+static bool     att_db_index_dirty;
+
+static void att_db_index_build(void){
+    att_db_index_valid = false;
+    att_db_index_dirty = false;
+    if (att_database == NULL){
+        return;
+    }
+    uint16_t count = 0;
+    uint32_t offset = 0;
+    uint16_t prev_handle = 0;
+    while (true){
+        if (offset > 0xffffu){
+            log_info("ATT DB index: db too large, index not used");
+            return;
+        }
+        uint16_t size = little_endian_read_16(att_database, offset);
+        if (size == 0u){
+            break;
+        }
+        if (count == (uint16_t) MAX_ATT_DB_INDEX_SIZE){
+            log_info("ATT DB index: more than %u attributes, index not used", (uint16_t) MAX_ATT_DB_INDEX_SIZE);
+            return;
+        }
+        uint16_t flags  = little_endian_read_16(att_database, offset + 2u);
+        uint16_t handle = little_endian_read_16(att_database, offset + 4u);
+        // binary search requires strictly ascending handles
+        if (handle <= prev_handle){
+            log_info("ATT DB index: handles not ascending, index not used");
+            return;
+        }
+        uint8_t const * uuid = &att_database[offset + 6u];
+        uint16_t uuid16;
+        if ((flags & (uint16_t)ATT_PROPERTY_UUID128) == 0u){
+            uuid16 = little_endian_read_16(uuid, 0);
+        } else if (is_Bluetooth_Base_UUID(uuid)){
+            uuid16 = little_endian_read_16(uuid, 12);
+        } else {
+            uuid16 = 0;
+        }
+        att_db_index_handle[count] = handle;
+        att_db_index_uuid16[count] = uuid16;
+        att_db_index_offset[count] = (uint16_t) offset;
+        count++;
+        prev_handle = handle;
+        offset += size;
+    }
+    att_db_index_offset[count] = (uint16_t) offset;
+    att_db_index_count = count;
+    att_db_index_valid = true;
+    log_info("ATT DB index: %u attributes", count);
+}
+
+static bool att_db_index_ready(void){
+    if (att_db_index_dirty){
+        att_db_index_build();
+    }
+    return att_db_index_valid;
+}
+
+// returns position of first attribute with handle >= given handle, or att_db_index_count
+static uint16_t att_db_index_lower_bound(uint16_t handle){
+    uint16_t low  = 0;
+    uint16_t high = att_db_index_count;
+    while (low < high){
+        uint16_t mid = low + ((high - low) >> 1);
+        if (att_db_index_handle[mid] < handle){
+            low = mid + 1u;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// returns position of first attribute at or after pos with 16-bit UUID a or b, or att_db_index_count
+static uint16_t att_db_index_find_uuid16(uint16_t pos, uint16_t uuid16_a, uint16_t uuid16_b){
+    const uint16_t * uuids = att_db_index_uuid16;
+    uint16_t count = att_db_index_count;
+    while (pos < count){
+        uint16_t uuid16 = uuids[pos];
+        if ((uuid16 == uuid16_a) || (uuid16 == uuid16_b)){
+            break;
+        }
+        pos++;
+    }
+    return pos;
+}
+#endif
+
 static void att_iterator_init(att_iterator_t *it){
     it->att_ptr = att_database;
+    it->index = 0;
+    it->handle = 0;
+}
+
+// init iterator to start at the first attribute with handle >= start_handle
+// without index, the caller skips attributes with lower handles
+static void att_iterator_seek(att_iterator_t *it, uint16_t start_handle){
+    att_iterator_init(it);
+#ifdef MAX_ATT_DB_INDEX_SIZE
+    if (att_db_index_ready()){
+        it->index = att_db_index_lower_bound(start_handle);
+        it->att_ptr = &att_database[att_db_index_offset[it->index]];
+    }
+#else
+    UNUSED(start_handle);
+#endif
+}
+
+// skip attributes that cannot match one of the given 16-bit UUIDs (use 0 for non-SIG 128-bit UUIDs)
+// does not skip over attributes after end_handle to the end of the db, as callers treat end of db as end of group
+// returns handle of the attribute before the next one returned by att_iterator_fetch_next
+// without index, this is a no-op and the caller has to check each attribute
+static uint16_t att_iterator_skip_to_uuid16(att_iterator_t *it, uint16_t end_handle, uint16_t uuid16_a, uint16_t uuid16_b){
+#ifdef MAX_ATT_DB_INDEX_SIZE
+    if ((it->att_ptr != NULL) && att_db_index_ready()){
+        uint16_t pos = att_db_index_find_uuid16(it->index, uuid16_a, uuid16_b);
+        if ((pos == att_db_index_count) && (pos > 0u) && (att_db_index_handle[pos - 1u] > end_handle)){
+            // stop at first attribute after end_handle, but never move backwards
+            uint16_t pos_after_end = att_db_index_lower_bound(end_handle + 1u);
+            pos = (pos_after_end > it->index) ? pos_after_end : it->index;
+        }
+        it->index = pos;
+        it->att_ptr = &att_database[att_db_index_offset[pos]];
+        if (pos > 0u){
+            return att_db_index_handle[pos - 1u];
+        }
+        return 0;
+    }
+#else
+    UNUSED(end_handle);
+    UNUSED(uuid16_a);
+    UNUSED(uuid16_b);
+#endif
+    return it->handle;
 }
 
 static bool att_iterator_has_next(att_iterator_t *it){
@@ -139,6 +282,7 @@ static void att_iterator_fetch_next(att_iterator_t *it){
     }
     // advance AFTER setting values
     it->att_ptr += it->size;
+    it->index++;
 }
 
 static int att_iterator_match_uuid16(att_iterator_t *it, uint16_t uuid){
@@ -178,6 +322,19 @@ static int att_find_handle(att_iterator_t *it, uint16_t handle){
     if (handle == 0u){
         return 0u;
     }
+#ifdef MAX_ATT_DB_INDEX_SIZE
+    if (att_db_index_ready()){
+        uint16_t pos = att_db_index_lower_bound(handle);
+        if ((pos == att_db_index_count) || (att_db_index_handle[pos] != handle)){
+            return 0;
+        }
+        att_iterator_init(it);
+        it->index = pos;
+        it->att_ptr = &att_database[att_db_index_offset[pos]];
+        att_iterator_fetch_next(it);
+        return 1;
+    }
+#endif
     att_iterator_init(it);
     while (att_iterator_has_next(it)){
         att_iterator_fetch_next(it);
@@ -237,6 +394,16 @@ void att_set_db(uint8_t const * db){
     log_info("att_set_db %p", db);
     // ignore db version
     att_database = &db[1];
+#ifdef MAX_ATT_DB_INDEX_SIZE
+    att_db_index_build();
+#endif
+}
+
+void att_db_modified(void){
+#ifdef MAX_ATT_DB_INDEX_SIZE
+    // rebuild index on next access
+    att_db_index_dirty = true;
+#endif
 }
 
 void att_set_read_callback(att_read_callback_t callback){
@@ -441,7 +608,7 @@ static uint16_t handle_find_information_request2(att_connection_t * att_connecti
     uint16_t uuid_len = 0;
     
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (!it.handle){
@@ -546,7 +713,7 @@ static uint16_t handle_find_by_type_value_request(att_connection_t * att_connect
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
 
@@ -611,11 +778,13 @@ static uint16_t handle_read_by_type_request2(att_connection_t * att_connection,
     uint16_t pair_len = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     uint8_t error_code = 0;
     uint16_t first_matching_but_unreadable_handle = 0;
+    uint16_t uuid16 = uuid16_from_uuid(attribute_type_len, attribute_type);
 
     while (att_iterator_has_next(&it)){
+        (void) att_iterator_skip_to_uuid16(&it, end_handle, uuid16, uuid16);
         att_iterator_fetch_next(&it);
         
         if ((it.handle == 0u ) || (it.handle > end_handle)){
@@ -851,10 +1020,12 @@ static uint16_t handle_read_blob_request(att_connection_t * att_connection, uint
 
 //
 // MARK: ATT_READ_MULTIPLE_REQUEST 0x0e
+// MARK: ATT_READ_MULTIPLE_VARIABLE_REQ 0x20
 //
-static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles){
-    log_info("ATT_READ_MULTIPLE_REQUEST: num handles %u", num_handles);
-    uint8_t request_type = ATT_READ_MULTIPLE_REQUEST;
+// with store_length, values are stored as Length Value Tuples and the last one is truncated to fit
+static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles, bool store_length){
+    log_info("ATT_READ_MULTIPLE_REQUEST: num handles %u, variable %u", num_handles, (int) store_length);
+    uint8_t request_type = store_length ? ATT_READ_MULTIPLE_VARIABLE_REQ : ATT_READ_MULTIPLE_REQUEST;
     
     uint16_t offset   = 1;
 
@@ -909,6 +1080,15 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
             break;
         }
 
+        // store length, skip value if it doesn't fit
+        if (store_length){
+            if ((offset + 2u) > response_buffer_size){
+                continue;
+            }
+            little_endian_store_16(response_buffer, offset, it.value_len);
+            offset += 2u;
+        }
+
         // store
         uint16_t bytes_copied = att_copy_value(&it, 0, response_buffer + offset, response_buffer_size - offset, att_connection->con_handle);
         offset += bytes_copied;
@@ -918,19 +1098,22 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
         return setup_error(response_buffer, request_type, handle, error_code);
     }
     
-    response_buffer[0] = (uint8_t)ATT_READ_MULTIPLE_RESPONSE;
+    response_buffer[0] = store_length ? (uint8_t)ATT_READ_MULTIPLE_VARIABLE_RSP : (uint8_t)ATT_READ_MULTIPLE_RESPONSE;
     return offset;
 }
 static uint16_t handle_read_multiple_request(att_connection_t * att_connection, uint8_t * request_buffer,  uint16_t request_len,
                                       uint8_t * response_buffer, uint16_t response_buffer_size){
 
+    uint8_t request_type = request_buffer[0];
+
     // 1 byte opcode + two or more attribute handles (2 bytes each)
     if ( (request_len < 5u) || ((request_len & 1u) == 0u) ){
-        return setup_error_invalid_pdu(response_buffer, ATT_READ_MULTIPLE_REQUEST);
+        return setup_error_invalid_pdu(response_buffer, request_type);
     }
 
     int num_handles = (request_len - 1u) >> 1u;
-    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1]);
+    bool store_length = request_type == ATT_READ_MULTIPLE_VARIABLE_REQ;
+    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1], store_length);
 }
 
 //
@@ -977,8 +1160,10 @@ static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connec
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
+        // attributes within a group only update prev_handle
+        prev_handle = att_iterator_skip_to_uuid16(&it, end_handle, GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID);
         att_iterator_fetch_next(&it);
         
         if ((it.handle != 0u) && (it.handle < start_handle)){
@@ -1287,6 +1472,31 @@ uint16_t att_prepare_handle_value_indication(att_connection_t * att_connection,
     response_buffer[0] = ATT_HANDLE_VALUE_INDICATION;
     return prepare_handle_value(att_connection, attribute_handle, value, value_len, response_buffer);
 }
+
+// MARK: ATT_MULTIPLE_HANDLE_VALUE_NTF 0x23
+uint16_t att_prepare_handle_value_multiple_notification(att_connection_t * att_connection,
+                                                        uint8_t num_attributes,
+                                                        const uint16_t * attribute_handles,
+                                                        const uint8_t ** values_data,
+                                                        const uint16_t * values_len,
+                                                        uint8_t * response_buffer){
+
+    response_buffer[0] = ATT_MULTIPLE_HANDLE_VALUE_NTF;
+    uint16_t offset = 1;
+    uint8_t i;
+    for (i = 0; i < num_attributes; i++){
+        // Handle Length Value Tuples are not truncated, stop at first one that does not fit
+        uint16_t value_len = values_len[i];
+        if ((offset + 4u + value_len) > att_connection->mtu){
+            break;
+        }
+        little_endian_store_16(response_buffer, offset, attribute_handles[i]);
+        little_endian_store_16(response_buffer, offset + 2u, value_len);
+        (void)memcpy(&response_buffer[offset + 4u], values_data[i], value_len);
+        offset += 4u + value_len;
+    }
+    return offset;
+}
     
 // MARK: Dispatcher
 uint16_t att_handle_request(att_connection_t * att_connection,
@@ -1317,6 +1527,7 @@ uint16_t att_handle_request(att_connection_t * att_connection,
             response_len = handle_read_blob_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
         case ATT_READ_MULTIPLE_REQUEST:  
+        case ATT_READ_MULTIPLE_VARIABLE_REQ:
             response_len = handle_read_multiple_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
         case ATT_READ_BY_GROUP_TYPE_REQUEST:  
@@ -1359,6 +1570,7 @@ bool gatt_server_get_handle_range_for_service_with_uuid16(uint16_t uuid16, uint1
     att_iterator_t it;
     att_iterator_init(&it);
     while (att_iterator_has_next(&it)){
+        prev_handle = att_iterator_skip_to_uuid16(&it, 0xffff, GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID);
         att_iterator_fetch_next(&it);
         int new_service_started = att_iterator_match_uuid16(&it, GATT_PRIMARY_SERVICE_UUID) || att_iterator_match_uuid16(&it, GATT_SECONDARY_SERVICE_UUID);
 
@@ -1389,8 +1601,9 @@ bool gatt_server_get_handle_range_for_service_with_uuid16(uint16_t uuid16, uint1
 // returns false if not found
 uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
+        (void) att_iterator_skip_to_uuid16(&it, end_handle, uuid16, uuid16);
         att_iterator_fetch_next(&it);
         if ((it.handle != 0u) && (it.handle < start_handle)){
             continue;
@@ -1410,9 +1623,12 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t st
 
 uint16_t gatt_server_get_descriptor_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t characteristic_uuid16, uint16_t descriptor_uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     bool characteristic_found = false;
     while (att_iterator_has_next(&it)){
+        if (!characteristic_found){
+            (void) att_iterator_skip_to_uuid16(&it, end_handle, characteristic_uuid16, characteristic_uuid16);
+        }
         att_iterator_fetch_next(&it);
         if ((it.handle != 0u) && (it.handle < start_handle)){
             continue;
@@ -1464,6 +1680,7 @@ bool gatt_server_get_handle_range_for_service_with_uuid128(const uint8_t * uuid1
     att_iterator_t it;
     att_iterator_init(&it);
     while (att_iterator_has_next(&it)){
+        prev_handle = att_iterator_skip_to_uuid16(&it, 0xffff, GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID);
         att_iterator_fetch_next(&it);
         int new_service_started = att_iterator_match_uuid16(&it, GATT_PRIMARY_SERVICE_UUID) || att_iterator_match_uuid16(&it, GATT_SECONDARY_SERVICE_UUID);
 
@@ -1490,9 +1707,11 @@ bool gatt_server_get_handle_range_for_service_with_uuid128(const uint8_t * uuid1
 uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128){
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
+    uint16_t uuid16 = uuid16_from_uuid(16, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
+        (void) att_iterator_skip_to_uuid16(&it, end_handle, uuid16, uuid16);
         att_iterator_fetch_next(&it);
         if ((it.handle != 0u) && (it.handle < start_handle)){
             continue;
@@ -1514,10 +1733,14 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t s
 uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uuid128(uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128){
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
+    uint16_t uuid16 = uuid16_from_uuid(16, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
+        if (characteristic_found == 0){
+            (void) att_iterator_skip_to_uuid16(&it, end_handle, uuid16, uuid16);
+        }
         att_iterator_fetch_next(&it);
         if ((it.handle != 0u) && (it.handle < start_handle)){
             continue;
@@ -1552,8 +1775,9 @@ bool gatt_server_get_included_service_with_uuid16(uint16_t start_handle, uint16_
     uint16_t * out_included_service_handle, uint16_t * out_included_service_start_handle, uint16_t * out_included_service_end_handle){
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it)){
+        (void) att_iterator_skip_to_uuid16(&it, end_handle, GATT_INCLUDE_SERVICE_UUID, GATT_INCLUDE_SERVICE_UUID);
         att_iterator_fetch_next(&it);
         if ((it.handle != 0u) && (it.handle < start_handle)){
             continue;
@@ -1700,7 +1924,7 @@ uint16_t btp_att_get_attributes_by_uuid16(uint16_t start_handle, uint16_t end_ha
     uint16_t pos = 1;
 
     att_iterator_t  it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it) && ((pos + 6) < response_buffer_size)){
         att_iterator_fetch_next(&it);
         log_info("handle %04x", it.handle);
@@ -1731,7 +1955,7 @@ uint16_t btp_att_get_attributes_by_uuid128(uint16_t start_handle, uint16_t end_h
     uint8_t num_attributes = 0;
     uint16_t pos = 1;
     att_iterator_t  it;
-    att_iterator_init(&it);
+    att_iterator_seek(&it, start_handle);
     while (att_iterator_has_next(&it) && ((pos + 20) < response_buffer_size)){
         att_iterator_fetch_next(&it);
         if (it.handle == 0){
@@ -181,6 +181,12 @@ typedef struct att_service_handler {
  */
 void att_set_db(uint8_t const * db);
 
+/**
+ * @brief notify ATT DB that the content of the current database has been modified in place, e.g. by att_db_util
+ * @note only needed if MAX_ATT_DB_INDEX_SIZE is defined, the index is rebuilt on next access
+ */
+void att_db_modified(void);
+
 /*
  * @brief set callback for read of dynamic attributes
  * @param callback
@@ -239,6 +245,24 @@ uint16_t att_prepare_handle_value_indication(att_connection_t * att_connection,
                                              uint16_t value_len, 
                                              uint8_t * response_buffer);
 
+/**
+ * @brief setup multiple handle value notification in response buffer for given handles and values
+ * @note values are packed in order as long as they fit into the MTU
+ * @param att_connection
+ * @param num_attributes
+ * @param attribute_handles
+ * @param values_data
+ * @param values_len
+ * @param response_buffer for notification
+ * @return size of notification, 1 if no value fits
+ */
+uint16_t att_prepare_handle_value_multiple_notification(att_connection_t * att_connection,
+                                                        uint8_t num_attributes,
+                                                        const uint16_t * attribute_handles,
+                                                        const uint8_t ** values_data,
+                                                        const uint16_t * values_len,
+                                                        uint8_t * response_buffer);
+
 /**
  * @brief transcation queue of prepared writes, e.g., after disconnect
  * @return att_connection
@@ -69,6 +69,8 @@ static void att_db_util_set_end_tag(void){
 	// end tag
 	att_db[att_db_size] = 0u;
 	att_db[att_db_size+1u] = 0u;
+	// db might be in use by ATT Server
+	att_db_modified();
 }
 
 void att_db_util_init(void){
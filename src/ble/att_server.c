@@ -75,13 +75,13 @@
 #define NVN_NUM_GATT_SERVER_CCC 20
 #endif
 
-static void att_run_for_context(hci_connection_t * hci_connection);
+static void att_run_for_context(att_server_t * att_server, att_connection_t * att_connection);
 static att_write_callback_t att_server_write_callback_for_handle(uint16_t handle);
 static btstack_packet_handler_t att_server_packet_handler_for_handle(uint16_t handle);
 static void att_server_handle_can_send_now(void);
 static void att_server_persistent_ccc_restore(hci_connection_t * hci_connection);
 static void att_server_persistent_ccc_clear(hci_connection_t * hci_connection);
-static void att_server_handle_att_pdu(hci_connection_t * hci_connection, uint8_t * packet, uint16_t size);
+static void att_server_handle_att_pdu(att_server_t * att_server, att_connection_t * att_connection, uint8_t * packet, uint16_t size);
 
 typedef enum {
     ATT_SERVER_RUN_PHASE_1_REQUESTS = 0,
@@ -110,6 +110,25 @@ static att_write_callback_t                   att_server_client_write_callback;
 // round robin
 static hci_con_handle_t att_server_last_can_send_now = HCI_CON_HANDLE_INVALID;
 
+#ifdef ENABLE_GATT_OVER_EATT
+typedef struct {
+    btstack_linked_item_t item;
+    att_server_t          att_server;
+    att_connection_t      att_connection;
+    uint8_t *             receive_buffer;
+} att_server_eatt_bearer_t;
+
+static btstack_linked_list_t att_server_eatt_bearer_pool;
+static btstack_linked_list_t att_server_eatt_bearer_active;
+static uint16_t              att_server_eatt_mtu;
+
+// EATT bearer of request currently handled by att_handle_request, 0 for unenhanced bearer
+static uint16_t              att_server_eatt_request_cid;
+
+static void att_server_eatt_update_security(hci_connection_t * hci_connection);
+static att_server_eatt_bearer_t * att_server_eatt_bearer_for_cid(uint16_t cid);
+#endif
+
 #ifdef ENABLE_LE_SIGNED_WRITE
 static hci_connection_t * hci_connection_for_state(att_server_state_t state){
     btstack_linked_list_iterator_t it;
@@ -123,26 +142,35 @@ static hci_connection_t * hci_connection_for_state(att_server_state_t state){
 }
 #endif
 
-static void att_server_request_can_send_now(hci_connection_t * hci_connection){
+static void att_server_request_can_send_now(att_server_t * att_server, att_connection_t * att_connection){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (att_server->eatt_cid != 0){
+        l2cap_request_can_send_now_event(att_server->eatt_cid);
+        return;
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
-    att_server_t * att_server = &hci_connection->att_server;
     if (att_server->l2cap_cid != 0){
         l2cap_request_can_send_now_event(att_server->l2cap_cid);
         return;
     }
 #endif
-    att_connection_t * att_connection = &hci_connection->att_connection;
+    UNUSED(att_server);
     att_dispatch_server_request_can_send_now_event(att_connection->con_handle);
 }
 
-static bool att_server_can_send_packet(hci_connection_t * hci_connection){
+static bool att_server_can_send_packet(att_server_t * att_server, att_connection_t * att_connection){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (att_server->eatt_cid != 0){
+        return l2cap_can_send_packet_now(att_server->eatt_cid);
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
-    att_server_t * att_server = &hci_connection->att_server;
     if (att_server->l2cap_cid != 0){
         return l2cap_can_send_packet_now(att_server->l2cap_cid) != 0;
     }
 #endif
-    att_connection_t * att_connection = &hci_connection->att_connection;
+    UNUSED(att_server);
     return att_dispatch_server_can_send_now(att_connection->con_handle) != 0;
 }
 
@@ -371,7 +399,10 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                             att_server_persistent_ccc_restore(hci_connection);
                         } 
                     }
-                    att_run_for_context(hci_connection);
+                    att_run_for_context(&hci_connection->att_server, &hci_connection->att_connection);
+#ifdef ENABLE_GATT_OVER_EATT
+                    att_server_eatt_update_security(hci_connection);
+#endif
                     break;
 
                 case HCI_EVENT_DISCONNECTION_COMPLETE:
@@ -415,7 +446,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server->ir_lookup_active = 0;
                     att_server->ir_le_device_db_index = sm_event_identity_resolving_succeeded_get_index(packet);
                     log_info("SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED");
-                    att_run_for_context(hci_connection);
+                    att_run_for_context(&hci_connection->att_server, &hci_connection->att_connection);
                     break;
                 case SM_EVENT_IDENTITY_RESOLVING_FAILED:
                     con_handle = sm_event_identity_resolving_failed_get_handle(packet);
@@ -426,7 +457,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     log_info("SM_EVENT_IDENTITY_RESOLVING_FAILED");
                     att_server->ir_lookup_active = 0;
                     att_server->ir_le_device_db_index = -1;
-                    att_run_for_context(hci_connection);
+                    att_run_for_context(&hci_connection->att_server, &hci_connection->att_connection);
                     break;
 
                 // Pairing started - delete stored CCC values
@@ -458,7 +489,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server = &hci_connection->att_server;
                     att_server->pairing_active = 0;
                     att_server->ir_le_device_db_index = sm_event_identity_created_get_index(packet);
-                    att_run_for_context(hci_connection);
+                    att_run_for_context(&hci_connection->att_server, &hci_connection->att_connection);
                     break;
 
                 // Pairing complete (with/without bonding=storing of pairing information)
@@ -469,7 +500,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_connection = &hci_connection->att_connection;
                     att_server = &hci_connection->att_server;
                     att_server->pairing_active = 0;
-                    att_run_for_context(hci_connection);
+                    att_run_for_context(&hci_connection->att_server, &hci_connection->att_connection);
                     break;
 
                 // Authorization
@@ -480,7 +511,10 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_connection = &hci_connection->att_connection;
                     att_server = &hci_connection->att_server;
                     att_connection->authorized = sm_event_authorization_result_get_authorization_result(packet);
-                    att_server_request_can_send_now(hci_connection);
+                    att_server_request_can_send_now(&hci_connection->att_server, &hci_connection->att_connection);
+#ifdef ENABLE_GATT_OVER_EATT
+                    att_server_eatt_update_security(hci_connection);
+#endif
                 	break;
                 }
                 default:
@@ -494,7 +528,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                 hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
                 att_server = &hci_connection->att_server;
                 if (att_server->l2cap_cid == channel) {
-                    att_server_handle_att_pdu(hci_connection, packet, size);
+                    att_server_handle_att_pdu(&hci_connection->att_server, &hci_connection->att_connection, packet, size);
                     break;
                 }
             }
@@ -532,20 +566,56 @@ static void att_signed_write_handle_cmac_result(uint8_t hash[8]){
     uint32_t counter_packet = little_endian_read_32(att_server->request_buffer, att_server->request_size-12);
     le_device_db_remote_counter_set(att_server->ir_le_device_db_index, counter_packet+1);
     att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
-    att_server_request_can_send_now(hci_connection);
+    att_server_request_can_send_now(&hci_connection->att_server, &hci_connection->att_connection);
+}
+#endif
+
+static uint8_t * att_server_reserve_response_buffer(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    // EATT bearer uses own buffer, which is owned by L2CAP until the SDU was sent
+    if (att_server->eatt_cid != 0u){
+        return att_server->eatt_send_buffer;
+    }
+#endif
+    UNUSED(att_server);
+    l2cap_reserve_packet_buffer();
+    return l2cap_get_outgoing_buffer();
 }
+
+static void att_server_release_response_buffer(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (att_server->eatt_cid != 0u){
+        return;
+    }
 #endif
+    UNUSED(att_server);
+    l2cap_release_packet_buffer();
+}
 
 // pre: att_server->state == ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED
 // pre: can send now
 // returns: 1 if packet was sent
-static int att_server_process_validated_request(hci_connection_t * hci_connection){
-    att_server_t * att_server = & hci_connection->att_server;
-    att_connection_t * att_connection = &hci_connection->att_connection;
-
-    l2cap_reserve_packet_buffer();
-    uint8_t * att_response_buffer = l2cap_get_outgoing_buffer();
-    uint16_t  att_response_size   = att_handle_request(att_connection, att_server->request_buffer, att_server->request_size, att_response_buffer);
+static int att_server_process_validated_request(att_server_t * att_server, att_connection_t * att_connection){
+
+    uint8_t * att_response_buffer = att_server_reserve_response_buffer(att_server);
+    uint16_t  att_response_size;
+
+#ifdef ENABLE_GATT_OVER_EATT
+    // provide bearer to read/write callbacks
+    att_server_eatt_request_cid = att_server->eatt_cid;
+
+    // ATT_MTU of EATT bearer is fixed by L2CAP, MTU Exchange is only allowed on unenhanced bearer
+    if ((att_server->eatt_cid != 0u) && (att_server->request_buffer[0] == ATT_EXCHANGE_MTU_REQUEST)){
+        att_response_buffer[0] = ATT_ERROR_RESPONSE;
+        att_response_buffer[1] = ATT_EXCHANGE_MTU_REQUEST;
+        little_endian_store_16(att_response_buffer, 2, 0);
+        att_response_buffer[4] = ATT_ERROR_REQUEST_NOT_SUPPORTED;
+        att_response_size = 5;
+    } else
+#endif
+    {
+        att_response_size = att_handle_request(att_connection, att_server->request_buffer, att_server->request_size, att_response_buffer);
+    }
 
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
     if ((att_response_size == ATT_READ_RESPONSE_PENDING) || (att_response_size == ATT_INTERNAL_WRITE_RESPONSE_PENDING)){
@@ -556,12 +626,18 @@ static int att_server_process_validated_request(hci_connection_t * hci_connectio
         if (att_response_size == ATT_READ_RESPONSE_PENDING){
             att_server_client_read_callback(att_connection->con_handle, ATT_READ_RESPONSE_PENDING, 0, NULL, 0);
         }
+#ifdef ENABLE_GATT_OVER_EATT
+        att_server_eatt_request_cid = 0;
+#endif
 
         // free reserved buffer
-        l2cap_release_packet_buffer();
+        att_server_release_response_buffer(att_server);
         return 0;
     }
 #endif
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_request_cid = 0;
+#endif
 
     // intercept "insufficient authorization" for authenticated connections to allow for user authorization
     if ((att_response_size     >= 4u)
@@ -571,11 +647,11 @@ static int att_server_process_validated_request(hci_connection_t * hci_connectio
 
         switch (gap_authorization_state(att_connection->con_handle)){
             case AUTHORIZATION_UNKNOWN:
-                l2cap_release_packet_buffer();
+                att_server_release_response_buffer(att_server);
                 sm_request_pairing(att_connection->con_handle);
                 return 0;
             case AUTHORIZATION_PENDING:
-                l2cap_release_packet_buffer();
+                att_server_release_response_buffer(att_server);
                 return 0;
             default:
                 break;
@@ -584,10 +660,15 @@ static int att_server_process_validated_request(hci_connection_t * hci_connectio
 
     att_server->state = ATT_SERVER_IDLE;
     if (att_response_size == 0u) {
-        l2cap_release_packet_buffer();
+        att_server_release_response_buffer(att_server);
         return 0;
     }
 
+#ifdef ENABLE_GATT_OVER_EATT
+    if (att_server->eatt_cid != 0u){
+        l2cap_send(att_server->eatt_cid, att_response_buffer, att_response_size);
+    } else
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0u){
         l2cap_send_prepared(att_server->l2cap_cid, att_response_size);
@@ -605,25 +686,64 @@ static int att_server_process_validated_request(hci_connection_t * hci_connectio
 }
 
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
+static uint8_t att_server_response_ready_for_bearer(att_server_t * att_server, att_connection_t * att_connection){
+    if (att_server->state != ATT_SERVER_RESPONSE_PENDING)   return ERROR_CODE_COMMAND_DISALLOWED;
+
+    att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
+    att_server_request_can_send_now(att_server, att_connection);
+    return ERROR_CODE_SUCCESS;
+}
+
 uint8_t att_server_response_ready(hci_con_handle_t con_handle){
     hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
     if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
-    att_server_t * att_server = &hci_connection->att_server;
+    uint8_t status = att_server_response_ready_for_bearer(&hci_connection->att_server, &hci_connection->att_connection);
 
-    if (att_server->state != ATT_SERVER_RESPONSE_PENDING)   return ERROR_CODE_COMMAND_DISALLOWED;
+#ifdef ENABLE_GATT_OVER_EATT
+    // retry all pending requests on EATT bearers, callbacks return ATT_READ_RESPONSE_PENDING again if not ready
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_bearer->att_connection.con_handle != con_handle) continue;
+        if (att_server_response_ready_for_bearer(&eatt_bearer->att_server, &eatt_bearer->att_connection) == ERROR_CODE_SUCCESS){
+            status = ERROR_CODE_SUCCESS;
+        }
+    }
+#endif
 
-    att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
-    att_server_request_can_send_now(hci_connection);
-    return ERROR_CODE_SUCCESS;
+    return status;
+}
+
+#ifdef ENABLE_GATT_OVER_EATT
+uint16_t att_server_eatt_get_request_cid(void){
+    return att_server_eatt_request_cid;
 }
+
+uint8_t att_server_eatt_response_ready(hci_con_handle_t con_handle, uint16_t eatt_cid){
+    hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
+    if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (eatt_cid == 0u){
+        return att_server_response_ready_for_bearer(&hci_connection->att_server, &hci_connection->att_connection);
+    }
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_cid(eatt_cid);
+    if ((eatt_bearer == NULL) || (eatt_bearer->att_connection.con_handle != con_handle)){
+        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    }
+    return att_server_response_ready_for_bearer(&eatt_bearer->att_server, &eatt_bearer->att_connection);
+}
+#endif
 #endif
 
-static void att_run_for_context(hci_connection_t * hci_connection){
-    att_server_t * att_server = &hci_connection->att_server;
-    att_connection_t * att_connection = &hci_connection->att_connection;
+static void att_run_for_context(att_server_t * att_server, att_connection_t * att_connection){
     switch (att_server->state){
         case ATT_SERVER_REQUEST_RECEIVED:
 
+#ifdef ENABLE_GATT_OVER_EATT
+            if (att_server->eatt_cid != 0){
+                // ok, EATT bearer requires encrypted connection
+            } else
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
             if (att_server->l2cap_cid != 0){
                 // ok
@@ -682,7 +802,7 @@ static void att_run_for_context(hci_connection_t * hci_connection){
 #endif
             // move on
             att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
-            att_server_request_can_send_now(hci_connection);
+            att_server_request_can_send_now(att_server, att_connection);
             break;
 
         default:
@@ -709,7 +829,7 @@ static void att_server_trigger_send_for_phase(hci_connection_t * hci_connection,
     att_server_t * att_server = &hci_connection->att_server;
     switch (phase){
         case ATT_SERVER_RUN_PHASE_1_REQUESTS:
-            att_server_process_validated_request(hci_connection);
+            att_server_process_validated_request(att_server, &hci_connection->att_connection);
             break;
         case ATT_SERVER_RUN_PHASE_2_INDICATIONS:
             client = (btstack_context_callback_registration_t*) att_server->indication_requests;
@@ -764,7 +884,7 @@ static void att_server_handle_can_send_now(void){
                     if (can_send_now){
                         att_server_trigger_send_for_phase(connection, phase);
                         last_send_con_handle = att_connection->con_handle;
-                        can_send_now = att_server_can_send_packet(connection);
+                        can_send_now = att_server_can_send_packet(att_server, att_connection);
                         data_ready = att_server_data_ready_for_phase(att_server, phase);
                         if (data_ready && (request_hci_connection == NULL)){
                             request_hci_connection = connection;
@@ -795,12 +915,10 @@ static void att_server_handle_can_send_now(void){
     }
 
     if (request_hci_connection == NULL) return;
-    att_server_request_can_send_now(request_hci_connection);
+    att_server_request_can_send_now(&request_hci_connection->att_server, &request_hci_connection->att_connection);
 }
 
-static void att_server_handle_att_pdu(hci_connection_t * hci_connection, uint8_t * packet, uint16_t size){
-    att_server_t * att_server = &hci_connection->att_server;
-    att_connection_t * att_connection = &hci_connection->att_connection;
+static void att_server_handle_att_pdu(att_server_t * att_server, att_connection_t * att_connection, uint8_t * packet, uint16_t size){
 
     uint8_t opcode  = packet[0u];
     uint8_t method  = opcode & 0x03fu;
@@ -818,7 +936,7 @@ static void att_server_handle_att_pdu(hci_connection_t * hci_connection, uint8_t
         uint16_t att_handle = att_server->value_indication_handle;
         att_server->value_indication_handle = 0u;    
         att_handle_value_indication_notify_client(0u, att_connection->con_handle, att_handle);
-        att_server_request_can_send_now(hci_connection);
+        att_server_request_can_send_now(att_server, att_connection);
         return;
     }
 
@@ -858,7 +976,7 @@ static void att_server_handle_att_pdu(hci_connection_t * hci_connection, uint8_t
     att_server->request_size = size;
     (void)memcpy(att_server->request_buffer, packet, size);
 
-    att_run_for_context(hci_connection);
+    att_run_for_context(att_server, att_connection);
 }
 
 static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size){
@@ -888,7 +1006,7 @@ static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *pa
             hci_connection = hci_connection_for_handle(handle);
             if (!hci_connection) break;
 
-            att_server_handle_att_pdu(hci_connection, packet, size);
+            att_server_handle_att_pdu(&hci_connection->att_server, &hci_connection->att_connection, packet, size);
             break;
             
         default:
@@ -896,6 +1014,201 @@ static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *pa
     }
 }
 
+#ifdef ENABLE_GATT_OVER_EATT
+
+// ---------------------
+// Enhanced ATT bearers
+
+static att_server_eatt_bearer_t * att_server_eatt_bearer_for_cid(uint16_t cid){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_bearer->att_server.eatt_cid == cid) {
+            return eatt_bearer;
+        }
+    }
+    return NULL;
+}
+
+static void att_server_eatt_bearer_release(att_server_eatt_bearer_t * eatt_bearer){
+    log_info("EATT bearer released, cid 0x%04x", eatt_bearer->att_server.eatt_cid);
+    att_clear_transaction_queue(&eatt_bearer->att_connection);
+    eatt_bearer->att_server.state = ATT_SERVER_IDLE;
+    eatt_bearer->att_server.eatt_cid = 0;
+    eatt_bearer->att_connection.con_handle = HCI_CON_HANDLE_INVALID;
+    btstack_linked_list_remove(&att_server_eatt_bearer_active, (btstack_linked_item_t *) eatt_bearer);
+    btstack_linked_list_add(&att_server_eatt_bearer_pool, (btstack_linked_item_t *) eatt_bearer);
+}
+
+static void att_server_eatt_copy_security(att_connection_t * att_connection, const att_connection_t * unenhanced_att_connection){
+    att_connection->encryption_key_size = unenhanced_att_connection->encryption_key_size;
+    att_connection->authenticated       = unenhanced_att_connection->authenticated;
+    att_connection->secure_connection   = unenhanced_att_connection->secure_connection;
+    att_connection->authorized          = unenhanced_att_connection->authorized;
+}
+
+// security properties are tracked by the unenhanced bearer, e.g. authorization result
+static void att_server_eatt_update_security(hci_connection_t * hci_connection){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_bearer->att_connection.con_handle != hci_connection->att_connection.con_handle) continue;
+        att_server_eatt_copy_security(&eatt_bearer->att_connection, &hci_connection->att_connection);
+        if (eatt_bearer->att_server.state == ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED){
+            att_server_request_can_send_now(&eatt_bearer->att_server, &eatt_bearer->att_connection);
+        }
+    }
+}
+
+static void att_server_eatt_handle_incoming_connection(const uint8_t * packet){
+    uint16_t local_cid = l2cap_event_ecbm_incoming_connection_get_local_cid(packet);
+    hci_con_handle_t con_handle = l2cap_event_ecbm_incoming_connection_get_handle(packet);
+    uint8_t num_channels = l2cap_event_ecbm_incoming_connection_get_num_channels(packet);
+    if (num_channels > L2CAP_ECBM_MAX_CID_ARRAY_SIZE){
+        num_channels = L2CAP_ECBM_MAX_CID_ARRAY_SIZE;
+    }
+
+    // take as many bearers as available
+    att_server_eatt_bearer_t * eatt_bearers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t * receive_buffers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint16_t local_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t num_bearers = 0;
+    while (num_bearers < num_channels){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_pop(&att_server_eatt_bearer_pool);
+        if (eatt_bearer == NULL) break;
+        eatt_bearers[num_bearers] = eatt_bearer;
+        receive_buffers[num_bearers] = eatt_bearer->receive_buffer;
+        num_bearers++;
+    }
+
+    log_info("EATT incoming connection, handle 0x%04x, %u channels requested, %u available", con_handle, num_channels, num_bearers);
+
+    if (num_bearers == 0u){
+        l2cap_ecbm_decline_channels(local_cid, L2CAP_ECBM_CONNECTION_RESULT_SOME_REFUSED_INSUFFICIENT_RESOURCES_AVAILABLE);
+        return;
+    }
+
+    uint8_t status = l2cap_ecbm_accept_channels(local_cid, num_bearers, L2CAP_LE_AUTOMATIC_CREDITS, att_server_eatt_mtu, receive_buffers, local_cids);
+    uint8_t i;
+    for (i=0;i<num_bearers;i++){
+        att_server_eatt_bearer_t * eatt_bearer = eatt_bearers[i];
+        if (status != ERROR_CODE_SUCCESS){
+            btstack_linked_list_add(&att_server_eatt_bearer_pool, (btstack_linked_item_t *) eatt_bearer);
+            continue;
+        }
+        eatt_bearer->att_server.eatt_cid = local_cids[i];
+        eatt_bearer->att_connection.con_handle = con_handle;
+        btstack_linked_list_add(&att_server_eatt_bearer_active, (btstack_linked_item_t *) eatt_bearer);
+    }
+}
+
+static void att_server_eatt_handle_channel_opened(const uint8_t * packet){
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_cid(l2cap_event_ecbm_channel_opened_get_local_cid(packet));
+    if (eatt_bearer == NULL) return;
+
+    hci_con_handle_t con_handle = l2cap_event_ecbm_channel_opened_get_handle(packet);
+    hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
+    if ((l2cap_event_ecbm_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS) || (hci_connection == NULL)){
+        att_server_eatt_bearer_release(eatt_bearer);
+        return;
+    }
+
+    // ATT_MTU is minimum of both L2CAP MTUs, no MTU exchange
+    att_connection_t * att_connection = &eatt_bearer->att_connection;
+    uint16_t remote_mtu = l2cap_event_ecbm_channel_opened_get_remote_mtu(packet);
+    att_connection->mtu = btstack_min(remote_mtu, att_connection->max_mtu);
+    att_connection->mtu_exchanged = true;
+    att_server_eatt_copy_security(att_connection, &hci_connection->att_connection);
+    eatt_bearer->att_server.state = ATT_SERVER_IDLE;
+
+    log_info("EATT bearer opened, handle 0x%04x, cid 0x%04x, mtu %u", con_handle, eatt_bearer->att_server.eatt_cid, att_connection->mtu);
+}
+
+static void att_server_eatt_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    att_server_eatt_bearer_t * eatt_bearer;
+    switch (packet_type) {
+        case L2CAP_DATA_PACKET:
+            eatt_bearer = att_server_eatt_bearer_for_cid(channel);
+            if (eatt_bearer == NULL) break;
+            if (size == 0u) break;
+            // Signed Write Command is only used on unencrypted unenhanced bearer
+            if (packet[0] == ATT_SIGNED_WRITE_COMMAND) break;
+            att_server_handle_att_pdu(&eatt_bearer->att_server, &eatt_bearer->att_connection, packet, size);
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)) {
+                case L2CAP_EVENT_ECBM_INCOMING_CONNECTION:
+                    att_server_eatt_handle_incoming_connection(packet);
+                    break;
+                case L2CAP_EVENT_ECBM_CHANNEL_OPENED:
+                    att_server_eatt_handle_channel_opened(packet);
+                    break;
+                case L2CAP_EVENT_CAN_SEND_NOW:
+                    eatt_bearer = att_server_eatt_bearer_for_cid(l2cap_event_can_send_now_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    if (eatt_bearer->att_server.state != ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED) break;
+                    att_server_process_validated_request(&eatt_bearer->att_server, &eatt_bearer->att_connection);
+                    break;
+                case L2CAP_EVENT_CHANNEL_CLOSED:
+                    eatt_bearer = att_server_eatt_bearer_for_cid(l2cap_event_channel_closed_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    att_server_eatt_bearer_release(eatt_bearer);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+uint8_t att_server_eatt_init(uint8_t num_eatt_bearers, uint8_t * storage_buffer, uint16_t storage_size){
+    if (num_eatt_bearers == 0u){
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    // bearer structs at start of storage, aligned for pointers, followed by receive and send buffers
+    uint16_t padding = (uint16_t) ((sizeof(void *) - (((uintptr_t) storage_buffer) % sizeof(void *))) % sizeof(void *));
+    uint32_t size_for_structs = padding + (num_eatt_bearers * sizeof(att_server_eatt_bearer_t));
+    if (storage_size <= size_for_structs){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    uint32_t mtu = (storage_size - size_for_structs) / (2u * num_eatt_bearers);
+    // complete requests are stored in request buffer
+    mtu = btstack_min(mtu, ATT_REQUEST_BUFFER_SIZE);
+    if (mtu < ATT_EATT_MIN_MTU){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+
+    uint8_t status = l2cap_ecbm_register_service(&att_server_eatt_handler, PSM_EATT, ATT_EATT_MIN_MTU, LEVEL_2);
+    if (status != ERROR_CODE_SUCCESS){
+        return status;
+    }
+
+    memset(storage_buffer, 0, storage_size);
+    att_server_eatt_mtu = (uint16_t) mtu;
+    att_server_eatt_bearer_t * eatt_bearers = (att_server_eatt_bearer_t *) &storage_buffer[padding];
+    uint8_t * bearer_buffer = &storage_buffer[size_for_structs];
+    uint8_t i;
+    for (i=0;i<num_eatt_bearers;i++){
+        att_server_eatt_bearer_t * eatt_bearer = &eatt_bearers[i];
+        eatt_bearer->att_connection.con_handle = HCI_CON_HANDLE_INVALID;
+        eatt_bearer->att_connection.mtu = ATT_DEFAULT_MTU;
+        eatt_bearer->att_connection.max_mtu = att_server_eatt_mtu;
+        eatt_bearer->receive_buffer = bearer_buffer;
+        bearer_buffer += att_server_eatt_mtu;
+        eatt_bearer->att_server.eatt_send_buffer = bearer_buffer;
+        bearer_buffer += att_server_eatt_mtu;
+        btstack_linked_list_add(&att_server_eatt_bearer_pool, (btstack_linked_item_t *) eatt_bearer);
+    }
+    log_info("EATT: %u bearers with MTU %u", num_eatt_bearers, att_server_eatt_mtu);
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 // ---------------------
 // persistent CCC writes
 static uint32_t att_server_persistent_ccc_tag_for_index(uint8_t index){
@@ -1202,7 +1515,7 @@ void att_server_register_packet_handler(btstack_packet_handler_t handler){
 int  att_server_can_send_packet_now(hci_con_handle_t con_handle){
     hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
     if (!hci_connection) return 0;
-    return att_server_can_send_packet(hci_connection);
+    return att_server_can_send_packet(&hci_connection->att_server, &hci_connection->att_connection);
 }
 
 uint8_t att_server_register_can_send_now_callback(btstack_context_callback_registration_t * callback_registration, hci_con_handle_t con_handle){
@@ -1220,7 +1533,7 @@ uint8_t att_server_request_to_send_notification(btstack_context_callback_registr
     if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     att_server_t * att_server = &hci_connection->att_server;
     bool added = btstack_linked_list_add_tail(&att_server->notification_requests, (btstack_linked_item_t*) callback_registration);
-    att_server_request_can_send_now(hci_connection);
+    att_server_request_can_send_now(&hci_connection->att_server, &hci_connection->att_connection);
     if (added){
         return ERROR_CODE_SUCCESS;
     } else {
@@ -1233,7 +1546,7 @@ uint8_t att_server_request_to_send_indication(btstack_context_callback_registrat
     if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     att_server_t * att_server = &hci_connection->att_server;
     bool added = btstack_linked_list_add_tail(&att_server->indication_requests, (btstack_linked_item_t*) callback_registration);
-    att_server_request_can_send_now(hci_connection);
+    att_server_request_can_send_now(&hci_connection->att_server, &hci_connection->att_connection);
     if (added){
         return ERROR_CODE_SUCCESS;
     } else {
@@ -1246,7 +1559,7 @@ uint8_t att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle
     if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     att_connection_t * att_connection = &hci_connection->att_connection;
 
-    if (!att_server_can_send_packet(hci_connection)) return BTSTACK_ACL_BUFFERS_FULL;
+    if (!att_server_can_send_packet(&hci_connection->att_server, &hci_connection->att_connection)) return BTSTACK_ACL_BUFFERS_FULL;
 
     l2cap_reserve_packet_buffer();
     uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
@@ -1260,6 +1573,37 @@ uint8_t att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle
 	return l2cap_send_prepared_connectionless(att_connection->con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
 }
 
+uint8_t att_server_multiple_notify(hci_con_handle_t con_handle, uint8_t num_attributes,
+                                   const uint16_t * attribute_handles, const uint8_t ** values_data, const uint16_t * values_len){
+    hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
+    if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    att_connection_t * att_connection = &hci_connection->att_connection;
+
+    if (num_attributes == 0u) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    // all Handle Length Value Tuples need to fit into a single notification
+    uint32_t required_size = 1u;
+    uint8_t i;
+    for (i = 0; i < num_attributes; i++){
+        required_size += 4u + values_len[i];
+    }
+    if (required_size > att_connection->mtu) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    if (!att_server_can_send_packet(&hci_connection->att_server, &hci_connection->att_connection)) return BTSTACK_ACL_BUFFERS_FULL;
+
+    l2cap_reserve_packet_buffer();
+    uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+    uint16_t size = att_prepare_handle_value_multiple_notification(att_connection, num_attributes, attribute_handles, values_data, values_len, packet_buffer);
+    btstack_assert(size == required_size);
+#ifdef ENABLE_GATT_OVER_CLASSIC
+    att_server_t * att_server = &hci_connection->att_server;
+    if (att_server->l2cap_cid != 0){
+        return l2cap_send_prepared(att_server->l2cap_cid, size);
+    }
+#endif
+    return l2cap_send_prepared_connectionless(att_connection->con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
+}
+
 uint8_t att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len){
     hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
     if (!hci_connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
@@ -1267,7 +1611,7 @@ uint8_t att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_hand
     att_connection_t * att_connection = &hci_connection->att_connection;
 
     if (att_server->value_indication_handle != 0u) return ATT_HANDLE_VALUE_INDICATION_IN_PROGRESS;
-    if (!att_server_can_send_packet(hci_connection)) return BTSTACK_ACL_BUFFERS_FULL;
+    if (!att_server_can_send_packet(&hci_connection->att_server, &hci_connection->att_connection)) return BTSTACK_ACL_BUFFERS_FULL;
 
     // track indication
     att_server->value_indication_handle = attribute_handle;
@@ -1299,4 +1643,8 @@ void att_server_deinit(void){
     att_server_client_write_callback = NULL;
     att_client_packet_handler = NULL;
     service_handlers = NULL;
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_bearer_pool = NULL;
+    att_server_eatt_bearer_active = NULL;
+#endif
 }
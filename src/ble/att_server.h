@@ -120,6 +120,20 @@ uint8_t att_server_request_to_send_indication(btstack_context_callback_registrat
  */
 uint8_t att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
 
+/**
+ * @brief notify client about multiple attribute value changes in a single Multiple Handle Value Notification
+ * @note all values are sent or none: each value needs 4 bytes plus its length, in total they need to fit into the MTU
+ *       minus 1, use att_server_get_mtu to size batches. The client has to indicate support in its Client Supported Features characteristic
+ * @param con_handle
+ * @param num_attributes
+ * @param attribute_handles
+ * @param values_data
+ * @param values_len
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if values don't fit into MTU, error otherwise
+ */
+uint8_t att_server_multiple_notify(hci_con_handle_t con_handle, uint8_t num_attributes,
+                                   const uint16_t * attribute_handles, const uint8_t ** values_data, const uint16_t * values_len);
+
 /**
  * @brief indicate value change to client. client is supposed to reply with an indication_response
  * @param con_handle
@@ -135,10 +149,46 @@ uint8_t att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_hand
  * @brief response ready - called after returning ATT_READ__RESPONSE_PENDING in an att_read_callback or
  * ATT_ERROR_WRITE_REQUEST_PENDING IN att_write_callback before to trigger callback again and complete the transaction
  * @nore The ATT Server will retry handling the current ATT request
+ * @note With ENABLE_GATT_OVER_EATT, pending requests on all bearers of the connection are retried,
+ *       see att_server_eatt_response_ready to retry a single bearer
  * @param con_handle
  * @return 0 if ok, error otherwise
  */
 uint8_t att_server_response_ready(hci_con_handle_t con_handle);
+
+#ifdef ENABLE_GATT_OVER_EATT
+/**
+ * @brief Get bearer of the ATT request that is currently handled
+ * @note Only valid in att_read_callback and att_write_callback
+ * @return local cid of EATT bearer, or 0 for unenhanced bearer
+ */
+uint16_t att_server_eatt_get_request_cid(void);
+
+/**
+ * @brief response ready for a single bearer - like att_server_response_ready, but only retries the ATT request
+ * on the bearer returned by att_server_eatt_get_request_cid when the response was deferred
+ * @param con_handle
+ * @param eatt_cid of EATT bearer, or 0 for unenhanced bearer
+ * @return 0 if ok, error otherwise
+ */
+uint8_t att_server_eatt_response_ready(hci_con_handle_t con_handle, uint16_t eatt_cid);
+#endif
+#endif
+
+#ifdef ENABLE_GATT_OVER_EATT
+/**
+ * @brief Accept Enhanced ATT bearers over L2CAP in Enhanced Credit-Based Flow-Control Mode
+ * @note Requests on EATT bearers are handled in parallel to the unenhanced bearer, notifications and
+ *       indications are sent over the unenhanced bearer
+ * @note MTU of EATT bearers is derived from storage size and limited by ATT_REQUEST_BUFFER_SIZE.
+ *       MTU Exchange Requests on EATT bearers are rejected with Request Not Supported
+ *       Each bearer needs about ATT_REQUEST_BUFFER_SIZE for the request plus twice its MTU for receive and send buffers
+ * @param num_eatt_bearers
+ * @param storage_buffer for all EATT bearers
+ * @param storage_size
+ * @return ERROR_CODE_SUCCESS if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if storage does not allow for MTU of 64
+ */
+uint8_t att_server_eatt_init(uint8_t num_eatt_bearers, uint8_t * storage_buffer, uint16_t storage_size);
 #endif
 
 /**
@@ -52,6 +52,7 @@
 #include "btstack_event.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
+#include "btstack_tlv.h"
 #include "btstack_util.h"
 #include "hci.h"
 #include "hci_dump.h"
@@ -78,6 +79,10 @@ static void gatt_client_report_error_if_pending(gatt_client_t *gatt_client, uint
 static void att_signed_write_handle_cmac_result(uint8_t hash[8]);
 #endif
 
+#ifdef ENABLE_GATT_OVER_EATT
+static void gatt_client_eatt_finalize(gatt_client_t * eatt_client, uint8_t att_error_code);
+#endif
+
 void gatt_client_init(void){
     gatt_client_connections = NULL;
 
@@ -109,6 +114,15 @@ static gatt_client_t * gatt_client_for_timer(btstack_timer_source_t * ts){
         if (&gatt_client->gc_timeout == ts) {
             return gatt_client;
         }
+#ifdef ENABLE_GATT_OVER_EATT
+        btstack_linked_item_t *eatt_it;
+        for (eatt_it = (btstack_linked_item_t *) gatt_client->eatt_clients; eatt_it != NULL; eatt_it = eatt_it->next){
+            gatt_client_t * eatt_client = (gatt_client_t *) eatt_it;
+            if (&eatt_client->gc_timeout == ts) {
+                return eatt_client;
+            }
+        }
+#endif
     }
     return NULL;
 }
@@ -199,17 +213,43 @@ static uint8_t gatt_client_provide_context_for_handle(hci_con_handle_t con_handl
     return ERROR_CODE_SUCCESS;
 }
 
-static uint8_t gatt_client_provide_context_for_handle_and_start_timer(hci_con_handle_t con_handle, gatt_client_t ** out_gatt_client){
-    uint8_t status = gatt_client_provide_context_for_handle(con_handle, out_gatt_client);
-    if (status != ERROR_CODE_SUCCESS){
-        return status;
+static bool is_ready(gatt_client_t * gatt_client){
+    return gatt_client->gatt_client_state == P_READY;
+}
+
+// @return unenhanced bearer if ready, otherwise first ready EATT bearer or NULL
+static gatt_client_t * gatt_client_get_ready_bearer(gatt_client_t * gatt_client){
+    if (is_ready(gatt_client)){
+        return gatt_client;
     }
-    gatt_client_timeout_start(*out_gatt_client);
-    return status;
+#ifdef ENABLE_GATT_OVER_EATT
+    if (gatt_client->eatt_state == GATT_CLIENT_EATT_READY){
+        btstack_linked_item_t *it;
+        for (it = (btstack_linked_item_t *) gatt_client->eatt_clients; it != NULL; it = it->next){
+            gatt_client_t * eatt_client = (gatt_client_t *) it;
+            if (is_ready(eatt_client)){
+                return eatt_client;
+            }
+        }
+    }
+#endif
+    return NULL;
 }
 
-static bool is_ready(gatt_client_t * gatt_client){
-    return gatt_client->gatt_client_state == P_READY;
+// @return ready bearer for new request with started timer
+static uint8_t gatt_client_provide_context_for_request(hci_con_handle_t con_handle, gatt_client_t ** out_gatt_client){
+    gatt_client_t * gatt_client;
+    uint8_t status = gatt_client_provide_context_for_handle(con_handle, &gatt_client);
+    if (status != ERROR_CODE_SUCCESS){
+        return status;
+    }
+    gatt_client_t * bearer = gatt_client_get_ready_bearer(gatt_client);
+    if (bearer == NULL){
+        return GATT_CLIENT_IN_WRONG_STATE;
+    }
+    gatt_client_timeout_start(bearer);
+    *out_gatt_client = bearer;
+    return ERROR_CODE_SUCCESS;
 }
 
 int gatt_client_is_ready(hci_con_handle_t con_handle){
@@ -218,7 +258,7 @@ int gatt_client_is_ready(hci_con_handle_t con_handle){
     if (status != ERROR_CODE_SUCCESS){
         return 0;
     }
-    return is_ready(gatt_client) ? 1 : 0;
+    return (gatt_client_get_ready_bearer(gatt_client) != NULL) ? 1 : 0;
 }
 
 void gatt_client_mtu_enable_auto_negotiation(uint8_t enabled){
@@ -240,8 +280,24 @@ uint8_t gatt_client_get_mtu(hci_con_handle_t con_handle, uint16_t * mtu){
     return GATT_CLIENT_IN_WRONG_STATE;
 }
 
+// precondition: can_send_packet_now == TRUE
+static uint8_t * gatt_client_reserve_request_buffer(gatt_client_t * gatt_client){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (gatt_client->eatt_cid != 0){
+        return gatt_client->eatt_send_buffer;
+    }
+#endif
+    l2cap_reserve_packet_buffer();
+    return l2cap_get_outgoing_buffer();
+}
+
 // precondition: can_send_packet_now == TRUE
 static uint8_t gatt_client_send(gatt_client_t * gatt_client, uint16_t len){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (gatt_client->eatt_cid != 0){
+        return l2cap_send(gatt_client->eatt_cid, gatt_client->eatt_send_buffer, len);
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (gatt_client->l2cap_psm){
         return l2cap_send_prepared(gatt_client->l2cap_cid, len);
@@ -252,9 +308,7 @@ static uint8_t gatt_client_send(gatt_client_t * gatt_client, uint16_t len){
 
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_confirmation(gatt_client_t * gatt_client) {
-    l2cap_reserve_packet_buffer();
-
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = ATT_HANDLE_VALUE_CONFIRMATION;
 
     return gatt_client_send(gatt_client, 1);
@@ -263,8 +317,7 @@ static uint8_t att_confirmation(gatt_client_t * gatt_client) {
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_find_information_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t start_handle,
                                             uint16_t end_handle) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
 
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
@@ -277,8 +330,7 @@ static uint8_t att_find_information_request(gatt_client_t *gatt_client, uint8_t
 static uint8_t
 att_find_by_type_value_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t attribute_group_type,
                                uint16_t start_handle, uint16_t end_handle, uint8_t *value, uint16_t value_size) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
@@ -293,8 +345,7 @@ att_find_by_type_value_request(gatt_client_t *gatt_client, uint8_t request_type,
 static uint8_t
 att_read_by_type_or_group_request_for_uuid16(gatt_client_t *gatt_client, uint8_t request_type, uint16_t uuid16,
                                              uint16_t start_handle, uint16_t end_handle) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
 
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
@@ -308,8 +359,7 @@ att_read_by_type_or_group_request_for_uuid16(gatt_client_t *gatt_client, uint8_t
 static uint8_t
 att_read_by_type_or_group_request_for_uuid128(gatt_client_t *gatt_client, uint8_t request_type, const uint8_t *uuid128,
                                               uint16_t start_handle, uint16_t end_handle) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
 
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
@@ -321,8 +371,7 @@ att_read_by_type_or_group_request_for_uuid128(gatt_client_t *gatt_client, uint8_
 
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_read_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t attribute_handle) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
 
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
@@ -333,8 +382,7 @@ static uint8_t att_read_request(gatt_client_t *gatt_client, uint8_t request_type
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_read_blob_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t attribute_handle,
                                      uint16_t value_offset) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     little_endian_store_16(request, 3, value_offset);
@@ -343,10 +391,9 @@ static uint8_t att_read_blob_request(gatt_client_t *gatt_client, uint8_t request
 }
 
 static uint8_t
-att_read_multiple_request(gatt_client_t *gatt_client, uint16_t num_value_handles, uint16_t *value_handles) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
-    request[0] = ATT_READ_MULTIPLE_REQUEST;
+att_read_multiple_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t num_value_handles, uint16_t *value_handles) {
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
+    request[0] = request_type;
     int i;
     int offset = 1;
     for (i=0;i<num_value_handles;i++){
@@ -361,8 +408,7 @@ att_read_multiple_request(gatt_client_t *gatt_client, uint16_t num_value_handles
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_signed_write_request(gatt_client_t *gatt_client, uint16_t request_type, uint16_t attribute_handle,
                                         uint16_t value_length, uint8_t *value, uint32_t sign_counter, uint8_t sgn[8]) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     (void)memcpy(&request[3], value, value_length);
@@ -377,8 +423,7 @@ static uint8_t att_signed_write_request(gatt_client_t *gatt_client, uint16_t req
 static uint8_t
 att_write_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t attribute_handle, uint16_t value_length,
                   uint8_t *value) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     (void)memcpy(&request[3], value, value_length);
@@ -388,8 +433,7 @@ att_write_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t att
 
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_execute_write_request(gatt_client_t *gatt_client, uint8_t request_type, uint8_t execute_write) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     request[1] = execute_write;
     
@@ -399,8 +443,7 @@ static uint8_t att_execute_write_request(gatt_client_t *gatt_client, uint8_t req
 // precondition: can_send_packet_now == TRUE
 static uint8_t att_prepare_write_request(gatt_client_t *gatt_client, uint8_t request_type, uint16_t attribute_handle,
                                          uint16_t value_offset, uint16_t blob_length, uint8_t *value) {
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     little_endian_store_16(request, 3, value_offset);
@@ -411,8 +454,7 @@ static uint8_t att_prepare_write_request(gatt_client_t *gatt_client, uint8_t req
 
 static uint8_t att_exchange_mtu_request(gatt_client_t *gatt_client) {
     uint16_t mtu = l2cap_max_le_mtu();
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = ATT_EXCHANGE_MTU_REQUEST;
     little_endian_store_16(request, 1, mtu);
     
@@ -502,7 +544,11 @@ static void send_gatt_read_blob_request(gatt_client_t *gatt_client){
 }
 
 static void send_gatt_read_multiple_request(gatt_client_t * gatt_client){
-    att_read_multiple_request(gatt_client, gatt_client->read_multiple_handle_count, gatt_client->read_multiple_handles);
+    att_read_multiple_request(gatt_client, ATT_READ_MULTIPLE_REQUEST, gatt_client->read_multiple_handle_count, gatt_client->read_multiple_handles);
+}
+
+static void send_gatt_read_multiple_variable_request(gatt_client_t * gatt_client){
+    att_read_multiple_request(gatt_client, ATT_READ_MULTIPLE_VARIABLE_REQ, gatt_client->read_multiple_handle_count, gatt_client->read_multiple_handles);
 }
 
 static void send_gatt_write_attribute_value_request(gatt_client_t * gatt_client){
@@ -571,7 +617,14 @@ static uint16_t get_last_result_handle_from_included_services_list(uint8_t * pac
 }
 
 static void gatt_client_notify_can_send_query(gatt_client_t * gatt_client){
-    while (gatt_client->gatt_client_state == P_READY){
+#ifdef ENABLE_GATT_OVER_EATT
+    // queries are queued on the unenhanced bearer
+    if (gatt_client->eatt_cid != 0){
+        gatt_client = gatt_client_get_context_for_handle(gatt_client->con_handle);
+        if (gatt_client == NULL) return;
+    }
+#endif
+    while (gatt_client_get_ready_bearer(gatt_client) != NULL){
         btstack_context_callback_registration_t * callback = (btstack_context_callback_registration_t *) btstack_linked_list_pop(&gatt_client->query_requests);
         if (callback == NULL) {
             return;
@@ -580,8 +633,61 @@ static void gatt_client_notify_can_send_query(gatt_client_t * gatt_client){
     }
 }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// GATT Client Cache: discovery results of bonded devices, validated by Database Hash
+
+static void gatt_client_cache_add_entry(gatt_client_t * gatt_client, gatt_client_cache_entry_type_t type, uint16_t start_handle,
+                                        uint16_t value_handle, uint16_t end_handle, uint16_t properties, const uint8_t * uuid128){
+    if (gatt_client->cache_query != (uint8_t) type) return;
+    gatt_client_cache_t * cache = &gatt_client->cache;
+    if (cache->num_entries >= GATT_CLIENT_CACHE_MAX_ENTRIES){
+        log_info("GATT Client Cache full, stop recording");
+        cache->num_entries = gatt_client->cache_query_num_entries;
+        gatt_client->cache_query = GATT_CLIENT_CACHE_ENTRY_NONE;
+        return;
+    }
+    gatt_client_cache_entry_t * entry = &cache->entries[cache->num_entries++];
+    entry->type = (uint8_t) type;
+    entry->complete = 0;
+    entry->start_handle = start_handle;
+    entry->value_handle = value_handle;
+    entry->end_handle = end_handle;
+    entry->properties = properties;
+    (void)memcpy(entry->uuid128, uuid128, 16);
+}
+
+// called before transaction complete if discovery query succeeded
+static void gatt_client_cache_query_succeeded(gatt_client_t * gatt_client){
+    switch ((gatt_client_cache_entry_type_t) gatt_client->cache_query){
+        case GATT_CLIENT_CACHE_ENTRY_SERVICE:
+            gatt_client->cache.services_complete = 1;
+            break;
+        case GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC:
+        case GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR:
+            gatt_client->cache.entries[gatt_client->cache_query_entry].complete = 1;
+            break;
+        default:
+            return;
+    }
+    gatt_client->cache_dirty = true;
+    gatt_client->cache_query = GATT_CLIENT_CACHE_ENTRY_NONE;
+}
+
+static void gatt_client_cache_transaction_complete(gatt_client_t * gatt_client){
+    // drop partial results of failed query
+    if (gatt_client->cache_query != GATT_CLIENT_CACHE_ENTRY_NONE){
+        gatt_client->cache.num_entries = gatt_client->cache_query_num_entries;
+        gatt_client->cache_query = GATT_CLIENT_CACHE_ENTRY_NONE;
+    }
+    gatt_client->cache_checked = false;
+}
+#endif
+
 static void gatt_client_handle_transaction_complete(gatt_client_t * gatt_client){
     gatt_client->gatt_client_state = P_READY;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_transaction_complete(gatt_client);
+#endif
     gatt_client_timeout_stop(gatt_client);
     gatt_client_notify_can_send_query(gatt_client);
 }
@@ -629,6 +735,9 @@ static void emit_gatt_complete_event(gatt_client_t * gatt_client, uint8_t att_st
 }
 
 static void emit_gatt_service_query_result_event(gatt_client_t * gatt_client, uint16_t start_group_handle, uint16_t end_group_handle, const uint8_t * uuid128){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_SERVICE, start_group_handle, 0, end_group_handle, 0, uuid128);
+#endif
     // @format HX
     uint8_t packet[24];
     packet[0] = GATT_EVENT_SERVICE_QUERY_RESULT;
@@ -658,6 +767,9 @@ static void emit_gatt_included_service_query_result_event(gatt_client_t * gatt_c
 
 static void emit_gatt_characteristic_query_result_event(gatt_client_t * gatt_client, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle,
                                                         uint16_t properties, const uint8_t * uuid128){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC, start_handle, value_handle, end_handle, properties, uuid128);
+#endif
     // @format HY
     uint8_t packet[28];
     packet[0] = GATT_EVENT_CHARACTERISTIC_QUERY_RESULT;
@@ -674,6 +786,9 @@ static void emit_gatt_characteristic_query_result_event(gatt_client_t * gatt_cli
 
 static void emit_gatt_all_characteristic_descriptors_result_event(
         gatt_client_t * gatt_client, uint16_t descriptor_handle, const uint8_t * uuid128){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR, descriptor_handle, 0, descriptor_handle, 0, uuid128);
+#endif
     // @format HZ
     uint8_t packet[22];
     packet[0] = GATT_EVENT_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT;
@@ -862,6 +977,32 @@ static void report_gatt_characteristic_value(gatt_client_t * gatt_client, uint16
     emit_event_new(gatt_client->callback, packet, characteristic_value_event_header_size + length);
 }
 
+// Handle Length Value Tuples, events are assembled in place, overwriting the previous value
+static void report_gatt_multiple_notification(gatt_client_t *gatt_client, uint8_t * packet, uint16_t size) {
+    uint16_t offset = 1;
+    while ((offset + 4u) <= size){
+        uint16_t value_handle = little_endian_read_16(packet, offset);
+        uint16_t value_length = little_endian_read_16(packet, offset + 2u);
+        offset += 4u;
+        if ((offset + value_length) > size) break;
+        report_gatt_notification(gatt_client, value_handle, &packet[offset], value_length);
+        offset += value_length;
+    }
+}
+
+// Length Value Tuples in order of requested handles, last value might be truncated
+static void report_gatt_multiple_variable_characteristic_values(gatt_client_t * gatt_client, uint8_t * packet, uint16_t size){
+    uint16_t offset = 1;
+    uint16_t i;
+    for (i = 0; (i < gatt_client->read_multiple_handle_count) && ((offset + 2u) <= size); i++){
+        uint16_t value_length = little_endian_read_16(packet, offset);
+        offset += 2u;
+        value_length = btstack_min(value_length, size - offset);
+        report_gatt_characteristic_value(gatt_client, gatt_client->read_multiple_handles[i], &packet[offset], value_length);
+        offset += value_length;
+    }
+}
+
 // @note assume that value is part of an l2cap buffer - overwrite parts of the HCI/L2CAP/ATT packet (4/4/3) bytes 
 static void report_gatt_long_characteristic_value_blob(gatt_client_t * gatt_client, uint16_t attribute_handle, uint8_t * blob, uint16_t blob_length, int value_offset){
     uint8_t * packet = setup_long_characteristic_value_packet(GATT_EVENT_LONG_CHARACTERISTIC_VALUE_QUERY_RESULT, gatt_client->con_handle, attribute_handle, value_offset, blob, blob_length);
@@ -904,6 +1045,9 @@ static int is_query_done(gatt_client_t * gatt_client, uint16_t last_result_handl
 
 static void trigger_next_query(gatt_client_t * gatt_client, uint16_t last_result_handle, gatt_client_state_t next_query_state){
     if (is_query_done(gatt_client, last_result_handle)){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        gatt_client_cache_query_succeeded(gatt_client);
+#endif
         gatt_client_handle_transaction_complete(gatt_client);
         emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
         return;
@@ -985,6 +1129,258 @@ static void gatt_client_run_for_client_start_signed_write(gatt_client_t *gatt_cl
 }
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+static uint16_t gatt_client_cache_storage_size(const gatt_client_cache_t * cache){
+    return (uint16_t) (offsetof(gatt_client_cache_t, entries) + (cache->num_entries * sizeof(gatt_client_cache_entry_t)));
+}
+
+static int gatt_client_cache_find_entry(gatt_client_t * gatt_client, gatt_client_cache_entry_type_t type, uint16_t start_handle, uint16_t end_handle){
+    const gatt_client_cache_t * cache = &gatt_client->cache;
+    uint16_t i;
+    for (i = 0; i < cache->num_entries; i++){
+        const gatt_client_cache_entry_t * entry = &cache->entries[i];
+        if (entry->type != (uint8_t) type) continue;
+        if (entry->end_handle != end_handle) continue;
+        switch (type){
+            case GATT_CLIENT_CACHE_ENTRY_SERVICE:
+                if (entry->start_handle == start_handle) return i;
+                break;
+            case GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC:
+                // descriptors follow the characteristic value
+                if ((entry->value_handle + 1u) == start_handle) return i;
+                break;
+            default:
+                break;
+        }
+    }
+    return -1;
+}
+
+// emit results of discovery query from cache, @return true if query was served
+static bool gatt_client_cache_emit_query_results(gatt_client_t * gatt_client){
+    const gatt_client_cache_t * cache = &gatt_client->cache;
+    gatt_client_cache_entry_type_t type;
+    bool filter_with_uuid = false;
+    int index;
+    uint16_t start_handle = gatt_client->start_group_handle;
+    uint16_t end_handle   = gatt_client->end_group_handle;
+    switch (gatt_client->gatt_client_state){
+        case P_W2_SEND_SERVICE_QUERY:
+            if (gatt_client->uuid16 != GATT_PRIMARY_SERVICE_UUID) return false;
+            if (cache->services_complete == 0u) return false;
+            type = GATT_CLIENT_CACHE_ENTRY_SERVICE;
+            break;
+        case P_W2_SEND_SERVICE_WITH_UUID_QUERY:
+            if (cache->services_complete == 0u) return false;
+            type = GATT_CLIENT_CACHE_ENTRY_SERVICE;
+            filter_with_uuid = true;
+            break;
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+        case P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY:
+            index = gatt_client_cache_find_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_SERVICE, start_handle, end_handle);
+            if ((index < 0) || (cache->entries[index].complete == 0u)) return false;
+            type = GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC;
+            filter_with_uuid = gatt_client->filter_with_uuid != 0u;
+            break;
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            index = gatt_client_cache_find_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC, start_handle, end_handle);
+            if ((index < 0) || (cache->entries[index].complete == 0u)) return false;
+            type = GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR;
+            break;
+        default:
+            return false;
+    }
+
+    log_info("GATT Client Cache: serve query, state %u", gatt_client->gatt_client_state);
+    uint16_t i;
+    for (i = 0; i < cache->num_entries; i++){
+        const gatt_client_cache_entry_t * entry = &cache->entries[i];
+        if (entry->type != (uint8_t) type) continue;
+        if ((entry->start_handle < start_handle) || (entry->start_handle > end_handle)) continue;
+        if (filter_with_uuid && (memcmp(entry->uuid128, gatt_client->uuid128, 16) != 0)) continue;
+        switch (type){
+            case GATT_CLIENT_CACHE_ENTRY_SERVICE:
+                emit_gatt_service_query_result_event(gatt_client, entry->start_handle, entry->end_handle, entry->uuid128);
+                break;
+            case GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC:
+                emit_gatt_characteristic_query_result_event(gatt_client, entry->start_handle, entry->value_handle,
+                                                            entry->end_handle, entry->properties, entry->uuid128);
+                break;
+            default:
+                emit_gatt_all_characteristic_descriptors_result_event(gatt_client, entry->start_handle, entry->uuid128);
+                break;
+        }
+    }
+    gatt_client_handle_transaction_complete(gatt_client);
+    emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
+    return true;
+}
+
+static void gatt_client_cache_start_recording(gatt_client_t * gatt_client){
+    gatt_client_cache_entry_type_t type;
+    int index = 0;
+    switch (gatt_client->gatt_client_state){
+        case P_W2_SEND_SERVICE_QUERY:
+            if (gatt_client->uuid16 != GATT_PRIMARY_SERVICE_UUID) return;
+            type = GATT_CLIENT_CACHE_ENTRY_SERVICE;
+            break;
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+            index = gatt_client_cache_find_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_SERVICE,
+                                                 gatt_client->start_group_handle, gatt_client->end_group_handle);
+            if (index < 0) return;
+            type = GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC;
+            break;
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            index = gatt_client_cache_find_entry(gatt_client, GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC,
+                                                 gatt_client->start_group_handle, gatt_client->end_group_handle);
+            if (index < 0) return;
+            type = GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR;
+            break;
+        default:
+            return;
+    }
+    gatt_client->cache_query = (uint8_t) type;
+    gatt_client->cache_query_entry = (uint16_t) index;
+    gatt_client->cache_query_num_entries = gatt_client->cache.num_entries;
+}
+
+// @return true if query was served from cache
+static bool gatt_client_cache_handle_query(gatt_client_t * gatt_client){
+    if (gatt_client->cache_checked) return false;
+    switch (gatt_client->gatt_client_state){
+        case P_W2_SEND_SERVICE_QUERY:
+        case P_W2_SEND_SERVICE_WITH_UUID_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+        case P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            break;
+        default:
+            return false;
+    }
+
+    int le_device_index;
+    switch (gatt_client->cache_state){
+        case GATT_CLIENT_CACHE_STATE_UNKNOWN:
+#ifdef ENABLE_GATT_OVER_CLASSIC
+            if (gatt_client->l2cap_psm != 0){
+                gatt_client->cache_state = GATT_CLIENT_CACHE_STATE_DISABLED;
+                return false;
+            }
+#endif
+            // only bonded devices, retry on next query otherwise
+            le_device_index = sm_le_device_index(gatt_client->con_handle);
+            if (le_device_index < 0) return false;
+            // read Database Hash first, then continue with query
+            gatt_client->le_device_index = le_device_index;
+            gatt_client->cache_resume_state = gatt_client->gatt_client_state;
+            gatt_client->gatt_client_state = P_W2_SEND_DATABASE_HASH_QUERY;
+            return false;
+        case GATT_CLIENT_CACHE_STATE_ACTIVE:
+            break;
+        default:
+            return false;
+    }
+
+    gatt_client->cache_checked = true;
+    if (gatt_client_cache_emit_query_results(gatt_client)) return true;
+    gatt_client_cache_start_recording(gatt_client);
+    return false;
+}
+
+static void gatt_client_cache_handle_database_hash(gatt_client_t * gatt_client, const uint8_t * packet, uint16_t size){
+    gatt_client->gatt_client_state = gatt_client->cache_resume_state;
+
+    // single handle-value pair with 128-bit hash
+    if ((size < 20u) || (packet[1] != 18u)){
+        gatt_client->cache_state = GATT_CLIENT_CACHE_STATE_DISABLED;
+        return;
+    }
+    const uint8_t * database_hash = &packet[4];
+
+    int addr_type;
+    bd_addr_t addr;
+    le_device_db_info(gatt_client->le_device_index, &addr_type, addr, NULL);
+
+    gatt_client_cache_t * cache = &gatt_client->cache;
+    gatt_client->cache_state = GATT_CLIENT_CACHE_STATE_ACTIVE;
+    gatt_client->cache_dirty = false;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl != NULL){
+        uint32_t tag = GATT_CLIENT_CACHE_TLV_TAG(gatt_client->le_device_index);
+        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) cache, sizeof(gatt_client_cache_t));
+        bool valid = (len >= (int) offsetof(gatt_client_cache_t, entries))
+                && (cache->num_entries <= GATT_CLIENT_CACHE_MAX_ENTRIES)
+                && (len == (int) gatt_client_cache_storage_size(cache))
+                && (cache->addr_type == (uint8_t) addr_type)
+                && (memcmp(cache->addr, addr, 6) == 0)
+                && (memcmp(cache->database_hash, database_hash, 16) == 0);
+        if (valid){
+            log_info("GATT Client Cache: restored %u entries for %s", cache->num_entries, bd_addr_to_str(addr));
+            return;
+        }
+        if (len > 0){
+            log_info("GATT Client Cache: outdated for %s", bd_addr_to_str(addr));
+            tlv_impl->delete_tag(tlv_context, tag);
+        }
+    }
+
+    (void)memcpy(cache->addr, addr, 6);
+    cache->addr_type = (uint8_t) addr_type;
+    (void)memcpy(cache->database_hash, database_hash, 16);
+    cache->services_complete = 0;
+    cache->num_entries = 0;
+}
+
+static void gatt_client_cache_store(gatt_client_t * gatt_client){
+    if (gatt_client->cache_state != GATT_CLIENT_CACHE_STATE_ACTIVE) return;
+    if (gatt_client->cache_dirty == false) return;
+    gatt_client->cache_dirty = false;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+
+    log_info("GATT Client Cache: store %u entries", gatt_client->cache.num_entries);
+    uint32_t tag = GATT_CLIENT_CACHE_TLV_TAG(gatt_client->le_device_index);
+    int result = tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &gatt_client->cache,
+                                     gatt_client_cache_storage_size(&gatt_client->cache));
+    if (result != 0){
+        log_error("GATT Client Cache: store tag failed");
+    }
+}
+
+// Service Changed indication invalidates cache, Database Hash is read again on next query
+static void gatt_client_cache_handle_indication(gatt_client_t * gatt_client, uint16_t value_handle){
+    if (gatt_client->cache_state != GATT_CLIENT_CACHE_STATE_ACTIVE) return;
+    const gatt_client_cache_t * cache = &gatt_client->cache;
+    uint16_t i;
+    for (i = 0; i < cache->num_entries; i++){
+        const gatt_client_cache_entry_t * entry = &cache->entries[i];
+        if (entry->type != (uint8_t) GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC) continue;
+        if (entry->value_handle != value_handle) continue;
+        if (uuid_has_bluetooth_prefix(entry->uuid128) == 0) return;
+        if (big_endian_read_32(entry->uuid128, 0) != ORG_BLUETOOTH_CHARACTERISTIC_GATT_SERVICE_CHANGED) return;
+        log_info("GATT Client Cache: Service Changed, invalidate");
+        const btstack_tlv_t * tlv_impl = NULL;
+        void * tlv_context;
+        btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+        if (tlv_impl != NULL){
+            tlv_impl->delete_tag(tlv_context, GATT_CLIENT_CACHE_TLV_TAG(gatt_client->le_device_index));
+        }
+        gatt_client->cache_state = GATT_CLIENT_CACHE_STATE_UNKNOWN;
+        gatt_client->cache_query = GATT_CLIENT_CACHE_ENTRY_NONE;
+        gatt_client->cache_dirty = false;
+        gatt_client->cache.services_complete = 0;
+        gatt_client->cache.num_entries = 0;
+        return;
+    }
+}
+#endif
+
 // returns true if packet was sent
 static bool gatt_client_run_for_gatt_client(gatt_client_t * gatt_client){
 
@@ -1005,6 +1401,12 @@ static bool gatt_client_run_for_gatt_client(gatt_client_t * gatt_client){
     if (gatt_client->l2cap_psm != 0){
         check_security = false;
     }
+#endif
+#ifdef ENABLE_GATT_OVER_EATT
+    // EATT bearers require encryption
+    if (gatt_client->eatt_cid != 0){
+        check_security = false;
+    }
 #endif
     if (client_request_pending && (gatt_client_required_security_level > gatt_client->security_level) && check_security){
         log_info("Trigger pairing, current security level %u, required %u\n", gatt_client->security_level, gatt_client_required_security_level);
@@ -1041,6 +1443,10 @@ static bool gatt_client_run_for_gatt_client(gatt_client_t * gatt_client){
         return true;
     }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    if (gatt_client_cache_handle_query(gatt_client)) return false;
+#endif
+
     // check MTU for writes
     switch (gatt_client->gatt_client_state){
         case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
@@ -1057,6 +1463,13 @@ static bool gatt_client_run_for_gatt_client(gatt_client_t * gatt_client){
     bool packet_sent = true;
     bool done = true;
     switch (gatt_client->gatt_client_state){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        case P_W2_SEND_DATABASE_HASH_QUERY:
+            gatt_client->gatt_client_state = P_W4_DATABASE_HASH_QUERY_RESULT;
+            att_read_by_type_or_group_request_for_uuid16(gatt_client, ATT_READ_BY_TYPE_REQUEST,
+                                                         ORG_BLUETOOTH_CHARACTERISTIC_DATABASE_HASH, 0x0001, 0xffff);
+            break;
+#endif
         case P_W2_SEND_SERVICE_QUERY:
             gatt_client->gatt_client_state = P_W4_SERVICE_QUERY_RESULT;
             send_gatt_services_request(gatt_client);
@@ -1112,6 +1525,11 @@ static bool gatt_client_run_for_gatt_client(gatt_client_t * gatt_client){
             send_gatt_read_multiple_request(gatt_client);
             break;
 
+        case P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST:
+            gatt_client->gatt_client_state = P_W4_READ_MULTIPLE_VARIABLE_RESPONSE;
+            send_gatt_read_multiple_variable_request(gatt_client);
+            break;
+
         case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
             gatt_client->gatt_client_state = P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT;
             send_gatt_write_attribute_value_request(gatt_client);
@@ -1267,6 +1685,25 @@ static void gatt_client_run(void){
     btstack_linked_item_t *it;
     for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
         gatt_client_t * gatt_client = (gatt_client_t *) it;
+#ifdef ENABLE_GATT_OVER_EATT
+        // handle EATT bearers, each with its own L2CAP channel
+        btstack_linked_item_t *eatt_it;
+        for (eatt_it = (btstack_linked_item_t *) gatt_client->eatt_clients; eatt_it != NULL; eatt_it = eatt_it->next){
+            gatt_client_t * eatt_client = (gatt_client_t *) eatt_it;
+            if (eatt_client->gatt_client_state == P_W4_L2CAP_CONNECTION) {
+                continue;
+            }
+            // skip idle bearers, don't request can send now without pending request or confirmation
+            if (is_ready(eatt_client) && (eatt_client->send_confirmation == 0)) {
+                continue;
+            }
+            if (l2cap_can_send_packet_now(eatt_client->eatt_cid)){
+                gatt_client_run_for_gatt_client(eatt_client);
+            } else {
+                l2cap_request_can_send_now_event(eatt_client->eatt_cid);
+            }
+        }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
         if (gatt_client->con_handle == HCI_CON_HANDLE_INVALID) {
             continue;
@@ -1371,6 +1808,15 @@ static void gatt_client_handle_disconnection_complete(const uint8_t * packet){
 
     gatt_client_report_error_if_pending(gatt_client, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
     gatt_client_timeout_stop(gatt_client);
+#ifdef ENABLE_GATT_OVER_EATT
+    while (gatt_client->eatt_clients != NULL){
+        gatt_client_eatt_finalize((gatt_client_t *) gatt_client->eatt_clients, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+    }
+    gatt_client->eatt_state = GATT_CLIENT_EATT_IDLE;
+#endif
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_store(gatt_client);
+#endif
     btstack_linked_list_remove(&gatt_client_connections, (btstack_linked_item_t *) gatt_client);
     btstack_memory_gatt_client_free(gatt_client);
 }
@@ -1485,6 +1931,11 @@ static void gatt_client_handle_att_read_response(gatt_client_t *gatt_client, uin
 
 static void gatt_client_handle_att_read_by_type_response(gatt_client_t *gatt_client, uint8_t *packet, uint16_t size) {
     switch (gatt_client->gatt_client_state) {
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        case P_W4_DATABASE_HASH_QUERY_RESULT:
+            gatt_client_cache_handle_database_hash(gatt_client, packet, size);
+            break;
+#endif
         case P_W4_ALL_CHARACTERISTICS_OF_SERVICE_QUERY_RESULT:
             report_gatt_characteristics(gatt_client, packet, size);
             trigger_next_characteristic_query(gatt_client,
@@ -1621,9 +2072,21 @@ static void gatt_client_handle_att_response(gatt_client_t * gatt_client, uint8_t
             if (size < 3u) return;
             report_gatt_notification(gatt_client, little_endian_read_16(packet, 1u), &packet[3], size - 3u);
             return;
+        case ATT_MULTIPLE_HANDLE_VALUE_NTF:
+            report_gatt_multiple_notification(gatt_client, packet, size);
+            return;
         case ATT_HANDLE_VALUE_INDICATION:
             if (size < 3u) break;
             report_gatt_indication(gatt_client, little_endian_read_16(packet, 1u), &packet[3], size - 3u);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            {
+                // cache is managed by the unenhanced context, also for indications received over EATT
+                gatt_client_t * cache_client = gatt_client_get_context_for_handle(gatt_client->con_handle);
+                if (cache_client != NULL){
+                    gatt_client_cache_handle_indication(cache_client, little_endian_read_16(packet, 1u));
+                }
+            }
+#endif
             gatt_client->send_confirmation = 1;
             break;
         case ATT_READ_BY_TYPE_RESPONSE:
@@ -1793,9 +2256,29 @@ static void gatt_client_handle_att_response(gatt_client_t * gatt_client, uint8_t
             }
             break;
 
+        case ATT_READ_MULTIPLE_VARIABLE_RSP:
+            switch (gatt_client->gatt_client_state) {
+                case P_W4_READ_MULTIPLE_VARIABLE_RESPONSE:
+                    report_gatt_multiple_variable_characteristic_values(gatt_client, packet, size);
+                    gatt_client_handle_transaction_complete(gatt_client);
+                    emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
+                    break;
+                default:
+                    break;
+            }
+            break;
+
         case ATT_ERROR_RESPONSE:
             if (size < 5u) return;
             error_code = packet[4];
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            // no Database Hash, continue query without cache
+            if (gatt_client->gatt_client_state == P_W4_DATABASE_HASH_QUERY_RESULT){
+                gatt_client->cache_state = GATT_CLIENT_CACHE_STATE_DISABLED;
+                gatt_client->gatt_client_state = gatt_client->cache_resume_state;
+                break;
+            }
+#endif
             switch (error_code) {
                 case ATT_ERROR_ATTRIBUTE_NOT_FOUND: {
                     switch (gatt_client->gatt_client_state) {
@@ -1803,12 +2286,18 @@ static void gatt_client_handle_att_response(gatt_client_t * gatt_client, uint8_t
                         case P_W4_SERVICE_WITH_UUID_RESULT:
                         case P_W4_INCLUDED_SERVICE_QUERY_RESULT:
                         case P_W4_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT:
+#ifdef ENABLE_GATT_CLIENT_CACHE
+                            gatt_client_cache_query_succeeded(gatt_client);
+#endif
                             gatt_client_handle_transaction_complete(gatt_client);
                             emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
                             break;
                         case P_W4_ALL_CHARACTERISTICS_OF_SERVICE_QUERY_RESULT:
                         case P_W4_CHARACTERISTIC_WITH_UUID_QUERY_RESULT:
                             characteristic_end_found(gatt_client, gatt_client->end_group_handle);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+                            gatt_client_cache_query_succeeded(gatt_client);
+#endif
                             gatt_client_handle_transaction_complete(gatt_client);
                             emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
                             break;
@@ -1856,6 +2345,9 @@ static void gatt_client_handle_att_response(gatt_client_t * gatt_client, uint8_t
                             case P_W4_READ_MULTIPLE_RESPONSE:
                                 gatt_client->gatt_client_state = P_W2_SEND_READ_MULTIPLE_REQUEST;
                                 break;
+                            case P_W4_READ_MULTIPLE_VARIABLE_RESPONSE:
+                                gatt_client->gatt_client_state = P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST;
+                                break;
                             case P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT:
                                 gatt_client->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_VALUE;
                                 break;
@@ -1962,6 +2454,7 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
     // special cases: notifications & indications motivate creating context
     switch (packet[0]) {
         case ATT_HANDLE_VALUE_NOTIFICATION:
+        case ATT_MULTIPLE_HANDLE_VALUE_NTF:
         case ATT_HANDLE_VALUE_INDICATION:
             gatt_client_provide_context_for_handle(handle, &gatt_client);
             break;
@@ -2015,13 +2508,10 @@ uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callb
 
 uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = 0x0001;
@@ -2034,13 +2524,10 @@ uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback,
 
 uint8_t gatt_client_discover_secondary_services(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = 0x0001;
@@ -2053,13 +2540,10 @@ uint8_t gatt_client_discover_secondary_services(btstack_packet_handler_t callbac
 
 uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = 0x0001;
@@ -2073,13 +2557,10 @@ uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t
 
 uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, const uint8_t * uuid128){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = 0x0001;
@@ -2093,13 +2574,10 @@ uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_
 
 uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t * service){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = service->start_group_handle;
@@ -2113,13 +2591,10 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
 
 uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t * service){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
     gatt_client->callback = callback;
     gatt_client->start_group_handle = service->start_group_handle;
     gatt_client->end_group_handle   = service->end_group_handle;
@@ -2131,13 +2606,10 @@ uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t
 
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = start_handle;
@@ -2153,13 +2625,10 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_
 
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = start_handle;
@@ -2184,13 +2653,10 @@ uint8_t gatt_client_discover_characteristics_for_service_by_uuid128(btstack_pack
 
 uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
     
     if (characteristic->value_handle == characteristic->end_handle){
         emit_gatt_complete_event(gatt_client, ATT_ERROR_SUCCESS);
@@ -2206,13 +2672,10 @@ uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t
 
 uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = value_handle;
@@ -2224,13 +2687,10 @@ uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_pack
 
 uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = start_handle;
@@ -2246,13 +2706,10 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handl
 
 uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->start_group_handle = start_handle;
@@ -2273,13 +2730,10 @@ uint8_t gatt_client_read_value_of_characteristic(btstack_packet_handler_t callba
 
 uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t offset){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = value_handle;
@@ -2299,13 +2753,10 @@ uint8_t gatt_client_read_long_value_of_characteristic(btstack_packet_handler_t c
 
 uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->read_multiple_handle_count = num_value_handles;
@@ -2315,6 +2766,21 @@ uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t
     return ERROR_CODE_SUCCESS;
 }
 
+uint8_t gatt_client_read_multiple_variable_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles){
+    gatt_client_t * gatt_client;
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
+    if (status != ERROR_CODE_SUCCESS){
+        return status;
+    }
+
+    gatt_client->callback = callback;
+    gatt_client->read_multiple_handle_count = num_value_handles;
+    gatt_client->read_multiple_handles = value_handles;
+    gatt_client->gatt_client_state = P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST;
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
 uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
     uint8_t status = gatt_client_provide_context_for_handle(con_handle, &gatt_client);
@@ -2330,13 +2796,10 @@ uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handl
 
 uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = value_handle;
@@ -2349,13 +2812,10 @@ uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callb
 
 uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t offset, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = value_handle;
@@ -2373,13 +2833,10 @@ uint8_t gatt_client_write_long_value_of_characteristic(btstack_packet_handler_t
 
 uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = value_handle;
@@ -2393,13 +2850,10 @@ uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_h
 
 uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic, uint16_t configuration){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
     
     if ( (configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) &&
         ((characteristic->properties & ATT_PROPERTY_NOTIFY) == 0u)) {
@@ -2427,13 +2881,10 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
 
 uint8_t gatt_client_read_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = descriptor_handle;
@@ -2449,13 +2900,10 @@ uint8_t gatt_client_read_characteristic_descriptor(btstack_packet_handler_t call
 
 uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = descriptor_handle;
@@ -2475,13 +2923,10 @@ uint8_t gatt_client_read_long_characteristic_descriptor(btstack_packet_handler_t
 
 uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = descriptor_handle;
@@ -2499,13 +2944,10 @@ uint8_t gatt_client_write_characteristic_descriptor(btstack_packet_handler_t cal
 
 uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = descriptor_handle;
@@ -2530,13 +2972,10 @@ uint8_t gatt_client_write_long_characteristic_descriptor(btstack_packet_handler_
  */
 uint8_t gatt_client_prepare_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint16_t value_length, uint8_t * value){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->attribute_handle = attribute_handle;
@@ -2553,13 +2992,10 @@ uint8_t gatt_client_prepare_write(btstack_packet_handler_t callback, hci_con_han
  */
 uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->gatt_client_state = P_W2_EXECUTE_PREPARED_WRITE;
@@ -2572,13 +3008,10 @@ uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_han
  */
 uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
     gatt_client_t * gatt_client;
-    uint8_t status = gatt_client_provide_context_for_handle_and_start_timer(con_handle, &gatt_client);
+    uint8_t status = gatt_client_provide_context_for_request(con_handle, &gatt_client);
     if (status != ERROR_CODE_SUCCESS){
         return status;
     }
-    if (is_ready(gatt_client) == 0){
-        return GATT_CLIENT_IN_WRONG_STATE;
-    }
 
     gatt_client->callback = callback;
     gatt_client->gatt_client_state = P_W2_CANCEL_PREPARED_WRITE;
@@ -2903,6 +3336,192 @@ uint8_t gatt_client_classic_disconnect(btstack_packet_handler_t callback, hci_co
 }
 #endif
 
+#ifdef ENABLE_GATT_OVER_EATT
+
+#include "hci_event.h"
+
+// long characteristic value event header is 10 bytes, ATT PDU header at least 1 byte
+#define GATT_CLIENT_EATT_RECEIVE_PRE_BUFFER_SIZE 9u
+
+static const hci_event_t gatt_client_eatt_connected = {
+        GATT_EVENT_CONNECTED, 0, "1BH"
+};
+
+static gatt_client_t * gatt_client_eatt_get_context_for_cid(uint16_t eatt_cid, gatt_client_t ** out_gatt_client){
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+        gatt_client_t * gatt_client = (gatt_client_t *) it;
+        btstack_linked_item_t *eatt_it;
+        for (eatt_it = (btstack_linked_item_t *) gatt_client->eatt_clients; eatt_it != NULL; eatt_it = eatt_it->next){
+            gatt_client_t * eatt_client = (gatt_client_t *) eatt_it;
+            if (eatt_client->eatt_cid == eatt_cid){
+                *out_gatt_client = gatt_client;
+                return eatt_client;
+            }
+        }
+    }
+    return NULL;
+}
+
+// remove EATT bearer from its connection, pending request is completed with given error
+static void gatt_client_eatt_finalize(gatt_client_t * eatt_client, uint8_t att_error_code){
+    gatt_client_t * gatt_client = gatt_client_get_context_for_handle(eatt_client->con_handle);
+    btstack_assert(gatt_client != NULL);
+    btstack_linked_list_remove(&gatt_client->eatt_clients, (btstack_linked_item_t *) eatt_client);
+    if (gatt_client->eatt_clients == NULL){
+        // continue on unenhanced bearer
+        gatt_client->eatt_state = GATT_CLIENT_EATT_IDLE;
+    }
+    if (eatt_client->gatt_client_state != P_W4_L2CAP_CONNECTION){
+        gatt_client_report_error_if_pending(eatt_client, att_error_code);
+    }
+    gatt_client_timeout_stop(eatt_client);
+    btstack_memory_gatt_client_free(eatt_client);
+}
+
+static void gatt_client_eatt_handle_channel_opened(gatt_client_t * gatt_client, gatt_client_t * eatt_client, const uint8_t * packet){
+    if (l2cap_event_ecbm_channel_opened_get_status(packet) == ERROR_CODE_SUCCESS){
+        uint16_t remote_mtu = l2cap_event_ecbm_channel_opened_get_remote_mtu(packet);
+        eatt_client->mtu = btstack_min(remote_mtu, eatt_client->mtu);
+        eatt_client->gatt_client_state = P_READY;
+    } else {
+        gatt_client_eatt_finalize(eatt_client, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+    }
+
+    btstack_assert(gatt_client->eatt_num_pending_channels > 0);
+    gatt_client->eatt_num_pending_channels--;
+    if (gatt_client->eatt_num_pending_channels > 0) return;
+
+    // all channels resolved, success if at least one bearer is available
+    uint8_t status = ERROR_CODE_SUCCESS;
+    if (gatt_client->eatt_clients == NULL){
+        gatt_client->eatt_state = GATT_CLIENT_EATT_IDLE;
+        status = ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES;
+    } else {
+        gatt_client->eatt_state = GATT_CLIENT_EATT_READY;
+    }
+
+    bd_addr_t addr;
+    memset(addr, 0, 6);
+    hci_connection_t * hci_connection = hci_connection_for_handle(gatt_client->con_handle);
+    if (hci_connection != NULL){
+        memcpy(addr, hci_connection->address, 6);
+    }
+    uint8_t buffer[20];
+    uint16_t len = hci_event_create_from_template_and_arguments(buffer, sizeof(buffer), &gatt_client_eatt_connected, status,
+                                                                addr, gatt_client->con_handle);
+    (*gatt_client->eatt_callback)(HCI_EVENT_PACKET, 0, buffer, len);
+
+    // serve queued queries on new bearers
+    gatt_client_notify_can_send_query(gatt_client);
+}
+
+static void gatt_client_eatt_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    gatt_client_t * gatt_client = NULL;
+    gatt_client_t * eatt_client;
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)) {
+                case L2CAP_EVENT_ECBM_CHANNEL_OPENED:
+                    eatt_client = gatt_client_eatt_get_context_for_cid(l2cap_event_ecbm_channel_opened_get_local_cid(packet), &gatt_client);
+                    if (eatt_client == NULL) break;
+                    gatt_client_eatt_handle_channel_opened(gatt_client, eatt_client, packet);
+                    break;
+                case L2CAP_EVENT_CAN_SEND_NOW:
+                    break;
+                case L2CAP_EVENT_CHANNEL_CLOSED:
+                    eatt_client = gatt_client_eatt_get_context_for_cid(l2cap_event_channel_closed_get_local_cid(packet), &gatt_client);
+                    if (eatt_client == NULL) break;
+                    gatt_client_eatt_finalize(eatt_client, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+                    break;
+                default:
+                    return;
+            }
+            break;
+        case L2CAP_DATA_PACKET:
+            eatt_client = gatt_client_eatt_get_context_for_cid(channel, &gatt_client);
+            if (eatt_client == NULL) return;
+            gatt_client_handle_att_response(eatt_client, packet, size);
+            break;
+        default:
+            return;
+    }
+    gatt_client_run();
+}
+
+uint8_t gatt_client_le_enhanced_connect(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint8_t num_channels, uint8_t * storage_buffer, uint16_t storage_size){
+    gatt_client_t * gatt_client;
+    uint8_t status = gatt_client_provide_context_for_handle(con_handle, &gatt_client);
+    if (status != ERROR_CODE_SUCCESS){
+        return status;
+    }
+    if (gatt_client->eatt_state != GATT_CLIENT_EATT_IDLE){
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    // EATT requires encrypted link, L2CAP does not trigger pairing
+    if (gap_encryption_key_size(con_handle) == 0){
+        return ERROR_CODE_INSUFFICIENT_SECURITY;
+    }
+    if ((num_channels == 0) || (num_channels > L2CAP_ECBM_MAX_CID_ARRAY_SIZE)){
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    // storage buffer provides receive and send buffer for each bearer. GATT events are assembled in place before
+    // the value in the received ATT PDU, so the receive buffer is preceded by room for the largest event header
+    uint16_t bearer_storage_size = storage_size / num_channels;
+    if (bearer_storage_size < (GATT_CLIENT_EATT_RECEIVE_PRE_BUFFER_SIZE + (2u * ATT_EATT_MIN_MTU))){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    uint16_t mtu = (bearer_storage_size - GATT_CLIENT_EATT_RECEIVE_PRE_BUFFER_SIZE) / 2u;
+
+    uint8_t * receive_buffers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint16_t new_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    gatt_client_t * eatt_clients[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t i;
+    for (i = 0; i < num_channels; i++){
+        gatt_client_t * eatt_client = btstack_memory_gatt_client_get();
+        if (eatt_client == NULL){
+            while (i > 0){
+                i--;
+                btstack_memory_gatt_client_free(eatt_clients[i]);
+            }
+            return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+        }
+        eatt_client->con_handle = con_handle;
+        eatt_client->mtu = mtu;
+        eatt_client->mtu_state = MTU_EXCHANGED;
+        eatt_client->security_level = gatt_client->security_level;
+        eatt_client->gatt_client_state = P_W4_L2CAP_CONNECTION;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        eatt_client->cache_state = GATT_CLIENT_CACHE_STATE_DISABLED;
+#endif
+        uint8_t * bearer_storage = &storage_buffer[i * bearer_storage_size];
+        eatt_client->eatt_receive_buffer = &bearer_storage[GATT_CLIENT_EATT_RECEIVE_PRE_BUFFER_SIZE];
+        eatt_client->eatt_send_buffer    = &bearer_storage[GATT_CLIENT_EATT_RECEIVE_PRE_BUFFER_SIZE + mtu];
+        receive_buffers[i] = eatt_client->eatt_receive_buffer;
+        eatt_clients[i] = eatt_client;
+    }
+
+    status = l2cap_ecbm_create_channels(&gatt_client_eatt_handler, con_handle, LEVEL_2, PSM_EATT, num_channels,
+                                        L2CAP_LE_AUTOMATIC_CREDITS, mtu, receive_buffers, new_cids);
+    if (status != ERROR_CODE_SUCCESS){
+        for (i = 0; i < num_channels; i++){
+            btstack_memory_gatt_client_free(eatt_clients[i]);
+        }
+        return status;
+    }
+
+    for (i = 0; i < num_channels; i++){
+        eatt_clients[i]->eatt_cid = new_cids[i];
+        btstack_linked_list_add_tail(&gatt_client->eatt_clients, (btstack_linked_item_t *) eatt_clients[i]);
+    }
+    gatt_client->eatt_callback = callback;
+    gatt_client->eatt_num_pending_channels = num_channels;
+    gatt_client->eatt_state = GATT_CLIENT_EATT_W4_CHANNELS_OPENED;
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
 void gatt_client_att_packet_handler_fuzz(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size){
     gatt_client_att_packet_handler(packet_type, handle, packet, size);
@@ -81,6 +81,9 @@ typedef enum {
     P_W2_SEND_READ_MULTIPLE_REQUEST,
     P_W4_READ_MULTIPLE_RESPONSE,
 
+    P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST,
+    P_W4_READ_MULTIPLE_VARIABLE_RESPONSE,
+
     P_W2_SEND_WRITE_CHARACTERISTIC_VALUE,
     P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT,
     
@@ -134,6 +137,11 @@ typedef enum {
     P_W2_SDP_QUERY,
     P_W4_SDP_QUERY,
     P_W4_L2CAP_CONNECTION,
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    P_W2_SEND_DATABASE_HASH_QUERY,
+    P_W4_DATABASE_HASH_QUERY_RESULT,
+#endif
 } gatt_client_state_t;
     
     
@@ -144,6 +152,59 @@ typedef enum{
     MTU_AUTO_EXCHANGE_DISABLED
 } gatt_client_mtu_t;
 
+#ifdef ENABLE_GATT_OVER_EATT
+typedef enum {
+    GATT_CLIENT_EATT_IDLE,
+    GATT_CLIENT_EATT_W4_CHANNELS_OPENED,
+    GATT_CLIENT_EATT_READY,
+} gatt_client_eatt_state_t;
+#endif
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+
+#ifndef GATT_CLIENT_CACHE_MAX_ENTRIES
+#define GATT_CLIENT_CACHE_MAX_ENTRIES 64
+#endif
+
+// TLV tag for GATT Client cache of LE Device DB entry, also deleted by LE Device DB TLV
+#define GATT_CLIENT_CACHE_TLV_TAG(index) ((((uint32_t) 'G') << 24u) | (((uint32_t) 'C') << 16u) | (((uint32_t) 'C') << 8u) | (uint8_t) (index))
+
+typedef enum {
+    GATT_CLIENT_CACHE_STATE_UNKNOWN = 0,
+    GATT_CLIENT_CACHE_STATE_ACTIVE,
+    GATT_CLIENT_CACHE_STATE_DISABLED,
+} gatt_client_cache_state_t;
+
+typedef enum {
+    GATT_CLIENT_CACHE_ENTRY_NONE = 0,
+    GATT_CLIENT_CACHE_ENTRY_SERVICE,
+    GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC,
+    GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR,
+} gatt_client_cache_entry_type_t;
+
+typedef struct {
+    uint8_t  type;
+    // service: characteristics cached, characteristic: descriptors cached
+    uint8_t  complete;
+    uint16_t start_handle;
+    uint16_t value_handle;
+    uint16_t end_handle;
+    uint16_t properties;
+    uint8_t  uuid128[16];
+} gatt_client_cache_entry_t;
+
+// stored in TLV up to and including entries[num_entries-1]
+typedef struct {
+    bd_addr_t addr;
+    uint8_t   addr_type;
+    uint8_t   services_complete;
+    uint8_t   database_hash[16];
+    uint16_t  num_entries;
+    gatt_client_cache_entry_t entries[GATT_CLIENT_CACHE_MAX_ENTRIES];
+} gatt_client_cache_t;
+
+#endif
+
 typedef struct gatt_client{
     btstack_linked_item_t    item;
     // TODO: rename gatt_client_state -> state
@@ -170,6 +231,18 @@ typedef struct gatt_client{
     btstack_context_callback_registration_t sdp_query_request;
 #endif
 
+#ifdef ENABLE_GATT_OVER_EATT
+    // unenhanced bearer: EATT bearers of this connection
+    gatt_client_eatt_state_t eatt_state;
+    btstack_linked_list_t    eatt_clients;
+    btstack_packet_handler_t eatt_callback;
+    uint8_t                  eatt_num_pending_channels;
+    // EATT bearer: L2CAP channel in Enhanced Credit-Based Flow-Control Mode, 0 for unenhanced bearer
+    uint16_t                 eatt_cid;
+    uint8_t *                eatt_send_buffer;
+    uint8_t *                eatt_receive_buffer;
+#endif
+
     uint16_t          mtu;
     gatt_client_mtu_t mtu_state;
     
@@ -214,6 +287,18 @@ typedef struct gatt_client{
 
     gap_security_level_t security_level;
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_state_t cache_state;
+    gatt_client_state_t       cache_resume_state;
+    bool     cache_checked;
+    bool     cache_dirty;
+    // entry type recorded by current query, parent entry and number of entries before query
+    uint8_t  cache_query;
+    uint16_t cache_query_entry;
+    uint16_t cache_query_num_entries;
+    gatt_client_cache_t cache;
+#endif
+
 } gatt_client_t;
 
 typedef struct gatt_client_notification {
@@ -266,6 +351,23 @@ void gatt_client_init(void);
  */
 void gatt_client_set_required_security_level(gap_security_level_t level);
 
+#ifdef ENABLE_GATT_OVER_EATT
+/**
+ * @brief Open Enhanced ATT bearers to remote GATT Server on encrypted LE Connection
+ *        GATT_EVENT_CONNECTED with status and con_handle is emitted when all bearers have been opened or failed
+ *        Afterwards, GATT requests for con_handle are scheduled on any idle bearer: the unenhanced bearer first,
+ *        then the EATT bearers. If no EATT bearer can be opened, requests continue on the unenhanced bearer.
+ * @note Each EATT bearer uses a GATT Client context, see MAX_NR_GATT_CLIENTS
+ * @param callback
+ * @param con_handle
+ * @param num_channels up to 5
+ * @param storage_buffer for receive and send buffers, each bearer uses 2 * MTU + 9 bytes
+ * @param storage_size
+ * @return status
+ */
+uint8_t gatt_client_le_enhanced_connect(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint8_t num_channels, uint8_t * storage_buffer, uint16_t storage_size);
+#endif
+
 /**
  * @brief Connect to remote GATT Server over Classic (BR/EDR) Connection
  *        GATT_EVENT_CONNECTED with status and con_handle for other API functions
@@ -588,6 +690,21 @@ uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_of
  */
 uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles);
 
+/**
+ * @brief Reads the values of multiple characteristics of variable length using their value handles in a single request.
+ * Each value is emitted via a GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT event with its value handle,
+ * followed by the GATT_EVENT_QUERY_COMPLETE event, which marks the end of read.
+ * If the values don't fit into the MTU, the last value is truncated and the following ones are not reported.
+ * @param  callback
+ * @param  con_handle
+ * @param  num_value_handles
+ * @param  value_handles list of handles, needs to stay valid until GATT_EVENT_QUERY_COMPLETE
+ * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                ERROR_CODE_SUCCESS         , if query is successfully registered
+ */
+uint8_t gatt_client_read_multiple_variable_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles);
+
 /** 
  * @brief Writes the characteristic value using the characteristic's value handle without 
  * an acknowledgment that the write was successfully performed.
@@ -100,6 +100,13 @@ int le_device_db_count(void);
  */
 int le_device_db_max_count(void);
 
+/**
+ * @brief get generation of db content, which changes whenever a device is added or removed or the db is (re-)loaded
+ * @note used to invalidate information derived from the stored devices, e.g. cached address resolution results
+ * @return generation
+ */
+uint32_t le_device_db_generation(void);
+
 /**
  * @brief get device information: addr type and address needed to identify device
  * @param index
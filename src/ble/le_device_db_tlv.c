@@ -41,6 +41,7 @@
 #include "ble/le_device_db_tlv.h"
 
 #include "ble/core.h"
+#include "ble/gatt_client.h"
 
 #include <string.h>
 #include "btstack_debug.h"
@@ -96,6 +97,7 @@ typedef struct le_device_db_entry_t {
 // only stores if entry present
 static uint8_t  entry_map[NVM_NUM_DEVICE_DB_ENTRIES];
 static uint32_t num_valid_entries;
+static uint32_t le_device_db_tlv_generation;
 
 static const btstack_tlv_t * le_device_db_tlv_btstack_tlv_impl;
 static       void *          le_device_db_tlv_btstack_tlv_context;
@@ -144,6 +146,14 @@ static bool le_device_db_tlv_delete(int index){
 	return true;
 }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// GATT Client cache is stored per LE Device DB index
+static void le_device_db_tlv_delete_gatt_client_cache(int index){
+    uint32_t tag = GATT_CLIENT_CACHE_TLV_TAG(index);
+    le_device_db_tlv_btstack_tlv_impl->delete_tag(le_device_db_tlv_btstack_tlv_context, tag);
+}
+#endif
+
 static void le_device_db_tlv_scan(void){
     int i;
     num_valid_entries = 0;
@@ -156,6 +166,7 @@ static void le_device_db_tlv_scan(void){
         entry_map[i] = 1;
         num_valid_entries++;
     }
+    le_device_db_tlv_generation++;
     log_info("num valid le device entries %u", (unsigned int) num_valid_entries);
 }
 
@@ -179,6 +190,10 @@ int le_device_db_max_count(void){
     return NVM_NUM_DEVICE_DB_ENTRIES;
 }
 
+uint32_t le_device_db_generation(void){
+    return le_device_db_tlv_generation;
+}
+
 void le_device_db_remove(int index){
     btstack_assert(index >= 0);
     btstack_assert(index < le_device_db_max_count());
@@ -188,12 +203,16 @@ void le_device_db_remove(int index){
 
 	// delete entry in TLV
 	le_device_db_tlv_delete(index);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    le_device_db_tlv_delete_gatt_client_cache(index);
+#endif
 
 	// mark as unused
     entry_map[index] = 0;
 
     // keep track
     num_valid_entries--;
+    le_device_db_tlv_generation++;
 }
 
 int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
@@ -239,6 +258,10 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
         index_to_use = index_for_empty;
     } else if (index_for_lowest_seq_nr >= 0){
         index_to_use = index_for_lowest_seq_nr;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        // entry gets replaced by a different device
+        le_device_db_tlv_delete_gatt_client_cache(index_to_use);
+#endif
     } else {
         // should not happen
         return -1;
@@ -274,6 +297,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
     if (new_entry){
         num_valid_entries++;
     }
+    le_device_db_tlv_generation++;
 
     return index_to_use;
 }
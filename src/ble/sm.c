@@ -87,6 +87,17 @@
 #define USE_CMAC_ENGINE
 #endif
 
+// resolve private addresses with local AES128 implementation for all IRKs in a single pass
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define USE_LOCAL_ADDRESS_RESOLUTION
+#ifndef SM_ADDRESS_RESOLUTION_CACHE_SIZE
+#define SM_ADDRESS_RESOLUTION_CACHE_SIZE 16
+#endif
+#if SM_ADDRESS_RESOLUTION_CACHE_SIZE > 0
+#define USE_ADDRESS_RESOLUTION_CACHE
+#endif
+#endif
+
 
 #define BTSTACK_TAG32(A,B,C,D) (((A) << 24) | ((B) << 16) | ((C) << 8) | (D))
 
@@ -259,6 +270,19 @@ static void *    sm_address_resolution_context;
 static address_resolution_mode_t sm_address_resolution_mode;
 static btstack_linked_list_t sm_address_resolution_general_queue;
 
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+// recently resolved private addresses, most recently used first
+typedef struct {
+    bd_addr_t address;
+    // -1 if address could not be resolved
+    int16_t   le_device_db_index;
+} sm_address_resolution_cache_entry_t;
+static sm_address_resolution_cache_entry_t sm_address_resolution_cache[SM_ADDRESS_RESOLUTION_CACHE_SIZE];
+static uint16_t sm_address_resolution_cache_count;
+// le_device_db generation the cached results are based on
+static uint32_t sm_address_resolution_cache_generation;
+#endif
+
 // aes128 crypto engine.
 static sm_aes128_state_t  sm_aes128_state;
 
@@ -271,7 +295,9 @@ static btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
 
 // temp storage for random data
 static uint8_t sm_random_data[8];
+#ifndef USE_LOCAL_ADDRESS_RESOLUTION
 static uint8_t sm_aes128_key[16];
+#endif
 static uint8_t sm_aes128_plaintext[16];
 static uint8_t sm_aes128_ciphertext[16];
 
@@ -403,7 +429,9 @@ static sm_connection_t * sm_get_connection_for_bd_addr_and_type(bd_addr_t addres
 #endif
 static inline int sm_calc_actual_encryption_key_size(int other);
 static int sm_validate_stk_generation_method(void);
+#ifndef USE_LOCAL_ADDRESS_RESOLUTION
 static void sm_handle_encryption_result_address_resolution(void *arg);
+#endif
 static void sm_handle_encryption_result_dkg_dhk(void *arg);
 static void sm_handle_encryption_result_dkg_irk(void *arg);
 static void sm_handle_encryption_result_enc_a(void *arg);
@@ -924,6 +952,68 @@ static void sm_setup_key_distribution(uint8_t keys_to_send, uint8_t keys_to_rece
 // CSRK Key Lookup
 
 
+#ifdef USE_LOCAL_ADDRESS_RESOLUTION
+// ah(irk, prand) == hash
+static bool sm_address_resolution_ah_matches(const sm_key_t irk, bd_addr_t address){
+    sm_key_t r_prime;
+    sm_key_t ah;
+    sm_ah_r_prime(address, r_prime);
+    btstack_aes128_calc(irk, r_prime, ah);
+    return memcmp(&address[3], &ah[13], 3) == 0;
+}
+#endif
+
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+static bool sm_address_resolution_is_resolvable_private_address(uint8_t addr_type, const bd_addr_t address){
+    return (addr_type == BD_ADDR_TYPE_LE_RANDOM) && ((address[0] & 0xc0u) == 0x40u);
+}
+
+static int sm_address_resolution_cache_find(const bd_addr_t address){
+    int i;
+    for (i = 0; i < sm_address_resolution_cache_count; i++){
+        if (memcmp(sm_address_resolution_cache[i].address, address, 6) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void sm_address_resolution_cache_remove(int pos){
+    sm_address_resolution_cache_count--;
+    (void)memmove(&sm_address_resolution_cache[pos], &sm_address_resolution_cache[pos + 1],
+                  (sm_address_resolution_cache_count - pos) * sizeof(sm_address_resolution_cache_entry_t));
+}
+
+// IRKs changed
+static void sm_address_resolution_cache_flush(void){
+    sm_address_resolution_cache_count = 0;
+}
+
+// drop all results if le_device_db changed since, e.g. by le_device_db_add() from app or reload from TLV
+static void sm_address_resolution_cache_validate(void){
+    uint32_t generation = le_device_db_generation();
+    if (generation == sm_address_resolution_cache_generation) return;
+    sm_address_resolution_cache_generation = generation;
+    sm_address_resolution_cache_flush();
+}
+
+static void sm_address_resolution_cache_add(const bd_addr_t address, int le_device_db_index){
+    sm_address_resolution_cache_validate();
+    int pos = sm_address_resolution_cache_find(address);
+    if (pos >= 0){
+        sm_address_resolution_cache_remove(pos);
+    } else if (sm_address_resolution_cache_count == SM_ADDRESS_RESOLUTION_CACHE_SIZE){
+        // drop least recently used
+        sm_address_resolution_cache_count--;
+    }
+    (void)memmove(&sm_address_resolution_cache[1], &sm_address_resolution_cache[0],
+                  sm_address_resolution_cache_count * sizeof(sm_address_resolution_cache_entry_t));
+    (void)memcpy(sm_address_resolution_cache[0].address, address, 6);
+    sm_address_resolution_cache[0].le_device_db_index = (int16_t) le_device_db_index;
+    sm_address_resolution_cache_count++;
+}
+#endif
+
 static int sm_address_resolution_idle(void){
     return sm_address_resolution_mode == ADDRESS_RESOLUTION_IDLE;
 }
@@ -1272,6 +1362,12 @@ static void sm_address_resolution_handle_event(address_resolution_event_t event)
     address_resolution_mode_t mode = sm_address_resolution_mode;
     void * context = sm_address_resolution_context;
 
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+    if (sm_address_resolution_is_resolvable_private_address(sm_address_resolution_addr_type, sm_address_resolution_address)){
+        sm_address_resolution_cache_add(sm_address_resolution_address, (event == ADDRESS_RESOLUTION_SUCCEEDED) ? matched_device_id : -1);
+    }
+#endif
+
     // reset context
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_context = NULL;
@@ -2184,6 +2280,26 @@ static bool sm_run_rau(void){
     return false;
 }
 
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+// returns true if lookup was completed
+static bool sm_address_resolution_cache_lookup(void){
+    if (!sm_address_resolution_is_resolvable_private_address(sm_address_resolution_addr_type, sm_address_resolution_address)) return false;
+    sm_address_resolution_cache_validate();
+    int pos = sm_address_resolution_cache_find(sm_address_resolution_address);
+    if (pos < 0) return false;
+    int le_device_db_index = sm_address_resolution_cache[pos].le_device_db_index;
+    if (le_device_db_index < 0){
+        log_info("LE Device Lookup: not found (cached)");
+        sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
+        return true;
+    }
+    log_info("LE Device Lookup: matched resolvable private address (cached), device %u", le_device_db_index);
+    sm_address_resolution_test = le_device_db_index;
+    sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCCEEDED);
+    return true;
+}
+#endif
+
 // CSRK Lookup
 static bool sm_run_csrk(void){
     btstack_linked_list_iterator_t it;
@@ -2213,6 +2329,16 @@ static bool sm_run_csrk(void){
         }
     }
 
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+    // -- Use cached result for recently seen resolvable private address
+    if (!sm_address_resolution_idle() && (sm_address_resolution_test == 0) && sm_address_resolution_cache_lookup()){
+        if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
+            sm_trigger_run();
+        }
+        return false;
+    }
+#endif
+
     // -- Continue with device lookup by public or resolvable private address
     if (!sm_address_resolution_idle()){
         while (sm_address_resolution_test < le_device_db_max_count()){
@@ -2227,7 +2353,9 @@ static bool sm_run_csrk(void){
                 continue;
             }
 
+#ifndef USE_LOCAL_ADDRESS_RESOLUTION
             log_info("LE Device Lookup: device %u of %u", sm_address_resolution_test, le_device_db_max_count());
+#endif
 
             if ((sm_address_resolution_addr_type == addr_type) && (memcmp(addr, sm_address_resolution_address, 6) == 0)){
                 log_info("LE Device Lookup: found by { addr_type, address} ");
@@ -2247,6 +2375,14 @@ static bool sm_run_csrk(void){
                 continue;
             }
 
+#ifdef USE_LOCAL_ADDRESS_RESOLUTION
+            if (sm_address_resolution_ah_matches(irk, sm_address_resolution_address)){
+                log_info("LE Device Lookup: matched resolvable private address, device %u", sm_address_resolution_test);
+                sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCCEEDED);
+                break;
+            }
+            sm_address_resolution_test++;
+#else
             if (sm_aes128_state == SM_AES128_ACTIVE) break;
 
             log_info("LE Device Lookup: calculate AH");
@@ -2257,12 +2393,20 @@ static bool sm_run_csrk(void){
             sm_aes128_state = SM_AES128_ACTIVE;
             btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_aes128_key, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_address_resolution, NULL);
             return true;
+#endif
         }
 
         if (sm_address_resolution_test >= le_device_db_max_count()){
             log_info("LE Device Lookup: not found");
             sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
         }
+
+#ifdef USE_LOCAL_ADDRESS_RESOLUTION
+        // lookup complete, continue with next address
+        if (sm_address_resolution_idle() && !btstack_linked_list_empty(&sm_address_resolution_general_queue)){
+            sm_trigger_run();
+        }
+#endif
     }
     return false;
 }
@@ -3469,6 +3613,7 @@ static void sm_handle_encryption_result_enc_ph4_ltk(void *arg){
 }
 #endif
 
+#ifndef USE_LOCAL_ADDRESS_RESOLUTION
 static void sm_handle_encryption_result_address_resolution(void *arg){
     UNUSED(arg);
     sm_aes128_state = SM_AES128_IDLE;
@@ -3485,6 +3630,7 @@ static void sm_handle_encryption_result_address_resolution(void *arg){
     sm_address_resolution_test++;
     sm_trigger_run();
 }
+#endif
 
 static void sm_handle_encryption_result_dkg_irk(void *arg){
     UNUSED(arg);
@@ -4892,6 +5038,9 @@ static void sm_state_reset(void) {
     sm_address_resolution_test = -1;    // no private address to resolve yet
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_general_queue = NULL;
+#ifdef USE_ADDRESS_RESOLUTION_CACHE
+    sm_address_resolution_cache_flush();
+#endif
     sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
     sm_persistent_keys_random_active = false;
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
@@ -716,6 +716,9 @@ typedef enum {
 // Minimum/default MTU
 #define ATT_DEFAULT_MTU               23
 
+// Minimum MTU for Enhanced ATT bearer
+#define ATT_EATT_MIN_MTU              64
+
 // MARK: ATT Error Codes
 #define ATT_ERROR_SUCCESS                          0x00
 #define ATT_ERROR_INVALID_HANDLE                   0x01
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_aes128.c"
+
+/*
+ *  btstack_aes128.c
+ *
+ */
+
+#include "btstack_config.h"
+
+#ifdef ENABLE_SOFTWARE_AES128
+
+#include <string.h>
+
+#include "btstack_aes128.h"
+#include "btstack_util.h"
+#include "rijndael.h"
+
+// x86 with AES-NI, detected at runtime
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BTSTACK_AES128_X86_AES_NI
+#include <wmmintrin.h>
+#endif
+
+// ARMv8 with Cryptography Extension, requires compiler flag, e.g. -march=armv8-a+crypto
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#define BTSTACK_AES128_ARMV8_CE
+#include <arm_neon.h>
+#endif
+
+#define BTSTACK_AES128_NUM_ROUNDS 10
+
+typedef enum {
+    BTSTACK_AES128_CPU_UNKNOWN = 0,
+    BTSTACK_AES128_CPU_PORTABLE,
+    BTSTACK_AES128_CPU_ACCELERATED
+} btstack_aes128_cpu_t;
+
+static btstack_aes128_cpu_t btstack_aes128_cpu;
+
+#ifdef BTSTACK_AES128_X86_AES_NI
+__attribute__((target("aes,sse2")))
+static __m128i btstack_aes128_expand_key_step_aes_ni(__m128i key, __m128i key_gen){
+    key_gen = _mm_shuffle_epi32(key_gen, _MM_SHUFFLE(3, 3, 3, 3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, key_gen);
+}
+
+// round constant has to be an immediate value
+#define BTSTACK_AES128_EXPAND_KEY_AES_NI(round, rcon) \
+    key = btstack_aes128_expand_key_step_aes_ni(key, _mm_aeskeygenassist_si128(key, rcon)); \
+    _mm_storeu_si128(&rk[round], key)
+
+__attribute__((target("aes,sse2")))
+static void btstack_aes128_expand_key_aes_ni(const uint8_t * key_bytes, uint8_t * round_keys){
+    __m128i * rk = (__m128i *) round_keys;
+    __m128i key = _mm_loadu_si128((const __m128i *) key_bytes);
+    _mm_storeu_si128(&rk[0], key);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 1, 0x01);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 2, 0x02);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 3, 0x04);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 4, 0x08);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 5, 0x10);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 6, 0x20);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 7, 0x40);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 8, 0x80);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI( 9, 0x1b);
+    BTSTACK_AES128_EXPAND_KEY_AES_NI(10, 0x36);
+}
+
+__attribute__((target("aes,sse2")))
+static void btstack_aes128_encrypt_block_aes_ni(const uint8_t * round_keys, const uint8_t * plaintext, uint8_t * ciphertext){
+    const __m128i * rk = (const __m128i *) round_keys;
+    __m128i block = _mm_loadu_si128((const __m128i *) plaintext);
+    block = _mm_xor_si128(block, _mm_loadu_si128(&rk[0]));
+    int i;
+    for (i = 1; i < BTSTACK_AES128_NUM_ROUNDS; i++){
+        block = _mm_aesenc_si128(block, _mm_loadu_si128(&rk[i]));
+    }
+    block = _mm_aesenclast_si128(block, _mm_loadu_si128(&rk[BTSTACK_AES128_NUM_ROUNDS]));
+    _mm_storeu_si128((__m128i *) ciphertext, block);
+}
+#endif
+
+#ifdef BTSTACK_AES128_ARMV8_CE
+static void btstack_aes128_encrypt_block_armv8(const uint8_t * round_keys, const uint8_t * plaintext, uint8_t * ciphertext){
+    uint8x16_t block = vld1q_u8(plaintext);
+    int i;
+    for (i = 0; i < (BTSTACK_AES128_NUM_ROUNDS - 1); i++){
+        // AESE: AddRoundKey, SubBytes, ShiftRows - AESMC: MixColumns
+        block = vaesmcq_u8(vaeseq_u8(block, vld1q_u8(&round_keys[i * 16])));
+    }
+    block = vaeseq_u8(block, vld1q_u8(&round_keys[(BTSTACK_AES128_NUM_ROUNDS - 1) * 16]));
+    block = veorq_u8(block, vld1q_u8(&round_keys[BTSTACK_AES128_NUM_ROUNDS * 16]));
+    vst1q_u8(ciphertext, block);
+}
+#endif
+
+static btstack_aes128_cpu_t btstack_aes128_detect_cpu(void){
+#ifdef BTSTACK_AES128_X86_AES_NI
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("aes")){
+        return BTSTACK_AES128_CPU_ACCELERATED;
+    }
+#endif
+#ifdef BTSTACK_AES128_ARMV8_CE
+    return BTSTACK_AES128_CPU_ACCELERATED;
+#endif
+    return BTSTACK_AES128_CPU_PORTABLE;
+}
+
+bool btstack_aes128_hardware_accelerated(void){
+    if (btstack_aes128_cpu == BTSTACK_AES128_CPU_UNKNOWN){
+        btstack_aes128_cpu = btstack_aes128_detect_cpu();
+    }
+    return btstack_aes128_cpu == BTSTACK_AES128_CPU_ACCELERATED;
+}
+
+void btstack_aes128_init(btstack_aes128_t * context, const uint8_t * key){
+    if (btstack_aes128_hardware_accelerated()){
+#ifdef BTSTACK_AES128_X86_AES_NI
+        btstack_aes128_expand_key_aes_ni(key, context->round_keys);
+        return;
+#endif
+#ifdef BTSTACK_AES128_ARMV8_CE
+        rijndaelSetupEncrypt(context->rk, key, KEYBITS);
+        // AES instructions use round keys in byte order
+        int i;
+        for (i = 0; i < ((BTSTACK_AES128_NUM_ROUNDS + 1) * 4); i++){
+            big_endian_store_32(context->round_keys, i * 4, context->rk[i]);
+        }
+        return;
+#endif
+    }
+    rijndaelSetupEncrypt(context->rk, key, KEYBITS);
+}
+
+void btstack_aes128_encrypt_block(const btstack_aes128_t * context, const uint8_t * plaintext, uint8_t * ciphertext){
+    if (btstack_aes128_hardware_accelerated()){
+#ifdef BTSTACK_AES128_X86_AES_NI
+        btstack_aes128_encrypt_block_aes_ni(context->round_keys, plaintext, ciphertext);
+        return;
+#endif
+#ifdef BTSTACK_AES128_ARMV8_CE
+        btstack_aes128_encrypt_block_armv8(context->round_keys, plaintext, ciphertext);
+        return;
+#endif
+    }
+    rijndaelEncrypt(context->rk, BTSTACK_AES128_NUM_ROUNDS, plaintext, ciphertext);
+}
+
+#endif
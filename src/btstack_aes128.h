@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title AES128
+ *
+ * AES-128 block encryption with expanded key, used by btstack_crypto with ENABLE_SOFTWARE_AES128.
+ * Uses AES instructions of x86 (AES-NI) or ARMv8 (Cryptography Extension) if available,
+ * and the rijndael implementation in 3rd-party otherwise.
+ */
+
+#ifndef BTSTACK_AES128_H
+#define BTSTACK_AES128_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "btstack_bool.h"
+
+typedef struct {
+    // rijndael expanded key, RKLENGTH(128)
+    uint32_t rk[44];
+    // expanded key as bytes, used with AES instructions
+    uint8_t  round_keys[11 * 16];
+} btstack_aes128_t;
+
+/* API_START */
+
+/**
+ * @brief Expand key
+ * @param context
+ * @param key
+ */
+void btstack_aes128_init(btstack_aes128_t * context, const uint8_t * key);
+
+/**
+ * @brief Encrypt single block with expanded key
+ * @param context
+ * @param plaintext
+ * @param ciphertext, may be same as plaintext
+ */
+void btstack_aes128_encrypt_block(const btstack_aes128_t * context, const uint8_t * plaintext, uint8_t * ciphertext);
+
+/**
+ * @brief Check if AES instructions of the CPU are used
+ * @return true if CPU supports AES instructions
+ */
+bool btstack_aes128_hardware_accelerated(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_AES128_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title CRC
+ *
+ * CRC-16 calculation for L2CAP Enhanced Retransmission Mode (FCS) and HCI Transport H5 (Data Integrity Check).
+ * With ENABLE_CRC_SLICE_BY_8, eight bytes are processed per step using 4 kB lookup tables per CRC.
+ * All CRCs can be calculated incrementally, e.g. over header and payload stored in separate buffers.
+ */
+
+#ifndef BTSTACK_CRC_H
+#define BTSTACK_CRC_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// initial value for btstack_crc16_l2cap_update
+#define BTSTACK_CRC16_L2CAP_INIT 0x0000u
+
+// initial value for btstack_crc16_h5_update
+#define BTSTACK_CRC16_H5_INIT    0xffffu
+
+/* API_START */
+
+/**
+ * @brief Update L2CAP FCS, generator polynomial D^16 + D^15 + D^2 + 1
+ * @param crc from BTSTACK_CRC16_L2CAP_INIT or previous update
+ * @param data
+ * @param len
+ * @return crc
+ */
+uint16_t btstack_crc16_l2cap_update(uint16_t crc, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Calculate L2CAP FCS over data
+ * @param data
+ * @param len
+ * @return fcs
+ */
+uint16_t btstack_crc16_l2cap_calc(const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Update H5 Data Integrity Check, CRC-CCITT with generator polynomial D^16 + D^12 + D^5 + 1
+ * @param crc from BTSTACK_CRC16_H5_INIT or previous update
+ * @param data
+ * @param len
+ * @return crc
+ */
+uint16_t btstack_crc16_h5_update(uint16_t crc, const uint8_t * data, uint16_t len);
+
+/**
+ * @brief Get H5 Data Integrity Check from CRC, to be sent MSB first
+ * @param crc
+ * @return dic
+ */
+uint16_t btstack_crc16_h5_finalize(uint16_t crc);
+
+/**
+ * @brief Calculate H5 Data Integrity Check over data
+ * @param data
+ * @param len
+ * @return dic
+ */
+uint16_t btstack_crc16_h5_calc(const uint8_t * data, uint16_t len);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_CRC_H
@@ -60,7 +60,7 @@
 
 #ifdef ENABLE_SOFTWARE_AES128
 #define HAVE_AES128
-#include "rijndael.h"
+#include "btstack_aes128.h"
 #endif
 
 #ifdef HAVE_AES128
@@ -167,11 +167,19 @@ static mbedtls_ecp_group   mbedtls_ec_group;
 #endif /* ENABLE_ECC_P256 */
 
 #ifdef ENABLE_SOFTWARE_AES128
-// AES128 using public domain rijndael implementation
+// expanded key of last AES128 operation, CMAC and CCM use the same key for all blocks
+static btstack_aes128_t btstack_crypto_aes128_context;
+static sm_key_t         btstack_crypto_aes128_context_key;
+static bool             btstack_crypto_aes128_context_valid;
+
+// AES128 using AES instructions if available or public domain rijndael implementation
 void btstack_aes128_calc(const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext){
-    uint32_t rk[RKLENGTH(KEYBITS)];
-    int nrounds = rijndaelSetupEncrypt(rk, &key[0], KEYBITS);
-    rijndaelEncrypt(rk, nrounds, plaintext, ciphertext);
+    if ((btstack_crypto_aes128_context_valid == false) || (memcmp(btstack_crypto_aes128_context_key, key, 16) != 0)){
+        btstack_aes128_init(&btstack_crypto_aes128_context, key);
+        (void) memcpy(btstack_crypto_aes128_context_key, key, 16);
+        btstack_crypto_aes128_context_valid = true;
+    }
+    btstack_aes128_encrypt_block(&btstack_crypto_aes128_context, plaintext, ciphertext);
 }
 #endif
 
@@ -1383,6 +1391,12 @@ void btstack_crypto_init(void){
 // De-Init
 void btstack_crypto_deinit(void) {
     btstack_crypto_initialized = false;
+#ifdef ENABLE_SOFTWARE_AES128
+    // don't keep key material around
+    btstack_crypto_aes128_context_valid = false;
+    (void) memset(&btstack_crypto_aes128_context, 0, sizeof(btstack_crypto_aes128_context));
+    (void) memset(btstack_crypto_aes128_context_key, 0, sizeof(btstack_crypto_aes128_context_key));
+#endif
 }
 
 // PTS only
@@ -0,0 +1,651 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_resample_polyphase.c"
+
+/*
+ *  btstack_resample_polyphase.c
+ *
+ */
+
+#include <string.h>
+
+#include "btstack_bool.h"
+#include "btstack_resample_polyphase.h"
+
+#if defined(__SSE2__)
+#define BTSTACK_RESAMPLE_POLYPHASE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BTSTACK_RESAMPLE_POLYPHASE_NEON
+#include <arm_neon.h>
+#endif
+
+#define BTSTACK_RESAMPLE_POLYPHASE_PHASE_BITS 6
+#define BTSTACK_RESAMPLE_POLYPHASE_NUM_PHASES (1 << BTSTACK_RESAMPLE_POLYPHASE_PHASE_BITS)
+#define BTSTACK_RESAMPLE_POLYPHASE_WEIGHT_BITS (16 - BTSTACK_RESAMPLE_POLYPHASE_PHASE_BITS)
+
+// Coefficient tables generated by tool/resample_polyphase_table_generator.py
+// The sum of absolute coefficients is below 2.0, so the Q15 x Q15 dot product fits into 32 bit
+// 8 taps, cutoff 0.75, Kaiser beta 5.0
+static const int16_t btstack_resample_polyphase_coefficients_low[(BTSTACK_RESAMPLE_POLYPHASE_NUM_PHASES + 1) * 8] = {
+       567,  -2885,   6406,  24592,   6406,  -2885,    567,      0,
+       574,  -2832,   6043,  24582,   6772,  -2934,    559,      4,
+       579,  -2777,   5685,  24561,   7143,  -2980,    549,      8,
+       583,  -2718,   5332,  24527,   7517,  -3022,    537,     12,
+       585,  -2657,   4984,  24481,   7895,  -3061,    524,     17,
+       586,  -2594,   4642,  24423,   8276,  -3096,    509,     22,
+       586,  -2528,   4306,  24349,   8660,  -3126,    493,     28,
+       585,  -2461,   3975,  24267,   9047,  -3153,    474,     34,
+       582,  -2392,   3651,  24170,   9437,  -3175,    454,     41,
+       578,  -2321,   3334,  24061,   9828,  -3192,    432,     48,
+       574,  -2249,   3022,  23941,  10222,  -3205,    408,     55,
+       568,  -2176,   2718,  23809,  10616,  -3212,    382,     63,
+       561,  -2101,   2420,  23665,  11012,  -3215,    355,     71,
+       554,  -2026,   2130,  23508,  11409,  -3212,    325,     80,
+       545,  -1950,   1847,  23341,  11806,  -3203,    293,     89,
+       536,  -1873,   1571,  23163,  12202,  -3189,    259,     99,
+       526,  -1796,   1302,  22974,  12599,  -3169,    224,    108,
+       516,  -1718,   1041,  22771,  12995,  -3142,    186,    119,
+       505,  -1640,    788,  22558,  13390,  -3110,    147,    130,
+       493,  -1563,    542,  22337,  13784,  -3071,    105,    141,
+       481,  -1485,    305,  22105,  14175,  -3026,     61,    152,
+       468,  -1408,     75,  21861,  14565,  -2973,     16,    164,
+       455,  -1331,   -147,  21610,  14952,  -2915,    -32,    176,
+       442,  -1255,   -361,  21347,  15336,  -2849,    -81,    189,
+       428,  -1179,   -567,  21076,  15717,  -2776,   -133,    202,
+       414,  -1104,   -765,  20794,  16095,  -2695,   -186,    215,
+       400,  -1030,   -954,  20505,  16468,  -2608,   -241,    228,
+       386,   -957,  -1136,  20207,  16837,  -2513,   -298,    242,
+       371,   -885,  -1310,  19902,  17201,  -2410,   -357,    256,
+       357,   -814,  -1475,  19588,  17560,  -2300,   -418,    270,
+       342,   -744,  -1632,  19266,  17914,  -2182,   -480,    284,
+       327,   -676,  -1782,  18940,  18262,  -2057,   -544,    298,
+       313,   -609,  -1923,  18604,  18602,  -1923,   -609,    313,
+       298,   -544,  -2057,  18262,  18940,  -1782,   -676,    327,
+       284,   -480,  -2182,  17914,  19266,  -1632,   -744,    342,
+       270,   -418,  -2300,  17560,  19588,  -1475,   -814,    357,
+       256,   -357,  -2410,  17201,  19902,  -1310,   -885,    371,
+       242,   -298,  -2513,  16837,  20207,  -1136,   -957,    386,
+       228,   -241,  -2608,  16468,  20505,   -954,  -1030,    400,
+       215,   -186,  -2695,  16095,  20794,   -765,  -1104,    414,
+       202,   -133,  -2776,  15717,  21076,   -567,  -1179,    428,
+       189,    -81,  -2849,  15336,  21347,   -361,  -1255,    442,
+       176,    -32,  -2915,  14952,  21610,   -147,  -1331,    455,
+       164,     16,  -2973,  14565,  21861,     75,  -1408,    468,
+       152,     61,  -3026,  14175,  22105,    305,  -1485,    481,
+       141,    105,  -3071,  13784,  22337,    542,  -1563,    493,
+       130,    147,  -3110,  13390,  22558,    788,  -1640,    505,
+       119,    186,  -3142,  12995,  22771,   1041,  -1718,    516,
+       108,    224,  -3169,  12599,  22974,   1302,  -1796,    526,
+        99,    259,  -3189,  12202,  23163,   1571,  -1873,    536,
+        89,    293,  -3203,  11806,  23341,   1847,  -1950,    545,
+        80,    325,  -3212,  11409,  23508,   2130,  -2026,    554,
+        71,    355,  -3215,  11012,  23665,   2420,  -2101,    561,
+        63,    382,  -3212,  10616,  23809,   2718,  -2176,    568,
+        55,    408,  -3205,  10222,  23941,   3022,  -2249,    574,
+        48,    432,  -3192,   9828,  24061,   3334,  -2321,    578,
+        41,    454,  -3175,   9437,  24170,   3651,  -2392,    582,
+        34,    474,  -3153,   9047,  24267,   3975,  -2461,    585,
+        28,    493,  -3126,   8660,  24349,   4306,  -2528,    586,
+        22,    509,  -3096,   8276,  24423,   4642,  -2594,    586,
+        17,    524,  -3061,   7895,  24481,   4984,  -2657,    585,
+        12,    537,  -3022,   7517,  24527,   5332,  -2718,    583,
+         8,    549,  -2980,   7143,  24561,   5685,  -2777,    579,
+         4,    559,  -2934,   6772,  24582,   6043,  -2832,    574,
+         0,    567,  -2885,   6406,  24592,   6406,  -2885,    567,
+};
+
+// 16 taps, cutoff 0.85, Kaiser beta 7.0
+static const int16_t btstack_resample_polyphase_coefficients_medium[(BTSTACK_RESAMPLE_POLYPHASE_NUM_PHASES + 1) * 16] = {
+        -9,    -62,    362,  -1047,   2144,  -3437,   4502,  27862,
+      4502,  -3437,   2144,  -1047,    362,    -62,     -9,      0,
+        -7,    -69,    372,  -1049,   2106,  -3293,   4059,  27850,
+      4951,  -3577,   2179,  -1043,    351,    -55,    -12,      5,
+        -4,    -76,    381,  -1048,   2065,  -3146,   3624,  27824,
+      5408,  -3714,   2210,  -1038,    339,    -48,    -15,      6,
+        -2,    -82,    389,  -1046,   2021,  -2997,   3197,  27783,
+      5870,  -3847,   2238,  -1030,    326,    -40,    -18,      6,
+         1,    -88,    396,  -1041,   1975,  -2846,   2778,  27722,
+      6339,  -3976,   2262,  -1020,    312,    -32,    -21,      7,
+         3,    -93,    402,  -1035,   1925,  -2692,   2368,  27645,
+      6814,  -4101,   2282,  -1008,    298,    -23,    -24,      7,
+         5,    -98,    407,  -1027,   1873,  -2538,   1966,  27554,
+      7293,  -4221,   2299,   -994,    282,    -14,    -27,      8,
+         7,   -103,    411,  -1018,   1819,  -2382,   1574,  27446,
+      7778,  -4336,   2311,   -977,    265,     -5,    -30,      8,
+         9,   -107,    414,  -1006,   1763,  -2225,   1191,  27320,
+      8266,  -4446,   2320,   -959,    247,      5,    -33,      9,
+        10,   -111,    417,   -993,   1704,  -2067,    818,  27179,
+      8759,  -4550,   2324,   -938,    229,     14,    -37,     10,
+        12,   -114,    418,   -979,   1644,  -1909,    455,  27021,
+      9255,  -4648,   2325,   -915,    209,     24,    -40,     10,
+        14,   -118,    419,   -963,   1581,  -1751,    102,  26848,
+      9753,  -4739,   2320,   -889,    189,     35,    -44,     11,
+        15,   -120,    419,   -945,   1518,  -1593,   -241,  26656,
+     10255,  -4824,   2312,   -862,    168,     45,    -47,     12,
+        16,   -123,    418,   -926,   1452,  -1436,   -573,  26454,
+     10758,  -4902,   2299,   -832,    145,     56,    -51,     13,
+        18,   -125,    416,   -906,   1385,  -1279,   -894,  26234,
+     11263,  -4973,   2281,   -800,    122,     67,    -54,     13,
+        19,   -127,    414,   -884,   1318,  -1124,  -1204,  25996,
+     11769,  -5036,   2259,   -765,     98,     79,    -58,     14,
+        20,   -128,    410,   -862,   1249,   -969,  -1503,  25748,
+     12275,  -5092,   2232,   -729,     74,     90,    -62,     15,
+        21,   -129,    406,   -838,   1179,   -816,  -1791,  25483,
+     12781,  -5139,   2201,   -690,     48,    102,    -65,     15,
+        21,   -130,    402,   -813,   1108,   -665,  -2068,  25206,
+     13287,  -5178,   2164,   -649,     22,    114,    -69,     16,
+        22,   -131,    397,   -788,   1037,   -516,  -2333,  24916,
+     13792,  -5209,   2123,   -606,     -5,    125,    -73,     17,
+        23,   -131,    391,   -761,    966,   -369,  -2586,  24607,
+     14295,  -5230,   2077,   -561,    -32,    138,    -76,     17,
+        23,   -131,    384,   -734,    894,   -224,  -2828,  24290,
+     14796,  -5243,   2027,   -514,    -60,    150,    -80,     18,
+        24,   -131,    377,   -706,    822,    -82,  -3058,  23959,
+     15295,  -5246,   1971,   -465,    -89,    162,    -84,     19,
+        24,   -130,    369,   -677,    750,     57,  -3277,  23616,
+     15790,  -5239,   1911,   -414,   -118,    174,    -87,     19,
+        24,   -129,    361,   -647,    678,    193,  -3483,  23261,
+     16282,  -5223,   1845,   -361,   -148,    186,    -91,     20,
+        25,   -128,    353,   -617,    607,    326,  -3678,  22890,
+     16770,  -5196,   1775,   -306,   -178,    198,    -94,     21,
+        25,   -127,    344,   -587,    535,    456,  -3861,  22511,
+     17254,  -5159,   1701,   -250,   -209,    211,    -97,     21,
+        25,   -126,    334,   -556,    464,    582,  -4032,  22123,
+     17732,  -5112,   1621,   -191,   -240,    223,   -101,     22,
+        25,   -124,    324,   -525,    394,    704,  -4192,  21725,
+     18204,  -5054,   1537,   -132,   -271,    235,   -104,     22,
+        25,   -122,    314,   -493,    325,    823,  -4340,  21313,
+     18671,  -4986,   1448,    -70,   -303,    247,   -107,     23,
+        24,   -120,    303,   -462,    256,    938,  -4476,  20894,
+     19131,  -4906,   1355,     -7,   -334,    259,   -110,     23,
+        24,   -117,    293,   -430,    189,   1049,  -4601,  20464,
+     19583,  -4816,   1257,     57,   -366,    270,   -112,     24,
+        24,   -115,    281,   -398,    122,   1155,  -4714,  20028,
+     20030,  -4714,   1155,    122,   -398,    281,   -115,     24,
+        24,   -112,    270,   -366,     57,   1257,  -4816,  19583,
+     20464,  -4601,   1049,    189,   -430,    293,   -117,     24,
+        23,   -110,    259,   -334,     -7,   1355,  -4906,  19131,
+     20894,  -4476,    938,    256,   -462,    303,   -120,     24,
+        23,   -107,    247,   -303,    -70,   1448,  -4986,  18671,
+     21313,  -4340,    823,    325,   -493,    314,   -122,     25,
+        22,   -104,    235,   -271,   -132,   1537,  -5054,  18204,
+     21725,  -4192,    704,    394,   -525,    324,   -124,     25,
+        22,   -101,    223,   -240,   -191,   1621,  -5112,  17732,
+     22123,  -4032,    582,    464,   -556,    334,   -126,     25,
+        21,    -97,    211,   -209,   -250,   1701,  -5159,  17254,
+     22511,  -3861,    456,    535,   -587,    344,   -127,     25,
+        21,    -94,    198,   -178,   -306,   1775,  -5196,  16770,
+     22890,  -3678,    326,    607,   -617,    353,   -128,     25,
+        20,    -91,    186,   -148,   -361,   1845,  -5223,  16282,
+     23261,  -3483,    193,    678,   -647,    361,   -129,     24,
+        19,    -87,    174,   -118,   -414,   1911,  -5239,  15790,
+     23616,  -3277,     57,    750,   -677,    369,   -130,     24,
+        19,    -84,    162,    -89,   -465,   1971,  -5246,  15295,
+     23959,  -3058,    -82,    822,   -706,    377,   -131,     24,
+        18,    -80,    150,    -60,   -514,   2027,  -5243,  14796,
+     24290,  -2828,   -224,    894,   -734,    384,   -131,     23,
+        17,    -76,    138,    -32,   -561,   2077,  -5230,  14295,
+     24607,  -2586,   -369,    966,   -761,    391,   -131,     23,
+        17,    -73,    125,     -5,   -606,   2123,  -5209,  13792,
+     24916,  -2333,   -516,   1037,   -788,    397,   -131,     22,
+        16,    -69,    114,     22,   -649,   2164,  -5178,  13287,
+     25206,  -2068,   -665,   1108,   -813,    402,   -130,     21,
+        15,    -65,    102,     48,   -690,   2201,  -5139,  12781,
+     25483,  -1791,   -816,   1179,   -838,    406,   -129,     21,
+        15,    -62,     90,     74,   -729,   2232,  -5092,  12275,
+     25748,  -1503,   -969,   1249,   -862,    410,   -128,     20,
+        14,    -58,     79,     98,   -765,   2259,  -5036,  11769,
+     25996,  -1204,  -1124,   1318,   -884,    414,   -127,     19,
+        13,    -54,     67,    122,   -800,   2281,  -4973,  11263,
+     26234,   -894,  -1279,   1385,   -906,    416,   -125,     18,
+        13,    -51,     56,    145,   -832,   2299,  -4902,  10758,
+     26454,   -573,  -1436,   1452,   -926,    418,   -123,     16,
+        12,    -47,     45,    168,   -862,   2312,  -4824,  10255,
+     26656,   -241,  -1593,   1518,   -945,    419,   -120,     15,
+        11,    -44,     35,    189,   -889,   2320,  -4739,   9753,
+     26848,    102,  -1751,   1581,   -963,    419,   -118,     14,
+        10,    -40,     24,    209,   -915,   2325,  -4648,   9255,
+     27021,    455,  -1909,   1644,   -979,    418,   -114,     12,
+        10,    -37,     14,    229,   -938,   2324,  -4550,   8759,
+     27179,    818,  -2067,   1704,   -993,    417,   -111,     10,
+         9,    -33,      5,    247,   -959,   2320,  -4446,   8266,
+     27320,   1191,  -2225,   1763,  -1006,    414,   -107,      9,
+         8,    -30,     -5,    265,   -977,   2311,  -4336,   7778,
+     27446,   1574,  -2382,   1819,  -1018,    411,   -103,      7,
+         8,    -27,    -14,    282,   -994,   2299,  -4221,   7293,
+     27554,   1966,  -2538,   1873,  -1027,    407,    -98,      5,
+         7,    -24,    -23,    298,  -1008,   2282,  -4101,   6814,
+     27645,   2368,  -2692,   1925,  -1035,    402,    -93,      3,
+         7,    -21,    -32,    312,  -1020,   2262,  -3976,   6339,
+     27722,   2778,  -2846,   1975,  -1041,    396,    -88,      1,
+         6,    -18,    -40,    326,  -1030,   2238,  -3847,   5870,
+     27783,   3197,  -2997,   2021,  -1046,    389,    -82,     -2,
+         6,    -15,    -48,    339,  -1038,   2210,  -3714,   5408,
+     27824,   3624,  -3146,   2065,  -1048,    381,    -76,     -4,
+         5,    -12,    -55,    351,  -1043,   2179,  -3577,   4951,
+     27850,   4059,  -3293,   2106,  -1049,    372,    -69,     -7,
+         0,     -9,    -62,    362,  -1047,   2144,  -3437,   4502,
+     27862,   4502,  -3437,   2144,  -1047,    362,    -62,     -9,
+};
+
+// 32 taps, cutoff 0.91, Kaiser beta 9.0
+static const int16_t btstack_resample_polyphase_coefficients_high[(BTSTACK_RESAMPLE_POLYPHASE_NUM_PHASES + 1) * 32] = {
+        -3,      8,    -13,     13,      3,    -51,    151,   -324,
+       583,   -930,   1348,  -1803,   2244,  -2615,   2862,  29822,
+      2862,  -2615,   2244,  -1803,   1348,   -930,    583,   -324,
+       151,    -51,      3,     13,    -13,      8,     -3,      0,
+        -3,      7,    -12,     10,      7,    -57,    160,   -333,
+       590,   -929,   1329,  -1752,   2139,  -2407,   2381,  29810,
+      3353,  -2821,   2346,  -1850,   1364,   -929,    575,   -314,
+       142,    -44,     -1,     15,    -14,      8,     -3,      1,
+        -3,      7,    -10,      8,     11,    -64,    168,   -342,
+       596,   -926,   1308,  -1699,   2031,  -2198,   1910,  29780,
+      3854,  -3025,   2444,  -1894,   1378,   -927,    565,   -303,
+       133,    -37,     -6,     17,    -15,      9,     -3,      1,
+        -3,      6,     -9,      6,     15,    -70,    176,   -350,
+       600,   -921,   1285,  -1643,   1920,  -1988,   1450,  29728,
+      4364,  -3227,   2539,  -1935,   1389,   -922,    555,   -291,
+       123,    -30,    -10,     20,    -16,      9,     -3,      1,
+        -3,      6,     -8,      4,     19,    -75,    183,   -357,
+       604,   -914,   1259,  -1585,   1807,  -1777,   1001,  29659,
+      4882,  -3426,   2631,  -1972,   1397,   -916,    542,   -279,
+       112,    -23,    -14,     22,    -17,      9,     -4,      1,
+        -2,      5,     -7,      1,     23,    -81,    190,   -363,
+       605,   -906,   1231,  -1523,   1692,  -1567,    563,  29568,
+      5408,  -3621,   2718,  -2006,   1402,   -907,    529,   -265,
+       102,    -16,    -19,     25,    -18,     10,     -4,      1,
+        -2,      5,     -6,     -1,     27,    -86,    196,   -368,
+       606,   -895,   1201,  -1460,   1575,  -1357,    138,  29457,
+      5942,  -3813,   2800,  -2036,   1405,   -897,    514,   -251,
+        91,     -8,    -24,     27,    -19,     10,     -4,      1,
+        -2,      5,     -5,     -3,     30,    -91,    202,   -373,
+       606,   -883,   1168,  -1394,   1456,  -1149,   -276,  29329,
+      6483,  -4001,   2878,  -2062,   1405,   -885,    499,   -237,
+        79,      0,    -28,     29,    -20,     11,     -4,      1,
+        -2,      4,     -4,     -5,     34,    -96,    207,   -377,
+       604,   -870,   1134,  -1327,   1336,   -941,   -677,  29180,
+      7030,  -4184,   2952,  -2084,   1402,   -870,    481,   -221,
+        68,      8,    -33,     32,    -21,     11,     -4,      1,
+        -2,      4,     -3,     -7,     37,   -100,    212,   -379,
+       601,   -855,   1098,  -1257,   1215,   -735,  -1065,  29010,
+      7583,  -4361,   3020,  -2103,   1396,   -854,    463,   -205,
+        56,     16,    -37,     34,    -22,     11,     -4,      1,
+        -2,      3,     -2,     -9,     40,   -105,    216,   -382,
+       596,   -838,   1060,  -1186,   1093,   -531,  -1440,  28828,
+      8142,  -4534,   3083,  -2117,   1387,   -836,    444,   -189,
+        43,     24,    -42,     36,    -23,     12,     -4,      1,
+        -2,      3,     -1,    -11,     43,   -109,    220,   -383,
+       591,   -820,   1020,  -1113,    971,   -329,  -1802,  28619,
+      8706,  -4700,   3141,  -2127,   1375,   -816,    423,   -171,
+        31,     32,    -47,     39,    -24,     12,     -4,      1,
+        -1,      2,      0,    -13,     46,   -112,    223,   -383,
+       585,   -800,    979,  -1039,    848,   -130,  -2150,  28393,
+      9273,  -4860,   3194,  -2133,   1360,   -794,    401,   -153,
+        18,     40,    -51,     41,    -25,     12,     -4,      1,
+        -1,      2,      1,    -14,     49,   -116,    226,   -383,
+       577,   -779,    936,   -964,    725,     66,  -2485,  28151,
+      9845,  -5013,   3240,  -2135,   1343,   -770,    378,   -135,
+         5,     48,    -56,     43,    -26,     13,     -4,      1,
+        -1,      2,      2,    -16,     51,   -119,    228,   -382,
+       568,   -757,    892,   -887,    602,    259,  -2805,  27889,
+     10419,  -5159,   3281,  -2132,   1322,   -744,    355,   -116,
+        -8,     56,    -60,     45,    -27,     13,     -4,      1,
+        -1,      1,      3,    -18,     54,   -121,    230,   -380,
+       559,   -733,    847,   -810,    480,    448,  -3112,  27611,
+     10996,  -5297,   3315,  -2125,   1298,   -717,    330,    -97,
+       -22,     65,    -65,     48,    -28,     13,     -5,      1,
+        -1,      1,      4,    -19,     56,   -124,    231,   -377,
+       548,   -708,    800,   -732,    358,    634,  -3404,  27313,
+     11575,  -5427,   3343,  -2114,   1272,   -687,    304,    -77,
+       -35,     73,    -69,     50,    -29,     13,     -5,      1,
+        -1,      0,      5,    -21,     58,   -126,    232,   -374,
+       536,   -682,    752,   -653,    237,    814,  -3682,  27003,
+     12155,  -5549,   3365,  -2098,   1242,   -656,    277,    -56,
+       -49,     81,    -74,     52,    -29,     13,     -5,      1,
+        -1,      0,      5,    -22,     60,   -128,    232,   -370,
+       524,   -655,    704,   -574,    117,    991,  -3945,  26672,
+     12736,  -5661,   3380,  -2078,   1210,   -624,    249,    -36,
+       -63,     89,    -78,     54,    -30,     14,     -5,      1,
+        -1,      0,      6,    -24,     62,   -129,    232,   -365,
+       510,   -627,    654,   -495,     -1,   1162,  -4194,  26326,
+     13316,  -5765,   3389,  -2053,   1175,   -589,    221,    -15,
+       -77,     98,    -82,     55,    -31,     14,     -5,      1,
+         0,     -1,      7,    -25,     63,   -131,    231,   -360,
+       496,   -598,    604,   -416,   -118,   1329,  -4428,  25964,
+     13896,  -5858,   3390,  -2024,   1137,   -553,    191,      7,
+       -91,    106,    -86,     57,    -31,     14,     -5,      1,
+         0,     -1,      8,    -26,     65,   -132,    230,   -354,
+       480,   -569,    553,   -337,   -234,   1490,  -4648,  25590,
+     14474,  -5942,   3385,  -1990,   1096,   -515,    161,     28,
+      -105,    114,    -90,     59,    -32,     14,     -5,      1,
+         0,     -1,      8,    -27,     66,   -132,    229,   -347,
+       464,   -538,    501,   -258,   -347,   1646,  -4853,  25197,
+     15051,  -6016,   3373,  -1952,   1053,   -476,    130,     50,
+      -119,    122,    -94,     60,    -32,     14,     -5,      1,
+         0,     -2,      9,    -28,     67,   -133,    226,   -340,
+       448,   -507,    450,   -180,   -458,   1796,  -5043,  24791,
+     15625,  -6078,   3354,  -1909,   1007,   -436,     99,     72,
+      -132,    129,    -98,     62,    -33,     14,     -5,      1,
+         0,     -2,      9,    -29,     68,   -133,    224,   -332,
+       430,   -475,    397,   -102,   -567,   1940,  -5219,  24374,
+     16196,  -6130,   3328,  -1862,    958,   -394,     66,     94,
+      -146,    137,   -102,     63,    -33,     14,     -5,      1,
+         0,     -2,     10,    -30,     69,   -133,    221,   -323,
+       412,   -442,    345,    -24,   -673,   2078,  -5380,  23934,
+     16762,  -6170,   3295,  -1810,    907,   -350,     34,    116,
+      -160,    144,   -105,     65,    -33,     14,     -4,      1,
+         0,     -2,     11,    -31,     69,   -132,    218,   -314,
+       393,   -409,    293,     52,   -777,   2209,  -5526,  23487,
+     17325,  -6198,   3254,  -1755,    853,   -306,      1,    139,
+      -173,    152,   -108,     66,    -34,     14,     -4,      1,
+         0,     -3,     11,    -31,     70,   -132,    214,   -305,
+       374,   -376,    240,    127,   -877,   2334,  -5658,  23032,
+     17882,  -6214,   3206,  -1695,    797,   -260,    -33,    161,
+      -187,    159,   -112,     67,    -34,     14,     -4,      1,
+         0,     -3,     11,    -32,     70,   -131,    210,   -295,
+       354,   -342,    188,    201,   -975,   2453,  -5776,  22563,
+     18433,  -6218,   3151,  -1630,    739,   -214,    -67,    183,
+      -200,    165,   -115,     68,    -34,     14,     -4,      1,
+         0,     -3,     12,    -32,     70,   -129,    206,   -284,
+       334,   -308,    136,    274,  -1070,   2565,  -5879,  22075,
+     18978,  -6209,   3089,  -1562,    678,   -166,   -101,    206,
+      -213,    172,   -117,     69,    -34,     14,     -4,      1,
+         0,     -3,     12,    -33,     71,   -128,    201,   -273,
+       314,   -273,     84,    346,  -1161,   2670,  -5968,  21583,
+     19516,  -6188,   3019,  -1489,    615,   -117,   -135,    228,
+      -226,    178,   -120,     69,    -34,     13,     -4,      1,
+         0,     -3,     13,    -33,     70,   -126,    196,   -262,
+       292,   -239,     33,    416,  -1248,   2768,  -6044,  21080,
+     20046,  -6153,   2943,  -1413,    551,    -68,   -170,    249,
+      -238,    184,   -122,     70,    -34,     13,     -4,      1,
+         1,     -4,     13,    -33,     70,   -124,    190,   -250,
+       271,   -204,    -18,    484,  -1332,   2859,  -6105,  20567,
+     20565,  -6105,   2859,  -1332,    484,    -18,   -204,    271,
+      -250,    190,   -124,     70,    -33,     13,     -4,      1,
+         1,     -4,     13,    -34,     70,   -122,    184,   -238,
+       249,   -170,    -68,    551,  -1413,   2943,  -6153,  20046,
+     21080,  -6044,   2768,  -1248,    416,     33,   -239,    292,
+      -262,    196,   -126,     70,    -33,     13,     -3,      0,
+         1,     -4,     13,    -34,     69,   -120,    178,   -226,
+       228,   -135,   -117,    615,  -1489,   3019,  -6188,  19516,
+     21583,  -5968,   2670,  -1161,    346,     84,   -273,    314,
+      -273,    201,   -128,     71,    -33,     12,     -3,      0,
+         1,     -4,     14,    -34,     69,   -117,    172,   -213,
+       206,   -101,   -166,    678,  -1562,   3089,  -6209,  18978,
+     22075,  -5879,   2565,  -1070,    274,    136,   -308,    334,
+      -284,    206,   -129,     70,    -32,     12,     -3,      0,
+         1,     -4,     14,    -34,     68,   -115,    165,   -200,
+       183,    -67,   -214,    739,  -1630,   3151,  -6218,  18433,
+     22563,  -5776,   2453,   -975,    201,    188,   -342,    354,
+      -295,    210,   -131,     70,    -32,     11,     -3,      0,
+         1,     -4,     14,    -34,     67,   -112,    159,   -187,
+       161,    -33,   -260,    797,  -1695,   3206,  -6214,  17882,
+     23032,  -5658,   2334,   -877,    127,    240,   -376,    374,
+      -305,    214,   -132,     70,    -31,     11,     -3,      0,
+         1,     -4,     14,    -34,     66,   -108,    152,   -173,
+       139,      1,   -306,    853,  -1755,   3254,  -6198,  17325,
+     23487,  -5526,   2209,   -777,     52,    293,   -409,    393,
+      -314,    218,   -132,     69,    -31,     11,     -2,      0,
+         1,     -4,     14,    -33,     65,   -105,    144,   -160,
+       116,     34,   -350,    907,  -1810,   3295,  -6170,  16762,
+     23934,  -5380,   2078,   -673,    -24,    345,   -442,    412,
+      -323,    221,   -133,     69,    -30,     10,     -2,      0,
+         1,     -5,     14,    -33,     63,   -102,    137,   -146,
+        94,     66,   -394,    958,  -1862,   3328,  -6130,  16196,
+     24374,  -5219,   1940,   -567,   -102,    397,   -475,    430,
+      -332,    224,   -133,     68,    -29,      9,     -2,      0,
+         1,     -5,     14,    -33,     62,    -98,    129,   -132,
+        72,     99,   -436,   1007,  -1909,   3354,  -6078,  15625,
+     24791,  -5043,   1796,   -458,   -180,    450,   -507,    448,
+      -340,    226,   -133,     67,    -28,      9,     -2,      0,
+         1,     -5,     14,    -32,     60,    -94,    122,   -119,
+        50,    130,   -476,   1053,  -1952,   3373,  -6016,  15051,
+     25197,  -4853,   1646,   -347,   -258,    501,   -538,    464,
+      -347,    229,   -132,     66,    -27,      8,     -1,      0,
+         1,     -5,     14,    -32,     59,    -90,    114,   -105,
+        28,    161,   -515,   1096,  -1990,   3385,  -5942,  14474,
+     25590,  -4648,   1490,   -234,   -337,    553,   -569,    480,
+      -354,    230,   -132,     65,    -26,      8,     -1,      0,
+         1,     -5,     14,    -31,     57,    -86,    106,    -91,
+         7,    191,   -553,   1137,  -2024,   3390,  -5858,  13896,
+     25964,  -4428,   1329,   -118,   -416,    604,   -598,    496,
+      -360,    231,   -131,     63,    -25,      7,     -1,      0,
+         1,     -5,     14,    -31,     55,    -82,     98,    -77,
+       -15,    221,   -589,   1175,  -2053,   3389,  -5765,  13316,
+     26326,  -4194,   1162,     -1,   -495,    654,   -627,    510,
+      -365,    232,   -129,     62,    -24,      6,      0,     -1,
+         1,     -5,     14,    -30,     54,    -78,     89,    -63,
+       -36,    249,   -624,   1210,  -2078,   3380,  -5661,  12736,
+     26672,  -3945,    991,    117,   -574,    704,   -655,    524,
+      -370,    232,   -128,     60,    -22,      5,      0,     -1,
+         1,     -5,     13,    -29,     52,    -74,     81,    -49,
+       -56,    277,   -656,   1242,  -2098,   3365,  -5549,  12155,
+     27003,  -3682,    814,    237,   -653,    752,   -682,    536,
+      -374,    232,   -126,     58,    -21,      5,      0,     -1,
+         1,     -5,     13,    -29,     50,    -69,     73,    -35,
+       -77,    304,   -687,   1272,  -2114,   3343,  -5427,  11575,
+     27313,  -3404,    634,    358,   -732,    800,   -708,    548,
+      -377,    231,   -124,     56,    -19,      4,      1,     -1,
+         1,     -5,     13,    -28,     48,    -65,     65,    -22,
+       -97,    330,   -717,   1298,  -2125,   3315,  -5297,  10996,
+     27611,  -3112,    448,    480,   -810,    847,   -733,    559,
+      -380,    230,   -121,     54,    -18,      3,      1,     -1,
+         1,     -4,     13,    -27,     45,    -60,     56,     -8,
+      -116,    355,   -744,   1322,  -2132,   3281,  -5159,  10419,
+     27889,  -2805,    259,    602,   -887,    892,   -757,    568,
+      -382,    228,   -119,     51,    -16,      2,      2,     -1,
+         1,     -4,     13,    -26,     43,    -56,     48,      5,
+      -135,    378,   -770,   1343,  -2135,   3240,  -5013,   9845,
+     28151,  -2485,     66,    725,   -964,    936,   -779,    577,
+      -383,    226,   -116,     49,    -14,      1,      2,     -1,
+         1,     -4,     12,    -25,     41,    -51,     40,     18,
+      -153,    401,   -794,   1360,  -2133,   3194,  -4860,   9273,
+     28393,  -2150,   -130,    848,  -1039,    979,   -800,    585,
+      -383,    223,   -112,     46,    -13,      0,      2,     -1,
+         1,     -4,     12,    -24,     39,    -47,     32,     31,
+      -171,    423,   -816,   1375,  -2127,   3141,  -4700,   8706,
+     28619,  -1802,   -329,    971,  -1113,   1020,   -820,    591,
+      -383,    220,   -109,     43,    -11,     -1,      3,     -2,
+         1,     -4,     12,    -23,     36,    -42,     24,     43,
+      -189,    444,   -836,   1387,  -2117,   3083,  -4534,   8142,
+     28828,  -1440,   -531,   1093,  -1186,   1060,   -838,    596,
+      -382,    216,   -105,     40,     -9,     -2,      3,     -2,
+         1,     -4,     11,    -22,     34,    -37,     16,     56,
+      -205,    463,   -854,   1396,  -2103,   3020,  -4361,   7583,
+     29010,  -1065,   -735,   1215,  -1257,   1098,   -855,    601,
+      -379,    212,   -100,     37,     -7,     -3,      4,     -2,
+         1,     -4,     11,    -21,     32,    -33,      8,     68,
+      -221,    481,   -870,   1402,  -2084,   2952,  -4184,   7030,
+     29180,   -677,   -941,   1336,  -1327,   1134,   -870,    604,
+      -377,    207,    -96,     34,     -5,     -4,      4,     -2,
+         1,     -4,     11,    -20,     29,    -28,      0,     79,
+      -237,    499,   -885,   1405,  -2062,   2878,  -4001,   6483,
+     29329,   -276,  -1149,   1456,  -1394,   1168,   -883,    606,
+      -373,    202,    -91,     30,     -3,     -5,      5,     -2,
+         1,     -4,     10,    -19,     27,    -24,     -8,     91,
+      -251,    514,   -897,   1405,  -2036,   2800,  -3813,   5942,
+     29457,    138,  -1357,   1575,  -1460,   1201,   -895,    606,
+      -368,    196,    -86,     27,     -1,     -6,      5,     -2,
+         1,     -4,     10,    -18,     25,    -19,    -16,    102,
+      -265,    529,   -907,   1402,  -2006,   2718,  -3621,   5408,
+     29568,    563,  -1567,   1692,  -1523,   1231,   -906,    605,
+      -363,    190,    -81,     23,      1,     -7,      5,     -2,
+         1,     -4,      9,    -17,     22,    -14,    -23,    112,
+      -279,    542,   -916,   1397,  -1972,   2631,  -3426,   4882,
+     29659,   1001,  -1777,   1807,  -1585,   1259,   -914,    604,
+      -357,    183,    -75,     19,      4,     -8,      6,     -3,
+         1,     -3,      9,    -16,     20,    -10,    -30,    123,
+      -291,    555,   -922,   1389,  -1935,   2539,  -3227,   4364,
+     29728,   1450,  -1988,   1920,  -1643,   1285,   -921,    600,
+      -350,    176,    -70,     15,      6,     -9,      6,     -3,
+         1,     -3,      9,    -15,     17,     -6,    -37,    133,
+      -303,    565,   -927,   1378,  -1894,   2444,  -3025,   3854,
+     29780,   1910,  -2198,   2031,  -1699,   1308,   -926,    596,
+      -342,    168,    -64,     11,      8,    -10,      7,     -3,
+         1,     -3,      8,    -14,     15,     -1,    -44,    142,
+      -314,    575,   -929,   1364,  -1850,   2346,  -2821,   3353,
+     29810,   2381,  -2407,   2139,  -1752,   1329,   -929,    590,
+      -333,    160,    -57,      7,     10,    -12,      7,     -3,
+         0,     -3,      8,    -13,     13,      3,    -51,    151,
+      -324,    583,   -930,   1348,  -1803,   2244,  -2615,   2862,
+     29822,   2862,  -2615,   2244,  -1803,   1348,   -930,    583,
+      -324,    151,    -51,      3,     13,    -13,      8,     -3,
+};
+
+// dot product of input samples with the coefficients of two adjacent phases
+static void btstack_resample_polyphase_filter(const int16_t * coefficients_0, const int16_t * coefficients_1, const int16_t * samples,
+                                              uint16_t num_taps, int32_t * result_0, int32_t * result_1){
+#if defined(BTSTACK_RESAMPLE_POLYPHASE_SSE2)
+    __m128i sum_0 = _mm_setzero_si128();
+    __m128i sum_1 = _mm_setzero_si128();
+    uint16_t i;
+    for (i = 0; i < num_taps; i += 8){
+        __m128i x = _mm_loadu_si128((const __m128i *) &samples[i]);
+        sum_0 = _mm_add_epi32(sum_0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) &coefficients_0[i]), x));
+        sum_1 = _mm_add_epi32(sum_1, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) &coefficients_1[i]), x));
+    }
+    // horizontal add: sum_0 in lane 0, sum_1 in lane 1
+    __m128i sums = _mm_add_epi32(_mm_unpacklo_epi32(sum_0, sum_1), _mm_unpackhi_epi32(sum_0, sum_1));
+    sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+    *result_0 = _mm_cvtsi128_si32(sums);
+    *result_1 = _mm_cvtsi128_si32(_mm_srli_si128(sums, 4));
+#elif defined(BTSTACK_RESAMPLE_POLYPHASE_NEON)
+    int32x4_t sum_0 = vdupq_n_s32(0);
+    int32x4_t sum_1 = vdupq_n_s32(0);
+    uint16_t i;
+    for (i = 0; i < num_taps; i += 4){
+        int16x4_t x = vld1_s16(&samples[i]);
+        sum_0 = vmlal_s16(sum_0, vld1_s16(&coefficients_0[i]), x);
+        sum_1 = vmlal_s16(sum_1, vld1_s16(&coefficients_1[i]), x);
+    }
+    int32x2_t sums = vpadd_s32(vadd_s32(vget_low_s32(sum_0), vget_high_s32(sum_0)),
+                               vadd_s32(vget_low_s32(sum_1), vget_high_s32(sum_1)));
+    *result_0 = vget_lane_s32(sums, 0);
+    *result_1 = vget_lane_s32(sums, 1);
+#else
+    int32_t sum_0 = 0;
+    int32_t sum_1 = 0;
+    uint16_t i;
+    for (i = 0; i < num_taps; i++){
+        sum_0 += (int32_t) coefficients_0[i] * samples[i];
+        sum_1 += (int32_t) coefficients_1[i] * samples[i];
+    }
+    *result_0 = sum_0;
+    *result_1 = sum_1;
+#endif
+}
+
+static int16_t btstack_resample_polyphase_saturate(int64_t value){
+    if (value >  32767) return  32767;
+    if (value < -32768) return -32768;
+    return (int16_t) value;
+}
+
+void btstack_resample_polyphase_init(btstack_resample_polyphase_t * context, int num_channels, btstack_resample_polyphase_quality_t quality){
+    memset(context, 0, sizeof(btstack_resample_polyphase_t));
+    context->src_step = 0x10000;  // default resampling 1.0
+    context->num_channels = num_channels;
+    switch (quality){
+        case BTSTACK_RESAMPLE_POLYPHASE_QUALITY_LOW:
+            context->coefficients = btstack_resample_polyphase_coefficients_low;
+            context->num_taps = 8;
+            break;
+        case BTSTACK_RESAMPLE_POLYPHASE_QUALITY_MEDIUM:
+            context->coefficients = btstack_resample_polyphase_coefficients_medium;
+            context->num_taps = 16;
+            break;
+        default:
+            context->coefficients = btstack_resample_polyphase_coefficients_high;
+            context->num_taps = 32;
+            break;
+    }
+}
+
+void btstack_resample_polyphase_set_factor(btstack_resample_polyphase_t * context, uint32_t src_step){
+    context->src_step = src_step;
+}
+
+uint16_t btstack_resample_polyphase_block(btstack_resample_polyphase_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer){
+    const uint16_t num_taps = context->num_taps;
+    const uint16_t num_history_frames = num_taps - 1u;
+    uint16_t dest_frames = 0;
+    uint16_t dest_samples = 0;
+    uint32_t src_frames = 0;
+    while (src_frames < num_frames){
+        uint32_t block_frames = num_frames - src_frames;
+        if (block_frames > BTSTACK_RESAMPLE_POLYPHASE_BLOCK_FRAMES){
+            block_frames = BTSTACK_RESAMPLE_POLYPHASE_BLOCK_FRAMES;
+        }
+        // deinterleave block after history
+        const int16_t * input = &input_buffer[src_frames * context->num_channels];
+        uint32_t i;
+        int channel;
+        for (i = 0; i < block_frames; i++){
+            for (channel = 0; channel < context->num_channels; channel++){
+                context->samples[channel][num_history_frames + i] = *input++;
+            }
+        }
+        const uint32_t available_frames = num_history_frames + block_frames;
+        // filter as long as all taps are available
+        while (true){
+            const uint32_t src_pos = context->src_pos >> 16;
+            if ((src_pos + num_taps) > available_frames) break;
+            const uint16_t phase  = (context->src_pos & 0xffffu) >> BTSTACK_RESAMPLE_POLYPHASE_WEIGHT_BITS;
+            const int32_t  weight = context->src_pos & ((1u << BTSTACK_RESAMPLE_POLYPHASE_WEIGHT_BITS) - 1u);
+            const int16_t * coefficients = &context->coefficients[phase * num_taps];
+            for (channel = 0; channel < context->num_channels; channel++){
+                int32_t result_0;
+                int32_t result_1;
+                btstack_resample_polyphase_filter(coefficients, &coefficients[num_taps], &context->samples[channel][src_pos], num_taps, &result_0, &result_1);
+                // interpolate between adjacent phases, Q15 to Q0 with rounding
+                int64_t result = (int64_t) result_0 + ((((int64_t) result_1 - result_0) * weight) >> BTSTACK_RESAMPLE_POLYPHASE_WEIGHT_BITS);
+                output_buffer[dest_samples++] = btstack_resample_polyphase_saturate((result + (1 << 14)) >> 15);
+            }
+            dest_frames++;
+            context->src_pos += context->src_step;
+        }
+        // keep history for next block
+        for (channel = 0; channel < context->num_channels; channel++){
+            memmove(&context->samples[channel][0], &context->samples[channel][block_frames], num_history_frames * sizeof(int16_t));
+        }
+        context->src_pos -= block_frames << 16;
+        src_frames += block_frames;
+    }
+    return dest_frames;
+}
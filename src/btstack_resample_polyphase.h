@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title Polyphase Resampling
+ *
+ * Resampling for 16-bit audio samples using Kaiser windowed sinc filters with precomputed
+ * polyphase coefficient tables. The resampling factor uses the same 16.16 fixed point
+ * step as btstack_resample, the filters are designed for factors close to 1.0, e.g. to
+ * compensate clock drift with btstack_sample_rate_compensation.
+ *
+ * The quality selects the filter length and cutoff:
+ * - low:     8 taps, cutoff at 0.75 x Nyquist
+ * - medium: 16 taps, cutoff at 0.85 x Nyquist
+ * - high:   32 taps, cutoff at 0.91 x Nyquist
+ *
+ * The output is delayed by num_taps / 2 - 1 input frames. SSE2 or NEON is used if available.
+ *
+ */
+
+#ifndef BTSTACK_RESAMPLE_POLYPHASE_H
+#define BTSTACK_RESAMPLE_POLYPHASE_H
+
+#include <stdint.h>
+
+#include "btstack_resample.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define BTSTACK_RESAMPLE_POLYPHASE_MAX_TAPS 32
+
+// number of input frames deinterleaved per step
+#ifndef BTSTACK_RESAMPLE_POLYPHASE_BLOCK_FRAMES
+#define BTSTACK_RESAMPLE_POLYPHASE_BLOCK_FRAMES 64
+#endif
+
+typedef enum {
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_LOW = 0,
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_MEDIUM,
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH,
+} btstack_resample_polyphase_quality_t;
+
+typedef struct {
+    uint32_t src_pos;
+    uint32_t src_step;
+    const int16_t * coefficients;
+    uint16_t num_taps;
+    int      num_channels;
+    // per channel: last num_taps - 1 input samples followed by current input samples
+    int16_t  samples[BTSTACK_RESAMPLE_MAX_CHANNELS][BTSTACK_RESAMPLE_POLYPHASE_MAX_TAPS - 1 + BTSTACK_RESAMPLE_POLYPHASE_BLOCK_FRAMES];
+} btstack_resample_polyphase_t;
+
+/* API_START */
+
+/**
+ * @brief Init polyphase resample context
+ * @param context
+ * @param num_channels
+ * @param quality
+ */
+void btstack_resample_polyphase_init(btstack_resample_polyphase_t * context, int num_channels, btstack_resample_polyphase_quality_t quality);
+
+/**
+ * @brief Set resampling factor
+ * @param factor as fixed point value, identity is 0x10000
+ */
+void btstack_resample_polyphase_set_factor(btstack_resample_polyphase_t * context, uint32_t factor);
+
+/**
+ * @brief Process block of input samples
+ * @note size of output buffer is not checked
+ * @param input_buffer
+ * @param num_frames
+ * @param output_buffer
+ * @return number destination frames
+ */
+uint16_t btstack_resample_polyphase_block(btstack_resample_polyphase_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_RESAMPLE_POLYPHASE_H
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_ring_buffer_spsc.c"
+
+/*
+ *  btstack_ring_buffer_spsc.c
+ *
+ */
+
+#include <string.h>
+
+#include "btstack_ring_buffer_spsc.h"
+#include "btstack_util.h"
+
+#ifdef BTSTACK_RING_BUFFER_SPSC_C11_ATOMICS
+
+#include <stdatomic.h>
+
+static inline uint32_t btstack_ring_buffer_spsc_load_relaxed(const BTSTACK_RING_BUFFER_SPSC_INDEX * index){
+    return atomic_load_explicit(index, memory_order_relaxed);
+}
+
+static inline uint32_t btstack_ring_buffer_spsc_load_acquire(const BTSTACK_RING_BUFFER_SPSC_INDEX * index){
+    return atomic_load_explicit(index, memory_order_acquire);
+}
+
+static inline void btstack_ring_buffer_spsc_store_relaxed(BTSTACK_RING_BUFFER_SPSC_INDEX * index, uint32_t value){
+    atomic_store_explicit(index, value, memory_order_relaxed);
+}
+
+static inline void btstack_ring_buffer_spsc_store_release(BTSTACK_RING_BUFFER_SPSC_INDEX * index, uint32_t value){
+    atomic_store_explicit(index, value, memory_order_release);
+}
+
+static inline void btstack_ring_buffer_spsc_fence(void){
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+#else
+
+// pre-C11: volatile indices, data and index accesses ordered by memory barrier
+#if defined(__GNUC__)
+#define BTSTACK_RING_BUFFER_SPSC_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+// compiler barrier, sufficient for x86 memory model
+#define BTSTACK_RING_BUFFER_SPSC_BARRIER() _ReadWriteBarrier()
+#else
+#error "btstack_ring_buffer_spsc requires C11 atomics or a memory barrier for this compiler"
+#endif
+
+static inline uint32_t btstack_ring_buffer_spsc_load_relaxed(const BTSTACK_RING_BUFFER_SPSC_INDEX * index){
+    return *index;
+}
+
+static inline uint32_t btstack_ring_buffer_spsc_load_acquire(const BTSTACK_RING_BUFFER_SPSC_INDEX * index){
+    uint32_t value = *index;
+    BTSTACK_RING_BUFFER_SPSC_BARRIER();
+    return value;
+}
+
+static inline void btstack_ring_buffer_spsc_store_relaxed(BTSTACK_RING_BUFFER_SPSC_INDEX * index, uint32_t value){
+    *index = value;
+}
+
+static inline void btstack_ring_buffer_spsc_store_release(BTSTACK_RING_BUFFER_SPSC_INDEX * index, uint32_t value){
+    BTSTACK_RING_BUFFER_SPSC_BARRIER();
+    *index = value;
+}
+
+static inline void btstack_ring_buffer_spsc_fence(void){
+    BTSTACK_RING_BUFFER_SPSC_BARRIER();
+}
+
+#endif
+
+#define ERROR_CODE_MEMORY_CAPACITY_EXCEEDED 0x07
+
+static uint32_t btstack_ring_buffer_spsc_used(const btstack_ring_buffer_spsc_t * ring_buffer, uint32_t write_index, uint32_t read_index){
+    if (write_index >= read_index){
+        return write_index - read_index;
+    }
+    return write_index + (2u * ring_buffer->size) - read_index;
+}
+
+static uint32_t btstack_ring_buffer_spsc_position(const btstack_ring_buffer_spsc_t * ring_buffer, uint32_t index){
+    if (index >= ring_buffer->size){
+        return index - ring_buffer->size;
+    }
+    return index;
+}
+
+static uint32_t btstack_ring_buffer_spsc_advance(const btstack_ring_buffer_spsc_t * ring_buffer, uint32_t index, uint32_t num_bytes){
+    index += num_bytes;
+    if (index >= (2u * ring_buffer->size)){
+        index -= 2u * ring_buffer->size;
+    }
+    return index;
+}
+
+// acquire: consumer has finished reading the released bytes
+static uint32_t btstack_ring_buffer_spsc_refresh_read_index(btstack_ring_buffer_spsc_t * ring_buffer){
+    ring_buffer->read_index_cached = btstack_ring_buffer_spsc_load_acquire(&ring_buffer->read_index);
+    return ring_buffer->read_index_cached;
+}
+
+// acquire: producer has finished writing the committed bytes
+static uint32_t btstack_ring_buffer_spsc_refresh_write_index(btstack_ring_buffer_spsc_t * ring_buffer){
+    ring_buffer->write_index_cached = btstack_ring_buffer_spsc_load_acquire(&ring_buffer->write_index);
+    return ring_buffer->write_index_cached;
+}
+
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size){
+    ring_buffer->storage = storage;
+    ring_buffer->size = storage_size;
+    btstack_ring_buffer_spsc_reset(ring_buffer);
+}
+
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer){
+    btstack_ring_buffer_spsc_store_relaxed(&ring_buffer->write_index, 0);
+    btstack_ring_buffer_spsc_store_relaxed(&ring_buffer->read_index,  0);
+    ring_buffer->read_index_cached  = 0;
+    ring_buffer->write_index_cached = 0;
+    btstack_ring_buffer_spsc_fence();
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer){
+    uint32_t read_index  = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->read_index);
+    uint32_t write_index = btstack_ring_buffer_spsc_refresh_write_index(ring_buffer);
+    return btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer){
+    uint32_t write_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->write_index);
+    uint32_t read_index  = btstack_ring_buffer_spsc_refresh_read_index(ring_buffer);
+    return ring_buffer->size - btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+}
+
+uint8_t * btstack_ring_buffer_spsc_write_reserve(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_length){
+    uint32_t write_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->write_index);
+    uint32_t read_index  = btstack_ring_buffer_spsc_refresh_read_index(ring_buffer);
+    uint32_t bytes_free  = ring_buffer->size - btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+    uint32_t position    = btstack_ring_buffer_spsc_position(ring_buffer, write_index);
+    *region_length = btstack_min(bytes_free, ring_buffer->size - position);
+    return &ring_buffer->storage[position];
+}
+
+// release: written bytes are visible before the consumer sees the new write index
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes){
+    uint32_t write_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->write_index);
+    write_index = btstack_ring_buffer_spsc_advance(ring_buffer, write_index, num_bytes);
+    btstack_ring_buffer_spsc_store_release(&ring_buffer->write_index, write_index);
+}
+
+const uint8_t * btstack_ring_buffer_spsc_read_reserve(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_length){
+    uint32_t read_index  = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->read_index);
+    uint32_t write_index = btstack_ring_buffer_spsc_refresh_write_index(ring_buffer);
+    uint32_t bytes_available = btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+    uint32_t position    = btstack_ring_buffer_spsc_position(ring_buffer, read_index);
+    *region_length = btstack_min(bytes_available, ring_buffer->size - position);
+    return &ring_buffer->storage[position];
+}
+
+// release: bytes have been read before the producer sees the new read index
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes){
+    uint32_t read_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->read_index);
+    read_index = btstack_ring_buffer_spsc_advance(ring_buffer, read_index, num_bytes);
+    btstack_ring_buffer_spsc_store_release(&ring_buffer->read_index, read_index);
+}
+
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length){
+    uint32_t write_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->write_index);
+    // use cached read index if it shows enough space
+    uint32_t bytes_free = ring_buffer->size - btstack_ring_buffer_spsc_used(ring_buffer, write_index, ring_buffer->read_index_cached);
+    if (bytes_free < data_length){
+        uint32_t read_index = btstack_ring_buffer_spsc_refresh_read_index(ring_buffer);
+        bytes_free = ring_buffer->size - btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+        if (bytes_free < data_length){
+            return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+        }
+    }
+
+    // copy first chunk until end of storage, second chunk from start
+    uint32_t position = btstack_ring_buffer_spsc_position(ring_buffer, write_index);
+    uint32_t bytes_to_copy = btstack_min(data_length, ring_buffer->size - position);
+    (void)memcpy(&ring_buffer->storage[position], data, bytes_to_copy);
+    if (bytes_to_copy < data_length){
+        (void)memcpy(&ring_buffer->storage[0], &data[bytes_to_copy], data_length - bytes_to_copy);
+    }
+
+    write_index = btstack_ring_buffer_spsc_advance(ring_buffer, write_index, data_length);
+    btstack_ring_buffer_spsc_store_release(&ring_buffer->write_index, write_index);
+    return ERROR_CODE_SUCCESS;
+}
+
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * data, uint32_t data_length, uint32_t * number_of_bytes_read){
+    uint32_t read_index = btstack_ring_buffer_spsc_load_relaxed(&ring_buffer->read_index);
+    // use cached write index if it shows enough data
+    uint32_t bytes_available = btstack_ring_buffer_spsc_used(ring_buffer, ring_buffer->write_index_cached, read_index);
+    if (bytes_available < data_length){
+        uint32_t write_index = btstack_ring_buffer_spsc_refresh_write_index(ring_buffer);
+        bytes_available = btstack_ring_buffer_spsc_used(ring_buffer, write_index, read_index);
+    }
+    uint32_t bytes_to_read = btstack_min(data_length, bytes_available);
+    *number_of_bytes_read = bytes_to_read;
+    if (bytes_to_read == 0u) return;
+
+    // copy first chunk until end of storage, second chunk from start
+    uint32_t position = btstack_ring_buffer_spsc_position(ring_buffer, read_index);
+    uint32_t bytes_to_copy = btstack_min(bytes_to_read, ring_buffer->size - position);
+    (void)memcpy(data, &ring_buffer->storage[position], bytes_to_copy);
+    if (bytes_to_copy < bytes_to_read){
+        (void)memcpy(&data[bytes_to_copy], &ring_buffer->storage[0], bytes_to_read - bytes_to_copy);
+    }
+
+    read_index = btstack_ring_buffer_spsc_advance(ring_buffer, read_index, bytes_to_read);
+    btstack_ring_buffer_spsc_store_release(&ring_buffer->read_index, read_index);
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title Lock-free SPSC Ring Buffer
+ *
+ * Ring buffer for one producer and one consumer running in different threads, e.g. an audio
+ * callback and the run loop. Read and write indices are C11 atomics with acquire/release
+ * ordering and are kept in separate cache lines. Besides copying read and write, it
+ * provides zero-copy access to contiguous regions via reserve and commit.
+ *
+ * Producer: btstack_ring_buffer_spsc_bytes_free, _write, _write_reserve, _write_commit
+ * Consumer: btstack_ring_buffer_spsc_bytes_available, _read, _read_reserve, _read_commit
+ *
+ * Uses C11 atomics if available. Otherwise, the indices are volatile and accesses are ordered
+ * by a memory barrier (GCC, Clang) or a compiler barrier (MSVC, x86 only).
+ *
+ */
+
+#ifndef BTSTACK_RING_BUFFER_SPSC_H
+#define BTSTACK_RING_BUFFER_SPSC_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifndef BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE
+#define BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE 64
+#endif
+
+// C11 atomics if available, volatile with memory barriers otherwise
+// C++ code only uses the API, _Atomic uint32_t has the same layout as uint32_t
+#if defined(__cplusplus)
+#define BTSTACK_RING_BUFFER_SPSC_INDEX uint32_t
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#define BTSTACK_RING_BUFFER_SPSC_C11_ATOMICS
+#define BTSTACK_RING_BUFFER_SPSC_INDEX _Atomic uint32_t
+#else
+#define BTSTACK_RING_BUFFER_SPSC_INDEX volatile uint32_t
+#endif
+
+typedef struct btstack_ring_buffer_spsc {
+    uint8_t  * storage;
+    uint32_t size;
+    uint8_t  padding_0[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE];
+
+    // written by producer, indices run from 0 to 2 * size - 1 to distinguish full from empty
+    BTSTACK_RING_BUFFER_SPSC_INDEX write_index;
+    uint32_t read_index_cached;
+    uint8_t  padding_1[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE];
+
+    // written by consumer
+    BTSTACK_RING_BUFFER_SPSC_INDEX read_index;
+    uint32_t write_index_cached;
+    uint8_t  padding_2[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE];
+} btstack_ring_buffer_spsc_t;
+
+/* API_START */
+
+/**
+ * Init ring buffer
+ * @param ring_buffer object
+ * @param storage
+ * @param storage_size in bytes
+ */
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size);
+
+/**
+ * Reset ring buffer to initial state (empty)
+ * @note neither producer nor consumer must access the ring buffer at the same time
+ * @param ring_buffer object
+ */
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get number of bytes available for read, called by consumer
+ * @param ring_buffer object
+ * @return number of bytes available for read
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get free space available for write, called by producer
+ * @param ring_buffer object
+ * @return number of bytes available for write
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Write bytes into ring buffer, called by producer
+ * @param ring_buffer object
+ * @param data to store
+ * @param data_length
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if not enough space in buffer
+ */
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length);
+
+/**
+ * Read from ring buffer, called by consumer
+ * @param ring_buffer object
+ * @param buffer to store read data
+ * @param length to read
+ * @param number_of_bytes_read
+ */
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read);
+
+/**
+ * Get contiguous free region for write, called by producer
+ * @note region may be smaller than bytes_free if free space wraps around
+ * @param ring_buffer object
+ * @param region_length of contiguous free region
+ * @return start of region
+ */
+uint8_t * btstack_ring_buffer_spsc_write_reserve(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_length);
+
+/**
+ * Make bytes written into reserved region available to consumer, called by producer
+ * @param ring_buffer object
+ * @param num_bytes <= region_length returned by btstack_ring_buffer_spsc_write_reserve
+ */
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes);
+
+/**
+ * Get contiguous region of data available for read, called by consumer
+ * @note region may be smaller than bytes_available if data wraps around
+ * @param ring_buffer object
+ * @param region_length of contiguous data
+ * @return start of region
+ */
+const uint8_t * btstack_ring_buffer_spsc_read_reserve(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_length);
+
+/**
+ * Release bytes from region returned by read_reserve to producer, called by consumer
+ * @param ring_buffer object
+ * @param num_bytes <= region_length returned by btstack_ring_buffer_spsc_read_reserve
+ */
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_RING_BUFFER_SPSC_H
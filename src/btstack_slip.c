@@ -44,6 +44,11 @@
 
 #include "btstack_slip.h"
 #include "btstack_debug.h"
+#include "btstack_util.h"
+
+#include <string.h>
+
+#define SLIP_ESC 0xdb
 
 typedef enum {
 	SLIP_ENCODER_DEFAULT,
@@ -142,6 +147,64 @@ uint8_t btstack_slip_encoder_get_byte(void){
 	return next_byte;
 }
 
+// Block processing
+
+// @return true if word contains SOF or ESC byte, check 4 bytes in parallel
+static inline bool btstack_slip_word_has_special_byte(uint32_t word){
+    uint32_t sof = word ^ 0xc0c0c0c0u;
+    uint32_t esc = word ^ 0xdbdbdbdbu;
+    uint32_t sof_zero = (sof - 0x01010101u) & ~sof & 0x80808080u;
+    uint32_t esc_zero = (esc - 0x01010101u) & ~esc & 0x80808080u;
+    return (sof_zero | esc_zero) != 0u;
+}
+
+// @return number of bytes before first SOF or ESC byte, or len if none
+static uint16_t btstack_slip_find_special_byte(const uint8_t * data, uint16_t len){
+    uint16_t pos = 0;
+    while ((len - pos) >= 4u){
+        uint32_t word;
+        (void) memcpy(&word, &data[pos], 4);
+        if (btstack_slip_word_has_special_byte(word)) break;
+        pos += 4u;
+    }
+    while (pos < len){
+        uint8_t next_byte = data[pos];
+        if ((next_byte == BTSTACK_SLIP_SOF) || (next_byte == SLIP_ESC)) break;
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * @brief Encode data from encoder into buffer
+ * @param buffer for encoded data
+ * @param max_len of buffer
+ * @return number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_encode_block(uint8_t * buffer, uint16_t max_len){
+	uint16_t pos = 0;
+	while (pos < max_len){
+		// copy bytes that don't need escaping
+		if ((encoder_state == SLIP_ENCODER_DEFAULT) && (encoder_len > 0u)){
+			uint16_t run_len = btstack_slip_find_special_byte(encoder_data, (uint16_t) btstack_min(encoder_len, max_len - pos));
+			if (run_len > 0u){
+				(void) memcpy(&buffer[pos], encoder_data, run_len);
+				encoder_data += run_len;
+				encoder_len  -= run_len;
+				pos          += run_len;
+				// After last byte, send CO SOF again
+				if (encoder_len == 0u){
+					encoder_state = SLIP_ENCODER_SEND_C0;
+				}
+				continue;
+			}
+		}
+		if (btstack_slip_encoder_has_data() == 0) break;
+		buffer[pos++] = btstack_slip_encoder_get_byte();
+	}
+	return pos;
+}
+
 // Decoder
 
 static void btstack_slip_decoder_reset(void){
@@ -248,3 +311,28 @@ uint16_t btstack_slip_decoder_frame_size(void){
 			return 0;
 	}
 }
+
+/**
+ * @brief Process received data until frame is complete
+ * @param data
+ * @param len
+ * @return number of bytes processed
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t len){
+	uint16_t pos = 0;
+	while ((pos < len) && (decoder_state != SLIP_DECODER_COMPLETE)){
+		// copy bytes that don't need unescaping
+		if (decoder_state == SLIP_DECODER_ACTIVE){
+			uint16_t run_len = btstack_slip_find_special_byte(&data[pos], len - pos);
+			run_len = (uint16_t) btstack_min(run_len, decoder_max_size - decoder_pos);
+			if (run_len > 0u){
+				(void) memcpy(&decoder_buffer[decoder_pos], &data[pos], run_len);
+				decoder_pos += run_len;
+				pos         += run_len;
+				continue;
+			}
+		}
+		btstack_slip_decoder_process(data[pos++]);
+	}
+	return pos;
+}
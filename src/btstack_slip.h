@@ -74,6 +74,14 @@ int  btstack_slip_encoder_has_data(void);
  */
 uint8_t btstack_slip_encoder_get_byte(void);
 
+/**
+ * @brief Encode next bytes from encoder into buffer
+ * @param buffer for encoded data
+ * @param max_len of buffer
+ * @return number of bytes stored in buffer, 0 if encoder has no data
+ */
+uint16_t btstack_slip_encoder_encode_block(uint8_t * buffer, uint16_t max_len);
+
 // DECODER
 
 /**
@@ -97,6 +105,14 @@ void btstack_slip_decoder_process(uint8_t input);
 
 uint16_t btstack_slip_decoder_frame_size(void);
 
+/**
+ * @brief Process received data until frame is complete
+ * @param data
+ * @param len
+ * @return number of bytes processed. Check btstack_slip_decoder_frame_size afterwards
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t len);
+
 /* API_END */
 
 #if defined __cplusplus
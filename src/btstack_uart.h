@@ -181,6 +181,19 @@ typedef struct {
      */
     void (*send_frame)(const uint8_t *buffer, uint16_t length);
 
+
+    /** Support for streaming receive, e.g. H4 read-ahead - can be set to NULL */
+
+    /**
+     * set callback for bytes received. NULL disables callback
+     */
+    void (*set_bytes_received)(void (*bytes_handler)(uint16_t num_bytes));
+
+    /**
+     * receive up to max_len bytes, callback is called as soon as at least one byte was received
+     */
+    void (*receive_bytes)(uint8_t *buffer, uint16_t max_len);
+
 } btstack_uart_t;
 
 /* API_END */
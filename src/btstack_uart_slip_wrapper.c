@@ -75,10 +75,7 @@ static uint32_t btstack_uart_slip_wrapper_baudrate;
 // SLIP ENCODING
 
 static void btstack_uart_slip_posix_encode_chunk_and_send(void){
-    uint16_t pos = 0;
-    while (btstack_slip_encoder_has_data() & (pos < SLIP_TX_CHUNK_LEN)) {
-        btstack_uart_slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    uint16_t pos = btstack_slip_encoder_encode_block(btstack_uart_slip_outgoing_buffer, SLIP_TX_CHUNK_LEN);
 
     // setup async write and start sending
     original_uart->send_block(btstack_uart_slip_outgoing_buffer, pos);
@@ -477,14 +477,44 @@ static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
 }
 
 
+/* Copy len bytes starting at offset from list of fragments */
+static void bnep_fragments_read(const bnep_fragment_t *fragments, uint16_t num_fragments, uint16_t offset, uint8_t *buffer, uint16_t len)
+{
+    uint16_t i;
+    for (i = 0; (i < num_fragments) && (len > 0); i++) {
+        const bnep_fragment_t *fragment = &fragments[i];
+        if (offset >= fragment->len) {
+            offset -= fragment->len;
+            continue;
+        }
+        uint16_t bytes_to_copy = btstack_min(fragment->len - offset, len);
+        (void)memcpy(buffer, fragment->data + offset, bytes_to_copy);
+        buffer += bytes_to_copy;
+        len    -= bytes_to_copy;
+        offset  = 0;
+    }
+}
+
 /* Send BNEP ethernet packet */
 int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
+{
+    bnep_fragment_t fragment;
+    fragment.data = packet;
+    fragment.len  = len;
+    return bnep_send_fragments(bnep_cid, &fragment, 1);
+}
+
+/* Send BNEP ethernet packet provided as list of fragments */
+int bnep_send_fragments(uint16_t bnep_cid, const bnep_fragment_t *fragments, uint16_t num_fragments)
 {
     bnep_channel_t *channel;
     uint8_t        *bnep_out_buffer = NULL;
+    uint8_t         header[(2 * sizeof(bd_addr_t)) + sizeof(uint16_t) + 4];
+    uint16_t        len = 0;
     uint16_t        pos = 0;
     uint16_t        pos_out = 0;
     uint16_t        payload_len;
+    uint16_t        i;
     int             err = 0;
     int             has_source;
     int             has_dest;
@@ -508,13 +538,24 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
         return BTSTACK_ACL_BUFFERS_FULL;
     }
 
+    for (i = 0; i < num_fragments; i++) {
+        len += fragments[i].len;
+    }
+    if (len < ((2 * sizeof(bd_addr_t)) + sizeof(uint16_t))) {
+        /* Omit this packet */
+        return 0;
+    }
+
+    /* Gather ethernet header and VLAN tag, which might be split across fragments */
+    bnep_fragments_read(fragments, num_fragments, 0, header, btstack_min(len, sizeof(header)));
+
     /* Extract destination and source address from the ethernet packet */
     pos = 0;
-    bd_addr_copy(addr_dest, &packet[pos]);
+    bd_addr_copy(addr_dest, &header[pos]);
     pos += sizeof(bd_addr_t);
-    bd_addr_copy(addr_source, &packet[pos]);
+    bd_addr_copy(addr_source, &header[pos]);
     pos += sizeof(bd_addr_t);
-    network_protocol_type = big_endian_read_16(packet, pos);
+    network_protocol_type = big_endian_read_16(header, pos);
     pos += sizeof(uint16_t);
 
     payload_len = len - pos;
@@ -525,7 +566,7 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
 			return 0;
         }
         /* The "real" network protocol type is 4 bytes ahead in a VLAN packet */
-		network_protocol_type = big_endian_read_16(packet, pos + 2);
+		network_protocol_type = big_endian_read_16(header, pos + 2);
 	}
 
     /* Check network protocol and multicast filters before sending */
@@ -593,7 +634,7 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
     
     /* TODO: Add extension headers, if we may support them at a later stage */
     /* Add the payload and then send out the package */
-    (void)memcpy(bnep_out_buffer + pos_out, packet + pos, payload_len);
+    bnep_fragments_read(fragments, num_fragments, pos, bnep_out_buffer + pos_out, payload_len);
     pos_out += payload_len;
 
     err = l2cap_send_prepared(channel->l2cap_cid, pos_out);
@@ -100,6 +100,12 @@ typedef struct {
 	uint8_t		        addr_end[ETHER_ADDR_LEN];
 } bnep_multi_filter_t;
 
+/* fragment of an ethernet packet, used for scatter-gather send */
+typedef struct {
+    const uint8_t *     data;
+    uint16_t            len;
+} bnep_fragment_t;
+
 
 // info regarding multiplexer
 // note: spec mandates single multplexer per device combination
@@ -185,6 +191,15 @@ void bnep_request_can_send_now_event(uint16_t bnep_cid);
  */
 int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len);
 
+/**
+ * @brief Send a data packet provided as list of fragments, e.g. a chain of network buffers.
+ * @note The fragments are copied directly into the outgoing L2CAP buffer
+ * @param bnep_cid
+ * @param fragments
+ * @param num_fragments
+ */
+int bnep_send_fragments(uint16_t bnep_cid, const bnep_fragment_t * fragments, uint16_t num_fragments);
+
 /**
  * @brief Set the network protocol filter.
  */
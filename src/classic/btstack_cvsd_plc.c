@@ -53,6 +53,14 @@
 #include "btstack_cvsd_plc.h"
 #include "btstack_debug.h"
 
+#if defined(__SSE2__)
+#define BTSTACK_CVSD_PLC_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BTSTACK_CVSD_PLC_NEON
+#include <arm_neon.h>
+#endif
+
 // static float rcos[CVSD_OLAL] = {
 //     0.99148655f,0.96623611f,0.92510857f,0.86950446f,
 //     0.80131732f,0.72286918f,0.63683150f,0.54613418f, 
@@ -70,55 +78,72 @@ float btstack_cvsd_plc_rcos(int index){
     return rcos[index];
 }
 
-// taken from http://www.codeproject.com/Articles/69941/Best-Square-Root-Method-Algorithm-Function-Precisi
-// Algorithm: Babylonian Method + some manipulations on IEEE 32 bit floating point representation
-static float sqrt3(const float x){
-    union {
-        int i;
-        float x;
-    } u;
-    u.x = x;
-    u.i = (1<<29) + (u.i >> 1) - (1<<22); 
-
-    // Two Babylonian Steps (simplified from:)
-    // u.x = 0.5f * (u.x + x/u.x);
-    // u.x = 0.5f * (u.x + x/u.x);
-    u.x =       u.x + (x/u.x);
-    u.x = (0.25f*u.x) + (x/u.x);
-
-    return u.x;
-}
-
 static float btstack_cvsd_plc_absolute(float x){
      if (x < 0) x = -x;
      return x;
 }
 
-static float btstack_cvsd_plc_cross_correlation(BTSTACK_CVSD_PLC_SAMPLE_FORMAT *x, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
-    float num = 0;
-    float den = 0;
-    float x2 = 0;
-    float y2 = 0;
-    int   m;
+// dot product of template and history window, exact in 64 bit
+// template must not contain -32768, as two -32768 * -32768 products overflow the int32 sum of SSE2 pmaddwd
+static int64_t btstack_cvsd_plc_dot_product(const BTSTACK_CVSD_PLC_SAMPLE_FORMAT *x, const BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
+#if defined(BTSTACK_CVSD_PLC_SSE2)
+    __m128i sum = _mm_setzero_si128();
+    int m;
+    for (m=0;m<CVSD_M;m+=8){
+        __m128i products = _mm_madd_epi16(_mm_loadu_si128((const __m128i *) &x[m]), _mm_loadu_si128((const __m128i *) &y[m]));
+        __m128i sign = _mm_srai_epi32(products, 31);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(products, sign));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(products, sign));
+    }
+    int64_t result[2];
+    _mm_storeu_si128((__m128i *) result, sum);
+    return result[0] + result[1];
+#elif defined(BTSTACK_CVSD_PLC_NEON)
+    int64x2_t sum = vdupq_n_s64(0);
+    int m;
+    for (m=0;m<CVSD_M;m+=4){
+        sum = vpadalq_s32(sum, vmull_s16(vld1_s16(&x[m]), vld1_s16(&y[m])));
+    }
+    return vgetq_lane_s64(sum, 0) + vgetq_lane_s64(sum, 1);
+#else
+    int64_t sum = 0;
+    int m;
     for (m=0;m<CVSD_M;m++){
-        num+=((float)x[m])*y[m];
-        x2+=((float)x[m])*x[m];
-        y2+=((float)y[m])*y[m];
+        sum += (int32_t) x[m] * y[m];
     }
-    den = (float)sqrt3(x2*y2);
-    return num/den;
+    return sum;
+#endif
 }
 
+// Find lag with maximal normalized cross correlation Cn = num / sqrt(x2 * y2) between template and history.
+// x2 is the same for all lags, so sign(num) * num^2 / y2 is compared instead, which avoids sqrt and division.
+// y2 is updated incrementally while sliding over the history.
 int btstack_cvsd_plc_pattern_match(BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
-    float maxCn = -999999.0;  // large negative number
+    BTSTACK_CVSD_PLC_SAMPLE_FORMAT x[CVSD_M];
+    int64_t y2 = 0;
+    int     m;
+    for (m=0;m<CVSD_M;m++){
+        BTSTACK_CVSD_PLC_SAMPLE_FORMAT sample = y[CVSD_LHIST-CVSD_M+m];
+        x[m] = (sample == INT16_MIN) ? -INT16_MAX : sample;
+        y2 += (int32_t) y[m] * y[m];
+    }
+
+    float maxNum2 = 0.0f;
+    float maxY2   = 1.0f;
     int   bestmatch = 0;
-    float Cn;
     int   n;
     for (n=0;n<CVSD_N;n++){
-        Cn = btstack_cvsd_plc_cross_correlation(&y[CVSD_LHIST-CVSD_M], &y[n]); 
-        if (Cn>maxCn){
-            bestmatch=n;
-            maxCn = Cn; 
+        if (n > 0){
+            y2 += (int32_t) y[n+CVSD_M-1] * y[n+CVSD_M-1] - (int32_t) y[n-1] * y[n-1];
+        }
+        float num  = (float) btstack_cvsd_plc_dot_product(x, &y[n]);
+        float num2 = num * btstack_cvsd_plc_absolute(num);
+        // num is zero if y2 is zero
+        float energy = (y2 > 0) ? (float) y2 : 1.0f;
+        if ((n == 0) || ((num2 * maxY2) > (maxNum2 * energy))){
+            bestmatch = n;
+            maxNum2 = num2;
+            maxY2   = energy;
         }
     }
     return bestmatch;
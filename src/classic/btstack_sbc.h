@@ -128,6 +128,7 @@ int btstack_sbc_decoder_sample_rate(btstack_sbc_decoder_state_t * state);
 /* BTstack SBC Encoder */
 /**
  * @brief Init SBC encoder
+ * @note  Multiple encoders can be used concurrently if each state was set up with btstack_sbc_encoder_bluedroid_init_instance
  * @param state
  * @param mode 
  * @param blocks
@@ -143,25 +144,29 @@ void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_m
 
 /**
  * @brief Encode PCM data
+ * @param state
  * @param buffer with samples in host endianess
  */
-void btstack_sbc_encoder_process_data(int16_t * input_buffer);
+void btstack_sbc_encoder_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer);
 
 /**
  * @brief Return SBC frame
+ * @param state
  */
-uint8_t * btstack_sbc_encoder_sbc_buffer(void);
+uint8_t * btstack_sbc_encoder_sbc_buffer(btstack_sbc_encoder_state_t * state);
 
 /**
  * @brief Return SBC frame length
+ * @param state
  */
-uint16_t  btstack_sbc_encoder_sbc_buffer_length(void);
+uint16_t  btstack_sbc_encoder_sbc_buffer_length(btstack_sbc_encoder_state_t * state);
 
 /**
  * @brief Return number of audio frames required for one SBC packet
+ * @param state
  * @note  each audio frame contains 2 sample values in stereo modes
  */
-int  btstack_sbc_encoder_num_audio_frames(void);
+int  btstack_sbc_encoder_num_audio_frames(btstack_sbc_encoder_state_t * state);
 
 /* API_END */
 
@@ -50,6 +50,7 @@
 #include <string.h>
 
 #include "btstack_sbc.h"
+#include "btstack_sbc_encoder_bluedroid.h"
 #include "btstack_sbc_plc.h"
 #include "btstack_debug.h"
 #include "btstack_util.h"
@@ -61,98 +62,103 @@
 #define SBC_MAX_CHANNELS 2
 // #define LOG_FRAME_STATUS
 
+// used if no context was provided by btstack_sbc_encoder_bluedroid_init_instance
+static btstack_sbc_encoder_bluedroid_t bd_encoder_state;
+static btstack_sbc_encoder_state_t * bd_encoder_state_owner;
 
-typedef struct {
-    SBC_ENC_PARAMS context;
-    int num_data_bytes;
-    uint8_t sbc_packet[1000];
-} bludroid_encoder_state_t;
-
-static btstack_sbc_encoder_state_t * sbc_encoder_state_singleton = NULL;
-static bludroid_encoder_state_t bd_encoder_state;
+static inline SBC_ENC_PARAMS * btstack_sbc_encoder_get_context(btstack_sbc_encoder_state_t * state){
+    btstack_assert(state != NULL);
+    btstack_assert(state->encoder_state != NULL);
+    return &((btstack_sbc_encoder_bluedroid_t *) state->encoder_state)->context;
+}
 
+void btstack_sbc_encoder_bluedroid_init_instance(btstack_sbc_encoder_state_t * state, btstack_sbc_encoder_bluedroid_t * context){
+    memset(context, 0, sizeof(btstack_sbc_encoder_bluedroid_t));
+    state->encoder_state = context;
+}
 
 void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_mode_t mode, 
                         int blocks, int subbands, btstack_sbc_allocation_method_t allocation_method, 
                         int sample_rate, int bitpool, btstack_sbc_channel_mode_t channel_mode){
 
-    if (sbc_encoder_state_singleton && (sbc_encoder_state_singleton != state) ){
-        log_error("SBC encoder: different sbc decoder state is allready registered");
-    } 
-    
-    sbc_encoder_state_singleton = state;
-
-    if (!sbc_encoder_state_singleton){
+    if (!state){
         log_error("SBC encoder init: sbc state is NULL");
+        return;
+    }
+
+    // use static context if none was provided
+    if (state->encoder_state == NULL){
+        if (bd_encoder_state_owner && (bd_encoder_state_owner != state)){
+            log_error("SBC encoder: static encoder context already used by different sbc encoder state, use btstack_sbc_encoder_bluedroid_init_instance");
+        }
+        bd_encoder_state_owner = state;
+        state->encoder_state = &bd_encoder_state;
     }
 
-    sbc_encoder_state_singleton->mode = mode;
+    state->mode = mode;
+
+    btstack_sbc_encoder_bluedroid_t * bd_encoder = (btstack_sbc_encoder_bluedroid_t *) state->encoder_state;
+    SBC_ENC_PARAMS * context = &bd_encoder->context;
 
-    switch (sbc_encoder_state_singleton->mode){
+    switch (state->mode){
         case SBC_MODE_STANDARD:
-            bd_encoder_state.context.s16NumOfBlocks = blocks;                          
-            bd_encoder_state.context.s16NumOfSubBands = subbands;                       
-            bd_encoder_state.context.s16AllocationMethod = (uint8_t)allocation_method;                     
-            bd_encoder_state.context.s16BitPool = bitpool;  
-            bd_encoder_state.context.mSBCEnabled = 0;
-            bd_encoder_state.context.s16ChannelMode = (uint8_t)channel_mode;
-            bd_encoder_state.context.s16NumOfChannels = 2;
-            if (bd_encoder_state.context.s16ChannelMode == SBC_MONO){
-                bd_encoder_state.context.s16NumOfChannels = 1;
+            context->s16NumOfBlocks = blocks;
+            context->s16NumOfSubBands = subbands;
+            context->s16AllocationMethod = (uint8_t)allocation_method;
+            context->s16BitPool = bitpool;
+            context->mSBCEnabled = 0;
+            context->s16ChannelMode = (uint8_t)channel_mode;
+            context->s16NumOfChannels = 2;
+            if (context->s16ChannelMode == SBC_MONO){
+                context->s16NumOfChannels = 1;
             }
             switch(sample_rate){
-                case 16000: bd_encoder_state.context.s16SamplingFreq = SBC_sf16000; break;
-                case 32000: bd_encoder_state.context.s16SamplingFreq = SBC_sf32000; break;
-                case 44100: bd_encoder_state.context.s16SamplingFreq = SBC_sf44100; break;
-                case 48000: bd_encoder_state.context.s16SamplingFreq = SBC_sf48000; break;
-                default: bd_encoder_state.context.s16SamplingFreq = 0; break;
+                case 16000: context->s16SamplingFreq = SBC_sf16000; break;
+                case 32000: context->s16SamplingFreq = SBC_sf32000; break;
+                case 44100: context->s16SamplingFreq = SBC_sf44100; break;
+                case 48000: context->s16SamplingFreq = SBC_sf48000; break;
+                default: context->s16SamplingFreq = 0; break;
             }
             break;
         case SBC_MODE_mSBC:
-            bd_encoder_state.context.s16NumOfBlocks    = 15;
-            bd_encoder_state.context.s16NumOfSubBands  = 8;
-            bd_encoder_state.context.s16AllocationMethod = SBC_LOUDNESS;
-            bd_encoder_state.context.s16BitPool   = 26;
-            bd_encoder_state.context.s16ChannelMode = SBC_MONO;
-            bd_encoder_state.context.s16NumOfChannels = 1;
-            bd_encoder_state.context.mSBCEnabled = 1;
-            bd_encoder_state.context.s16SamplingFreq = SBC_sf16000;
+            context->s16NumOfBlocks    = 15;
+            context->s16NumOfSubBands  = 8;
+            context->s16AllocationMethod = SBC_LOUDNESS;
+            context->s16BitPool   = 26;
+            context->s16ChannelMode = SBC_MONO;
+            context->s16NumOfChannels = 1;
+            context->mSBCEnabled = 1;
+            context->s16SamplingFreq = SBC_sf16000;
             break;
         default:
             btstack_assert(false);
             break;
     }
-    bd_encoder_state.context.pu8Packet = bd_encoder_state.sbc_packet;
-    
-    sbc_encoder_state_singleton->encoder_state = &bd_encoder_state;
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+    context->pu8Packet = bd_encoder->sbc_packet;
+
     SBC_Encoder_Init(context);
 }
 
-
-void btstack_sbc_encoder_process_data(int16_t * input_buffer){
-    if (!sbc_encoder_state_singleton){
-        log_error("SBC encoder: sbc state is NULL, call btstack_sbc_encoder_init to initialize it");
-    }
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+void btstack_sbc_encoder_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     context->ps16PcmBuffer = input_buffer;
     if (context->mSBCEnabled){
-        context->pu8Packet[0] = 0xad;
+        context->pu8Packet[0] = mSBC_SYNCWORD;
     }
     SBC_Encoder(context);
 }
 
-int btstack_sbc_encoder_num_audio_frames(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+int btstack_sbc_encoder_num_audio_frames(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->s16NumOfSubBands * context->s16NumOfBlocks;
 }
 
-uint8_t * btstack_sbc_encoder_sbc_buffer(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint8_t * btstack_sbc_encoder_sbc_buffer(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->pu8Packet;
 }
 
-uint16_t  btstack_sbc_encoder_sbc_buffer_length(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint16_t  btstack_sbc_encoder_sbc_buffer_length(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = btstack_sbc_encoder_get_context(state);
     return context->u16PacketLength;
 }
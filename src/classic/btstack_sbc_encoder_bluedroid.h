@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title SBC Encoder Bluedroid
+ *
+ * Context storage for the Bluedroid based SBC encoder to run multiple encoders concurrently.
+ *
+ */
+
+#ifndef BTSTACK_SBC_ENCODER_BLUEDROID_H
+#define BTSTACK_SBC_ENCODER_BLUEDROID_H
+
+#include <stdint.h>
+#include "sbc_encoder.h"
+#include "btstack_sbc.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/* API_START */
+
+typedef struct {
+    SBC_ENC_PARAMS context;
+    int num_data_bytes;
+    uint8_t sbc_packet[1000];
+} btstack_sbc_encoder_bluedroid_t;
+
+/**
+ * @brief Use provided Bluedroid encoder context for SBC encoder state. Call before btstack_sbc_encoder_init.
+ * @note  Without this, btstack_sbc_encoder_init uses a single static context, which only supports one encoder.
+ * @param state
+ * @param context for Bluedroid SBC encoder
+ */
+void btstack_sbc_encoder_bluedroid_init_instance(btstack_sbc_encoder_state_t * state, btstack_sbc_encoder_bluedroid_t * context);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+#endif // BTSTACK_SBC_ENCODER_BLUEDROID_H
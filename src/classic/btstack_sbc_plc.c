@@ -53,6 +53,14 @@
 #include "btstack_sbc_plc.h"
 #include "btstack_debug.h"
 
+#if defined(__SSE2__)
+#define BTSTACK_SBC_PLC_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BTSTACK_SBC_PLC_NEON
+#include <arm_neon.h>
+#endif
+
 #define SAMPLE_FORMAT int16_t
 
 // Zero Frame (57 bytes) with padding zeros to avoid out of bound reads
@@ -74,55 +82,72 @@ static float rcos[SBC_OLAL] = {
     0.13049554f,0.07489143f,0.03376389f,0.00851345f
 };
 
-// taken from http://www.codeproject.com/Articles/69941/Best-Square-Root-Method-Algorithm-Function-Precisi
-// Algorithm: Babylonian Method + some manipulations on IEEE 32 bit floating point representation
-static float sqrt3(const float x){
-    union {
-        int i;
-        float x;
-    } u;
-    u.x = x;
-    u.i = (1<<29) + (u.i >> 1) - (1<<22); 
-
-    // Two Babylonian Steps (simplified from:)
-    // u.x = 0.5f * (u.x + x/u.x);
-    // u.x = 0.5f * (u.x + x/u.x);
-    u.x =       u.x + (x/u.x);
-    u.x = (0.25f*u.x) + (x/u.x);
-
-    return u.x;
-}
-
 static float absolute(float x){
      if (x < 0) x = -x;
      return x;
 }
 
-static float CrossCorrelation(SAMPLE_FORMAT *x, SAMPLE_FORMAT *y){
-    float num = 0;
-    float den = 0;
-    float x2 = 0;
-    float y2 = 0;
-    int   m;
+// dot product of template and history window, exact in 64 bit
+// template must not contain -32768, as two -32768 * -32768 products overflow the int32 sum of SSE2 pmaddwd
+static int64_t DotProduct(const SAMPLE_FORMAT *x, const SAMPLE_FORMAT *y){
+#if defined(BTSTACK_SBC_PLC_SSE2)
+    __m128i sum = _mm_setzero_si128();
+    int m;
+    for (m=0;m<SBC_M;m+=8){
+        __m128i products = _mm_madd_epi16(_mm_loadu_si128((const __m128i *) &x[m]), _mm_loadu_si128((const __m128i *) &y[m]));
+        __m128i sign = _mm_srai_epi32(products, 31);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(products, sign));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(products, sign));
+    }
+    int64_t result[2];
+    _mm_storeu_si128((__m128i *) result, sum);
+    return result[0] + result[1];
+#elif defined(BTSTACK_SBC_PLC_NEON)
+    int64x2_t sum = vdupq_n_s64(0);
+    int m;
+    for (m=0;m<SBC_M;m+=4){
+        sum = vpadalq_s32(sum, vmull_s16(vld1_s16(&x[m]), vld1_s16(&y[m])));
+    }
+    return vgetq_lane_s64(sum, 0) + vgetq_lane_s64(sum, 1);
+#else
+    int64_t sum = 0;
+    int m;
     for (m=0;m<SBC_M;m++){
-        num+=((float)x[m])*y[m];
-        x2+=((float)x[m])*x[m];
-        y2+=((float)y[m])*y[m];
+        sum += (int32_t) x[m] * y[m];
     }
-    den = (float)sqrt3(x2*y2);
-    return num/den;
+    return sum;
+#endif
 }
 
-static int PatternMatch(SAMPLE_FORMAT *y){
-    float maxCn = -999999.0;  // large negative number
+// Find lag with maximal normalized cross correlation Cn = num / sqrt(x2 * y2) between template and history.
+// x2 is the same for all lags, so sign(num) * num^2 / y2 is compared instead, which avoids sqrt and division.
+// y2 is updated incrementally while sliding over the history.
+int btstack_sbc_plc_pattern_match(SAMPLE_FORMAT *y){
+    SAMPLE_FORMAT x[SBC_M];
+    int64_t y2 = 0;
+    int     m;
+    for (m=0;m<SBC_M;m++){
+        SAMPLE_FORMAT sample = y[SBC_LHIST-SBC_M+m];
+        x[m] = (sample == INT16_MIN) ? -INT16_MAX : sample;
+        y2 += (int32_t) y[m] * y[m];
+    }
+
+    float maxNum2 = 0.0f;
+    float maxY2   = 1.0f;
     int   bestmatch = 0;
-    float Cn;
     int   n;
     for (n=0;n<SBC_N;n++){
-        Cn = CrossCorrelation(&y[SBC_LHIST-SBC_M], &y[n]); 
-        if (Cn>maxCn){
-            bestmatch=n;
-            maxCn = Cn; 
+        if (n > 0){
+            y2 += (int32_t) y[n+SBC_M-1] * y[n+SBC_M-1] - (int32_t) y[n-1] * y[n-1];
+        }
+        float num  = (float) DotProduct(x, &y[n]);
+        float num2 = num * absolute(num);
+        // num is zero if y2 is zero
+        float energy = (y2 > 0) ? (float) y2 : 1.0f;
+        if ((n == 0) || ((num2 * maxY2) > (maxNum2 * energy))){
+            bestmatch = n;
+            maxNum2 = num2;
+            maxY2   = energy;
         }
     }
     return bestmatch;
@@ -338,7 +363,7 @@ void btstack_sbc_plc_bad_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT
     if (plc_state->nbf==1){
         // printf("first bad frame\n");
         // Perform pattern matching to find where to replicate
-        plc_state->bestlag = PatternMatch(plc_state->hist);
+        plc_state->bestlag = btstack_sbc_plc_pattern_match(plc_state->hist);
     }
 
 #ifdef OCTAVE_OUTPUT
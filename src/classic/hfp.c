@@ -1182,6 +1182,35 @@ static hfp_command_entry_t hfp_hf_command_table[] = {
     { "RING",   HFP_CMD_RING },
 };
 
+// perfect hash over command tables, index into table or 0xff if empty
+// tables need to be regenerated with tool/hfp_command_hash_generator.py whenever a command is added
+// generated by tool/hfp_command_hash_generator.py
+#define HFP_COMMAND_HASH_BITS 6
+#define HFP_COMMAND_HASH_SIZE (1 << HFP_COMMAND_HASH_BITS)
+#define HFP_AG_COMMAND_HASH_SEED 0x811cd21eu
+static const uint8_t hfp_ag_command_hash[HFP_COMMAND_HASH_SIZE] = {
+    0x1f, 0x0e, 0xff, 0xff, 0x10, 0xff, 0x06, 0x11, 0x0c, 0xff, 0xff, 0x09, 0x1d, 0xff, 0x14, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0x08, 0x18, 0x1a, 0x01, 0x00, 0xff, 0x03, 0x16, 0xff, 0x0a, 0xff, 0x05,
+    0xff, 0xff, 0xff, 0xff, 0x1e, 0xff, 0x0f, 0x0b, 0xff, 0x1c, 0xff, 0xff, 0xff, 0x12, 0x17, 0x1b,
+    0x15, 0xff, 0xff, 0xff, 0x13, 0x0d, 0xff, 0x19, 0x04, 0xff, 0xff, 0xff, 0xff, 0xff, 0x07, 0x02,
+};
+#define HFP_HF_COMMAND_HASH_SEED 0x811c9e08u
+static const uint8_t hfp_hf_command_hash[HFP_COMMAND_HASH_SIZE] = {
+    0xff, 0xff, 0xff, 0xff, 0x0e, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x06, 0xff, 0xff, 0xff, 0xff,
+    0x08, 0xff, 0xff, 0x0a, 0xff, 0x09, 0xff, 0x13, 0xff, 0x0d, 0xff, 0xff, 0xff, 0xff, 0x04, 0x07,
+    0xff, 0x0c, 0x14, 0xff, 0x11, 0x01, 0x05, 0xff, 0x0f, 0x12, 0x02, 0x15, 0x16, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x10, 0xff, 0xff, 0xff, 0xff, 0x0b, 0xff, 0xff, 0x17, 0xff, 0xff, 0x03, 0x00,
+};
+
+static uint32_t hfp_command_hash(uint32_t seed, const char * text){
+    // FNV-1a followed by Fibonacci hashing
+    uint32_t hash = seed;
+    while (*text != 0){
+        hash = (hash ^ (uint8_t) *text++) * 0x01000193u;
+    }
+    return (uint32_t)(hash * 0x9e3779b1u) >> (32 - HFP_COMMAND_HASH_BITS);
+}
+
 static const hfp_custom_at_command_t *
 hfp_custom_command_lookup(bool isHandsFree, const char *text) {
     btstack_linked_list_t * custom_commands = isHandsFree ? &hfp_custom_commands_hf : &hfp_custom_commands_ag;
@@ -1205,33 +1234,18 @@ static hfp_command_t parse_command(const char * line_buffer, int isHandsFree){
         return HFP_CMD_CUSTOM_MESSAGE;
     }
 
-    // table lookup based on role
-    uint16_t num_entries;
-    hfp_command_entry_t * table;
+    // hash lookup based on role
+    const hfp_command_entry_t * table;
+    uint8_t index;
     if (isHandsFree == 0){
         table = hfp_ag_command_table;
-        num_entries = sizeof(hfp_ag_command_table) / sizeof(hfp_command_entry_t);
+        index = hfp_ag_command_hash[hfp_command_hash(HFP_AG_COMMAND_HASH_SEED, line_buffer)];
     } else {
         table = hfp_hf_command_table;
-        num_entries = sizeof(hfp_hf_command_table) / sizeof(hfp_command_entry_t);
-    }
-    // binary search
-    uint16_t left = 0;
-    uint16_t right = num_entries - 1;
-    while (left <= right){
-        uint16_t middle = left + (right - left) / 2;
-        hfp_command_entry_t *entry = &table[middle];
-        int match = strcmp(line_buffer, entry->command);
-        if (match < 0){
-            // search term is lower than middle element
-            if (right == 0) break;
-            right = middle - 1;
-        } else if (match == 0){
-            return entry->command_id;
-        } else {
-            // search term is higher than middle element
-            left = middle + 1;
-        }
+        index = hfp_hf_command_hash[hfp_command_hash(HFP_HF_COMMAND_HASH_SEED, line_buffer)];
+    }
+    if ((index != 0xffu) && (strcmp(line_buffer, table[index].command) == 0)){
+        return table[index].command_id;
     }
 
     // note: if parser in CMD_HEADER state would treats digits and maybe '+' as separator, match on "ATD" would work.
@@ -1539,6 +1553,84 @@ void hfp_parse(hfp_connection_t * hfp_connection, uint8_t byte, int isHandsFree)
     }
 }
 
+// bytes handled by the state machine: separators, brackets, double quotes, spaces and command header delimiters
+// all other bytes are only stored in the line buffer. as all delimiters are below 0x40, a 64-bit mask is used
+#define HFP_PARSER_DELIMITER_MASK ( \
+    (1ull << '\n') | (1ull << '\r') | (1ull << ' ') | (1ull << '"') | (1ull << '(') | (1ull << ')') | \
+    (1ull << ',')  | (1ull << '-')  | (1ull << ':') | (1ull << ';') | (1ull << '=') | (1ull << '?') )
+
+static bool hfp_parser_is_delimiter(uint8_t byte){
+    return (byte < 64u) && (((HFP_PARSER_DELIMITER_MASK >> byte) & 1u) != 0u);
+}
+
+// returns offset of first occurrence of byte or size if not found
+static uint16_t hfp_parser_find(const uint8_t * data, uint16_t size, uint8_t byte){
+    const uint8_t * match = (const uint8_t *) memchr(data, byte, size);
+    if (match == NULL) return size;
+    return (uint16_t) (match - data);
+}
+
+// returns number of bytes at start of data that hfp_parse would only append to the line buffer
+static uint16_t hfp_parser_plain_run(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t size){
+    uint16_t run;
+    if (hfp_connection->parser_quoted){
+        // everything up to closing double quote or end of line
+        run = hfp_parser_find(data, size, '"');
+        run = hfp_parser_find(data, run, '\r');
+        return hfp_parser_find(data, run, '\n');
+    }
+    switch (hfp_connection->parser_state){
+        case HFP_PARSER_CMD_HEADER:
+            // byte after '=' is a lookahead
+            if (hfp_connection->found_equal_sign) return 0;
+            break;
+        case HFP_PARSER_CMD_SEQUENCE:
+        case HFP_PARSER_SECOND_ITEM:
+        case HFP_PARSER_THIRD_ITEM:
+        case HFP_PARSER_CUSTOM_COMMAND:
+            break;
+        default:
+            return 0;
+    }
+    run = 0;
+    while ((run < size) && !hfp_parser_is_delimiter(data[run])){
+        run++;
+    }
+    return run;
+}
+
+static void hfp_parser_store_bytes(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t size){
+    // same truncation as hfp_parser_store_byte
+    int space = (HFP_MAX_VR_TEXT_SIZE - 1) - hfp_connection->line_size;
+    if (space <= 0) return;
+    if ((int) size > space){
+        size = (uint16_t) space;
+    }
+    (void) memcpy(&hfp_connection->line_buffer[hfp_connection->line_size], data, size);
+    hfp_connection->line_size += size;
+    hfp_connection->line_buffer[hfp_connection->line_size] = 0;
+}
+
+uint16_t hfp_parse_buffer(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t size, int isHandsFree){
+    uint16_t pos = 0;
+    while (pos < size){
+        // store runs of plain bytes at once
+        uint16_t run = hfp_parser_plain_run(hfp_connection, &data[pos], size - pos);
+        if (run > 0u){
+            hfp_parser_store_bytes(hfp_connection, &data[pos], run);
+            pos += run;
+            continue;
+        }
+        // delimiter
+        uint8_t byte = data[pos++];
+        hfp_parse(hfp_connection, byte, isHandsFree);
+        if (hfp_parser_is_end_of_line(byte)){
+            break;
+        }
+    }
+    return pos;
+}
+
 static void parse_sequence(hfp_connection_t * hfp_connection){
     int value;
     switch (hfp_connection->command){
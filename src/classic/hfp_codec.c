@@ -121,8 +121,8 @@ uint16_t hfp_codec_num_audio_samples_per_frame(const hfp_codec_t * hfp_codec){
 #ifdef ENABLE_HFP_WIDE_BAND_SPEECH
 static void hfp_codec_encode_msbc(hfp_codec_t * hfp_codec, int16_t * pcm_samples){
     // Encode SBC Frame
-    btstack_sbc_encoder_process_data(pcm_samples);
-    (void)memcpy(&hfp_codec->sco_packet[hfp_codec->write_pos], btstack_sbc_encoder_sbc_buffer(), FRAME_SIZE_MSBC);
+    btstack_sbc_encoder_process_data(hfp_codec->msbc_encoder_context, pcm_samples);
+    (void)memcpy(&hfp_codec->sco_packet[hfp_codec->write_pos], btstack_sbc_encoder_sbc_buffer(hfp_codec->msbc_encoder_context), FRAME_SIZE_MSBC);
     hfp_codec->write_pos += FRAME_SIZE_MSBC;
     // Final padding to use SCO_FRAME_SIZE bytes
     hfp_codec->sco_packet[hfp_codec->write_pos++] = 0;
@@ -91,9 +91,9 @@ void hfp_msbc_encode_audio_frame(int16_t * pcm_samples){
     hfp_msbc_msbc_sequence_number = (hfp_msbc_msbc_sequence_number + 1) & 3;
 
     // SBC Frame
-    btstack_sbc_encoder_process_data(pcm_samples);
+    btstack_sbc_encoder_process_data(&hfp_msbc_state, pcm_samples);
     (void)memcpy(hfp_msbc_buffer + hfp_msbc_buffer_offset,
-                 btstack_sbc_encoder_sbc_buffer(), MSBC_FRAME_SIZE);
+                 btstack_sbc_encoder_sbc_buffer(&hfp_msbc_state), MSBC_FRAME_SIZE);
     hfp_msbc_buffer_offset += MSBC_FRAME_SIZE;
 
     // Final padding to use 60 bytes for 120 audio samples
@@ -118,7 +118,7 @@ int hfp_msbc_num_bytes_in_stream(void){
 }
 
 int hfp_msbc_num_audio_samples_per_frame(void){
-    return btstack_sbc_encoder_num_audio_frames();
+    return btstack_sbc_encoder_num_audio_frames(&hfp_msbc_state);
 }
 
 
@@ -595,6 +595,53 @@ void gap_set_scan_duplicate_filter(bool enabled);
  */
 void gap_set_scan_phys(uint8_t phys);
 
+/**
+ * @brief Set window for LE Scan Filter, requires ENABLE_LE_SCAN_FILTER
+ * @note Within the window, only the first advertisement and scan response with the same data is reported per device.
+ *       Only legacy advertising PDUs are filtered, GAP_EVENT_EXTENDED_ADVERTISING_REPORT events are not affected.
+ * @param window_ms or 0 to report all advertisements, default: 0
+ */
+void gap_le_scan_filter_set_window(uint32_t window_ms);
+
+/**
+ * @brief Drop advertisements with RSSI below threshold, requires ENABLE_LE_SCAN_FILTER
+ * @param rssi_min in dBm or -127 to report all advertisements, default: -127
+ */
+void gap_le_scan_filter_set_rssi_threshold(int8_t rssi_min);
+
+/**
+ * @brief Drop advertisements that don't contain AD Type, requires ENABLE_LE_SCAN_FILTER
+ * @note Scan responses are reported if the advertisement of the same device was reported before
+ * @param ad_type see bluetooth_data_types.h or 0 to report all advertisements, default: 0
+ */
+void gap_le_scan_filter_set_ad_type(uint8_t ad_type);
+
+/**
+ * @brief Drop advertisements that don't list 16-bit Service UUID, requires ENABLE_LE_SCAN_FILTER
+ * @note Scan responses are reported if the advertisement of the same device was reported before
+ * @param uuid16 or 0 to report all advertisements, default: 0
+ */
+void gap_le_scan_filter_set_uuid16(uint16_t uuid16);
+
+/**
+ * @brief Drop advertisements that don't list 128-bit Service UUID, requires ENABLE_LE_SCAN_FILTER
+ * @note Scan responses are reported if the advertisement of the same device was reported before
+ * @param uuid128 in big endian or NULL to report all advertisements, default: NULL
+ */
+void gap_le_scan_filter_set_uuid128(const uint8_t * uuid128);
+
+/**
+ * @brief Get number of advertising reports forwarded to and dropped by LE Scan Filter, requires ENABLE_LE_SCAN_FILTER
+ * @param num_forwarded
+ * @param num_dropped
+ */
+void gap_le_scan_filter_get_counters(uint32_t * num_forwarded, uint32_t * num_dropped);
+
+/**
+ * @brief Forget reported devices and reset counters of LE Scan Filter, requires ENABLE_LE_SCAN_FILTER
+ */
+void gap_le_scan_filter_reset(void);
+
 /**
  * @brief Start LE Scan 
  */
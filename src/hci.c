@@ -216,6 +216,9 @@ static void hci_emit_event(uint8_t * event, uint16_t size, int dump);
 static void hci_emit_acl_packet(uint8_t * packet, uint16_t size);
 static void hci_run(void);
 static int  hci_is_le_connection(hci_connection_t * connection);
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+static void hci_acl_tx_queue_drop(hci_connection_t * connection);
+#endif
 
 #ifdef ENABLE_CLASSIC
 static int hci_have_usb_transport(void);
@@ -331,6 +334,23 @@ create_connection_for_bd_addr_and_type(const bd_addr_t addr, bd_addr_type_t addr
     return conn;
 }
 
+/**
+ * remove connection from list and lookup table and free it
+ */
+static void hci_connection_free(hci_connection_t * conn){
+    uint16_t index;
+    for (index = 0; index < HCI_CONNECTION_LOOKUP_TABLE_SIZE; index++){
+        if (hci_stack->connection_lookup_table[index] == conn){
+            hci_stack->connection_lookup_table[index] = NULL;
+        }
+    }
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    hci_acl_tx_queue_drop(conn);
+#endif
+    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+    btstack_memory_hci_connection_free(conn);
+}
+
 
 /**
  * get le connection parameter range
@@ -398,11 +418,22 @@ void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+    // connections without valid handle are not cached
+    uint16_t index = con_handle & (HCI_CONNECTION_LOOKUP_TABLE_SIZE - 1u);
+    if (con_handle != HCI_CON_HANDLE_INVALID){
+        hci_connection_t * cached = hci_stack->connection_lookup_table[index];
+        if ((cached != NULL) && (cached->con_handle == con_handle)){
+            return cached;
+        }
+    }
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * item = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         if ( item->con_handle == con_handle ) {
+            if (con_handle != HCI_CON_HANDLE_INVALID){
+                hci_stack->connection_lookup_table[index] = item;
+            }
             return item;
         }
     } 
@@ -753,7 +784,10 @@ static int hci_transport_can_send_prepared_packet_now(uint8_t packet_type){
 }
 
 static bool hci_can_send_prepared_acl_packet_for_address_type(bd_addr_type_t address_type){
+#ifndef ENABLE_HCI_ACL_TX_QUEUE
+    // with ACL TX queue, packets are queued until transport is ready
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return false;
+#endif
     return hci_number_free_acl_slots_for_connection_type(address_type) > 0;
 }
 
@@ -763,7 +797,9 @@ bool hci_can_send_acl_le_packet_now(void){
 }
 
 bool hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle) {
+#ifndef ENABLE_HCI_ACL_TX_QUEUE
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return false;
+#endif
     return hci_number_free_acl_slots_for_handle(con_handle) > 0;
 }
 
@@ -863,10 +899,7 @@ static void hci_controller_dump_packets(void){
 }
 #endif
 
-static uint8_t hci_send_acl_packet_fragments(hci_connection_t *connection){
-
-    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
-
+static uint16_t hci_acl_max_fragment_length(hci_connection_t * connection){
     // max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
     uint16_t max_acl_data_packet_length = hci_stack->acl_data_packet_length;
     if (hci_is_le_connection(connection) && (hci_stack->le_data_packets_length > 0u)){
@@ -878,6 +911,39 @@ static uint8_t hci_send_acl_packet_fragments(hci_connection_t *connection){
         max_acl_data_packet_length = connection->le_max_tx_octets;
     }
 #endif
+    return max_acl_data_packet_length;
+}
+
+// setup ACL header in front of fragment payload at pos, returns fragment payload length
+static uint16_t hci_acl_prepare_fragment(uint8_t * buffer, uint16_t pos, uint16_t total_size, uint16_t max_acl_data_packet_length, bool * more_fragments){
+    const uint16_t acl_header_pos = pos - 4u;
+    uint16_t current_acl_data_packet_length = total_size - pos;
+    *more_fragments = false;
+
+    // if ACL packet is larger than Bluetooth packet buffer, only send max_acl_data_packet_length
+    if (current_acl_data_packet_length > max_acl_data_packet_length){
+        *more_fragments = true;
+        current_acl_data_packet_length = max_acl_data_packet_length & (~(HCI_ACL_CHUNK_SIZE_ALIGNMENT-1));
+    }
+
+    // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
+    if (acl_header_pos > 0u){
+        uint16_t handle_and_flags = little_endian_read_16(buffer, 0);
+        handle_and_flags = (handle_and_flags & 0xcfffu) | (1u << 12u);
+        little_endian_store_16(buffer, acl_header_pos, handle_and_flags);
+    }
+
+    // update header len
+    little_endian_store_16(buffer, acl_header_pos + 2u, current_acl_data_packet_length);
+    return current_acl_data_packet_length;
+}
+
+#ifndef ENABLE_HCI_ACL_TX_QUEUE
+static uint8_t hci_send_acl_packet_fragments(hci_connection_t *connection){
+
+    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
+
+    uint16_t max_acl_data_packet_length = hci_acl_max_fragment_length(connection);
 
     log_debug("hci_send_acl_packet_fragments entered");
 
@@ -889,25 +955,10 @@ static uint8_t hci_send_acl_packet_fragments(hci_connection_t *connection){
 
         // get current data
         const uint16_t acl_header_pos = hci_stack->acl_fragmentation_pos - 4u;
-        int current_acl_data_packet_length = hci_stack->acl_fragmentation_total_size - hci_stack->acl_fragmentation_pos;
-        bool more_fragments = false;
-
-        // if ACL packet is larger than Bluetooth packet buffer, only send max_acl_data_packet_length
-        if (current_acl_data_packet_length > max_acl_data_packet_length){
-            more_fragments = true;
-            current_acl_data_packet_length = max_acl_data_packet_length & (~(HCI_ACL_CHUNK_SIZE_ALIGNMENT-1));
-        }
+        bool more_fragments;
+        uint16_t current_acl_data_packet_length = hci_acl_prepare_fragment(hci_stack->hci_packet_buffer,
+            hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, max_acl_data_packet_length, &more_fragments);
 
-        // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
-        if (acl_header_pos > 0u){
-            uint16_t handle_and_flags = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
-            handle_and_flags = (handle_and_flags & 0xcfffu) | (1u << 12u);
-            little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos, handle_and_flags);
-        }
-
-        // update header len
-        little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos + 2u, current_acl_data_packet_length);
-        
         // count packet
         connection->num_packets_sent++;
         log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", (int) more_fragments);
@@ -957,6 +1008,193 @@ static uint8_t hci_send_acl_packet_fragments(hci_connection_t *connection){
 
     return status;
 }
+#endif
+
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+// ACL TX queue: hci_send_acl_packet_buffer queues the current packet buffer for its connection and continues
+// with the next free buffer. Queued packets are passed to the HCI transport without copying them, in round-robin
+// order across connections, as soon as the transport is ready and the controller has free ACL buffers.
+// Asynchronous transports may accept up to HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT packets, each one is
+// reported by a HCI_EVENT_TRANSPORT_PACKET_SENT in send order. Transports that report can send now while
+// a packet is still in flight are expected to copy it, e.g. libusb
+
+static void hci_acl_tx_queue_init(void){
+    uint16_t i;
+    hci_stack->acl_tx_buffers_free = NULL;
+    for (i = 0; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        hci_stack->acl_tx_buffers[i].fragments_in_flight = 0;
+    }
+    for (i = 1; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        btstack_linked_list_add_tail(&hci_stack->acl_tx_buffers_free, (btstack_linked_item_t *) &hci_stack->acl_tx_buffers[i]);
+    }
+    hci_stack->acl_tx_buffer_current = &hci_stack->acl_tx_buffers[0];
+    hci_stack->acl_tx_in_flight_head  = 0;
+    hci_stack->acl_tx_in_flight_count = 0;
+    hci_stack->acl_tx_con_handle_last = HCI_CON_HANDLE_INVALID;
+    hci_stack->hci_packet_buffer = &hci_stack->acl_tx_buffers[0].data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+}
+
+static void hci_acl_tx_queue_free_buffer(hci_acl_tx_buffer_t * buffer){
+    if (hci_stack->acl_tx_buffer_current != NULL){
+        btstack_linked_list_add(&hci_stack->acl_tx_buffers_free, (btstack_linked_item_t *) buffer);
+        return;
+    }
+    // all buffers have been queued, continue with this one and release packet buffer
+    hci_stack->acl_tx_buffer_current = buffer;
+    hci_stack->hci_packet_buffer = &buffer->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    hci_release_packet_buffer();
+}
+
+static bool hci_acl_tx_queue_can_send(hci_connection_t * connection){
+    hci_acl_tx_buffer_t * buffer = (hci_acl_tx_buffer_t *) connection->acl_tx_queue;
+    if (buffer == NULL){
+        return false;
+    }
+    if (buffer->credit_reserved){
+        return true;
+    }
+    return hci_number_free_acl_slots_for_connection_type(connection->address_type) > 0;
+}
+
+// round-robin: first connection ready to send after the one served last
+static hci_connection_t * hci_acl_tx_queue_next_connection(void){
+    hci_connection_t * first_ready = NULL;
+    hci_connection_t * last_served = NULL;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (connection->con_handle == hci_stack->acl_tx_con_handle_last){
+            last_served = connection;
+            continue;
+        }
+        if (!hci_acl_tx_queue_can_send(connection)){
+            continue;
+        }
+        if (last_served != NULL){
+            return connection;
+        }
+        if (first_ready == NULL){
+            first_ready = connection;
+        }
+    }
+    if (first_ready != NULL){
+        return first_ready;
+    }
+    if ((last_served != NULL) && hci_acl_tx_queue_can_send(last_served)){
+        return last_served;
+    }
+    return NULL;
+}
+
+static void hci_acl_tx_queue_run(void){
+    bool synchronous = hci_transport_synchronous();
+    while (true){
+        if (!synchronous && (hci_stack->acl_tx_in_flight_count == HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT)) return;
+        if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return;
+
+        hci_connection_t * connection = hci_acl_tx_queue_next_connection();
+        if (connection == NULL) return;
+        hci_stack->acl_tx_con_handle_last = connection->con_handle;
+
+        hci_acl_tx_buffer_t * buffer = (hci_acl_tx_buffer_t *) connection->acl_tx_queue;
+        uint8_t * acl_buffer = &buffer->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+        const uint16_t acl_header_pos = buffer->pos - 4u;
+        bool more_fragments;
+        uint16_t current_acl_data_packet_length = hci_acl_prepare_fragment(acl_buffer, buffer->pos, buffer->total_size,
+                                                                           hci_acl_max_fragment_length(connection), &more_fragments);
+
+        // count packet, controller buffer for first fragment has been accounted when queued
+        if (buffer->credit_reserved){
+            buffer->credit_reserved = false;
+        } else {
+            connection->num_packets_sent++;
+        }
+
+        // update state before send_packet as "transport done" might be sent during send_packet already
+        buffer->pos += current_acl_data_packet_length;
+        if (!more_fragments){
+            btstack_linked_list_pop(&connection->acl_tx_queue);
+        }
+        if (!synchronous){
+            uint8_t index = (uint8_t) ((hci_stack->acl_tx_in_flight_head + hci_stack->acl_tx_in_flight_count) % HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT);
+            hci_stack->acl_tx_in_flight[index] = buffer;
+            hci_stack->acl_tx_in_flight_count++;
+            buffer->fragments_in_flight++;
+        }
+
+        uint8_t * packet = &acl_buffer[acl_header_pos];
+        const int size = current_acl_data_packet_length + 4;
+        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
+        int err = hci_stack->hci_transport->send_packet(HCI_ACL_DATA_PACKET, packet, size);
+        if (err != 0){
+            // no error from HCI Transport expected
+            log_error("hci_acl_tx_queue_run: send_packet failed %d", err);
+        }
+
+#ifdef ENABLE_CONTROLLER_DUMP_PACKETS
+        hci_controller_dump_packets();
+#endif
+
+        if (synchronous && !more_fragments){
+            hci_acl_tx_queue_free_buffer(buffer);
+        }
+    }
+}
+
+static void hci_acl_tx_queue_packet_sent(void){
+    hci_acl_tx_buffer_t * buffer = hci_stack->acl_tx_in_flight[hci_stack->acl_tx_in_flight_head];
+    hci_stack->acl_tx_in_flight_head = (uint8_t) ((hci_stack->acl_tx_in_flight_head + 1u) % HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT);
+    hci_stack->acl_tx_in_flight_count--;
+    buffer->fragments_in_flight--;
+    // all fragments sent or connection closed
+    if ((buffer->pos == buffer->total_size) && (buffer->fragments_in_flight == 0u)){
+        hci_acl_tx_queue_free_buffer(buffer);
+    }
+}
+
+static void hci_acl_tx_queue_drop(hci_connection_t * connection){
+    bool buffer_available = hci_stack->acl_tx_buffer_current != NULL;
+    while (connection->acl_tx_queue != NULL){
+        hci_acl_tx_buffer_t * buffer = (hci_acl_tx_buffer_t *) btstack_linked_list_pop(&connection->acl_tx_queue);
+        if (buffer->fragments_in_flight > 0u){
+            // free on last HCI_EVENT_TRANSPORT_PACKET_SENT
+            buffer->pos = buffer->total_size;
+        } else {
+            hci_acl_tx_queue_free_buffer(buffer);
+        }
+    }
+    if (!buffer_available && (hci_stack->acl_tx_buffer_current != NULL)){
+        hci_emit_transport_packet_sent();
+    }
+}
+
+// pre: caller has reserved the packet buffer
+static uint8_t hci_acl_tx_queue_add(hci_connection_t * connection, uint16_t size){
+    hci_acl_tx_buffer_t * buffer = hci_stack->acl_tx_buffer_current;
+    buffer->total_size = size;
+    buffer->pos = 4;   // start of L2CAP packet
+    // hci_send_acl_packet_buffer verified that the controller has a free buffer
+    buffer->credit_reserved = true;
+    connection->num_packets_sent++;
+    btstack_linked_list_add_tail(&connection->acl_tx_queue, (btstack_linked_item_t *) buffer);
+
+    // continue with next free buffer, if available
+    hci_stack->acl_tx_buffer_current = (hci_acl_tx_buffer_t *) btstack_linked_list_pop(&hci_stack->acl_tx_buffers_free);
+    if (hci_stack->acl_tx_buffer_current != NULL){
+        hci_stack->hci_packet_buffer = &hci_stack->acl_tx_buffer_current->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+        hci_release_packet_buffer();
+    }
+
+    hci_acl_tx_queue_run();
+
+    // notify upper layers if packet buffer is available again, done by transport for asynchronous transports
+    if (hci_transport_synchronous() && !hci_stack->hci_packet_buffer_reserved){
+        hci_emit_transport_packet_sent();
+    }
+    return ERROR_CODE_SUCCESS;
+}
+#endif
 
 // pre: caller has reserved the packet buffer
 uint8_t hci_send_acl_packet_buffer(int size){
@@ -987,11 +1225,15 @@ uint8_t hci_send_acl_packet_buffer(int size){
 
     // hci_dump_packet( HCI_ACL_DATA_PACKET, 0, packet, size);
 
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    return hci_acl_tx_queue_add(connection, (uint16_t) size);
+#else
     // setup data
     hci_stack->acl_fragmentation_total_size = size;
     hci_stack->acl_fragmentation_pos = 4;   // start of L2CAP packet
 
     return hci_send_acl_packet_fragments(connection);
+#endif
 }
 
 #ifdef ENABLE_CLASSIC
@@ -1292,8 +1534,7 @@ static void hci_shutdown_connection(hci_connection_t *conn){
 
     hci_connection_stop_timer(conn);
 
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(conn);
     
     // now it's gone
     hci_emit_nr_connections_changed();
@@ -1485,6 +1726,116 @@ void gap_le_get_own_connection_address(uint8_t * addr_type, bd_addr_t addr){
     hci_get_own_address_for_addr_type(hci_stack->le_connection_own_addr_type, addr);
 }
 
+#ifdef ENABLE_LE_SCAN_FILTER
+// FNV-1a
+static uint32_t hci_le_scan_filter_hash(const uint8_t * data, uint8_t data_len){
+    uint32_t hash = 0x811c9dc5u;
+    uint8_t i;
+    for (i = 0; i < data_len; i++){
+        hash ^= data[i];
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+static le_scan_filter_entry_t * hci_le_scan_filter_get_entry(uint8_t address_type, const uint8_t * address, uint8_t event_type){
+    uint16_t i;
+    for (i = 0; i < hci_stack->le_scan_filter_num_entries; i++){
+        le_scan_filter_entry_t * entry = &hci_stack->le_scan_filter_entries[i];
+        if (entry->event_type != event_type) continue;
+        if (entry->address_type != address_type) continue;
+        if (memcmp(entry->address, address, 6) != 0) continue;
+        return entry;
+    }
+    return NULL;
+}
+
+static bool hci_le_scan_filter_ad_data_contains_type(uint8_t data_len, const uint8_t * data, uint8_t ad_type){
+    ad_context_t context;
+    for (ad_iterator_init(&context, data_len, data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        if (ad_iterator_get_data_type(&context) == ad_type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool hci_le_scan_filter_content_accepted(uint8_t data_len, const uint8_t * data){
+    if ((hci_stack->le_scan_filter_ad_type != 0u) && !hci_le_scan_filter_ad_data_contains_type(data_len, data, hci_stack->le_scan_filter_ad_type)){
+        return false;
+    }
+    if ((hci_stack->le_scan_filter_uuid16 != 0u) && !ad_data_contains_uuid16(data_len, data, hci_stack->le_scan_filter_uuid16)){
+        return false;
+    }
+    if (hci_stack->le_scan_filter_uuid128_set && !ad_data_contains_uuid128(data_len, data, hci_stack->le_scan_filter_uuid128)){
+        return false;
+    }
+    return true;
+}
+
+// event_type: legacy advertising event type, address in little endian as received
+static bool hci_le_scan_filter_accept(uint8_t event_type, uint8_t address_type, const uint8_t * address, int8_t rssi,
+                                      uint8_t data_len, const uint8_t * data){
+    // rssi 127 = not available
+    if ((rssi != 127) && (rssi < hci_stack->le_scan_filter_rssi_min)){
+        hci_stack->le_scan_filter_num_dropped++;
+        return false;
+    }
+
+    bool content_filter_active = (hci_stack->le_scan_filter_ad_type != 0u) || (hci_stack->le_scan_filter_uuid16 != 0u) || hci_stack->le_scan_filter_uuid128_set;
+    bool accepted;
+    if (event_type == 4u){
+        // scan response usually doesn't contain service uuids, accept if advertisement has been reported
+        accepted = !content_filter_active || (hci_le_scan_filter_get_entry(address_type, address, 0) != NULL)
+                                          || (hci_le_scan_filter_get_entry(address_type, address, 2) != NULL);
+    } else {
+        accepted = hci_le_scan_filter_content_accepted(data_len, data);
+    }
+    if (!accepted){
+        hci_stack->le_scan_filter_num_dropped++;
+        return false;
+    }
+
+    // without window, entries are only needed for scan response with content filter
+    if ((hci_stack->le_scan_filter_window_ms == 0u) && !content_filter_active){
+        hci_stack->le_scan_filter_num_forwarded++;
+        return true;
+    }
+
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+    uint32_t data_hash = hci_le_scan_filter_hash(data, data_len);
+    le_scan_filter_entry_t * entry = hci_le_scan_filter_get_entry(address_type, address, event_type);
+    if (entry != NULL){
+        entry->last_seen_ms = now_ms;
+        if ((entry->data_hash == data_hash) && ((now_ms - entry->window_start_ms) < hci_stack->le_scan_filter_window_ms)){
+            hci_stack->le_scan_filter_num_dropped++;
+            return false;
+        }
+    } else {
+        if (hci_stack->le_scan_filter_num_entries < MAX_NR_LE_SCAN_FILTER_ENTRIES){
+            entry = &hci_stack->le_scan_filter_entries[hci_stack->le_scan_filter_num_entries++];
+        } else {
+            // replace least recently seen advertiser
+            uint16_t i;
+            entry = &hci_stack->le_scan_filter_entries[0];
+            for (i = 1; i < MAX_NR_LE_SCAN_FILTER_ENTRIES; i++){
+                if ((int32_t)(hci_stack->le_scan_filter_entries[i].last_seen_ms - entry->last_seen_ms) < 0){
+                    entry = &hci_stack->le_scan_filter_entries[i];
+                }
+            }
+        }
+        entry->address_type = address_type;
+        (void)memcpy(entry->address, address, 6);
+        entry->event_type = event_type;
+        entry->last_seen_ms = now_ms;
+    }
+    entry->data_hash = data_hash;
+    entry->window_start_ms = now_ms;
+    hci_stack->le_scan_filter_num_forwarded++;
+    return true;
+}
+#endif
+
 void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
 
     uint16_t offset = 3;
@@ -1498,6 +1849,13 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         uint8_t data_length = packet[offset + 8];
         if (data_length > LE_ADVERTISING_DATA_SIZE) return;
         if ((offset + 9u + data_length + 1u) > size)    return;
+#ifdef ENABLE_LE_SCAN_FILTER
+        if (!hci_le_scan_filter_accept(packet[offset], packet[offset + 1], &packet[offset + 2], (int8_t) packet[offset + 9 + data_length],
+                                       data_length, &packet[offset + 9])){
+            offset += 10u + data_length;
+            continue;
+        }
+#endif
         // setup event
         uint8_t event_size = 10u + data_length;
         uint16_t pos = 0;
@@ -1558,6 +1916,13 @@ void le_handle_extended_advertisement_report(uint8_t *packet, uint16_t size) {
                     legacy_event_type = 0;
                     break;
             }
+#ifdef ENABLE_LE_SCAN_FILTER
+            if (!hci_le_scan_filter_accept(legacy_event_type, packet[offset], &packet[offset + 1], (int8_t) packet[offset + 11],
+                                           (uint8_t) data_length, &packet[offset + 22])){
+                offset += 22u + data_length;
+                continue;
+            }
+#endif
             uint16_t pos = 0;
             event[pos++] = GAP_EVENT_ADVERTISING_REPORT;
             event[pos++] = 10u + data_length;
@@ -1619,6 +1984,16 @@ static void hci_update_advertisements_enabled_for_current_roles(void){
 #endif
 
 #ifdef ENABLE_CLASSIC
+// send command constructed in-place in hci packet buffer
+static void gap_send_prepared_cmd_packet(uint8_t * packet, uint16_t size){
+    uint8_t status = hci_send_cmd_packet(packet, size);
+    // release packet buffer on error or for synchronous transport implementations
+    if ((status != ERROR_CODE_SUCCESS) || hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
+
 static void gap_run_set_local_name(void){
     hci_reserve_packet_buffer();
     uint8_t * packet = hci_stack->hci_packet_buffer;
@@ -1635,7 +2010,7 @@ static void gap_run_set_local_name(void){
     (void)memcpy(&packet[3], hci_stack->local_name, bytes_to_copy);
     // expand '00:00:00:00:00:00' in name with bd_addr
     btstack_replace_bd_addr_placeholder(&packet[3], bytes_to_copy, hci_stack->local_bd_addr);
-    hci_send_cmd_packet(packet, HCI_CMD_HEADER_SIZE + DEVICE_NAME_LEN);
+    gap_send_prepared_cmd_packet(packet, HCI_CMD_HEADER_SIZE + DEVICE_NAME_LEN);
 }
 
 static void gap_run_set_eir_data(void){
@@ -1676,7 +2051,7 @@ static void gap_run_set_eir_data(void){
         // expand '00:00:00:00:00:00' in name with bd_addr
         btstack_replace_bd_addr_placeholder(&packet[offset], bytes_to_copy, hci_stack->local_bd_addr);
     }
-    hci_send_cmd_packet(packet, HCI_CMD_HEADER_SIZE + 1 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
+    gap_send_prepared_cmd_packet(packet, HCI_CMD_HEADER_SIZE + 1 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
 }
 
 static void hci_run_gap_tasks_classic(void){
@@ -2509,8 +2884,7 @@ static void hci_handle_connection_failed(hci_connection_t * conn, uint8_t status
 #endif
     
     // connection failed, remove entry
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(conn);
 
 #ifdef ENABLE_CLASSIC
     // notify client if dedicated bonding
@@ -3217,8 +3591,7 @@ static void event_handle_le_connection_complete(const uint8_t * packet){
 		// outgoing le connection establishment is done
 		if (conn){
 			// remove entry
-			btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-			btstack_memory_hci_connection_free( conn );
+			hci_connection_free(conn);
 		}
 		return;
 	}
@@ -4051,6 +4424,19 @@ static void event_handler(uint8_t *packet, uint16_t size){
                 log_error("Synchronous HCI Transport shouldn't send HCI_EVENT_TRANSPORT_PACKET_SENT");
                 return; // instead of break: to avoid re-entering hci_run()
             }
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+            // packet from ACL TX queue, packet buffer not affected
+            if (hci_stack->acl_tx_in_flight_count > 0u){
+                hci_acl_tx_queue_packet_sent();
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+                hci_iso_notify_can_send_now();
+#endif
+#ifdef ENABLE_CLASSIC
+                hci_notify_if_sco_can_send_now();
+#endif
+                break;
+            }
+#endif
             hci_stack->acl_fragmentation_tx_active = 0;
 #ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
             hci_stack->iso_fragmentation_tx_active = 0;
@@ -4551,6 +4937,9 @@ static void hci_state_reset(void){
 
     // buffer is free
     hci_stack->hci_packet_buffer_reserved = false;
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    hci_acl_tx_queue_init();
+#endif
 
     // no pending cmds
     hci_stack->decline_reason = 0;
@@ -4639,7 +5028,11 @@ void hci_init(const hci_transport_t *transport, const void *config){
     hci_stack->config = config;
     
     // setup pointer for outgoing packet buffer
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    hci_acl_tx_queue_init();
+#else
     hci_stack->hci_packet_buffer = &hci_stack->hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+#endif
 
     // max acl payload size defined in config.h
     hci_stack->acl_data_packet_length = HCI_ACL_PAYLOAD_SIZE;
@@ -4710,6 +5103,10 @@ void hci_init(const hci_transport_t *transport, const void *config){
     hci_stack->le_scan_interval = 0x1e0; // 300 ms
     hci_stack->le_scan_window   =  0x30; //  30 ms
     hci_stack->le_scan_phys     =  0x01; // LE 1M PHY
+
+#ifdef ENABLE_LE_SCAN_FILTER
+    hci_stack->le_scan_filter_rssi_min = -127;
+#endif
 #endif
 
 #ifdef ENABLE_LE_PERIPHERAL
@@ -5544,6 +5941,16 @@ static void hci_halting_timeout_handler(btstack_timer_source_t * ds){
     hci_halting_run();
 }   
 
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+static void hci_run_acl_tx_queue(void){
+    bool buffer_available = hci_stack->acl_tx_buffer_current != NULL;
+    hci_acl_tx_queue_run();
+    // notify upper layers if packet buffer got released, done by transport for asynchronous transports
+    if (!buffer_available && (hci_stack->acl_tx_buffer_current != NULL) && hci_transport_synchronous()){
+        hci_emit_transport_packet_sent();
+    }
+}
+#else
 static bool hci_run_acl_fragments(void){
     if (hci_stack->acl_fragmentation_total_size > 0u) {
         hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(hci_stack->hci_packet_buffer);
@@ -5562,6 +5969,7 @@ static bool hci_run_acl_fragments(void){
     }
     return false;
 }
+#endif
 
 #ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
 static bool hci_run_iso_fragments(void){
@@ -7227,9 +7635,14 @@ static void hci_run(void){
 
     bool done;
 
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    // send queued ACL packets first, commands are sent if transport is still ready
+    hci_run_acl_tx_queue();
+#else
     // send continuation fragments first, as they block the prepared packet buffer
     done = hci_run_acl_fragments();
     if (done) return;
+#endif
 
 #ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
     done = hci_run_iso_fragments();
@@ -8048,8 +8461,48 @@ void gap_set_local_name(const char * local_name){
 #ifdef ENABLE_BLE
 
 #ifdef ENABLE_LE_CENTRAL
+#ifdef ENABLE_LE_SCAN_FILTER
+void gap_le_scan_filter_set_window(uint32_t window_ms){
+    hci_stack->le_scan_filter_window_ms = window_ms;
+}
+
+void gap_le_scan_filter_set_rssi_threshold(int8_t rssi_min){
+    hci_stack->le_scan_filter_rssi_min = rssi_min;
+}
+
+void gap_le_scan_filter_set_ad_type(uint8_t ad_type){
+    hci_stack->le_scan_filter_ad_type = ad_type;
+}
+
+void gap_le_scan_filter_set_uuid16(uint16_t uuid16){
+    hci_stack->le_scan_filter_uuid16 = uuid16;
+}
+
+void gap_le_scan_filter_set_uuid128(const uint8_t * uuid128){
+    hci_stack->le_scan_filter_uuid128_set = uuid128 != NULL;
+    if (uuid128 != NULL){
+        (void)memcpy(hci_stack->le_scan_filter_uuid128, uuid128, 16);
+    }
+}
+
+void gap_le_scan_filter_get_counters(uint32_t * num_forwarded, uint32_t * num_dropped){
+    *num_forwarded = hci_stack->le_scan_filter_num_forwarded;
+    *num_dropped   = hci_stack->le_scan_filter_num_dropped;
+}
+
+void gap_le_scan_filter_reset(void){
+    hci_stack->le_scan_filter_num_entries = 0;
+    hci_stack->le_scan_filter_num_forwarded = 0;
+    hci_stack->le_scan_filter_num_dropped = 0;
+}
+#endif
+
 void gap_start_scan(void){
     hci_stack->le_scanning_enabled = true;
+#ifdef ENABLE_LE_SCAN_FILTER
+    // report all devices again
+    hci_stack->le_scan_filter_num_entries = 0;
+#endif
     hci_run();
 }
 
@@ -8167,8 +8620,7 @@ uint8_t gap_connect_cancel(void){
                     case SEND_CREATE_CONNECTION:
                         // skip sending create connection and emit event instead
                         hci_emit_le_connection_complete(conn->address_type, conn->address, 0, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
-                        btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-                        btstack_memory_hci_connection_free( conn );
+                        hci_connection_free(conn);
                         break;
                     case SENT_CREATE_CONNECTION:
                         // let hci_run_general_gap_le cancel outgoing connection
@@ -10273,6 +10725,7 @@ void hci_free_connections_fuzz(void){
         btstack_linked_list_iterator_remove(&it);
         btstack_memory_hci_connection_free(con);
     }
+    memset(hci_stack->connection_lookup_table, 0, sizeof(hci_stack->connection_lookup_table));
 }
 void hci_simulate_working_fuzz(void){
     hci_stack->le_scanning_param_update = false;
@@ -166,6 +166,46 @@ extern "C" {
 #endif
 #endif
 
+// number of entries in direct-mapped connection lookup table used by hci_connection_for_handle, power of two
+// default: next power of two >= MAX_NR_HCI_CONNECTIONS, at least 8
+#ifndef HCI_CONNECTION_LOOKUP_TABLE_SIZE
+#if !defined(MAX_NR_HCI_CONNECTIONS) || (MAX_NR_HCI_CONNECTIONS <= 8)
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 8
+#elif MAX_NR_HCI_CONNECTIONS <= 16
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 16
+#elif MAX_NR_HCI_CONNECTIONS <= 32
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 32
+#elif MAX_NR_HCI_CONNECTIONS <= 64
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 64
+#elif MAX_NR_HCI_CONNECTIONS <= 128
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 128
+#else
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 256
+#endif
+#endif
+
+#if (HCI_CONNECTION_LOOKUP_TABLE_SIZE == 0) || ((HCI_CONNECTION_LOOKUP_TABLE_SIZE & (HCI_CONNECTION_LOOKUP_TABLE_SIZE - 1)) != 0)
+#error "HCI_CONNECTION_LOOKUP_TABLE_SIZE must be a power of two"
+#endif
+
+// number of outgoing packet buffers used with ENABLE_HCI_ACL_TX_QUEUE
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+#ifndef HCI_ACL_TX_QUEUE_NUM_BUFFERS
+#define HCI_ACL_TX_QUEUE_NUM_BUFFERS 4
+#endif
+// max number of ACL packets passed to an asynchronous HCI transport before its HCI_EVENT_TRANSPORT_PACKET_SENT
+#ifndef HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT
+#define HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT 4
+#endif
+#endif
+
+// number of advertisers tracked by ENABLE_LE_SCAN_FILTER
+#ifdef ENABLE_LE_SCAN_FILTER
+#ifndef MAX_NR_LE_SCAN_FILTER_ENTRIES
+#define MAX_NR_LE_SCAN_FILTER_ENTRIES 32
+#endif
+#endif
+
 // 
 #define IS_COMMAND(packet, command) ( little_endian_read_16(packet,0) == command.opcode )
 
@@ -465,6 +505,10 @@ typedef struct sm_connection {
 // ATT Server
 //
 
+#if defined(ENABLE_GATT_OVER_EATT) && !defined(ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE)
+#error "ENABLE_GATT_OVER_EATT requires ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE. Please update btstack_config.h"
+#endif
+
 // max ATT request matches L2CAP PDU -- allow to use smaller buffer
 #ifndef ATT_REQUEST_BUFFER_SIZE
 #define ATT_REQUEST_BUFFER_SIZE HCI_ACL_PAYLOAD_SIZE
@@ -498,6 +542,12 @@ typedef struct {
     uint16_t                l2cap_cid;
 #endif
 
+#ifdef ENABLE_GATT_OVER_EATT
+    // EATT bearer: L2CAP channel in Enhanced Credit-Based Flow-Control Mode, 0 for unenhanced bearer
+    uint16_t                eatt_cid;
+    uint8_t *               eatt_send_buffer;
+#endif
+
     uint16_t                request_size;
     uint8_t                 request_buffer[ATT_REQUEST_BUFFER_SIZE];
 
@@ -520,6 +570,40 @@ typedef struct {
     uint16_t                  fixed_channels_supported;    // Core V5.3 - only first octet used
 } l2cap_state_t;
 
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+// outgoing packet buffer, queued for its connection after hci_send_acl_packet_buffer
+typedef struct {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    // ACL packet incl. header and position of next fragment payload
+    uint16_t total_size;
+    uint16_t pos;
+
+    // controller buffer for first fragment already accounted in num_packets_sent
+    bool     credit_reserved;
+
+    // fragments passed to asynchronous transport and not reported as sent yet
+    uint8_t  fragments_in_flight;
+
+    // PRE_BUFFER + ACL Header + ACL payload
+    uint8_t  data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
+} hci_acl_tx_buffer_t;
+#endif
+
+#ifdef ENABLE_LE_SCAN_FILTER
+// last forwarded advertising report per advertiser and report type
+typedef struct {
+    bd_addr_t address;
+    uint8_t   address_type;
+    // legacy event type, advertisements and scan responses are tracked separately
+    uint8_t   event_type;
+    uint32_t  data_hash;
+    uint32_t  window_start_ms;
+    uint32_t  last_seen_ms;
+} le_scan_filter_entry_t;
+#endif
+
 //
 typedef struct {
     // linked list - assert: first field
@@ -627,6 +711,11 @@ typedef struct {
     // number packets sent to controller
     uint8_t num_packets_sent;
 
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    // outgoing ACL packets not sent to controller yet
+    btstack_linked_list_t acl_tx_queue;
+#endif
+
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     uint8_t num_packets_completed;
 #endif
@@ -979,6 +1068,9 @@ typedef struct {
     // list of existing baseband connections
     btstack_linked_list_t     connections;
 
+    // direct-mapped cache for connections, indexed by lower bits of con handle
+    hci_connection_t *        connection_lookup_table[HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+
     /* callback to L2CAP layer */
     btstack_packet_handler_t acl_packet_handler;
 
@@ -1069,11 +1161,27 @@ typedef struct {
 
     // single buffer for HCI packet assembly + additional prebuffer for H4 drivers
     uint8_t   * hci_packet_buffer;
+#ifndef ENABLE_HCI_ACL_TX_QUEUE
     uint8_t   hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
+#endif
     bool      hci_packet_buffer_reserved;
     uint16_t  acl_fragmentation_pos;
     uint16_t  acl_fragmentation_total_size;
     uint8_t   acl_fragmentation_tx_active;
+
+#ifdef ENABLE_HCI_ACL_TX_QUEUE
+    // pool of outgoing packet buffers, hci_packet_buffer points into current buffer
+    hci_acl_tx_buffer_t   acl_tx_buffers[HCI_ACL_TX_QUEUE_NUM_BUFFERS];
+    btstack_linked_list_t acl_tx_buffers_free;
+    // NULL if all buffers are queued, hci_packet_buffer stays reserved until one gets free
+    hci_acl_tx_buffer_t * acl_tx_buffer_current;
+    // buffers of fragments passed to asynchronous transport in send order, one HCI_EVENT_TRANSPORT_PACKET_SENT each
+    hci_acl_tx_buffer_t * acl_tx_in_flight[HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT];
+    uint8_t               acl_tx_in_flight_head;
+    uint8_t               acl_tx_in_flight_count;
+    // round-robin scheduling across connections
+    hci_con_handle_t      acl_tx_con_handle_last;
+#endif
      
     /* host to controller flow control */
     uint8_t  num_cmd_packets;
@@ -1190,6 +1298,19 @@ typedef struct {
     uint16_t le_scan_interval;
     uint16_t le_scan_window;
 
+#ifdef ENABLE_LE_SCAN_FILTER
+    le_scan_filter_entry_t le_scan_filter_entries[MAX_NR_LE_SCAN_FILTER_ENTRIES];
+    uint16_t le_scan_filter_num_entries;
+    uint32_t le_scan_filter_window_ms;
+    int8_t   le_scan_filter_rssi_min;
+    uint8_t  le_scan_filter_ad_type;
+    uint16_t le_scan_filter_uuid16;
+    bool     le_scan_filter_uuid128_set;
+    uint8_t  le_scan_filter_uuid128[16];
+    uint32_t le_scan_filter_num_forwarded;
+    uint32_t le_scan_filter_num_dropped;
+#endif
+
     uint8_t  le_connection_own_addr_type;
     uint8_t  le_connection_phys;
     bd_addr_t le_connection_own_address;
@@ -114,7 +114,8 @@ typedef struct {
 
 typedef enum {
     HCI_TRANSPORT_CONFIG_UART,
-    HCI_TRANSPORT_CONFIG_USB
+    HCI_TRANSPORT_CONFIG_USB,
+    HCI_TRANSPORT_CONFIG_VIRTUAL
 } hci_transport_config_type_t;
 
 typedef struct {
@@ -56,6 +56,7 @@
 #include "btstack_uart_block.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 #define ENABLE_LOG_EHCILL
 
@@ -150,6 +151,33 @@ static uint16_t read_pos;
 static uint8_t hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE + 1]; // packet type + max(acl header + acl payload, event header + event data)
 static uint8_t * hci_packet = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
 
+// Read-ahead: read as many bytes as available and parse all complete packets per UART callback
+#ifdef ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
+#ifdef ENABLE_EHCILL
+#error "ENABLE_HCI_TRANSPORT_H4_READ_AHEAD cannot be used with ENABLE_EHCILL"
+#endif
+#if defined(ENABLE_CC256X_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND) || defined(ENABLE_CYPRESS_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND)
+#error "ENABLE_HCI_TRANSPORT_H4_READ_AHEAD cannot be used with baudrate change flowcontrol bug workarounds"
+#endif
+#ifndef HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE
+#define HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE (2 * (1 + HCI_INCOMING_PACKET_BUFFER_SIZE))
+#endif
+#if HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE < (1 + HCI_INCOMING_PACKET_BUFFER_SIZE)
+#error "HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE must be at least 1 + HCI_INCOMING_PACKET_BUFFER_SIZE"
+#endif
+#if HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE > 0xffff
+#error "HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE must not exceed 65535"
+#endif
+
+// packets are delivered in place: keep pre-buffer in front and one byte after the data for handlers that terminate strings
+static uint8_t hci_transport_h4_read_ahead_storage[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE + 1];
+static uint8_t * hci_transport_h4_read_ahead_buffer = &hci_transport_h4_read_ahead_storage[HCI_INCOMING_PRE_BUFFER_SIZE];
+static uint16_t  hci_transport_h4_read_ahead_len;    // bytes in buffer
+static uint16_t  hci_transport_h4_read_ahead_pos;    // start of next packet
+static bool      hci_transport_h4_read_ahead_active; // UART supports receive bytes
+static bool      hci_transport_h4_read_ahead_pending;
+#endif
+
 // Baudrate change bugs in TI CC256x and CYW20704
 #ifdef ENABLE_CC256X_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND
 #define ENABLE_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND
@@ -341,6 +369,115 @@ static void hci_transport_h4_block_read(void){
     }
 }
 
+#ifdef ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
+
+static void hci_transport_h4_read_ahead_reset(void){
+    hci_transport_h4_read_ahead_len = 0;
+    hci_transport_h4_read_ahead_pos = 0;
+}
+
+static void hci_transport_h4_read_ahead_trigger_next_read(void){
+    // move partial packet to start of buffer
+    uint16_t bytes_pending = hci_transport_h4_read_ahead_len - hci_transport_h4_read_ahead_pos;
+    if (hci_transport_h4_read_ahead_pos > 0u){
+        memmove(hci_transport_h4_read_ahead_buffer, &hci_transport_h4_read_ahead_buffer[hci_transport_h4_read_ahead_pos], bytes_pending);
+        hci_transport_h4_read_ahead_pos = 0;
+        hci_transport_h4_read_ahead_len = bytes_pending;
+    }
+    hci_transport_h4_read_ahead_pending = true;
+    btstack_uart->receive_bytes(&hci_transport_h4_read_ahead_buffer[bytes_pending], HCI_TRANSPORT_H4_READ_AHEAD_BUFFER_SIZE - bytes_pending);
+}
+
+// @return size of complete H4 packet incl. packet type, 0 if more data is needed
+static uint16_t hci_transport_h4_read_ahead_packet_size(const uint8_t * data, uint16_t len){
+    uint16_t header_size;
+    switch (data[0]){
+        case HCI_EVENT_PACKET:
+            header_size = HCI_EVENT_HEADER_SIZE;
+            break;
+        case HCI_ACL_DATA_PACKET:
+            header_size = HCI_ACL_HEADER_SIZE;
+            break;
+        case HCI_SCO_DATA_PACKET:
+            header_size = HCI_SCO_HEADER_SIZE;
+            break;
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+        case HCI_ISO_DATA_PACKET:
+            header_size = HCI_ISO_HEADER_SIZE;
+            break;
+#endif
+        default:
+            log_error("hci_transport_h4: invalid packet type 0x%02x", data[0]);
+            // drop packet type
+            hci_transport_h4_read_ahead_pos++;
+            return 0;
+    }
+    if (len < (1u + header_size)){
+        return 0;
+    }
+
+    uint16_t payload_len;
+    switch (data[0]){
+        case HCI_EVENT_PACKET:
+            payload_len = data[2];
+            break;
+        case HCI_SCO_DATA_PACKET:
+            payload_len = data[3];
+            break;
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+        case HCI_ISO_DATA_PACKET:
+            payload_len = little_endian_read_16(data, 3) & 0x3fff;
+            break;
+#endif
+        default:
+            payload_len = little_endian_read_16(data, 3);
+            break;
+    }
+    if (payload_len > (HCI_INCOMING_PACKET_BUFFER_SIZE - header_size)){
+        log_error("hci_transport_h4: invalid packet type 0x%02x payload len %d - only space for %u", data[0], payload_len, HCI_INCOMING_PACKET_BUFFER_SIZE - header_size);
+        // drop packet type and header
+        hci_transport_h4_read_ahead_pos += 1u + header_size;
+        return 0;
+    }
+    if (len < (1u + header_size + payload_len)){
+        return 0;
+    }
+    return 1u + header_size + payload_len;
+}
+
+static void hci_transport_h4_bytes_received(uint16_t num_bytes){
+    hci_transport_h4_read_ahead_pending = false;
+    hci_transport_h4_read_ahead_len += num_bytes;
+
+    // deliver all complete packets
+    while (h4_state != H4_OFF){
+        uint16_t pos = hci_transport_h4_read_ahead_pos;
+        uint16_t bytes_available = hci_transport_h4_read_ahead_len - pos;
+        if (bytes_available == 0u) break;
+        uint8_t * data = &hci_transport_h4_read_ahead_buffer[pos];
+        uint16_t packet_size = hci_transport_h4_read_ahead_packet_size(data, bytes_available);
+        if (packet_size == 0u){
+            // invalid data skipped, check remaining bytes
+            if (hci_transport_h4_read_ahead_pos != pos) continue;
+            // incomplete packet
+            break;
+        }
+        // mark packet as consumed before delivering it to stack as it might close the transport
+        hci_transport_h4_read_ahead_pos += packet_size;
+        // handlers may write a string terminator after the packet, restore following byte afterwards
+        uint8_t next_byte = data[packet_size];
+        hci_transport_h4_packet_handler(data[0], &data[1], packet_size - 1u);
+        data[packet_size] = next_byte;
+    }
+
+    // transport closed or re-opened by packet handler
+    if (h4_state == H4_OFF) return;
+    if (hci_transport_h4_read_ahead_pending) return;
+
+    hci_transport_h4_read_ahead_trigger_next_read();
+}
+#endif
+
 static void hci_transport_h4_block_sent(void){
 
     static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
@@ -441,6 +578,16 @@ static void hci_transport_h4_init(const void * transport_config){
     btstack_uart->init(&hci_transport_h4_uart_config);
     btstack_uart->set_block_received(&hci_transport_h4_block_read);
     btstack_uart->set_block_sent(&hci_transport_h4_block_sent);
+
+#ifdef ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
+    // use read-ahead if supported by UART driver
+    hci_transport_h4_read_ahead_active = (btstack_uart->set_bytes_received != NULL) && (btstack_uart->receive_bytes != NULL);
+    if (hci_transport_h4_read_ahead_active){
+        btstack_uart->set_bytes_received(&hci_transport_h4_bytes_received);
+    } else {
+        log_info("hci_transport_h4: UART driver does not support read-ahead");
+    }
+#endif
 }
 
 static int hci_transport_h4_open(void){
@@ -452,7 +599,15 @@ static int hci_transport_h4_open(void){
 
     // init rx + tx state machines
     hci_transport_h4_reset_statemachine();
-    hci_transport_h4_trigger_next_read();
+#ifdef ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
+    if (hci_transport_h4_read_ahead_active){
+        hci_transport_h4_read_ahead_reset();
+        hci_transport_h4_read_ahead_trigger_next_read();
+    } else
+#endif
+    {
+        hci_transport_h4_trigger_next_read();
+    }
     tx_state = TX_IDLE;
 
 #ifdef ENABLE_EHCILL
@@ -49,6 +49,7 @@
 
 #include "hci_transport_h5.h"
 
+#include "btstack_crc.h"
 #include "btstack_debug.h"
 #include "hci.h"
 #include "hci_transport.h"
@@ -82,8 +83,16 @@ typedef enum {
 
 } hci_transport_link_actions_t;
 
-// Configuration Field. No packet buffers -> sliding window = 1, no OOF flow control, support data integrity check
-#define LINK_CONFIG_SLIDING_WINDOW_SIZE 1
+// Sliding window: number of unacknowledged reliable packets. With more than one, outgoing packets are copied into window buffers
+#ifndef HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 1
+#endif
+#if (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE < 1) || (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 7)
+#error "HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE must be in range 1..7"
+#endif
+
+// Configuration Field. Sliding window size, no OOF flow control, support data integrity check
+#define LINK_CONFIG_SLIDING_WINDOW_SIZE HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
 #define LINK_CONFIG_OOF_FLOW_CONTROL 0
 #define LINK_CONFIG_DATA_INTEGRITY_CHECK 1
 #define LINK_CONFIG_VERSION_NR 0
@@ -95,6 +104,9 @@ typedef enum {
 // resend wakeup
 #define LINK_WAKEUP_MS 50
 
+// max delay for acknowledgement of received reliable packets if window is not full
+#define LINK_ACK_DELAY_MS 10
+
 // additional packet types
 #define LINK_ACKNOWLEDGEMENT_TYPE 0x00
 #define LINK_CONTROL_PACKET_TYPE 0x0f
@@ -123,8 +135,11 @@ static int       slip_write_active;
 // H5 Link State
 static hci_transport_link_state_t link_state;
 static btstack_timer_source_t link_timer;
-static uint8_t  link_seq_nr;
+static uint8_t  link_seq_nr;            // seq nr of oldest unacknowledged packet
 static uint8_t  link_ack_nr;
+static uint8_t  link_sliding_window_size;
+static uint8_t  link_rx_unacked;        // received reliable packets not acknowledged yet
+static btstack_timer_source_t link_ack_timer;
 static uint16_t link_resend_timeout_ms;
 static uint8_t  link_peer_asleep;
 static uint8_t  link_peer_supports_data_integrity_check;
@@ -134,10 +149,30 @@ static uint32_t link_new_baudrate;
 static btstack_timer_source_t inactivity_timer;
 static uint16_t link_inactivity_timeout_ms; // auto-sleep if set
 
-// Outgoing packet
-static uint8_t   hci_packet_type;
-static uint16_t  hci_packet_size;
-static uint8_t * hci_packet;
+// Outgoing reliable packets in sliding window, starting with link_seq_nr
+typedef struct {
+    uint8_t * packet;
+    uint16_t  size;
+    uint8_t   type;
+} hci_transport_link_window_entry_t;
+
+static hci_transport_link_window_entry_t link_window[HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE];
+static uint8_t link_window_head;    // oldest unacknowledged packet
+static uint8_t link_window_count;   // queued packets
+static uint8_t link_window_sent;    // queued packets sent since last (re)transmission
+
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+// H5 header + packet + DIC
+static uint8_t link_window_buffer[HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE][4 + HCI_OUTGOING_PACKET_BUFFER_SIZE + 2];
+#endif
+
+// HCI_EVENT_TRANSPORT_PACKET_SENT not emitted yet for last reliable packet
+static bool link_packet_sent_pending;
+
+// Outgoing unreliable packet
+static uint16_t  hci_sco_packet_size;
+static uint8_t * hci_sco_packet;
+static int       slip_write_sco_packet;
 
 // restore 2 bytes temp overwritten by DIC
 static uint8_t * hci_packet_restore_dic_address;
@@ -159,47 +194,11 @@ static int  hci_transport_link_have_outgoing_packet(void);
 static void hci_transport_h5_frame_sent(void);
 static void hci_transport_h5_process_frame(uint16_t frame_size);
 static void hci_transport_link_run(void);
-static void hci_transport_link_send_queued_packet(void);
+static int  hci_transport_link_send_queued_packet(void);
 static void hci_transport_link_set_timer(uint16_t timeout_ms);
 static void hci_transport_link_timeout_handler(btstack_timer_source_t * timer);
 static void hci_transport_slip_init(void);
 
-// -----------------------------
-// CRC16-CCITT Calculation - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
-
-static const uint16_t crc16_ccitt_table[] ={
-    0x0000, 0x1081, 0x2102, 0x3183,
-    0x4204, 0x5285, 0x6306, 0x7387,
-    0x8408, 0x9489, 0xa50a, 0xb58b,
-    0xc60c, 0xd68d, 0xe70e, 0xf78f
-};
-
-static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ ch) & 0x000f];
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ (ch >> 4)) & 0x000f];
-    return crc;
-}
-
-static uint16_t btstack_reverse_bits_16(uint16_t value){
-    int reverse = 0;
-    int i;
-    for (i = 0; i < 16; i++) { 
-        reverse = reverse << 1;
-        reverse |= value & 1;
-        value = value >> 1;
-    }
-    return reverse;
-}
-
-static uint16_t crc16_calc_for_slip_frame(const uint8_t * data, uint16_t len){
-    int i;
-    uint16_t crc = 0xffff;
-    for (i=0 ; i < len ; i++){
-        crc = crc16_ccitt_update(crc, data[i]);
-    }
-    return btstack_reverse_bits_16(crc);
-}
-
 // -----------------------------
 static void hci_transport_inactivity_timeout_handler(btstack_timer_source_t * ts){
     log_info("inactivity timeout. link state %d, peer asleep %u, actions 0x%02x, outgoing packet %u",
@@ -253,7 +252,7 @@ static void hci_transport_slip_send_frame_with_dic(uint8_t * frame, uint16_t fra
         hci_packet_restore_dic_address = &frame[frame_size];
         hci_packet_restore_dic_data = little_endian_read_16(hci_packet_restore_dic_address, 0);
         // calc and set DIC
-        uint16_t data_integrity_check = crc16_calc_for_slip_frame(frame, frame_size);
+        uint16_t data_integrity_check = btstack_crc16_h5_calc(frame, frame_size);
         big_endian_store_16(frame, frame_size, data_integrity_check);
         frame_size += 2;
     }
@@ -263,21 +262,56 @@ static void hci_transport_slip_send_frame_with_dic(uint8_t * frame, uint16_t fra
     btstack_uart->send_frame(frame, frame_size);
 }
 
-static void hci_transport_link_send_queued_packet(void){
-    uint8_t * buffer =      hci_packet      - 4;
-    uint16_t  buffer_size = hci_packet_size + 4;
+static void hci_transport_link_ack_sent(void){
+    // every packet but link control contains our ack nr
+    link_rx_unacked = 0;
+    btstack_run_loop_remove_timer(&link_ack_timer);
+    hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+}
+
+// @return 1 if packet was sent
+static int hci_transport_link_send_queued_packet(void){
+    uint8_t * packet;
+    uint16_t  packet_size;
+    uint8_t   packet_type;
+    uint8_t   seq_nr;
+    int       reliable;
+
+    if (hci_sco_packet != NULL){
+        // unreliable packet
+        packet      = hci_sco_packet;
+        packet_size = hci_sco_packet_size;
+        packet_type = HCI_SCO_DATA_PACKET;
+        seq_nr      = 0;
+        reliable    = 0;
+        slip_write_sco_packet = 1;
+    } else if (link_window_sent < link_window_count){
+        // next reliable packet in window
+        const hci_transport_link_window_entry_t * entry = &link_window[(link_window_head + link_window_sent) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE];
+        packet      = entry->packet;
+        packet_size = entry->size;
+        packet_type = entry->type;
+        seq_nr      = (link_seq_nr + link_window_sent) & 0x07;
+        reliable    = 1;
+        link_window_sent++;
+    } else {
+        return 0;
+    }
 
     // setup header
-    int reliable = hci_packet_type == HCI_SCO_DATA_PACKET ? 0 : 1;
-    hci_transport_link_calc_header(buffer, link_seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, reliable, hci_packet_type, hci_packet_size);
+    uint8_t * buffer =      packet      - 4;
+    uint16_t  buffer_size = packet_size + 4;
+    hci_transport_link_calc_header(buffer, seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, reliable, packet_type, packet_size);
+    hci_transport_link_ack_sent();
 
     // send frame with dic
-    log_debug("send queued packet: seq %u, ack %u, size %u, append dic %u", link_seq_nr, link_ack_nr, hci_packet_size, link_peer_supports_data_integrity_check);
-    log_debug_hexdump(hci_packet, hci_packet_size);
+    log_debug("send queued packet: seq %u, ack %u, size %u, append dic %u", seq_nr, link_ack_nr, packet_size, link_peer_supports_data_integrity_check);
+    log_debug_hexdump(packet, packet_size);
     hci_transport_slip_send_frame_with_dic(buffer, buffer_size);
 
     // reset inactvitiy timer
     hci_transport_inactivity_timer_set();
+    return 1;
 }
 
 static void hci_transport_link_send_control(const uint8_t * message, int message_len){
@@ -301,6 +335,7 @@ static void hci_transport_link_send_ack_packet(void){
     log_debug("send ack %u", link_ack_nr);
     uint8_t header[4];
     hci_transport_link_calc_header(header, 0, link_ack_nr, 0, 0, LINK_ACKNOWLEDGEMENT_TYPE, 0);
+    hci_transport_link_ack_sent();
     hci_transport_slip_send_frame_with_dic(header, sizeof(header));
 }
 
@@ -385,11 +420,10 @@ static void hci_transport_link_run(void){
         return;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
         // packet already contains ack, no need to send addtitional one
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
-        hci_transport_link_send_queued_packet();
-        return;
+        if (hci_transport_link_send_queued_packet()) return;
+        // all queued packets sent
+        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
@@ -408,9 +442,16 @@ static void hci_transport_link_run(void){
 static void hci_transport_link_set_timer(uint16_t timeout_ms){
     btstack_run_loop_set_timer_handler(&link_timer, &hci_transport_link_timeout_handler);
     btstack_run_loop_set_timer(&link_timer, timeout_ms);
+    btstack_run_loop_remove_timer(&link_timer);
     btstack_run_loop_add_timer(&link_timer);
 }
 
+static void hci_transport_link_ack_timeout_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+    hci_transport_link_run();
+}
+
 static void hci_transport_link_timeout_handler(btstack_timer_source_t * timer){
     switch (link_state){
         case LINK_UNINITIALIZED:
@@ -431,7 +472,8 @@ static void hci_transport_link_timeout_handler(btstack_timer_source_t * timer){
                 hci_transport_link_set_timer(LINK_WAKEUP_MS);
                 break;
             }
-            // resend packet
+            // resend all unacknowledged packets
+            link_window_sent = 0;
             hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
             hci_transport_link_set_timer(link_resend_timeout_ms);
             break;
@@ -446,6 +488,7 @@ static void hci_transport_link_init(void){
     link_state = LINK_UNINITIALIZED;
     link_peer_asleep = 0;
     link_peer_supports_data_integrity_check = 0;
+    link_sliding_window_size = 1;
  
     // get started
     hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
@@ -458,18 +501,72 @@ static int hci_transport_link_inc_seq_nr(int seq_nr){
 }
 
 static int hci_transport_link_have_outgoing_packet(void){
-    return hci_packet != 0;
+    return (link_window_count > 0u) || (hci_sco_packet != NULL);
 }
 
 static void hci_transport_link_clear_queue(void){
     btstack_run_loop_remove_timer(&link_timer);
-    hci_packet = NULL;
+    btstack_run_loop_remove_timer(&link_ack_timer);
+    link_window_head  = 0;
+    link_window_count = 0;
+    link_window_sent  = 0;
+    link_packet_sent_pending = false;
+    link_rx_unacked   = 0;
+    hci_sco_packet    = NULL;
 }
 
 static void hci_transport_h5_queue_packet(uint8_t packet_type, uint8_t *packet, int size){
-    hci_packet = packet;
-    hci_packet_type = packet_type;
-    hci_packet_size = size;
+    if (packet_type == HCI_SCO_DATA_PACKET){
+        hci_sco_packet = packet;
+        hci_sco_packet_size = size;
+        return;
+    }
+
+    btstack_assert(link_window_count < HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    hci_transport_link_window_entry_t * entry = &link_window[(link_window_head + link_window_count) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE];
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+    // copy packet to allow upper stack to send next one
+    btstack_assert(size <= HCI_OUTGOING_PACKET_BUFFER_SIZE);
+    uint8_t * buffer = &link_window_buffer[entry - link_window][4];
+    (void) memcpy(buffer, packet, size);
+    entry->packet = buffer;
+#else
+    entry->packet = packet;
+#endif
+    entry->size = size;
+    entry->type = packet_type;
+    link_window_count++;
+    link_packet_sent_pending = true;
+}
+
+static void hci_transport_h5_emit_packet_sent(void){
+    // notify upper stack that it can send again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+}
+
+static void hci_transport_link_emit_packet_sent_if_window_available(void){
+    if (!link_packet_sent_pending) return;
+    if (link_window_count >= link_sliding_window_size) return;
+    link_packet_sent_pending = false;
+    hci_transport_h5_emit_packet_sent();
+}
+
+static void hci_transport_link_window_acknowledged(uint8_t num_packets){
+    log_debug("%u outgoing packets with seq %u.. ack'ed", num_packets, link_seq_nr);
+    link_seq_nr = (link_seq_nr + num_packets) & 0x07;
+    link_window_head = (link_window_head + num_packets) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE;
+    link_window_count -= num_packets;
+    link_window_sent = (link_window_sent > num_packets) ? (link_window_sent - num_packets) : 0;
+
+    // restart resend timer for remaining packets
+    if (link_window_count == 0u){
+        btstack_run_loop_remove_timer(&link_timer);
+    } else {
+        hci_transport_link_set_timer(link_resend_timeout_ms);
+    }
+
+    hci_transport_link_emit_packet_sent_if_window_available();
 }
 
 static void hci_transport_h5_emit_sleep_state(int sleep_active){
@@ -531,7 +628,7 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
     // validate data integrity check
     if (data_integrity_check_present){
         uint16_t dic_packet = big_endian_read_16(slip_payload, received_payload_len);
-        uint16_t dic_calculate = crc16_calc_for_slip_frame(slip_header, 4 + received_payload_len);
+        uint16_t dic_calculate = btstack_crc16_h5_calc(slip_header, 4 + received_payload_len);
         if (dic_packet != dic_calculate){
             log_info("expected dic value 0x%04x but got 0x%04x", dic_calculate, dic_packet);
             return;
@@ -577,16 +674,18 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
             if (memcmp(slip_payload, link_control_config_response, link_control_config_response_prefix_len) == 0){
                 uint8_t config = slip_payload[2];
                 link_peer_supports_data_integrity_check = (config & 0x10) != 0;
-                log_info("link received config response 0x%02x, data integrity check supported %u", config, link_peer_supports_data_integrity_check);
+                link_sliding_window_size = (uint8_t) btstack_max(1, btstack_min(config & 0x07, LINK_CONFIG_SLIDING_WINDOW_SIZE));
+                log_info("link received config response 0x%02x, data integrity check supported %u, sliding window %u", config,
+                         link_peer_supports_data_integrity_check, link_sliding_window_size);
                 link_state = LINK_ACTIVE;
                 btstack_run_loop_remove_timer(&link_timer);
                 log_info("link activated");
                 // 
                 link_seq_nr = 0;
                 link_ack_nr = 0;
+                hci_transport_link_clear_queue();
                 // notify upper stack that it can start
-                uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+                hci_transport_h5_emit_packet_sent();
                 break;
             }
             break;
@@ -599,23 +698,25 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                     hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
                     break;
                 }
-                // ack packet right away
                 link_ack_nr = hci_transport_link_inc_seq_nr(link_ack_nr);
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                link_rx_unacked++;
+                if (link_rx_unacked >= link_sliding_window_size){
+                    // peer cannot send more, ack right away
+                    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                } else if (link_rx_unacked == 1u){
+                    // delay ack to combine it with outgoing packet or ack for following packets
+                    btstack_run_loop_set_timer_handler(&link_ack_timer, &hci_transport_link_ack_timeout_handler);
+                    btstack_run_loop_set_timer(&link_ack_timer, LINK_ACK_DELAY_MS);
+                    btstack_run_loop_add_timer(&link_ack_timer);
+                }
             }
 
             // Process ACKs in reliable packet and explicit ack packets
             if (reliable_packet || link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE){
-                // our packet is good if the remote expects our seq nr + 1
-                int next_seq_nr = hci_transport_link_inc_seq_nr(link_seq_nr);
-                if (hci_transport_link_have_outgoing_packet() && next_seq_nr == ack_nr){
-                    log_debug("outoing packet with seq %u ack'ed", link_seq_nr);
-                    link_seq_nr = next_seq_nr;
-                    hci_transport_link_clear_queue();
-
-                    // notify upper stack that it can send again
-                    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+                // remote expects seq nr of next packet, all packets before are ack'ed
+                uint8_t num_packets_acked = (ack_nr - link_seq_nr) & 0x07;
+                if ((num_packets_acked > 0u) && (num_packets_acked <= link_window_count)){
+                    hci_transport_link_window_acknowledged(num_packets_acked);
                 }
             } 
 
@@ -734,13 +835,15 @@ static void hci_transport_h5_frame_sent(void){
     }
 
     // SCO packets are sent as unreliable, so we're done now
-    if (hci_packet_type == HCI_SCO_DATA_PACKET){
-        hci_transport_link_clear_queue();
-        // notify upper stack that it can send again
-        uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-        packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+    if (slip_write_sco_packet){
+        slip_write_sco_packet = 0;
+        hci_sco_packet = NULL;
+        hci_transport_h5_emit_packet_sent();
     }
 
+    // reliable packet has been copied into window
+    hci_transport_link_emit_packet_sent_if_window_available();
+
     hci_transport_link_run();
 }
 
@@ -814,9 +917,11 @@ static void hci_transport_h5_register_packet_handler(void (*handler)(uint8_t pac
 }
 
 static int hci_transport_h5_can_send_packet_now(uint8_t packet_type){
-    int res = !hci_transport_link_have_outgoing_packet() && link_state == LINK_ACTIVE;
-    // log_info("can_send_packet_now: %u", res);
-    return res;
+    if (link_state != LINK_ACTIVE) return 0;
+    // upper stack waits for HCI_EVENT_TRANSPORT_PACKET_SENT
+    if (link_packet_sent_pending || (hci_sco_packet != NULL)) return 0;
+    if (packet_type == HCI_SCO_DATA_PACKET) return 1;
+    return link_window_count < link_sliding_window_size;
 }
 
 static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, int size){
@@ -839,7 +944,10 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         hci_transport_link_set_timer(LINK_WAKEUP_MS);
     } else {
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        hci_transport_link_set_timer(link_resend_timeout_ms);
+        // resend timer covers oldest unacknowledged packet
+        if ((packet_type != HCI_SCO_DATA_PACKET) && (link_window_count == 1u)){
+            hci_transport_link_set_timer(link_resend_timeout_ms);
+        }
     }
     hci_transport_link_run();
     return 0;
@@ -850,6 +958,9 @@ static int hci_transport_h5_set_baudrate(uint32_t baudrate){
     log_info("set_baudrate %"PRIu32", h5 actions %x", baudrate, hci_transport_link_actions);
     // Baudrate is changed after an HCI Baudrate Change Command, which usually causes an HCI Event Commmand Complete
     // Before changing the baudrate, the HCI Command Complete needs to get acknowledged
+    if (link_rx_unacked > 0u){
+        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+    }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SET_BAUDRATE;
         link_new_baudrate = baudrate;
@@ -51,6 +51,27 @@ extern "C" {
 
 /* API_START */
 
+typedef struct {
+    // packets
+    uint32_t event_in_packets;
+    uint32_t acl_in_packets;
+    uint32_t command_out_packets;
+    uint32_t acl_out_packets;
+    // time from transfer completion until packet was handled by main thread
+    uint64_t in_dispatch_latency_us_total;
+    uint32_t in_dispatch_latency_us_max;
+    // time from submit until outgoing transfer was completed
+    uint64_t out_latency_us_total;
+    uint32_t out_latency_us_max;
+    // queue occupancy
+    uint32_t out_in_flight_max;
+    uint32_t completed_queue_max;
+    // stalls and errors
+    uint32_t out_buffers_exhausted;
+    uint32_t stalls;
+    uint32_t errors;
+} hci_transport_usb_statistics_t;
+
 /*
  * @brief
  */
@@ -68,6 +89,17 @@ void hci_transport_usb_set_path(int len, uint8_t * port_numbers);
  */
 void hci_transport_usb_add_device(uint16_t vendor_id, uint16_t product_id);
 
+/**
+ * @brief Get transfer statistics, currently provided by libusb transport
+ * @param statistics
+ */
+void hci_transport_usb_get_statistics(hci_transport_usb_statistics_t * statistics);
+
+/**
+ * @brief Reset transfer statistics
+ */
+void hci_transport_usb_reset_statistics(void);
+
 /* API_END */
 
 #if defined __cplusplus
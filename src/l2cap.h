@@ -458,6 +458,7 @@ bool l2cap_can_send_prepared_packet_now(uint16_t local_cid);
 #define PSM_HID_INTERRUPT 0x13
 #define PSM_ATT           0x1f
 #define PSM_IPSP          0x23
+#define PSM_EATT          0x27
 
 /** 
  * @brief Set up L2CAP and register L2CAP with HCI layer.
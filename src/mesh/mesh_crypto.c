@@ -273,3 +273,101 @@ void mesh_transport_key_calc_aid(btstack_crypto_aes128_cmac_t * request, mesh_tr
     mesh_k4(request, app_key->key, &app_key->aid, callback, callback_arg);
 }
 
+#if defined(ENABLE_SOFTWARE_AES128) || defined (HAVE_AES128)
+// AES-CCM with 2 byte length field as used by Mesh Network and Upper Transport layer
+
+static void mesh_ccm_setup_a_i(uint8_t * a_i, const uint8_t * nonce, uint16_t counter){
+    a_i[0] = 1;     // L - 1
+    (void)memcpy(&a_i[1], nonce, 13);
+    big_endian_store_16(a_i, 14, counter);
+}
+
+// CBC-MAC over additional authenticated data and plaintext, plaintext is decrypted on the fly if not NULL
+static void mesh_ccm_calc_mac(const uint8_t * key, const uint8_t * nonce, const uint8_t * aad, uint16_t aad_len,
+                              const uint8_t * ciphertext, uint16_t len, uint8_t mic_len, uint8_t * plaintext, uint8_t * x_i){
+    uint8_t block[16];
+    uint16_t i;
+
+    // B_0
+    block[0] = ((aad_len > 0u) ? 0x40 : 0x00) | ((uint8_t)((mic_len - 2u) / 2u) << 3) | 1u;
+    (void)memcpy(&block[1], nonce, 13);
+    big_endian_store_16(block, 14, len);
+    btstack_aes128_calc(key, block, x_i);
+
+    // additional authenticated data with 2 byte length prefix
+    if (aad_len > 0u){
+        uint16_t aad_pos = 0;
+        uint16_t block_pos = 2;
+        x_i[0] ^= (uint8_t)(aad_len >> 8);
+        x_i[1] ^= (uint8_t) aad_len;
+        while (aad_pos < aad_len){
+            x_i[block_pos++] ^= aad[aad_pos++];
+            if ((block_pos == 16u) || (aad_pos == aad_len)){
+                btstack_aes128_calc(key, x_i, x_i);
+                block_pos = 0;
+            }
+        }
+    }
+
+    // message
+    uint16_t counter = 1;
+    for (i = 0; i < len; i += 16u){
+        uint16_t block_len = btstack_min(16u, len - i);
+        uint8_t s_i[16];
+        mesh_ccm_setup_a_i(block, nonce, counter++);
+        btstack_aes128_calc(key, block, s_i);
+        uint16_t j;
+        for (j = 0; j < block_len; j++){
+            uint8_t plain = ciphertext[i + j] ^ s_i[j];
+            x_i[j] ^= plain;
+            if (plaintext != NULL){
+                plaintext[i + j] = plain;
+            }
+        }
+        btstack_aes128_calc(key, x_i, x_i);
+    }
+}
+
+static void mesh_ccm_decrypt_ctr(const uint8_t * key, const uint8_t * nonce, const uint8_t * ciphertext, uint16_t len, uint8_t * plaintext){
+    uint8_t a_i[16];
+    uint8_t s_i[16];
+    uint16_t counter = 1;
+    uint16_t i;
+    for (i = 0; i < len; i += 16u){
+        uint16_t block_len = btstack_min(16u, len - i);
+        mesh_ccm_setup_a_i(a_i, nonce, counter++);
+        btstack_aes128_calc(key, a_i, s_i);
+        uint16_t j;
+        for (j = 0; j < block_len; j++){
+            plaintext[i + j] = ciphertext[i + j] ^ s_i[j];
+        }
+    }
+}
+
+bool mesh_ccm_decrypt(const uint8_t * key, const uint8_t * nonce, const uint8_t * additional_authenticated_data, uint16_t additional_authenticated_data_len,
+                      const uint8_t * ciphertext, uint16_t len, uint8_t * plaintext, const uint8_t * mic, uint8_t mic_len){
+    btstack_assert((mic_len == 4u) || (mic_len == 8u));
+    uint8_t x_i[16];
+    uint8_t s_0[16];
+
+    // in-place: verify MIC first and only decrypt if it matches
+    bool in_place = plaintext == ciphertext;
+    mesh_ccm_calc_mac(key, nonce, additional_authenticated_data, additional_authenticated_data_len, ciphertext, len,
+                      mic_len, in_place ? NULL : plaintext, x_i);
+
+    uint8_t a_0[16];
+    mesh_ccm_setup_a_i(a_0, nonce, 0);
+    btstack_aes128_calc(key, a_0, s_0);
+    uint8_t i;
+    uint8_t diff = 0;
+    for (i = 0; i < mic_len; i++){
+        diff |= (x_i[i] ^ s_0[i]) ^ mic[i];
+    }
+    if (diff != 0u) return false;
+
+    if (in_place){
+        mesh_ccm_decrypt_ctr(key, nonce, ciphertext, len, plaintext);
+    }
+    return true;
+}
+#endif
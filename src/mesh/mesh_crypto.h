@@ -104,6 +104,25 @@ void mesh_network_key_derive(btstack_crypto_aes128_cmac_t * request, mesh_networ
  */
 void mesh_transport_key_calc_aid(btstack_crypto_aes128_cmac_t * request, mesh_transport_key_t * app_key, void (* callback)(void * arg), void * callback_arg);
 
+#if defined(ENABLE_SOFTWARE_AES128) || defined (HAVE_AES128)
+/**
+ * Decrypt AES-CCM message with 13 byte nonce and verify MIC synchronously using btstack_aes128_calc
+ * @note for in-place decryption, ciphertext is only overwritten if MIC matches, which allows to try multiple keys
+ * @param key
+ * @param nonce (13 bytes)
+ * @param additional_authenticated_data or NULL
+ * @param additional_authenticated_data_len
+ * @param ciphertext
+ * @param len
+ * @param plaintext, may be same as ciphertext
+ * @param mic to compare against
+ * @param mic_len 4 or 8
+ * @return true if MIC matches
+ */
+bool mesh_ccm_decrypt(const uint8_t * key, const uint8_t * nonce, const uint8_t * additional_authenticated_data, uint16_t additional_authenticated_data_len,
+                      const uint8_t * ciphertext, uint16_t len, uint8_t * plaintext, const uint8_t * mic, uint8_t mic_len);
+#endif
+
 
 #ifdef __cplusplus
 } /* end of extern "C" */
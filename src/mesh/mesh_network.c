@@ -48,6 +48,7 @@
 #include "btstack_util.h"
 
 #include "mesh/beacon.h"
+#include "mesh/mesh_crypto.h"
 #include "mesh/mesh_foundation.h"
 #include "mesh/mesh_iv_index_seq_number.h"
 #include "mesh/mesh_keys.h"
@@ -64,7 +65,22 @@
 #endif
 
 // configuration
+#ifndef MESH_NETWORK_CACHE_SIZE
 #define MESH_NETWORK_CACHE_SIZE 2
+#endif
+
+// hash table slots are uint16_t and hold ring index + 1, table size is 2 * MESH_NETWORK_CACHE_SIZE
+#if MESH_NETWORK_CACHE_SIZE > 32767
+#error "MESH_NETWORK_CACHE_SIZE must not exceed 32767"
+#endif
+
+// hash table with twice as many slots as cache entries keeps probe sequences short
+#define MESH_NETWORK_CACHE_TABLE_SIZE (2 * MESH_NETWORK_CACHE_SIZE)
+
+// try all network keys with matching NID synchronously with local AES128 implementation
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define USE_LOCAL_DECRYPTION
+#endif
 
 // debug config
 #define LOG_NETWORK
@@ -137,8 +153,12 @@ static mesh_network_pdu_t * adv_bearer_network_pdu;
 
 
 // mesh network cache - we use 32-bit 'hashes'
+// entries are stored in a FIFO ring for eviction and indexed by an open-addressing hash table
+// a table slot contains the ring index + 1, 0 marks an empty slot
 static uint32_t mesh_network_cache[MESH_NETWORK_CACHE_SIZE];
-static int      mesh_network_cache_index;
+static uint16_t mesh_network_cache_table[MESH_NETWORK_CACHE_TABLE_SIZE];
+static uint16_t mesh_network_cache_index;
+static uint16_t mesh_network_cache_count;
 
 // register for freed network pdu
 void (*mesh_network_free_pdu_callback)(void);
@@ -146,7 +166,10 @@ void (*mesh_network_free_pdu_callback)(void);
 // prototypes
 
 static void mesh_network_run(void);
+#ifndef USE_LOCAL_DECRYPTION
 static void process_network_pdu_validate(void);
+#endif
+static void process_network_pdu_validated(void);
 
 // network caching
 static uint32_t mesh_network_cache_hash(mesh_network_pdu_t * network_pdu){
@@ -160,18 +183,70 @@ static uint32_t mesh_network_cache_hash(mesh_network_pdu_t * network_pdu){
     return (src << 16) | (ivi << 15) | (seq & 0x7fff);
 }
 
+static uint16_t mesh_network_cache_home_slot(uint32_t hash){
+    // scramble bits and map onto table size without division
+    uint32_t scrambled = hash * 0x9E3779B1u;
+    return (uint16_t) (((uint64_t) scrambled * MESH_NETWORK_CACHE_TABLE_SIZE) >> 32);
+}
+
+static uint16_t mesh_network_cache_next_slot(uint16_t slot){
+    slot++;
+    if (slot == MESH_NETWORK_CACHE_TABLE_SIZE){
+        slot = 0;
+    }
+    return slot;
+}
+
 static int mesh_network_cache_find(uint32_t hash){
-    int i;
-    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++) {
-        if (mesh_network_cache[i] == hash) {
+    uint16_t slot = mesh_network_cache_home_slot(hash);
+    while (mesh_network_cache_table[slot] != 0){
+        if (mesh_network_cache[mesh_network_cache_table[slot] - 1] == hash) {
             return 1;
         }
+        slot = mesh_network_cache_next_slot(slot);
     }
     return 0;
 }
 
+static void mesh_network_cache_remove(uint32_t hash){
+    uint16_t slot = mesh_network_cache_home_slot(hash);
+    while (mesh_network_cache[mesh_network_cache_table[slot] - 1] != hash){
+        slot = mesh_network_cache_next_slot(slot);
+    }
+    // backward shift deletion: move following entries into the gap unless their home slot lies between gap and entry
+    uint16_t next_slot = slot;
+    while (true){
+        next_slot = mesh_network_cache_next_slot(next_slot);
+        uint16_t entry = mesh_network_cache_table[next_slot];
+        if (entry == 0) break;
+        uint16_t home_slot = mesh_network_cache_home_slot(mesh_network_cache[entry - 1]);
+        bool keep;
+        if (slot <= next_slot){
+            keep = (slot < home_slot) && (home_slot <= next_slot);
+        } else {
+            keep = (slot < home_slot) || (home_slot <= next_slot);
+        }
+        if (keep) continue;
+        mesh_network_cache_table[slot] = entry;
+        slot = next_slot;
+    }
+    mesh_network_cache_table[slot] = 0;
+}
+
 static void mesh_network_cache_add(uint32_t hash){
-    mesh_network_cache[mesh_network_cache_index++] = hash;
+    // evict oldest entry if full
+    if (mesh_network_cache_count == MESH_NETWORK_CACHE_SIZE){
+        mesh_network_cache_remove(mesh_network_cache[mesh_network_cache_index]);
+    } else {
+        mesh_network_cache_count++;
+    }
+    mesh_network_cache[mesh_network_cache_index] = hash;
+    uint16_t slot = mesh_network_cache_home_slot(hash);
+    while (mesh_network_cache_table[slot] != 0){
+        slot = mesh_network_cache_next_slot(slot);
+    }
+    mesh_network_cache_table[slot] = mesh_network_cache_index + 1;
+    mesh_network_cache_index++;
     if (mesh_network_cache_index >= MESH_NETWORK_CACHE_SIZE){
         mesh_network_cache_index = 0;
     }
@@ -487,42 +562,13 @@ static void process_network_pdu_done(void){
     mesh_network_run();
 }
 
-static void process_network_pdu_validate_d(void * arg){
-    UNUSED(arg);
-    // mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) arg;
+// incoming_pdu_decoded has been decrypted with current_network_key and NetMIC matches
+static void process_network_pdu_validated(void){
 
     uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
     uint8_t ctl         = ctl_ttl >> 7;
     uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
 
-    // store NetMIC
-    uint8_t net_mic[8];
-    btstack_crypto_ccm_get_authentication_value(&mesh_network_crypto_request.ccm, net_mic);
-#ifdef LOG_NETWORK
-    printf("RX-NetMIC (%p): ", incoming_pdu_decoded); 
-    printf_hexdump(net_mic, net_mic_len);
-#endif
-    // store in decoded pdu
-    (void)memcpy(&incoming_pdu_decoded->data[incoming_pdu_decoded->len - net_mic_len],
-                 net_mic, net_mic_len);
-
-#ifdef LOG_NETWORK
-    uint8_t cypher_len  = incoming_pdu_decoded->len - 9 - net_mic_len;
-    printf("RX-Decrypted DST/TransportPDU (%p): ", incoming_pdu_decoded);
-    printf_hexdump(&incoming_pdu_decoded->data[7], 2 + cypher_len);
-
-    printf("RX-Decrypted: ");
-    printf_hexdump(incoming_pdu_decoded->data, incoming_pdu_decoded->len);
-#endif
-
-    // validate network mic
-    if (memcmp(net_mic, &incoming_pdu_raw->data[incoming_pdu_decoded->len-net_mic_len], net_mic_len) != 0){
-        // fail
-        printf("RX-NetMIC mismatch, try next key (%p)\n", incoming_pdu_decoded);
-        process_network_pdu_validate();
-        return;
-    }    
-
     // remove NetMIC from payload
     incoming_pdu_decoded->len -= net_mic_len;
 
@@ -607,22 +653,7 @@ static uint32_t iv_index_for_pdu(const mesh_network_pdu_t * network_pdu){
     return iv_index;
 }
 
-static void process_network_pdu_validate_b(void * arg){
-    UNUSED(arg);
-
-#ifdef LOG_NETWORK
-    printf("RX-PECB: ");
-    printf_hexdump(obfuscation_block, 6);
-#endif
-
-    // de-obfuscate
-    unsigned int i;
-    for (i=0;i<6;i++){
-        incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ obfuscation_block[i];
-    }
-
-    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
-
+static void process_network_pdu_create_nonce(uint32_t iv_index){
     if (incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
         // create network nonce
         mesh_proxy_create_nonce(network_nonce, incoming_pdu_decoded, iv_index);
@@ -638,6 +669,106 @@ static void process_network_pdu_validate_b(void * arg){
         printf_hexdump(network_nonce, 13);
 #endif
     }
+}
+
+#ifdef USE_LOCAL_DECRYPTION
+
+// try all network keys with matching NID in a single pass
+static void process_network_pdu_validate_local(void){
+    // PECB input is the same for all network keys
+    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
+    memset(encryption_block, 0, 5);
+    big_endian_store_32(encryption_block, 5, iv_index);
+    (void)memcpy(&encryption_block[9], &incoming_pdu_raw->data[7], 7);
+
+    while (mesh_network_key_nid_iterator_has_more(&validation_network_key_it)){
+        current_network_key = mesh_network_key_nid_iterator_get_next(&validation_network_key_it);
+
+        // de-obfuscate
+        btstack_aes128_calc(current_network_key->privacy_key, encryption_block, obfuscation_block);
+        unsigned int i;
+        for (i=0;i<6;i++){
+            incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ obfuscation_block[i];
+        }
+
+        uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
+        uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
+        if (incoming_pdu_raw->len < (9 + net_mic_len)) continue;
+        uint8_t cypher_len  = incoming_pdu_raw->len - 7 - net_mic_len;
+
+        process_network_pdu_create_nonce(iv_index);
+        if (mesh_ccm_decrypt(current_network_key->encryption_key, network_nonce, NULL, 0, &incoming_pdu_raw->data[7], cypher_len,
+                             &incoming_pdu_decoded->data[7], &incoming_pdu_raw->data[7 + cypher_len], net_mic_len)){
+            process_network_pdu_validated();
+            return;
+        }
+#ifdef LOG_NETWORK
+        printf("RX-NetMIC mismatch, try next key (%p)\n", incoming_pdu_decoded);
+#endif
+    }
+
+    printf("No valid network key found\n");
+    btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
+    incoming_pdu_decoded = NULL;
+    process_network_pdu_done();
+}
+
+#else
+
+static void process_network_pdu_validate_d(void * arg){
+    UNUSED(arg);
+    // mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) arg;
+
+    uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
+    uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
+
+    // store NetMIC
+    uint8_t net_mic[8];
+    btstack_crypto_ccm_get_authentication_value(&mesh_network_crypto_request.ccm, net_mic);
+#ifdef LOG_NETWORK
+    printf("RX-NetMIC (%p): ", incoming_pdu_decoded); 
+    printf_hexdump(net_mic, net_mic_len);
+#endif
+    // store in decoded pdu
+    (void)memcpy(&incoming_pdu_decoded->data[incoming_pdu_decoded->len - net_mic_len],
+                 net_mic, net_mic_len);
+
+#ifdef LOG_NETWORK
+    uint8_t cypher_len  = incoming_pdu_decoded->len - 9 - net_mic_len;
+    printf("RX-Decrypted DST/TransportPDU (%p): ", incoming_pdu_decoded);
+    printf_hexdump(&incoming_pdu_decoded->data[7], 2 + cypher_len);
+
+    printf("RX-Decrypted: ");
+    printf_hexdump(incoming_pdu_decoded->data, incoming_pdu_decoded->len);
+#endif
+
+    // validate network mic
+    if (memcmp(net_mic, &incoming_pdu_raw->data[incoming_pdu_decoded->len-net_mic_len], net_mic_len) != 0){
+        // fail
+        printf("RX-NetMIC mismatch, try next key (%p)\n", incoming_pdu_decoded);
+        process_network_pdu_validate();
+        return;
+    }    
+
+    process_network_pdu_validated();
+}
+
+static void process_network_pdu_validate_b(void * arg){
+    UNUSED(arg);
+
+#ifdef LOG_NETWORK
+    printf("RX-PECB: ");
+    printf_hexdump(obfuscation_block, 6);
+#endif
+
+    // de-obfuscate
+    unsigned int i;
+    for (i=0;i<6;i++){
+        incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ obfuscation_block[i];
+    }
+
+    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
+    process_network_pdu_create_nonce(iv_index);
 
     // 
     uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
@@ -674,7 +805,7 @@ static void process_network_pdu_validate(void){
     (void)memcpy(&encryption_block[9], &incoming_pdu_raw->data[7], 7);
     btstack_crypto_aes128_encrypt(&mesh_network_crypto_request.aes128, current_network_key->privacy_key, encryption_block, obfuscation_block, &process_network_pdu_validate_b, NULL);
 }
-
+#endif
 
 static void process_network_pdu(void){
     //
@@ -690,7 +821,11 @@ static void process_network_pdu(void){
     // uint8_t iv_index = network_pdu_data[0] >> 7;
     mesh_network_key_nid_iterator_init(&validation_network_key_it, nid);
 
+#ifdef USE_LOCAL_DECRYPTION
+    process_network_pdu_validate_local();
+#else
     process_network_pdu_validate();
+#endif
 }
 
 // returns true if done
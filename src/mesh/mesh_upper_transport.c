@@ -48,6 +48,7 @@
 #include "btstack_memory.h"
 #include "btstack_debug.h"
 
+#include "mesh/mesh_crypto.h"
 #include "mesh/mesh_foundation.h"
 #include "mesh_upper_transport.h"
 #include "mesh/mesh_iv_index_seq_number.h"
@@ -62,6 +63,11 @@
 // MESH_ACCESS_MESH_NETWORK_PAYLOAD_MAX (384) / MESH_NETWORK_PAYLOAD_MAX (29) = 13.24.. < 14
 #define MESSAGE_BUILDER_MAX_NUM_NETWORK_PDUS (14)
 
+// try all application keys with matching AID synchronously with local AES128 implementation
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define USE_LOCAL_DECRYPTION
+#endif
+
 // combined key x address iterator for upper transport decryption
 
 typedef struct {
@@ -78,7 +84,9 @@ typedef struct {
 
 static void mesh_upper_transport_run(void);
 static void mesh_upper_transport_schedule_send_requests(void);
+#ifndef USE_LOCAL_DECRYPTION
 static void mesh_upper_transport_validate_access_message(void);
+#endif
 
 // upper transport callbacks - in access layer
 static void (*mesh_access_message_handler)( mesh_transport_callback_type_t callback_type, mesh_transport_status_t status, mesh_pdu_t * pdu);
@@ -471,6 +479,93 @@ void mesh_upper_transport_request_to_send(btstack_context_callback_registration_
     mesh_upper_transport_schedule_send_requests();
 }
 
+static void mesh_upper_transport_access_message_validated(void){
+    printf("TransMIC matches\n");
+
+    uint8_t transmic_len = ((incoming_access_decrypted->flags & MESH_TRANSPORT_FLAG_TRANSMIC_64) != 0) ? 8 : 4;
+
+    // remove TransMIC from payload
+    incoming_access_decrypted->len -= transmic_len;
+
+    // if virtual address, update dst to pseudo_dst
+    if (mesh_network_address_virtual(incoming_access_decrypted->dst)){
+        incoming_access_decrypted->dst = mesh_transport_key_it.address->pseudo_dst;
+    }
+
+    // pass to upper layer
+    incoming_access_pdu_ready = true;
+    mesh_upper_transport_schedule_send_requests();
+}
+
+static void mesh_upper_transport_copy_encrypted_access_payload(void){
+    mesh_network_pdu_t * unsegmented_pdu = NULL;
+    mesh_segmented_pdu_t * segmented_pdu = NULL;
+    switch (incoming_access_encrypted->pdu_type){
+        case MESH_PDU_TYPE_SEGMENTED:
+            segmented_pdu = (mesh_segmented_pdu_t *) incoming_access_encrypted;
+            mesh_segmented_pdu_flatten(&segmented_pdu->segments, 12, incoming_access_decrypted->data);
+            break;
+        case MESH_PDU_TYPE_UNSEGMENTED:
+            unsegmented_pdu = (mesh_network_pdu_t *) incoming_access_encrypted;
+            (void)memcpy(incoming_access_decrypted->data, &unsegmented_pdu->data[10], incoming_access_decrypted->len);
+            break;
+        default:
+            btstack_assert(false);
+            break;
+    }
+}
+
+#ifdef USE_LOCAL_DECRYPTION
+
+// try all application keys and virtual addresses in a single pass, payload is only decrypted if TransMIC matches
+static void mesh_upper_transport_validate_access_message_local(void){
+    uint8_t   transmic_len = ((incoming_access_decrypted->flags & MESH_TRANSPORT_FLAG_TRANSMIC_64) != 0) ? 8 : 4;
+    uint8_t * upper_transport_pdu_data = incoming_access_decrypted->data;
+    uint8_t   upper_transport_pdu_len  = incoming_access_decrypted->len - transmic_len;
+    uint8_t   akf = incoming_access_decrypted->akf_aid_control & 0x40;
+
+    mesh_upper_transport_copy_encrypted_access_payload();
+    mesh_print_hex("EncAccessPayload", upper_transport_pdu_data, upper_transport_pdu_len);
+
+    crypto_active = 1;
+    while (mesh_transport_key_and_virtual_address_iterator_has_more(&mesh_transport_key_it)){
+        mesh_transport_key_and_virtual_address_iterator_next(&mesh_transport_key_it);
+        const mesh_transport_key_t * message_key = mesh_transport_key_it.key;
+
+        if (message_key->akf){
+            transport_segmented_setup_application_nonce(application_nonce, (mesh_pdu_t *) incoming_access_decrypted);
+        } else {
+            transport_segmented_setup_device_nonce(application_nonce, (mesh_pdu_t *) incoming_access_decrypted);
+        }
+        incoming_access_decrypted->appkey_index = message_key->appkey_index;
+
+        const uint8_t * aad = NULL;
+        uint16_t aad_len = 0;
+        if (mesh_network_address_virtual(incoming_access_decrypted->dst)){
+            aad = mesh_transport_key_it.address->label_uuid;
+            aad_len = 16;
+        }
+
+        if (mesh_ccm_decrypt(message_key->key, application_nonce, aad, aad_len, upper_transport_pdu_data, upper_transport_pdu_len,
+                             upper_transport_pdu_data, &upper_transport_pdu_data[upper_transport_pdu_len], transmic_len)){
+            mesh_print_hex("Decrypted PDU", upper_transport_pdu_data, upper_transport_pdu_len);
+            mesh_upper_transport_access_message_validated();
+            return;
+        }
+
+        if (!akf){
+            printf("TransMIC does not match device key, done\n");
+            mesh_upper_transport_process_access_message_done(incoming_access_decrypted);
+            return;
+        }
+    }
+
+    printf("No valid transport key found\n");
+    mesh_upper_transport_process_access_message_done(incoming_access_decrypted);
+}
+
+#else
+
 static void mesh_upper_transport_validate_access_message_ccm(void * arg){
     UNUSED(arg);
 
@@ -486,20 +581,7 @@ static void mesh_upper_transport_validate_access_message_ccm(void * arg){
     mesh_print_hex("TransMIC", trans_mic, transmic_len);
 
     if (memcmp(trans_mic, &upper_transport_pdu[upper_transport_pdu_len], transmic_len) == 0){
-        printf("TransMIC matches\n");
-
-        // remove TransMIC from payload
-        incoming_access_decrypted->len -= transmic_len;
-
-        // if virtual address, update dst to pseudo_dst
-        if (mesh_network_address_virtual(incoming_access_decrypted->dst)){
-            incoming_access_decrypted->dst = mesh_transport_key_it.address->pseudo_dst;
-        }
-
-        // pass to upper layer
-        incoming_access_pdu_ready = true;
-        mesh_upper_transport_schedule_send_requests();
-
+        mesh_upper_transport_access_message_validated();
     } else {
         uint8_t akf = incoming_access_decrypted->akf_aid_control & 0x40;
         if (akf){
@@ -519,27 +601,10 @@ static void mesh_upper_transport_validate_access_message_digest(void * arg){
     uint8_t   upper_transport_pdu_len      = incoming_access_decrypted->len - transmic_len;
     uint8_t * upper_transport_pdu_data_out = incoming_access_decrypted->data;
 
-    mesh_network_pdu_t * unsegmented_pdu = NULL;
-    mesh_segmented_pdu_t * segmented_pdu = NULL;
-    switch (incoming_access_encrypted->pdu_type){
-        case MESH_PDU_TYPE_SEGMENTED:
-            segmented_pdu = (mesh_segmented_pdu_t *) incoming_access_encrypted;
-            mesh_segmented_pdu_flatten(&segmented_pdu->segments, 12, upper_transport_pdu_data_out);
-            mesh_print_hex("Encrypted Payload:", upper_transport_pdu_data_out, upper_transport_pdu_len);
-            btstack_crypto_ccm_decrypt_block(&ccm, upper_transport_pdu_len, upper_transport_pdu_data_out, upper_transport_pdu_data_out,
-                                             &mesh_upper_transport_validate_access_message_ccm, NULL);
-            break;
-        case MESH_PDU_TYPE_UNSEGMENTED:
-            unsegmented_pdu = (mesh_network_pdu_t *) incoming_access_encrypted;
-            (void)memcpy(upper_transport_pdu_data_out, &unsegmented_pdu->data[10], incoming_access_decrypted->len);
-            btstack_crypto_ccm_decrypt_block(&ccm, upper_transport_pdu_len, upper_transport_pdu_data_out, upper_transport_pdu_data_out,
-                                             &mesh_upper_transport_validate_access_message_ccm, NULL);
-            break;
-        default:
-            btstack_assert(false);
-            break;
-    }
-
+    mesh_upper_transport_copy_encrypted_access_payload();
+    mesh_print_hex("Encrypted Payload:", upper_transport_pdu_data_out, upper_transport_pdu_len);
+    btstack_crypto_ccm_decrypt_block(&ccm, upper_transport_pdu_len, upper_transport_pdu_data_out, upper_transport_pdu_data_out,
+                                     &mesh_upper_transport_validate_access_message_ccm, NULL);
 }
 
 static void mesh_upper_transport_validate_access_message(void){
@@ -583,6 +648,8 @@ static void mesh_upper_transport_validate_access_message(void){
     }
 }
 
+#endif
+
 static void mesh_upper_transport_process_access_message(void){
     uint8_t   transmic_len = ((incoming_access_decrypted->flags & MESH_TRANSPORT_FLAG_TRANSMIC_64) != 0) ? 8 : 4;
     uint8_t * upper_transport_pdu     =  incoming_access_decrypted->data;
@@ -597,7 +664,11 @@ static void mesh_upper_transport_process_access_message(void){
 
     mesh_transport_key_and_virtual_address_iterator_init(&mesh_transport_key_it, incoming_access_decrypted->dst,
                                                          incoming_access_decrypted->netkey_index, akf, aid);
+#ifdef USE_LOCAL_DECRYPTION
+    mesh_upper_transport_validate_access_message_local();
+#else
     mesh_upper_transport_validate_access_message();
+#endif
 }
 
 static void mesh_upper_transport_message_received(mesh_pdu_t * pdu){
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure ATT requests/sec for GATT discovery and handle lookups on a large ATT DB
+// A discovery run performs primary service discovery, characteristic discovery per
+// service and descriptor discovery per characteristic with the default MTU of 23
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+#include "btstack_crypto.h"
+#include "btstack_util.h"
+
+#define NUM_SERVICES                 32
+#define NUM_CHARACTERISTICS_PER_SERVICE 8
+#define NUM_DISCOVERY_RUNS          200
+#define NUM_LOOKUP_RUNS            2000
+
+static att_connection_t att_connection;
+static uint8_t att_request[32];
+static uint8_t att_response[ATT_DEFAULT_MTU];
+
+static uint16_t service_ranges[NUM_SERVICES + 1][2];
+static uint16_t num_service_ranges;
+static uint16_t characteristic_uuids[NUM_SERVICES * NUM_CHARACTERISTICS_PER_SERVICE];
+static uint16_t num_characteristics;
+
+static uint32_t num_requests;
+static uint32_t checksum;
+
+static uint8_t characteristic_value[4] = { 1, 2, 3, 4};
+
+// mock, database hash not used
+void btstack_crypto_aes128_cmac_generator(btstack_crypto_aes128_cmac_t * request, const uint8_t * key, uint16_t size, uint8_t (*get_byte_callback)(uint16_t pos), uint8_t * hash, void (* callback)(void * arg), void * callback_arg){
+    UNUSED(request);
+    UNUSED(key);
+    UNUSED(size);
+    UNUSED(get_byte_callback);
+    UNUSED(hash);
+    UNUSED(callback);
+    UNUSED(callback_arg);
+}
+
+static uint16_t att_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    return att_read_callback_handle_blob(characteristic_value, sizeof(characteristic_value), offset, buffer, buffer_size);
+}
+
+static void setup_att_db(void){
+    att_db_util_init();
+    att_db_util_add_service_uuid16(ORG_BLUETOOTH_SERVICE_GENERIC_ACCESS);
+    att_db_util_add_characteristic_uuid16(GAP_DEVICE_NAME_UUID, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, (uint8_t *) "Benchmark", 9);
+    uint8_t uuid128[16] = { 0xFB, 0x34, 0x9B, 0x5F, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    uint16_t i;
+    for (i = 0; i < NUM_SERVICES; i++){
+        // mix of 16 and 128-bit services and characteristics
+        if ((i & 1u) == 0u){
+            att_db_util_add_service_uuid16(0xA000u + i);
+        } else {
+            uuid128[0] = (uint8_t) i;
+            att_db_util_add_service_uuid128(uuid128);
+        }
+        uint16_t j;
+        for (j = 0; j < NUM_CHARACTERISTICS_PER_SERVICE; j++){
+            uint16_t uuid16 = 0xB000u + (i * NUM_CHARACTERISTICS_PER_SERVICE) + j;
+            uint16_t properties = ATT_PROPERTY_READ | ((j & 1u) ? ATT_PROPERTY_NOTIFY : 0u);
+            if ((j & 3u) == 3u){
+                uuid128[0] = (uint8_t) uuid16;
+                uuid128[1] = (uint8_t) (uuid16 >> 8);
+                att_db_util_add_characteristic_uuid128(uuid128, properties | ATT_PROPERTY_DYNAMIC, ATT_SECURITY_NONE, ATT_SECURITY_NONE, characteristic_value, 0);
+                uuid128[1] = 0;
+            } else {
+                att_db_util_add_characteristic_uuid16(uuid16, properties, ATT_SECURITY_NONE, ATT_SECURITY_NONE, characteristic_value, sizeof(characteristic_value));
+                characteristic_uuids[num_characteristics++] = uuid16;
+            }
+        }
+    }
+    att_set_db(att_db_util_get_address());
+    att_set_read_callback(&att_read_callback);
+}
+
+static uint16_t send_request(uint16_t request_len){
+    uint16_t response_len = att_handle_request(&att_connection, att_request, request_len, att_response);
+    uint16_t i;
+    for (i = 0; i < response_len; i++){
+        checksum = (checksum * 31u) + att_response[i];
+    }
+    num_requests++;
+    return response_len;
+}
+
+static uint16_t send_range_request(uint8_t opcode, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
+    att_request[0] = opcode;
+    little_endian_store_16(att_request, 1, start_handle);
+    little_endian_store_16(att_request, 3, end_handle);
+    if (opcode == ATT_FIND_INFORMATION_REQUEST){
+        return send_request(5);
+    }
+    little_endian_store_16(att_request, 5, uuid16);
+    return send_request(7);
+}
+
+static void discover_primary_services(void){
+    num_service_ranges = 0;
+    uint16_t start_handle = 1;
+    while (true){
+        uint16_t len = send_range_request(ATT_READ_BY_GROUP_TYPE_REQUEST, start_handle, 0xffff, GATT_PRIMARY_SERVICE_UUID);
+        if (att_response[0] != ATT_READ_BY_GROUP_TYPE_RESPONSE) break;
+        uint16_t pair_len = att_response[1];
+        uint16_t pos;
+        uint16_t end_handle = 0;
+        for (pos = 2; (pos + pair_len) <= len; pos += pair_len){
+            end_handle = little_endian_read_16(att_response, pos + 2);
+            if (num_service_ranges <= NUM_SERVICES){
+                service_ranges[num_service_ranges][0] = little_endian_read_16(att_response, pos);
+                service_ranges[num_service_ranges][1] = end_handle;
+                num_service_ranges++;
+            }
+        }
+        if (end_handle == 0xffff) break;
+        start_handle = end_handle + 1u;
+    }
+}
+
+static void discover_characteristics(uint16_t start_handle, uint16_t end_handle){
+    while (start_handle <= end_handle){
+        uint16_t len = send_range_request(ATT_READ_BY_TYPE_REQUEST, start_handle, end_handle, GATT_CHARACTERISTICS_UUID);
+        if (att_response[0] != ATT_READ_BY_TYPE_RESPONSE) break;
+        uint16_t pair_len = att_response[1];
+        uint16_t pos;
+        uint16_t last_handle = 0;
+        for (pos = 2; (pos + pair_len) <= len; pos += pair_len){
+            last_handle = little_endian_read_16(att_response, pos);
+        }
+        if (last_handle == 0xffff) break;
+        start_handle = last_handle + 1u;
+    }
+}
+
+static void discover_descriptors(uint16_t start_handle, uint16_t end_handle){
+    while (start_handle <= end_handle){
+        uint16_t len = send_range_request(ATT_FIND_INFORMATION_REQUEST, start_handle, end_handle, 0);
+        if (att_response[0] != ATT_FIND_INFORMATION_REPLY) break;
+        uint16_t pair_len = (att_response[1] == 0x01u) ? 4u : 18u;
+        uint16_t pos;
+        uint16_t last_handle = 0;
+        for (pos = 2; (pos + pair_len) <= len; pos += pair_len){
+            last_handle = little_endian_read_16(att_response, pos);
+        }
+        if (last_handle == 0xffff) break;
+        start_handle = last_handle + 1u;
+    }
+}
+
+static void discover_all(void){
+    discover_primary_services();
+    uint16_t i;
+    for (i = 0; i < num_service_ranges; i++){
+        discover_characteristics(service_ranges[i][0], service_ranges[i][1]);
+        discover_descriptors(service_ranges[i][0], service_ranges[i][1]);
+    }
+}
+
+static void lookup_all(void){
+    uint16_t i;
+    for (i = 0; i < num_characteristics; i++){
+        uint16_t value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(1, 0xffff, characteristic_uuids[i]);
+        uint16_t ccc_handle = gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(1, 0xffff, characteristic_uuids[i]);
+        checksum = (checksum * 31u) + value_handle + ccc_handle;
+        att_request[0] = ATT_READ_REQUEST;
+        little_endian_store_16(att_request, 1, value_handle);
+        (void) send_request(3);
+    }
+}
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+int main(void){
+    setup_att_db();
+    att_connection.mtu = ATT_DEFAULT_MTU;
+    att_connection.max_mtu = ATT_DEFAULT_MTU;
+
+    printf("ATT DB: %u services, %u bytes\n", NUM_SERVICES + 1, att_db_util_get_size());
+
+    num_requests = 0;
+    double start = time_seconds();
+    uint32_t run;
+    for (run = 0; run < NUM_DISCOVERY_RUNS; run++){
+        discover_all();
+    }
+    double duration = time_seconds() - start;
+    printf("Discovery: %8.0f runs/sec, %10.0f requests/sec (%u requests per run)\n",
+           NUM_DISCOVERY_RUNS / duration, num_requests / duration, num_requests / NUM_DISCOVERY_RUNS);
+
+    num_requests = 0;
+    start = time_seconds();
+    for (run = 0; run < NUM_LOOKUP_RUNS; run++){
+        lookup_all();
+    }
+    duration = time_seconds() - start;
+    printf("Lookup:    %8.0f characteristics/sec\n", (NUM_LOOKUP_RUNS * num_characteristics) / duration);
+
+    printf("Checksum:  %08x\n", checksum);
+    return 0;
+}
@@ -323,6 +323,77 @@ TEST(AttDb, handle_read_multiple_request){
 #endif
 }
 
+TEST(AttDb, handle_read_multiple_variable_request){
+	uint16_t value_handles[2];
+
+	// less then two values
+	att_request_len = att_read_multiple_request(1, value_handles);
+	att_request[0] = ATT_READ_MULTIPLE_VARIABLE_REQ;
+	att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_ERROR_RESPONSE, ATT_READ_MULTIPLE_VARIABLE_REQ, 0, 0, ATT_ERROR_INVALID_PDU};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// handle read not permitted
+	value_handles[0] = 0x05;
+	value_handles[1] = 0x06;
+	att_request_len = att_read_multiple_request(2, value_handles);
+	att_request[0] = ATT_READ_MULTIPLE_VARIABLE_REQ;
+	att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_ERROR_RESPONSE, ATT_READ_MULTIPLE_VARIABLE_REQ, value_handles[1], 0, ATT_ERROR_READ_NOT_PERMITTED};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// static read with length value tuples
+	value_handles[0] = 0x03;
+	value_handles[1] = 0x05;
+	att_request_len = att_read_multiple_request(2, value_handles);
+	att_request[0] = ATT_READ_MULTIPLE_VARIABLE_REQ;
+	att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_READ_MULTIPLE_VARIABLE_RSP, 0x01, 0x00, 0x64, 0x05, 0x00, 0x10, 0x06, 0x00, 0x1B, 0x2A};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// last value truncated to MTU
+	att_connection.mtu = 9;
+	att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_READ_MULTIPLE_VARIABLE_RSP, 0x01, 0x00, 0x64, 0x05, 0x00, 0x10, 0x06, 0x00};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+}
+
+TEST(AttDb, att_prepare_handle_value_multiple_notification){
+	const uint8_t value_a[] = { 0x11 };
+	const uint8_t value_b[] = { 0x21, 0x22, 0x23 };
+	const uint16_t attribute_handles[] = { 0x03, 0x0c };
+	const uint8_t * values_data[] = { value_a, value_b };
+	const uint16_t values_len[] = { sizeof(value_a), sizeof(value_b) };
+
+	att_response_len = att_prepare_handle_value_multiple_notification(&att_connection, 2, attribute_handles, values_data, values_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_MULTIPLE_HANDLE_VALUE_NTF, 0x03, 0x00, 0x01, 0x00, 0x11, 0x0c, 0x00, 0x03, 0x00, 0x21, 0x22, 0x23};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// tuples are not truncated
+	att_connection.mtu = 12;
+	att_response_len = att_prepare_handle_value_multiple_notification(&att_connection, 2, attribute_handles, values_data, values_len, att_response);
+	{
+		const uint8_t expected_response[] = {ATT_MULTIPLE_HANDLE_VALUE_NTF, 0x03, 0x00, 0x01, 0x00, 0x11};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+}
+
 TEST(AttDb, handle_write_request){
 	uint16_t attribute_handle = 0x03;
 
@@ -603,6 +674,27 @@ TEST(AttDb, att_uuid_for_handle){
 	CHECK_EQUAL(expected_response, uuid);
 }
 
+TEST(AttDb, att_db_modified){
+	// characteristic added after att_set_db
+	uint16_t value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_HEART_RATE_MEASUREMENT);
+	CHECK_EQUAL(0, value_handle);
+
+	att_db_util_add_service_uuid16(ORG_BLUETOOTH_SERVICE_HEART_RATE);
+	att_db_util_add_characteristic_uuid16(ORG_BLUETOOTH_CHARACTERISTIC_HEART_RATE_MEASUREMENT, ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY, ATT_SECURITY_NONE, ATT_SECURITY_NONE, &battery_level, 1);
+
+	value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_HEART_RATE_MEASUREMENT);
+	CHECK(value_handle != 0);
+	CHECK_EQUAL(ORG_BLUETOOTH_CHARACTERISTIC_HEART_RATE_MEASUREMENT, att_uuid_for_handle(value_handle));
+	CHECK_EQUAL(value_handle + 1, gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(value_handle, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_HEART_RATE_MEASUREMENT));
+
+	uint16_t start_handle = 0;
+	uint16_t end_handle = 0xffff;
+	bool service_exists = gatt_server_get_handle_range_for_service_with_uuid16(ORG_BLUETOOTH_SERVICE_HEART_RATE, &start_handle, &end_handle);
+	CHECK_EQUAL(true, service_exists);
+	CHECK_EQUAL(value_handle - 2, start_handle);
+	CHECK_EQUAL(value_handle + 1, end_handle);
+}
+
 TEST(AttDb, gatt_server_get_handle_range){
 	uint16_t start_handle;
 	uint16_t end_handle;
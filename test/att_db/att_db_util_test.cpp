@@ -93,6 +93,8 @@ extern "C" {
 
     void att_set_db(uint8_t const * db){
     }
+    void att_db_modified(void){
+    }
     void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
     }
     bool hci_can_send_command_packet_now(void){
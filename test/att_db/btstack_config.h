@@ -28,4 +28,9 @@
 #define NVM_NUM_DEVICE_DB_ENTRIES 4
 #define NVM_NUM_LINK_KEYS 2
 
+// ATT DB index, disabled to test lookup without index and to get baseline for att_db_benchmark
+#ifndef ATT_DB_WITHOUT_INDEX
+#define MAX_ATT_DB_INDEX_SIZE 1024
+#endif
+
 #endif
@@ -39,9 +39,13 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #include <portaudio.h>
 
 #include "btstack_sbc.h"
+#include "btstack_sbc_encoder_bluedroid.h"
 #include "avdtp.h"
 #include "avdtp_source.h"
 #include "btstack_stdin.h"
@@ -56,6 +60,9 @@
 #endif
 #define TABLE_SIZE_441HZ   100
 
+#define MAX_NUM_STREAMS         8
+#define NUM_FRAMES_PER_STREAM   20000
+
 typedef struct {
     int16_t source[TABLE_SIZE_441HZ];
     int left_phase;
@@ -70,6 +77,17 @@ static btstack_sbc_mode_t mode = SBC_MODE_STANDARD;
 static btstack_sbc_encoder_state_t sbc_encoder_state;
 static btstack_sbc_decoder_state_t sbc_decoder_state;
 
+// concurrent encoders, each running in its own thread
+typedef struct {
+    btstack_sbc_encoder_state_t     state;
+    btstack_sbc_encoder_bluedroid_t context;
+    pthread_t thread;
+    int16_t   pcm[16 * 8 * NUM_CHANNELS];
+    uint32_t  checksum;
+} encoder_stream_t;
+
+static encoder_stream_t encoder_streams[MAX_NUM_STREAMS];
+
 static void handle_pcm_data(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context){
     UNUSED(sample_rate);
     UNUSED(context);
@@ -102,6 +120,66 @@ static void fill_sine_frame(void *userData, int num_samples_to_write){
     }
 }
 
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void * encoder_stream_run(void * arg){
+    encoder_stream_t * stream = (encoder_stream_t *) arg;
+    int i;
+    for (i=0; i<NUM_FRAMES_PER_STREAM; i++){
+        btstack_sbc_encoder_process_data(&stream->state, stream->pcm);
+        uint8_t * sbc_frame = btstack_sbc_encoder_sbc_buffer(&stream->state);
+        uint16_t  sbc_frame_len = btstack_sbc_encoder_sbc_buffer_length(&stream->state);
+        uint16_t  pos;
+        for (pos = 0; pos < sbc_frame_len; pos++){
+            stream->checksum = (stream->checksum * 31) + sbc_frame[pos];
+        }
+    }
+    return NULL;
+}
+
+static void measure_concurrent_encoders(int num_streams){
+    int i;
+    for (i=0; i<num_streams; i++){
+        encoder_stream_t * stream = &encoder_streams[i];
+        btstack_sbc_encoder_bluedroid_init_instance(&stream->state, &stream->context);
+        btstack_sbc_encoder_init(&stream->state, SBC_MODE_STANDARD, 16, 8, SBC_ALLOCATION_METHOD_LOUDNESS, 44100, 53, SBC_CHANNEL_MODE_STEREO);
+        // same input for all streams, output has to match if encoders don't share state
+        memcpy(stream->pcm, pcm_frame, sizeof(stream->pcm));
+        stream->checksum = 0;
+    }
+
+    double start = time_seconds();
+    for (i=0; i<num_streams; i++){
+        pthread_create(&encoder_streams[i].thread, NULL, &encoder_stream_run, &encoder_streams[i]);
+    }
+    for (i=0; i<num_streams; i++){
+        pthread_join(encoder_streams[i].thread, NULL);
+    }
+    double duration = time_seconds() - start;
+
+    bool output_identical = true;
+    for (i=1; i<num_streams; i++){
+        if (encoder_streams[i].checksum != encoder_streams[0].checksum){
+            output_identical = false;
+        }
+    }
+
+    // streams run in parallel up to the number of cores
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_cores < 1){
+        num_cores = 1;
+    }
+    int num_cores_used = (num_streams < num_cores) ? num_streams : (int) num_cores;
+
+    double frames_per_second = (double) (num_streams * NUM_FRAMES_PER_STREAM) / duration;
+    printf("%u concurrent streams: %9.0f frames/s total, %9.0f frames/s per core%s\n", num_streams,
+           frames_per_second, frames_per_second / num_cores_used, output_identical ? "" : " - OUTPUT MISMATCH");
+}
+
 int btstack_main(int argc, const char * argv[]);
 int btstack_main(int argc, const char * argv[]){
     (void) argc;
@@ -124,20 +202,25 @@ int btstack_main(int argc, const char * argv[]){
     timestamp_start = btstack_run_loop_get_time_ms();
     for (i=0; i<num_frames; i++){
         fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
+        btstack_sbc_encoder_process_data(&sbc_encoder_state, (int16_t *) pcm_frame);
     }
     encoding_time = btstack_run_loop_get_time_ms() - timestamp_start;
 
     timestamp_start = btstack_run_loop_get_time_ms();
     for (i=0; i<num_frames; i++){
         fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
-        btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, btstack_sbc_encoder_sbc_buffer(), btstack_sbc_encoder_sbc_buffer_length());
+        btstack_sbc_encoder_process_data(&sbc_encoder_state, (int16_t *) pcm_frame);
+        btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, btstack_sbc_encoder_sbc_buffer(&sbc_encoder_state), btstack_sbc_encoder_sbc_buffer_length(&sbc_encoder_state));
     }
     decoding_time =  btstack_run_loop_get_time_ms() - timestamp_start - encoding_time;
 
     printf("%d frames encoded in %dms\n", num_frames, encoding_time);
     printf("%d frames decoded in %dms\n", num_frames, decoding_time);
+
+    int num_streams;
+    for (num_streams = 1; num_streams <= MAX_NUM_STREAMS; num_streams++){
+        measure_concurrent_encoders(num_streams);
+    }
     
     exit(0);
 }
@@ -121,7 +121,7 @@ static void store_sbc_frame_for_transmission(uint8_t * sbc_frame, int sbc_frame_
 static void avdtp_source_stream_endpoint_run(avdtp_stream_endpoint_t * stream_endpoint){
     // performe sbc encoding
     int total_num_bytes_read = 0;
-    int num_audio_samples_to_read = btstack_sbc_encoder_num_audio_frames();
+    int num_audio_samples_to_read = btstack_sbc_encoder_num_audio_frames(&stream_endpoint->sbc_encoder_state);
     int audio_bytes_to_read = num_audio_samples_to_read * BYTES_PER_AUDIO_SAMPLE; 
 
     printf("run: audio samples %u, audio_bytes_to_read: %d\n", num_audio_samples_to_read, audio_bytes_to_read);
@@ -135,14 +135,14 @@ static void avdtp_source_stream_endpoint_run(avdtp_stream_endpoint_t * stream_en
         uint8_t pcm_frame[256*BYTES_PER_AUDIO_SAMPLE];
         btstack_ring_buffer_read(&stream_endpoint->audio_ring_buffer, pcm_frame, audio_bytes_to_read, &number_of_bytes_read); 
         // printf("     num audio bytes read %d\n", number_of_bytes_read);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
+        btstack_sbc_encoder_process_data(&stream_endpoint->sbc_encoder_state, (int16_t *) pcm_frame);
         
-        uint16_t sbc_frame_bytes = btstack_sbc_encoder_sbc_buffer_length();
+        uint16_t sbc_frame_bytes = btstack_sbc_encoder_sbc_buffer_length(&stream_endpoint->sbc_encoder_state);
         printf("decode %d bytes\n", sbc_frame_bytes);
         total_num_bytes_read += number_of_bytes_read;
 
-        store_sbc_frame_for_transmission(btstack_sbc_encoder_sbc_buffer(), sbc_frame_bytes, stream_endpoint);
-        btstack_sbc_decoder_process_data(&state, 0, btstack_sbc_encoder_sbc_buffer(), sbc_frame_bytes);
+        store_sbc_frame_for_transmission(btstack_sbc_encoder_sbc_buffer(&stream_endpoint->sbc_encoder_state), sbc_frame_bytes, stream_endpoint);
+        btstack_sbc_decoder_process_data(&state, 0, btstack_sbc_encoder_sbc_buffer(&stream_endpoint->sbc_encoder_state), sbc_frame_bytes);
     }
 }
 
@@ -0,0 +1,628 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// End-to-end benchmarks over the virtual HCI transport without a radio
+//
+// Each benchmark forks two BTstack instances that are connected via a socketpair. The initiator connects to
+// the responder and one side streams data at full rate until the receiver got all packets and disconnects.
+//
+// Reported for sender and receiver:
+// - throughput from first to last packet
+// - CPU time per packet, including the simulated Controller and socket I/O
+// - event-to-send latency: time from passing an HCI packet to the host until it sends the next ACL packet
+
+#define BTSTACK_FILE__ "benchmark.c"
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack.h"
+#include "btstack_run_loop_posix.h"
+#include "hci_transport_virtual.h"
+#include "hci_dump_posix_stdout.h"
+
+#include "benchmark.h"
+
+#define BENCHMARK_L2CAP_PSM         0x0081
+#define BENCHMARK_RFCOMM_CHANNEL    1
+#define BENCHMARK_RTP_HEADER_SIZE   12
+#define BENCHMARK_TIMEOUT_MS        30000
+#define BENCHMARK_VALUE_HANDLE      ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE
+
+typedef enum {
+    BENCHMARK_GATT_NOTIFY,
+    BENCHMARK_GATT_WRITE,
+    BENCHMARK_L2CAP_CBM,
+    BENCHMARK_RFCOMM,
+    BENCHMARK_A2DP,
+    BENCHMARK_COUNT
+} benchmark_type_t;
+
+static const char * benchmark_names[BENCHMARK_COUNT] = {
+    "gatt_notify", "gatt_write", "l2cap_cbm", "rfcomm", "a2dp"
+};
+
+static bd_addr_t initiator_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x01 };
+static bd_addr_t responder_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x02 };
+
+static hci_transport_config_virtual_t transport_config = {
+    HCI_TRANSPORT_CONFIG_VIRTUAL,
+    { 0 },
+    -1,
+    1021,   // ACL payload
+    8,      // ACL buffers
+    0,      // latency
+    0,      // loss
+    0,      // seed
+};
+
+static uint32_t benchmark_num_packets = 2000;
+static bool     benchmark_packet_log;
+
+// current benchmark
+static benchmark_type_t benchmark_type;
+static bool             benchmark_initiator;
+static bool             benchmark_sender;
+static bool             benchmark_done;
+static hci_con_handle_t benchmark_con_handle = HCI_CON_HANDLE_INVALID;
+static uint16_t         benchmark_cid;
+static uint16_t         benchmark_payload_size;
+static uint8_t          benchmark_local_seid;
+static uint32_t         benchmark_rtp_timestamp;
+
+static uint32_t benchmark_packets;
+static uint64_t benchmark_bytes;
+static uint64_t benchmark_first_us;
+static uint64_t benchmark_last_us;
+static uint64_t benchmark_first_cpu_us;
+static uint64_t benchmark_last_cpu_us;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_timer_source_t benchmark_timeout;
+static gatt_client_notification_t gatt_notification_listener;
+static uint8_t benchmark_data[1024];
+static uint8_t l2cap_receive_buffer[1000];
+
+// a2dp
+static uint8_t sdp_service_buffer[150];
+static uint8_t media_sbc_codec_configuration[4];
+static uint8_t media_sbc_codec_capabilities[] = {
+    (AVDTP_SBC_44100 << 4) | AVDTP_SBC_STEREO,
+    (AVDTP_SBC_BLOCK_LENGTH_16 << 4) | (AVDTP_SBC_SUBBANDS_8 << 2) | AVDTP_SBC_ALLOCATION_METHOD_LOUDNESS,
+    2, 53
+};
+
+static uint64_t benchmark_time_us(clockid_t clock_id){
+    struct timespec now;
+    clock_gettime(clock_id, &now);
+    return ((uint64_t) now.tv_sec * 1000000u) + ((uint64_t) now.tv_nsec / 1000u);
+}
+
+static void benchmark_count_packet(uint16_t size){
+    if (benchmark_done) return;
+    if (size == 0) return;
+    if (benchmark_packets == 0){
+        benchmark_first_us = benchmark_time_us(CLOCK_MONOTONIC);
+        benchmark_first_cpu_us = benchmark_time_us(CLOCK_PROCESS_CPUTIME_ID);
+    }
+    benchmark_packets++;
+    benchmark_bytes += size;
+    if (benchmark_packets < benchmark_num_packets) return;
+    benchmark_last_us = benchmark_time_us(CLOCK_MONOTONIC);
+    benchmark_last_cpu_us = benchmark_time_us(CLOCK_PROCESS_CPUTIME_ID);
+    benchmark_done = true;
+    // receiver ends benchmark
+    if (benchmark_sender == false){
+        gap_disconnect(benchmark_con_handle);
+    }
+}
+
+static void benchmark_packet_sent(uint16_t size){
+    benchmark_count_packet(size);
+}
+
+static void benchmark_packet_received(uint16_t size){
+    benchmark_count_packet(size);
+}
+
+static void benchmark_report(void){
+    hci_transport_virtual_statistics_t statistics;
+    hci_transport_virtual_get_statistics(&statistics);
+    const char * role = benchmark_sender ? "sender" : "receiver";
+    if (benchmark_done == false){
+        printf("%-12s %-8s: FAILED after %" PRIu32 " of %" PRIu32 " packets\n", benchmark_names[benchmark_type], role,
+               benchmark_packets, benchmark_num_packets);
+        return;
+    }
+    uint64_t duration_us = btstack_max(1, benchmark_last_us - benchmark_first_us);
+    uint64_t cpu_us = benchmark_last_cpu_us - benchmark_first_cpu_us;
+    uint64_t average_latency_ns = (statistics.event_to_send_count == 0) ? 0 :
+        (statistics.event_to_send_sum_us * 1000u) / statistics.event_to_send_count;
+    printf("%-12s %-8s: %6" PRIu32 " packets, %8" PRIu64 " bytes, %8.1f kB/s, cpu %6.2f us/packet, "
+           "event-to-send %6.2f us avg, %5" PRIu32 " us max, %" PRIu32 " retransmissions\n",
+           benchmark_names[benchmark_type], role, benchmark_packets, benchmark_bytes,
+           (double) benchmark_bytes * 1000.0 / (double) duration_us,
+           (double) cpu_us / (double) benchmark_packets,
+           (double) average_latency_ns / 1000.0, statistics.event_to_send_max_us, statistics.retransmissions);
+}
+
+static void benchmark_timeout_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    btstack_run_loop_trigger_exit();
+}
+
+// GATT
+
+static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            if (benchmark_type != BENCHMARK_GATT_NOTIFY) break;
+            benchmark_payload_size = att_event_mtu_exchange_complete_get_MTU(packet) - 3;
+            att_server_request_can_send_now_event(benchmark_con_handle);
+            break;
+        case ATT_EVENT_CAN_SEND_NOW:
+            if (benchmark_done) break;
+            att_server_notify(benchmark_con_handle, BENCHMARK_VALUE_HANDLE, benchmark_data, benchmark_payload_size);
+            benchmark_packet_sent(benchmark_payload_size);
+            att_server_request_can_send_now_event(benchmark_con_handle);
+            break;
+        default:
+            break;
+    }
+}
+
+static int att_write_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(offset);
+    UNUSED(buffer);
+    if ((att_handle == BENCHMARK_VALUE_HANDLE) && (transaction_mode == ATT_TRANSACTION_MODE_NONE)){
+        benchmark_packet_received(buffer_size);
+    }
+    return 0;
+}
+
+static void gatt_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case GATT_EVENT_NOTIFICATION:
+            benchmark_packet_received(gatt_event_notification_get_value_length(packet));
+            break;
+        case GATT_EVENT_MTU:
+            if (benchmark_type != BENCHMARK_GATT_WRITE) break;
+            benchmark_payload_size = gatt_event_mtu_get_MTU(packet) - 3;
+            gatt_client_request_can_write_without_response_event(&gatt_client_packet_handler, benchmark_con_handle);
+            break;
+        case GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE:
+            if (benchmark_done) break;
+            gatt_client_write_value_of_characteristic_without_response(benchmark_con_handle, BENCHMARK_VALUE_HANDLE, benchmark_payload_size, benchmark_data);
+            benchmark_packet_sent(benchmark_payload_size);
+            gatt_client_request_can_write_without_response_event(&gatt_client_packet_handler, benchmark_con_handle);
+            break;
+        default:
+            break;
+    }
+}
+
+// L2CAP Credit-Based Flow-Control Mode
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    if (packet_type == L2CAP_DATA_PACKET){
+        benchmark_packet_received(size);
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_CBM_INCOMING_CONNECTION:
+            l2cap_cbm_accept_connection(l2cap_event_cbm_incoming_connection_get_local_cid(packet),
+                                        l2cap_receive_buffer, sizeof(l2cap_receive_buffer), L2CAP_LE_AUTOMATIC_CREDITS);
+            break;
+        case L2CAP_EVENT_CBM_CHANNEL_OPENED:
+            if (l2cap_event_cbm_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            if (benchmark_sender == false) break;
+            benchmark_cid = l2cap_event_cbm_channel_opened_get_local_cid(packet);
+            benchmark_payload_size = l2cap_event_cbm_channel_opened_get_remote_mtu(packet);
+            l2cap_request_can_send_now_event(benchmark_cid);
+            break;
+        case L2CAP_EVENT_CAN_SEND_NOW:
+            if (benchmark_done) break;
+            l2cap_send(benchmark_cid, benchmark_data, benchmark_payload_size);
+            benchmark_packet_sent(benchmark_payload_size);
+            l2cap_request_can_send_now_event(benchmark_cid);
+            break;
+        default:
+            break;
+    }
+}
+
+// RFCOMM
+
+static void rfcomm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    if (packet_type == RFCOMM_DATA_PACKET){
+        benchmark_packet_received(size);
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case RFCOMM_EVENT_INCOMING_CONNECTION:
+            rfcomm_accept_connection(rfcomm_event_incoming_connection_get_rfcomm_cid(packet));
+            break;
+        case RFCOMM_EVENT_CHANNEL_OPENED:
+            if (rfcomm_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            if (benchmark_sender == false) break;
+            benchmark_cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+            benchmark_payload_size = btstack_min(rfcomm_event_channel_opened_get_max_frame_size(packet), sizeof(benchmark_data));
+            rfcomm_request_can_send_now_event(benchmark_cid);
+            break;
+        case RFCOMM_EVENT_CAN_SEND_NOW:
+            if (benchmark_done) break;
+            rfcomm_send(benchmark_cid, benchmark_data, benchmark_payload_size);
+            benchmark_packet_sent(benchmark_payload_size);
+            rfcomm_request_can_send_now_event(benchmark_cid);
+            break;
+        default:
+            break;
+    }
+}
+
+// A2DP
+
+static void a2dp_media_handler(uint8_t local_seid, uint8_t * packet, uint16_t size){
+    UNUSED(local_seid);
+    UNUSED(packet);
+    // media packet includes RTP header
+    if (size < BENCHMARK_RTP_HEADER_SIZE) return;
+    benchmark_packet_received(size - BENCHMARK_RTP_HEADER_SIZE);
+}
+
+static void a2dp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_A2DP_META) return;
+    switch (hci_event_a2dp_meta_get_subevent_code(packet)){
+        case A2DP_SUBEVENT_STREAM_ESTABLISHED:
+            if (a2dp_subevent_stream_established_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            if (benchmark_sender == false) break;
+            benchmark_cid = a2dp_subevent_stream_established_get_a2dp_cid(packet);
+            benchmark_local_seid = a2dp_subevent_stream_established_get_local_seid(packet);
+            a2dp_source_start_stream(benchmark_cid, benchmark_local_seid);
+            break;
+        case A2DP_SUBEVENT_STREAM_STARTED:
+            if (benchmark_sender == false) break;
+            benchmark_payload_size = btstack_min(a2dp_max_media_payload_size(benchmark_cid, benchmark_local_seid), sizeof(benchmark_data));
+            a2dp_source_stream_endpoint_request_can_send_now(benchmark_cid, benchmark_local_seid);
+            break;
+        case A2DP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW:
+            if (benchmark_done) break;
+            a2dp_source_stream_send_media_payload_rtp(benchmark_cid, benchmark_local_seid, 0, benchmark_rtp_timestamp,
+                                                      benchmark_data, benchmark_payload_size);
+            benchmark_rtp_timestamp += 128;
+            benchmark_packet_sent(benchmark_payload_size);
+            a2dp_source_stream_endpoint_request_can_send_now(benchmark_cid, benchmark_local_seid);
+            break;
+        default:
+            break;
+    }
+}
+
+// HCI
+
+static void benchmark_start_initiator(void){
+    switch (benchmark_type){
+        case BENCHMARK_GATT_NOTIFY:
+        case BENCHMARK_GATT_WRITE:
+        case BENCHMARK_L2CAP_CBM:
+            gap_connect(responder_addr, BD_ADDR_TYPE_LE_PUBLIC);
+            break;
+        case BENCHMARK_RFCOMM:
+            rfcomm_create_channel(&rfcomm_packet_handler, responder_addr, BENCHMARK_RFCOMM_CHANNEL, &benchmark_cid);
+            break;
+        case BENCHMARK_A2DP:
+            a2dp_source_establish_stream(responder_addr, &benchmark_cid);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_le_connected(void){
+    if (benchmark_initiator == false) return;
+    switch (benchmark_type){
+        case BENCHMARK_GATT_NOTIFY:
+            gatt_client_listen_for_characteristic_value_updates(&gatt_notification_listener, &gatt_client_packet_handler, benchmark_con_handle, NULL);
+            gatt_client_send_mtu_negotiation(&gatt_client_packet_handler, benchmark_con_handle);
+            break;
+        case BENCHMARK_GATT_WRITE:
+            gatt_client_send_mtu_negotiation(&gatt_client_packet_handler, benchmark_con_handle);
+            break;
+        case BENCHMARK_L2CAP_CBM:
+            l2cap_cbm_create_channel(&l2cap_packet_handler, benchmark_con_handle, BENCHMARK_L2CAP_PSM, l2cap_receive_buffer,
+                                     sizeof(l2cap_receive_buffer), L2CAP_LE_AUTOMATIC_CREDITS, LEVEL_0, &benchmark_cid);
+            break;
+        default:
+            break;
+    }
+}
+
+static void hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
+            if (benchmark_initiator){
+                benchmark_start_initiator();
+            }
+            break;
+        case HCI_EVENT_CONNECTION_COMPLETE:
+            if (hci_event_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            benchmark_con_handle = hci_event_connection_complete_get_connection_handle(packet);
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            benchmark_con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+            benchmark_le_connected();
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            btstack_run_loop_trigger_exit();
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_setup(void){
+    switch (benchmark_type){
+        case BENCHMARK_GATT_NOTIFY:
+        case BENCHMARK_GATT_WRITE:
+            sm_init();
+            if (benchmark_initiator){
+                gatt_client_init();
+                // explicit MTU exchange reports GATT_EVENT_MTU to benchmark handler
+                gatt_client_mtu_enable_auto_negotiation(0);
+            } else {
+                att_server_init(profile_data, NULL, &att_write_callback);
+                att_server_register_packet_handler(&att_packet_handler);
+            }
+            break;
+        case BENCHMARK_L2CAP_CBM:
+            sm_init();
+            if (benchmark_initiator == false){
+                l2cap_cbm_register_service(&l2cap_packet_handler, BENCHMARK_L2CAP_PSM, LEVEL_0);
+            }
+            break;
+        case BENCHMARK_RFCOMM:
+            rfcomm_init();
+            if (benchmark_initiator == false){
+                rfcomm_register_service(&rfcomm_packet_handler, BENCHMARK_RFCOMM_CHANNEL, 0xffff);
+            }
+            break;
+        case BENCHMARK_A2DP:
+            sdp_init();
+            if (benchmark_initiator){
+                a2dp_source_init();
+                a2dp_source_register_packet_handler(&a2dp_packet_handler);
+                a2dp_source_create_stream_endpoint(AVDTP_AUDIO, AVDTP_CODEC_SBC, media_sbc_codec_capabilities, sizeof(media_sbc_codec_capabilities),
+                                                   media_sbc_codec_configuration, sizeof(media_sbc_codec_configuration));
+            } else {
+                a2dp_sink_init();
+                a2dp_sink_register_packet_handler(&a2dp_packet_handler);
+                a2dp_sink_register_media_handler(&a2dp_media_handler);
+                a2dp_sink_create_stream_endpoint(AVDTP_AUDIO, AVDTP_CODEC_SBC, media_sbc_codec_capabilities, sizeof(media_sbc_codec_capabilities),
+                                                 media_sbc_codec_configuration, sizeof(media_sbc_codec_configuration));
+                a2dp_sink_create_sdp_record(sdp_service_buffer, 0x10001, AVDTP_SINK_FEATURE_MASK_HEADPHONE, NULL, NULL);
+                sdp_register_service(sdp_service_buffer);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (benchmark_initiator) return;
+    switch (benchmark_type){
+        case BENCHMARK_RFCOMM:
+        case BENCHMARK_A2DP:
+            gap_connectable_control(1);
+            break;
+        default:
+            {
+                bd_addr_t null_addr;
+                memset(null_addr, 0, sizeof(null_addr));
+                gap_advertisements_set_params(0x0030, 0x0030, 0, 0, null_addr, 0x07, 0x00);
+                gap_advertisements_enable(1);
+            }
+            break;
+    }
+}
+
+static bool benchmark_process(benchmark_type_t type, bool initiator, int link_fd){
+    benchmark_type = type;
+    benchmark_initiator = initiator;
+    benchmark_sender = (type == BENCHMARK_GATT_NOTIFY) ? !initiator : initiator;
+
+    memcpy(transport_config.bd_addr, initiator ? initiator_addr : responder_addr, 6);
+    transport_config.link_fd = link_fd;
+    transport_config.seed = initiator ? 1 : 2;
+
+    if (benchmark_packet_log){
+        hci_dump_init(hci_dump_posix_stdout_get_instance());
+    }
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    hci_init(hci_transport_virtual_instance(), &transport_config);
+    gap_set_security_level(LEVEL_0);
+
+    hci_event_callback_registration.callback = &hci_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    l2cap_init();
+    benchmark_setup();
+
+    btstack_run_loop_set_timer_handler(&benchmark_timeout, &benchmark_timeout_handler);
+    btstack_run_loop_set_timer(&benchmark_timeout, BENCHMARK_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&benchmark_timeout);
+
+    hci_power_control(HCI_POWER_ON);
+    btstack_run_loop_execute();
+
+    benchmark_report();
+    fflush(stdout);
+    return benchmark_done;
+}
+
+static pid_t benchmark_fork(benchmark_type_t type, bool initiator, int link_fd, int other_fd){
+    pid_t pid = fork();
+    if (pid == 0){
+        close(other_fd);
+        bool ok = benchmark_process(type, initiator, link_fd);
+        exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    return pid;
+}
+
+// BTstack keeps its state in globals, each side runs in a fresh process
+static bool benchmark_run(benchmark_type_t type){
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0){
+        perror("socketpair");
+        return false;
+    }
+    fflush(stdout);
+    pid_t responder = benchmark_fork(type, false, fds[1], fds[0]);
+    pid_t initiator = benchmark_fork(type, true,  fds[0], fds[1]);
+    close(fds[0]);
+    close(fds[1]);
+    if ((responder < 0) || (initiator < 0)){
+        perror("fork");
+        return false;
+    }
+    bool ok = true;
+    pid_t pids[2] = { responder, initiator };
+    int i;
+    for (i = 0; i < 2; i++){
+        int status = 0;
+        waitpid(pids[i], &status, 0);
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)){
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [options] [benchmark...]\n", name);
+    printf("Benchmarks: gatt_notify gatt_write l2cap_cbm rfcomm a2dp (default: all)\n");
+    printf("-n packets     number of packets per benchmark, default %" PRIu32 "\n", benchmark_num_packets);
+    printf("-b buffers     Controller ACL buffers, default %u\n", transport_config.num_acl_packets);
+    printf("-m size        Controller ACL payload size, default %u\n", transport_config.acl_data_packet_length);
+    printf("-l latency     Controller latency in ms, default %u\n", transport_config.latency_ms);
+    printf("-p per-mille   retransmission rate, default %u\n", transport_config.loss_per_mille);
+    printf("-d             log HCI packets to stdout\n");
+}
+
+int main(int argc, char * argv[]){
+    bool selected[BENCHMARK_COUNT];
+    bool any_selected = false;
+    memset(selected, 0, sizeof(selected));
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:m:l:p:dh")) != -1){
+        switch (opt){
+            case 'n':
+                benchmark_num_packets = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                transport_config.num_acl_packets = (uint8_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                transport_config.acl_data_packet_length = (uint16_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                transport_config.latency_ms = (uint16_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                transport_config.loss_per_mille = (uint16_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                benchmark_packet_log = true;
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    for (int i = optind; i < argc; i++){
+        int type;
+        for (type = 0; type < BENCHMARK_COUNT; type++){
+            if (strcmp(argv[i], benchmark_names[type]) == 0) break;
+        }
+        if (type == BENCHMARK_COUNT){
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        selected[type] = true;
+        any_selected = true;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    memset(benchmark_data, 0x55, sizeof(benchmark_data));
+
+    bool ok = true;
+    int type;
+    for (type = 0; type < BENCHMARK_COUNT; type++){
+        if (any_selected && !selected[type]) continue;
+        ok = benchmark_run((benchmark_type_t) type) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "btstack_crc.h"
+#include "btstack_util.h"
+#include "crc_reference.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t check_string[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+TEST_GROUP(CRC){
+    uint8_t data[1100];
+    void setup(void){
+        srand(1);
+        uint16_t i;
+        for (i = 0; i < sizeof(data); i++){
+            data[i] = (uint8_t) rand();
+        }
+    }
+};
+
+TEST(CRC, L2CAPCheckValue){
+    // CRC-16/ARC
+    CHECK_EQUAL(0xbb3d, btstack_crc16_l2cap_calc(check_string, sizeof(check_string)));
+}
+
+TEST(CRC, H5CheckValue){
+    // CRC-16/MCRF4XX 0x6f91, bit reversed
+    CHECK_EQUAL(0x89f6, btstack_crc16_h5_calc(check_string, sizeof(check_string)));
+}
+
+TEST(CRC, EmptyInput){
+    CHECK_EQUAL(0x0000, btstack_crc16_l2cap_calc(data, 0));
+    CHECK_EQUAL(0x1234, btstack_crc16_l2cap_update(0x1234, data, 0));
+    CHECK_EQUAL(crc_reference_h5_calc(data, 0), btstack_crc16_h5_calc(data, 0));
+}
+
+TEST(CRC, L2CAPMatchesPreviousImplementation){
+    uint16_t len;
+    for (len = 0; len <= 64; len++){
+        CHECK_EQUAL(crc_reference_l2cap_calc(data, len), btstack_crc16_l2cap_calc(data, len));
+        // unaligned start
+        CHECK_EQUAL(crc_reference_l2cap_calc(&data[3], len), btstack_crc16_l2cap_calc(&data[3], len));
+    }
+    for (len = 64; len <= sizeof(data); len += 37){
+        CHECK_EQUAL(crc_reference_l2cap_calc(data, len), btstack_crc16_l2cap_calc(data, len));
+    }
+}
+
+TEST(CRC, H5MatchesPreviousImplementation){
+    uint16_t len;
+    for (len = 0; len <= 64; len++){
+        CHECK_EQUAL(crc_reference_h5_calc(data, len), btstack_crc16_h5_calc(data, len));
+        // unaligned start
+        CHECK_EQUAL(crc_reference_h5_calc(&data[5], len), btstack_crc16_h5_calc(&data[5], len));
+    }
+    for (len = 64; len <= sizeof(data); len += 37){
+        CHECK_EQUAL(crc_reference_h5_calc(data, len), btstack_crc16_h5_calc(data, len));
+    }
+}
+
+TEST(CRC, L2CAPIncremental){
+    uint16_t expected = crc_reference_l2cap_calc(data, 300);
+    uint16_t split;
+    for (split = 0; split <= 300; split += 7){
+        uint16_t crc = btstack_crc16_l2cap_update(BTSTACK_CRC16_L2CAP_INIT, data, split);
+        crc = btstack_crc16_l2cap_update(crc, &data[split], 300 - split);
+        CHECK_EQUAL(expected, crc);
+    }
+}
+
+TEST(CRC, H5Incremental){
+    uint16_t expected = crc_reference_h5_calc(data, 300);
+    uint16_t split;
+    for (split = 0; split <= 300; split += 7){
+        uint16_t crc = btstack_crc16_h5_update(BTSTACK_CRC16_H5_INIT, data, split);
+        crc = btstack_crc16_h5_update(crc, &data[split], 300 - split);
+        CHECK_EQUAL(expected, btstack_crc16_h5_finalize(crc));
+    }
+}
+
+TEST(CRC, L2CAPFrameVerifies){
+    // FCS examples from Bluetooth Core Specification, Vol 3, Part A, 3.3.5, FCS stored little endian after frame
+    // I-frame: length 14, CID 0x0040, TxSeq 1, ReqSeq 0, payload 00..09
+    const uint8_t i_frame[] = {
+        0x0e, 0x00, 0x40, 0x00, 0x02, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x38, 0x61
+    };
+    // S-frame: length 4, CID 0x0040, RR with ReqSeq 1
+    const uint8_t s_frame[] = { 0x04, 0x00, 0x40, 0x00, 0x01, 0x01, 0xd4, 0x14 };
+
+    CHECK_EQUAL(0x6138, btstack_crc16_l2cap_calc(i_frame, sizeof(i_frame) - 2));
+    CHECK_EQUAL(little_endian_read_16(i_frame, sizeof(i_frame) - 2), btstack_crc16_l2cap_calc(i_frame, sizeof(i_frame) - 2));
+    CHECK_EQUAL(0x14d4, btstack_crc16_l2cap_calc(s_frame, sizeof(s_frame) - 2));
+    CHECK_EQUAL(little_endian_read_16(s_frame, sizeof(s_frame) - 2), btstack_crc16_l2cap_calc(s_frame, sizeof(s_frame) - 2));
+    CHECK_EQUAL(0x6138, crc_reference_l2cap_calc(i_frame, sizeof(i_frame) - 2));
+
+    // single bit error is detected
+    uint8_t corrupted[sizeof(i_frame)];
+    memcpy(corrupted, i_frame, sizeof(i_frame));
+    corrupted[10] ^= 0x01;
+    CHECK(little_endian_read_16(corrupted, sizeof(corrupted) - 2) != btstack_crc16_l2cap_calc(corrupted, sizeof(corrupted) - 2));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure MB/sec for L2CAP ERTM FCS and H5 DIC over typical frame sizes
+// - previous byte-wise implementations (crc_reference.c)
+// - btstack_crc, with byte tables or slice-by-8 (ENABLE_CRC_SLICE_BY_8) depending on build
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "btstack_crc.h"
+#include "crc_reference.h"
+
+#define NUM_BYTES 200000000u
+
+typedef uint16_t (*crc_function_t)(const uint8_t * data, uint16_t len);
+
+static uint8_t data[1024];
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void verify(void){
+    uint16_t len;
+    for (len = 0; len <= sizeof(data); len++){
+        if (btstack_crc16_l2cap_calc(data, len) != crc_reference_l2cap_calc(data, len)){
+            printf("L2CAP FCS mismatch for len %u\n", len);
+            exit(10);
+        }
+        if (btstack_crc16_h5_calc(data, len) != crc_reference_h5_calc(data, len)){
+            printf("H5 DIC mismatch for len %u\n", len);
+            exit(10);
+        }
+    }
+}
+
+static void benchmark(const char * name, crc_function_t crc_function, uint16_t frame_len){
+    uint32_t num_frames = NUM_BYTES / frame_len;
+    uint16_t crc = 0;
+    uint32_t i;
+    double start = time_seconds();
+    for (i = 0; i < num_frames; i++){
+        data[0] = (uint8_t) crc;
+        crc = (*crc_function)(data, frame_len);
+    }
+    double duration = time_seconds() - start;
+    double bytes = (double) num_frames * frame_len;
+    printf("%-16s %4u bytes %8.1f MB/sec %6.2f ns/byte, last %04x\n", name, frame_len,
+           bytes / duration / 1000000.0, duration * 1000000000.0 / bytes, crc);
+}
+
+int main(int argc, const char * argv[]){
+    (void) argc;
+    (void) argv;
+
+    uint16_t i;
+    srand(0);
+    for (i = 0; i < sizeof(data); i++){
+        data[i] = (uint8_t) rand();
+    }
+    verify();
+
+#ifdef ENABLE_CRC_SLICE_BY_8
+    printf("btstack_crc: slice-by-8\n");
+#else
+    printf("btstack_crc: byte tables\n");
+#endif
+
+    // S-Frame, I-Frame with default MPS, and max I-Frame for 3-DH5
+    static const uint16_t l2cap_frame_sizes[] = { 6, 48, 1021 };
+    // H5 header with HCI Event, ACL packet with 3-DH5 payload
+    static const uint16_t h5_frame_sizes[] = { 20, 1025 };
+
+    for (i = 0; i < sizeof(l2cap_frame_sizes) / sizeof(uint16_t); i++){
+        benchmark("l2cap reference", &crc_reference_l2cap_calc, l2cap_frame_sizes[i]);
+        benchmark("l2cap btstack", &btstack_crc16_l2cap_calc, l2cap_frame_sizes[i]);
+    }
+    for (i = 0; i < sizeof(h5_frame_sizes) / sizeof(uint16_t); i++){
+        benchmark("h5 reference", &crc_reference_h5_calc, h5_frame_sizes[i]);
+        benchmark("h5 btstack", &btstack_crc16_h5_calc, h5_frame_sizes[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure AES128 blocks/sec for
+// - rijndael with key setup for each block (btstack_aes128_calc before btstack_aes128)
+// - rijndael with expanded key
+// - btstack_aes128, using AES instructions if available, with and without key setup for each block
+// and AES-CMAC over a 384 byte message (e.g. Mesh segmented message) via btstack_crypto
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_aes128.h"
+#include "btstack_crypto.h"
+#include "btstack_util.h"
+#include "rijndael.h"
+
+#define NUM_BLOCKS 4000000
+#define NUM_CMAC   100000
+#define CMAC_MESSAGE_LEN 384
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void report(const char * name, uint32_t count, double duration, const uint8_t * result){
+    printf("%-28s %12.0f blocks/sec, last %02x%02x%02x%02x\n", name, count / duration, result[0], result[1], result[2], result[3]);
+}
+
+static void verify(void){
+    // FIPS-197, Appendix C.1
+    static const uint8_t key[16]       = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const uint8_t plaintext[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    static const uint8_t expected[16]  = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+    btstack_aes128_t context;
+    uint8_t ciphertext[16];
+    btstack_aes128_init(&context, key);
+    btstack_aes128_encrypt_block(&context, plaintext, ciphertext);
+    if (memcmp(ciphertext, expected, 16) != 0){
+        printf("FIPS-197 test vector failed\n");
+        exit(10);
+    }
+
+    // compare with rijndael for random keys and data
+    uint32_t rk[RKLENGTH(KEYBITS)];
+    uint8_t random_key[16];
+    uint8_t random_plaintext[16];
+    uint8_t reference[16];
+    int i;
+    srand(0);
+    for (i = 0; i < 10000; i++){
+        int j;
+        for (j = 0; j < 16; j++){
+            random_key[j] = (uint8_t) rand();
+            random_plaintext[j] = (uint8_t) rand();
+        }
+        int nrounds = rijndaelSetupEncrypt(rk, random_key, KEYBITS);
+        rijndaelEncrypt(rk, nrounds, random_plaintext, reference);
+        btstack_aes128_init(&context, random_key);
+        btstack_aes128_encrypt_block(&context, random_plaintext, ciphertext);
+        if (memcmp(ciphertext, reference, 16) != 0){
+            printf("Mismatch with rijndael for iteration %u\n", i);
+            exit(10);
+        }
+    }
+}
+
+static void benchmark_blocks(void){
+    static const uint8_t key[16] = { 0x63, 0x96, 0x47, 0x71, 0x73, 0x4f, 0xbd, 0x76, 0xe3, 0xb4, 0x05, 0x19, 0xd1, 0xd9, 0x4a, 0x48 };
+    uint8_t block[16];
+    uint32_t rk[RKLENGTH(KEYBITS)];
+    uint32_t i;
+    double start;
+
+    memset(block, 0, sizeof(block));
+    start = time_seconds();
+    for (i = 0; i < NUM_BLOCKS; i++){
+        int nrounds = rijndaelSetupEncrypt(rk, key, KEYBITS);
+        rijndaelEncrypt(rk, nrounds, block, block);
+    }
+    report("rijndael, key setup", NUM_BLOCKS, time_seconds() - start, block);
+
+    memset(block, 0, sizeof(block));
+    start = time_seconds();
+    int nrounds = rijndaelSetupEncrypt(rk, key, KEYBITS);
+    for (i = 0; i < NUM_BLOCKS; i++){
+        rijndaelEncrypt(rk, nrounds, block, block);
+    }
+    report("rijndael, expanded key", NUM_BLOCKS, time_seconds() - start, block);
+
+    btstack_aes128_t context;
+    memset(block, 0, sizeof(block));
+    start = time_seconds();
+    btstack_aes128_init(&context, key);
+    for (i = 0; i < NUM_BLOCKS; i++){
+        btstack_aes128_encrypt_block(&context, block, block);
+    }
+    report("btstack_aes128", NUM_BLOCKS, time_seconds() - start, block);
+
+    // e.g. resolvable private address lookup with one IRK per bonded device
+    memset(block, 0, sizeof(block));
+    start = time_seconds();
+    for (i = 0; i < NUM_BLOCKS; i++){
+        btstack_aes128_init(&context, key);
+        btstack_aes128_encrypt_block(&context, block, block);
+    }
+    report("btstack_aes128, key setup", NUM_BLOCKS, time_seconds() - start, block);
+}
+
+static void cmac_done(void * arg){
+    UNUSED(arg);
+}
+
+static void benchmark_cmac(void){
+    static const uint8_t key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    static uint8_t message[CMAC_MESSAGE_LEN];
+    uint8_t hash[16];
+    btstack_crypto_aes128_cmac_t request;
+    uint32_t i;
+
+    btstack_crypto_init();
+    double start = time_seconds();
+    for (i = 0; i < NUM_CMAC; i++){
+        message[0] = (uint8_t) i;
+        btstack_crypto_aes128_cmac_message(&request, key, sizeof(message), message, hash, &cmac_done, NULL);
+    }
+    double duration = time_seconds() - start;
+    printf("%-28s %12.0f messages/sec (%u bytes), last %02x%02x%02x%02x\n", "btstack_crypto cmac", NUM_CMAC / duration,
+           CMAC_MESSAGE_LEN, hash[0], hash[1], hash[2], hash[3]);
+}
+
+int main(void){
+    verify();
+    printf("AES instructions: %s\n", btstack_aes128_hardware_accelerated() ? "yes" : "no");
+    benchmark_blocks();
+    benchmark_cmac();
+    return 0;
+}
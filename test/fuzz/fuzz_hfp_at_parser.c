@@ -1,20 +1,42 @@
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
 
 #include "classic/hfp.h"
 
+static hfp_connection_t hfp_connection_bytewise;
+static hfp_connection_t hfp_connection_buffer;
+
 int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
-    // test ad iterator by calling simple function that uses it
+    // hfp_parse_buffer uses uint16_t length
     if (size < 1) return 0;
+    if (size > 65535) return 0;
 
+    // first byte: bit 0 = role, bits 1..7 = chunk size for buffer parser
     int is_handsfree = data[0] & 1;
-    hfp_connection_t hfp_connection;
-    memset(&hfp_connection, 0, sizeof(hfp_connection_t));
+    uint16_t chunk_size = (data[0] >> 1) + 1;
+    memset(&hfp_connection_bytewise, 0, sizeof(hfp_connection_t));
+    memset(&hfp_connection_buffer,   0, sizeof(hfp_connection_t));
 
     uint32_t i;
     for (i = 1; i < size; i++){
-        hfp_parse(&hfp_connection, data[i], is_handsfree);
+        hfp_parse(&hfp_connection_bytewise, data[i], is_handsfree);
+    }
+
+    // parse in chunks, buffer parser returns after each end of line
+    uint16_t pos = 1;
+    while (pos < size){
+        uint16_t len = btstack_min(chunk_size, (uint16_t) (size - pos));
+        uint16_t chunk_end = pos + len;
+        while (pos < chunk_end){
+            pos += hfp_parse_buffer(&hfp_connection_buffer, &data[pos], chunk_end - pos, is_handsfree);
+        }
     }
- 
+
+    // both parsers have to end in the same state
+    if (memcmp(&hfp_connection_bytewise, &hfp_connection_buffer, sizeof(hfp_connection_t)) != 0){
+        abort();
+    }
+
     return 0;
 }
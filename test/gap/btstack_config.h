@@ -15,6 +15,7 @@
 #define ENABLE_BLE
 #define ENABLE_LE_CENTRAL
 #define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_SCAN_FILTER
 #define ENABLE_LE_SIGNED_WRITE
 #define ENABLE_LOG_ERROR
 #define ENABLE_LOG_INFO
@@ -0,0 +1,407 @@
+// tests for ENABLE_HCI_ACL_TX_QUEUE with synchronous and asynchronous HCI transport
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "hci.h"
+#include "btstack_event.h"
+#include "btstack_debug.h"
+#include "btstack_util.h"
+#include "btstack_run_loop_posix.h"
+
+#ifndef ENABLE_HCI_ACL_TX_QUEUE
+#error "ENABLE_HCI_ACL_TX_QUEUE required"
+#endif
+
+// test connections from hci_setup_test_connections_fuzz
+#define CLASSIC_HANDLE 0x0003
+#define LE_HANDLE      0x0005
+
+// LE controller buffers, set via HCI_LE_Read_Buffer_Size
+#define LE_ACL_LEN     27
+#define LE_ACL_NUM     2
+
+typedef struct {
+    uint8_t  type;
+    uint16_t size;
+    uint8_t  buffer[HCI_ACL_PAYLOAD_SIZE + 4];
+} hci_packet_t;
+
+#define MAX_HCI_PACKETS 20
+static uint16_t transport_count_packets;
+static hci_packet_t transport_packets[MAX_HCI_PACKETS];
+
+// packets accepted by asynchronous transport without HCI_EVENT_TRANSPORT_PACKET_SENT yet
+static uint16_t transport_packets_in_flight;
+// 1: single packet like H4, more: copying transport like libusb, 0: transport blocked
+static uint16_t transport_max_packets_in_flight;
+
+static uint16_t count_packet_sent_events;
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+
+static int hci_transport_test_can_send_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return (transport_packets_in_flight < transport_max_packets_in_flight) ? 1 : 0;
+}
+
+static int hci_transport_test_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    btstack_assert(transport_count_packets < MAX_HCI_PACKETS);
+    memcpy(transport_packets[transport_count_packets].buffer, packet, size);
+    transport_packets[transport_count_packets].type = packet_type;
+    transport_packets[transport_count_packets].size = (uint16_t) size;
+    transport_count_packets++;
+    transport_packets_in_flight++;
+    return 0;
+}
+
+static void hci_transport_test_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static void hci_transport_test_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int hci_transport_test_open(void){
+    return 0;
+}
+
+static int hci_transport_test_close(void){
+    return 0;
+}
+
+static int hci_transport_test_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+static const hci_transport_t hci_transport_async = {
+        /* const char * name; */                                        "ASYNC",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_test_init,
+        /* int    (*open)(void); */                                     &hci_transport_test_open,
+        /* int    (*close)(void); */                                    &hci_transport_test_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_test_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_test_can_send_now,
+        /* int    (*send_packet)(...); */                               &hci_transport_test_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_test_set_baudrate,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+// synchronous transport: no can_send_packet_now, no HCI_EVENT_TRANSPORT_PACKET_SENT
+static const hci_transport_t hci_transport_sync = {
+        /* const char * name; */                                        "SYNC",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_test_init,
+        /* int    (*open)(void); */                                     &hci_transport_test_open,
+        /* int    (*close)(void); */                                    &hci_transport_test_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_test_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+        /* int    (*send_packet)(...); */                               &hci_transport_test_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_test_set_baudrate,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+static void event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) == HCI_EVENT_TRANSPORT_PACKET_SENT){
+        count_packet_sent_events++;
+    }
+}
+
+// asynchronous transport reports oldest packet as sent
+static void transport_complete_packet(void){
+    btstack_assert(transport_packets_in_flight > 0);
+    transport_packets_in_flight--;
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+}
+
+static void controller_set_le_buffers(uint16_t acl_len, uint8_t acl_num){
+    uint8_t event[] = { HCI_EVENT_COMMAND_COMPLETE, 7, 1, 0x02, 0x20, 0, 0, 0, 0};
+    little_endian_store_16(event, 6, acl_len);
+    event[8] = acl_num;
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void controller_completed_packets(hci_con_handle_t con_handle, uint16_t num_packets){
+    uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5, 1, 0, 0, 0, 0};
+    little_endian_store_16(event, 3, con_handle);
+    little_endian_store_16(event, 5, num_packets);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void controller_disconnect(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, 0, 0, 0x13};
+    little_endian_store_16(event, 3, con_handle);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// send ACL packet with payload_len bytes, payload[i] = tag + i
+static uint8_t send_acl_packet(hci_con_handle_t con_handle, uint16_t payload_len, uint8_t tag){
+    CHECK_TRUE(hci_can_send_acl_packet_now(con_handle));
+    CHECK_TRUE(hci_reserve_packet_buffer());
+    uint8_t * buffer = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(buffer, 0, con_handle | (0x02 << 12));
+    little_endian_store_16(buffer, 2, payload_len);
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        buffer[4 + i] = (uint8_t) (tag + i);
+    }
+    return hci_send_acl_packet_buffer(4 + payload_len);
+}
+
+static void check_acl_packet(uint16_t index, hci_con_handle_t con_handle, uint8_t boundary_flag, uint16_t payload_len, uint8_t first_byte){
+    CHECK_TRUE(index < transport_count_packets);
+    const hci_packet_t * packet = &transport_packets[index];
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, packet->type);
+    CHECK_EQUAL(4 + payload_len, packet->size);
+    uint16_t handle_and_flags = little_endian_read_16(packet->buffer, 0);
+    CHECK_EQUAL(con_handle, handle_and_flags & 0x0fff);
+    CHECK_EQUAL(boundary_flag, (handle_and_flags >> 12) & 0x03);
+    CHECK_EQUAL(payload_len, little_endian_read_16(packet->buffer, 2));
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        CHECK_EQUAL((uint8_t) (first_byte + i), packet->buffer[4 + i]);
+    }
+}
+
+static void hci_setup(const hci_transport_t * transport){
+    transport_count_packets = 0;
+    transport_packets_in_flight = 0;
+    transport_max_packets_in_flight = 4;
+    count_packet_sent_events = 0;
+    hci_init(transport, NULL);
+    hci_simulate_working_fuzz();
+    hci_setup_test_connections_fuzz();
+    hci_event_callback_registration.callback = &event_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+    controller_set_le_buffers(LE_ACL_LEN, LE_ACL_NUM);
+    count_packet_sent_events = 0;
+}
+
+TEST_GROUP(HCI_ACL_TX_QUEUE_ASYNC){
+    void setup(void){
+        hci_setup(&hci_transport_async);
+    }
+    void teardown(void){
+        hci_remove_event_handler(&hci_event_callback_registration);
+        hci_free_connections_fuzz();
+    }
+};
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, SinglePacketSingleEvent){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    CHECK_EQUAL(1, transport_count_packets);
+    check_acl_packet(0, CLASSIC_HANDLE, 0x02, 10, 0x10);
+    // packet buffer available again, but only transport reports packet sent
+    CHECK_TRUE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    CHECK_EQUAL(0, count_packet_sent_events);
+    transport_complete_packet();
+    CHECK_EQUAL(1, count_packet_sent_events);
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, Pipelining){
+    // transport accepts further packets before the first one is reported as sent
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x20));
+    CHECK_EQUAL(2, transport_count_packets);
+    CHECK_EQUAL(0, count_packet_sent_events);
+    check_acl_packet(0, CLASSIC_HANDLE, 0x02, 10, 0x10);
+    check_acl_packet(1, CLASSIC_HANDLE, 0x02, 10, 0x20);
+    transport_complete_packet();
+    transport_complete_packet();
+    CHECK_EQUAL(2, count_packet_sent_events);
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, MaxPacketsInFlight){
+    uint16_t i;
+    for (i = 0; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, (uint8_t) (i * 0x10)));
+    }
+    CHECK_EQUAL(HCI_ACL_TX_QUEUE_MAX_PACKETS_IN_FLIGHT, transport_count_packets);
+    // all buffers in use, packet buffer stays reserved
+    CHECK_FALSE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    // completion of oldest packet frees its buffer and lets next queued packet go
+    transport_complete_packet();
+    CHECK_TRUE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    CHECK_EQUAL(1, count_packet_sent_events);
+    while (transport_packets_in_flight > 0){
+        transport_complete_packet();
+    }
+    CHECK_EQUAL(HCI_ACL_TX_QUEUE_NUM_BUFFERS, transport_count_packets);
+    for (i = 0; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        check_acl_packet(i, CLASSIC_HANDLE, 0x02, 10, (uint8_t) (i * 0x10));
+    }
+    CHECK_EQUAL(HCI_ACL_TX_QUEUE_NUM_BUFFERS, count_packet_sent_events);
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, QueueWhileTransportBusy){
+    transport_max_packets_in_flight = 1;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x20));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x30));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x40));
+    CHECK_EQUAL(1, transport_count_packets);
+    CHECK_EQUAL(0, count_packet_sent_events);
+    CHECK_FALSE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    // round-robin: LE connection is served before second Classic packet
+    while (transport_packets_in_flight > 0){
+        transport_complete_packet();
+    }
+    CHECK_EQUAL(4, transport_count_packets);
+    check_acl_packet(0, CLASSIC_HANDLE, 0x02, 10, 0x10);
+    check_acl_packet(1, LE_HANDLE,      0x02, 10, 0x40);
+    check_acl_packet(2, CLASSIC_HANDLE, 0x02, 10, 0x20);
+    check_acl_packet(3, CLASSIC_HANDLE, 0x02, 10, 0x30);
+    // one event per packet sent by transport
+    CHECK_EQUAL(4, count_packet_sent_events);
+    CHECK_TRUE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, Credits){
+    // first fragment is accounted when queued
+    transport_max_packets_in_flight = 0;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x10));
+    CHECK_EQUAL(1, hci_number_free_acl_slots_for_handle(LE_HANDLE));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x20));
+    CHECK_EQUAL(0, hci_number_free_acl_slots_for_handle(LE_HANDLE));
+    CHECK_FALSE(hci_can_send_acl_packet_now(LE_HANDLE));
+    // Classic buffers are not affected
+    CHECK_TRUE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    CHECK_EQUAL(0, transport_count_packets);
+    // controller buffers are freed by Number Of Completed Packets only
+    transport_max_packets_in_flight = 4;
+    controller_completed_packets(CLASSIC_HANDLE, 0);
+    CHECK_EQUAL(2, transport_count_packets);
+    transport_complete_packet();
+    transport_complete_packet();
+    CHECK_FALSE(hci_can_send_acl_packet_now(LE_HANDLE));
+    controller_completed_packets(LE_HANDLE, 2);
+    CHECK_EQUAL(LE_ACL_NUM, hci_number_free_acl_slots_for_handle(LE_HANDLE));
+    CHECK_TRUE(hci_can_send_acl_packet_now(LE_HANDLE));
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, FragmentsWaitForCredits){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 60, 0x00));
+    // 27 + 27 + 6, third fragment needs a free controller buffer
+    CHECK_EQUAL(2, transport_count_packets);
+    transport_complete_packet();
+    transport_complete_packet();
+    CHECK_EQUAL(2, transport_count_packets);
+    controller_completed_packets(LE_HANDLE, 1);
+    CHECK_EQUAL(3, transport_count_packets);
+    transport_complete_packet();
+    check_acl_packet(0, LE_HANDLE, 0x02, 27, 0);
+    check_acl_packet(1, LE_HANDLE, 0x01, 27, 27);
+    check_acl_packet(2, LE_HANDLE, 0x01,  6, 54);
+    CHECK_EQUAL(3, count_packet_sent_events);
+    CHECK_EQUAL(0, hci_number_free_acl_slots_for_handle(LE_HANDLE));
+}
+
+// all packet buffers can be queued while transport is blocked
+static void check_all_buffers_free(void){
+    uint16_t i;
+    uint16_t count_packets = transport_count_packets;
+    transport_max_packets_in_flight = 0;
+    for (i = 0; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x00));
+    }
+    CHECK_FALSE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    CHECK_EQUAL(count_packets, transport_count_packets);
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, DisconnectDropsQueuedPackets){
+    transport_max_packets_in_flight = 1;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x20));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x30));
+    CHECK_EQUAL(1, transport_count_packets);
+    controller_disconnect(LE_HANDLE);
+    CHECK_TRUE(hci_connection_for_handle(LE_HANDLE) == NULL);
+    transport_complete_packet();
+    CHECK_EQUAL(1, transport_count_packets);
+    CHECK_EQUAL(1, count_packet_sent_events);
+    check_all_buffers_free();
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, DisconnectWithAllBuffersQueued){
+    transport_max_packets_in_flight = 0;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x10));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 10, 0x20));
+    uint16_t i;
+    for (i = 2; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x30));
+    }
+    CHECK_FALSE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    // dropping queued packets releases packet buffer, no transport event will follow
+    controller_disconnect(LE_HANDLE);
+    CHECK_EQUAL(1, count_packet_sent_events);
+    CHECK_TRUE(hci_can_send_acl_packet_now(CLASSIC_HANDLE));
+    transport_max_packets_in_flight = 4;
+    controller_completed_packets(CLASSIC_HANDLE, 0);
+    CHECK_EQUAL(HCI_ACL_TX_QUEUE_NUM_BUFFERS - 2, transport_count_packets);
+}
+
+TEST(HCI_ACL_TX_QUEUE_ASYNC, DisconnectWhileInFlight){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 60, 0x00));
+    CHECK_EQUAL(2, transport_count_packets);
+    controller_disconnect(LE_HANDLE);
+    // buffer is freed after transport is done with it
+    transport_complete_packet();
+    transport_complete_packet();
+    CHECK_EQUAL(2, transport_count_packets);
+    CHECK_EQUAL(2, count_packet_sent_events);
+    check_all_buffers_free();
+}
+
+TEST_GROUP(HCI_ACL_TX_QUEUE_SYNC){
+    void setup(void){
+        hci_setup(&hci_transport_sync);
+    }
+    void teardown(void){
+        hci_remove_event_handler(&hci_event_callback_registration);
+        hci_free_connections_fuzz();
+    }
+};
+
+TEST(HCI_ACL_TX_QUEUE_SYNC, SinglePacketSingleEvent){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    CHECK_EQUAL(1, transport_count_packets);
+    check_acl_packet(0, CLASSIC_HANDLE, 0x02, 10, 0x10);
+    CHECK_EQUAL(1, count_packet_sent_events);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x20));
+    CHECK_EQUAL(2, transport_count_packets);
+    CHECK_EQUAL(2, count_packet_sent_events);
+}
+
+TEST(HCI_ACL_TX_QUEUE_SYNC, FragmentsWaitForCredits){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(LE_HANDLE, 60, 0x00));
+    CHECK_EQUAL(2, transport_count_packets);
+    CHECK_EQUAL(1, count_packet_sent_events);
+    // buffer stays queued until last fragment is sent
+    uint16_t i;
+    for (i = 1; i < HCI_ACL_TX_QUEUE_NUM_BUFFERS; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, send_acl_packet(CLASSIC_HANDLE, 10, 0x10));
+    }
+    controller_completed_packets(LE_HANDLE, 1);
+    CHECK_EQUAL(HCI_ACL_TX_QUEUE_NUM_BUFFERS + 2, transport_count_packets);
+    check_acl_packet(2 + HCI_ACL_TX_QUEUE_NUM_BUFFERS - 1, LE_HANDLE, 0x01, 6, 54);
+    CHECK_EQUAL(1 + HCI_ACL_TX_QUEUE_NUM_BUFFERS - 1, count_packet_sent_events);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
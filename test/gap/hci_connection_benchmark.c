@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure ACL packets/sec through hci.c for a varying number of LE connections
+// Each iteration delivers one incoming ACL packet, sends one outgoing ACL packet
+// and completes it with a Number Of Completed Packets event
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_memory.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+
+#define NUM_ITERATIONS 2000000
+#define ACL_PAYLOAD_LEN 27
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static uint32_t acl_packets_received;
+
+static void hci_transport_benchmark_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int hci_transport_benchmark_open(void){
+    return 0;
+}
+
+static int hci_transport_benchmark_close(void){
+    return 0;
+}
+
+static void hci_transport_benchmark_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static int hci_transport_benchmark_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    UNUSED(packet_type);
+    UNUSED(packet);
+    UNUSED(size);
+    return 0;
+}
+
+static int hci_transport_benchmark_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+// synchronous transport: can_send_packet_now == NULL
+static const hci_transport_t hci_transport_benchmark = {
+        /* const char * name; */                                        "BENCHMARK",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_benchmark_init,
+        /* int    (*open)(void); */                                     &hci_transport_benchmark_open,
+        /* int    (*close)(void); */                                    &hci_transport_benchmark_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_benchmark_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+        /* int    (*send_packet)(...); */                               &hci_transport_benchmark_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_benchmark_set_baudrate,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+static void acl_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(packet);
+    UNUSED(size);
+    acl_packets_received++;
+}
+
+static void inject_le_read_buffer_size_complete(void){
+    uint8_t event[] = { HCI_EVENT_COMMAND_COMPLETE, 7, 1, 0, 0, ERROR_CODE_SUCCESS, 251, 0, 8};
+    little_endian_store_16(event, 3, hci_le_read_buffer_size.opcode);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void inject_le_connection_complete(hci_con_handle_t con_handle){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = BD_ADDR_TYPE_LE_RANDOM;
+    bd_addr_t addr = { 0xc0, 0x11, 0x22, 0x33, 0x00, 0x00 };
+    big_endian_store_16(addr, 4, con_handle);
+    reverse_bd_addr(addr, &event[8]);
+    little_endian_store_16(event, 14, 40);
+    little_endian_store_16(event, 18, 500);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void inject_number_of_completed_packets(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5, 1, 0, 0, 1, 0};
+    little_endian_store_16(event, 3, con_handle);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void inject_acl_packet(hci_con_handle_t con_handle){
+    uint8_t packet[4 + 4 + ACL_PAYLOAD_LEN];
+    memset(packet, 0, sizeof(packet));
+    little_endian_store_16(packet, 0, con_handle | 0x2000);
+    little_endian_store_16(packet, 2, 4 + ACL_PAYLOAD_LEN);
+    little_endian_store_16(packet, 4, ACL_PAYLOAD_LEN);
+    little_endian_store_16(packet, 6, 0x0004);
+    packet_handler(HCI_ACL_DATA_PACKET, packet, sizeof(packet));
+}
+
+static void send_acl_packet(hci_con_handle_t con_handle){
+    hci_reserve_packet_buffer();
+    uint8_t * packet = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(packet, 0, con_handle | 0x2000);
+    little_endian_store_16(packet, 2, 4 + ACL_PAYLOAD_LEN);
+    little_endian_store_16(packet, 4, ACL_PAYLOAD_LEN);
+    little_endian_store_16(packet, 6, 0x0004);
+    memset(&packet[8], 0x55, ACL_PAYLOAD_LEN);
+    hci_send_acl_packet_buffer(4 + 4 + ACL_PAYLOAD_LEN);
+}
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void benchmark(uint16_t num_connections){
+    hci_init(&hci_transport_benchmark, NULL);
+    hci_register_acl_packet_handler(&acl_handler);
+    hci_simulate_working_fuzz();
+    inject_le_read_buffer_size_complete();
+
+    // controllers assign handles sequentially, start at 0x40 to include non-zero upper bits
+    uint16_t i;
+    for (i = 0; i < num_connections; i++){
+        inject_le_connection_complete(0x40 + i);
+    }
+
+    acl_packets_received = 0;
+    double start = time_seconds();
+    uint32_t iteration;
+    for (iteration = 0; iteration < NUM_ITERATIONS; iteration++){
+        hci_con_handle_t con_handle = 0x40 + (iteration % num_connections);
+        inject_acl_packet(con_handle);
+        send_acl_packet(con_handle);
+        inject_number_of_completed_packets(con_handle);
+    }
+    double duration = time_seconds() - start;
+
+    printf("%2u connections: %10.0f packets/sec (%u received)\n", num_connections,
+           (2.0 * NUM_ITERATIONS) / duration, acl_packets_received);
+
+    hci_free_connections_fuzz();
+}
+
+int main(void){
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    benchmark(1);
+    benchmark(8);
+    benchmark(32);
+    benchmark(64);
+    return 0;
+}
@@ -375,6 +375,21 @@ TEST(HCI, Disconnect){
     gap_disconnect(5);
 }
 
+TEST(HCI, ConnectionForHandle){
+    // test connections use handles 0x0001..0x0005
+    hci_connection_t * conn = hci_connection_for_handle(5);
+    CHECK(conn != NULL);
+    CHECK_EQUAL(5, conn->con_handle);
+    // second lookup served from lookup table
+    CHECK_EQUAL(conn, hci_connection_for_handle(5));
+    // same lookup table slot, but different handle
+    CHECK(hci_connection_for_handle(5 + HCI_CONNECTION_LOOKUP_TABLE_SIZE) == NULL);
+    CHECK(hci_connection_for_handle(HCI_CON_HANDLE_INVALID) == NULL);
+    // freed connections are removed from lookup table
+    hci_free_connections_fuzz();
+    CHECK(hci_connection_for_handle(5) == NULL);
+}
+
 TEST(HCI, GetRole){
     gap_get_role(HCI_CON_HANDLE_INVALID);
     gap_get_role(5);
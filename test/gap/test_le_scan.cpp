@@ -16,6 +16,8 @@
 #include "hci_dump.h"
 #include "hci_dump_posix_fs.h"
 #include "btstack_debug.h"
+#include "btstack_run_loop_posix.h"
+#include "bluetooth_data_types.h"
 
 typedef struct {
     uint8_t type;
@@ -132,7 +134,146 @@ TEST(GAP_LE, ScanStartParam){
     CHECK_HCI_COMMAND(&hci_le_set_scan_enable);
 }
 
+static uint16_t advertising_reports;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static void gap_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) == GAP_EVENT_ADVERTISING_REPORT){
+        advertising_reports++;
+    }
+}
+
+// HCI LE Advertising Report with single report
+static void simulate_advertising_report(uint8_t event_type, uint8_t addr_lsb, int8_t rssi, const uint8_t * data, uint8_t data_len){
+    uint8_t event[2 + 2 + 10 + 31];
+    uint16_t pos = 0;
+    event[pos++] = HCI_EVENT_LE_META;
+    event[pos++] = 2 + 10 + data_len;
+    event[pos++] = HCI_SUBEVENT_LE_ADVERTISING_REPORT;
+    event[pos++] = 1;
+    event[pos++] = event_type;
+    event[pos++] = BD_ADDR_TYPE_LE_RANDOM;
+    event[pos++] = addr_lsb;
+    memset(&event[pos], 0xc0, 5);
+    pos += 5;
+    event[pos++] = data_len;
+    memcpy(&event[pos], data, data_len);
+    pos += data_len;
+    event[pos++] = (uint8_t) rssi;
+    packet_handler(HCI_EVENT_PACKET, event, pos);
+}
+
+static const uint8_t adv_data_hrs[] = { 0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06, 0x03, BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, 0x0d, 0x18 };
+static const uint8_t adv_data_bas[] = { 0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06, 0x03, BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, 0x0f, 0x18 };
+static const uint8_t scan_response[] = { 0x05, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'T', 'E', 'S', 'T' };
+
+TEST_GROUP(GAP_LE_SCAN_FILTER){
+        void setup(void){
+            transport_count_packets = 0;
+            next_hci_packet = 0;
+            advertising_reports = 0;
+            hci_init(&hci_transport_test, NULL);
+            hci_event_callback_registration.callback = &gap_event_handler;
+            hci_add_event_handler(&hci_event_callback_registration);
+            hci_simulate_working_fuzz();
+            mock().expectOneCall("hci_can_send_packet_now_using_packet_buffer").andReturnValue(1);
+            gap_start_scan();
+        }
+        void teardown(void){
+            mock().clear();
+        }
+};
+
+TEST(GAP_LE_SCAN_FILTER, Disabled){
+    simulate_advertising_report(0, 1, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(0, 1, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    CHECK_EQUAL(2, advertising_reports);
+}
+
+TEST(GAP_LE_SCAN_FILTER, Duplicates){
+    gap_le_scan_filter_set_window(10000);
+    simulate_advertising_report(0, 1, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(0, 1, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(0, 2, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    // scan response is reported separately
+    simulate_advertising_report(4, 1, -40, scan_response, sizeof(scan_response));
+    simulate_advertising_report(4, 1, -40, scan_response, sizeof(scan_response));
+    // changed data is reported
+    simulate_advertising_report(0, 1, -40, adv_data_bas, sizeof(adv_data_bas));
+    CHECK_EQUAL(4, advertising_reports);
+    uint32_t num_forwarded;
+    uint32_t num_dropped;
+    gap_le_scan_filter_get_counters(&num_forwarded, &num_dropped);
+    CHECK_EQUAL(4, num_forwarded);
+    CHECK_EQUAL(2, num_dropped);
+    // scan start reports all devices again
+    gap_start_scan();
+    simulate_advertising_report(0, 1, -40, adv_data_bas, sizeof(adv_data_bas));
+    CHECK_EQUAL(5, advertising_reports);
+    gap_le_scan_filter_reset();
+    gap_le_scan_filter_get_counters(&num_forwarded, &num_dropped);
+    CHECK_EQUAL(0, num_forwarded);
+    CHECK_EQUAL(0, num_dropped);
+}
+
+TEST(GAP_LE_SCAN_FILTER, Eviction){
+    gap_le_scan_filter_set_window(10000);
+    uint16_t i;
+    for (i = 0; i <= MAX_NR_LE_SCAN_FILTER_ENTRIES; i++){
+        simulate_advertising_report(0, (uint8_t) i, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    }
+    CHECK_EQUAL(MAX_NR_LE_SCAN_FILTER_ENTRIES + 1, advertising_reports);
+    // most recent device is still tracked
+    simulate_advertising_report(0, MAX_NR_LE_SCAN_FILTER_ENTRIES, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    CHECK_EQUAL(MAX_NR_LE_SCAN_FILTER_ENTRIES + 1, advertising_reports);
+}
+
+TEST(GAP_LE_SCAN_FILTER, Rssi){
+    gap_le_scan_filter_set_rssi_threshold(-60);
+    simulate_advertising_report(0, 1, -70, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(0, 1, -50, adv_data_hrs, sizeof(adv_data_hrs));
+    // rssi not available
+    simulate_advertising_report(0, 1, 127, adv_data_hrs, sizeof(adv_data_hrs));
+    CHECK_EQUAL(2, advertising_reports);
+}
+
+TEST(GAP_LE_SCAN_FILTER, AdType){
+    gap_le_scan_filter_set_ad_type(BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME);
+    simulate_advertising_report(0, 1, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(3, 2, -40, scan_response, sizeof(scan_response));
+    CHECK_EQUAL(1, advertising_reports);
+}
+
+TEST(GAP_LE_SCAN_FILTER, Uuid16){
+    gap_le_scan_filter_set_uuid16(0x180d);
+    simulate_advertising_report(0, 1, -40, adv_data_bas, sizeof(adv_data_bas));
+    // scan response only reported after advertisement
+    simulate_advertising_report(4, 2, -40, scan_response, sizeof(scan_response));
+    simulate_advertising_report(0, 2, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    simulate_advertising_report(4, 2, -40, scan_response, sizeof(scan_response));
+    CHECK_EQUAL(2, advertising_reports);
+}
+
+TEST(GAP_LE_SCAN_FILTER, Uuid128){
+    // big endian
+    const uint8_t uuid128[] = { 0x6E, 0x40, 0x00, 0x01, 0xB5, 0xA3, 0xF3, 0x93, 0xE0, 0xA9, 0xE5, 0x0E, 0x24, 0xDC, 0xCA, 0x9E };
+    uint8_t adv_data_uuid128[2 + 16];
+    adv_data_uuid128[0] = 17;
+    adv_data_uuid128[1] = BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS;
+    reverse_128(uuid128, &adv_data_uuid128[2]);
+    gap_le_scan_filter_set_uuid128(uuid128);
+    simulate_advertising_report(0, 1, -40, adv_data_uuid128, sizeof(adv_data_uuid128));
+    simulate_advertising_report(0, 2, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    CHECK_EQUAL(1, advertising_reports);
+    gap_le_scan_filter_set_uuid128(NULL);
+    simulate_advertising_report(0, 2, -40, adv_data_hrs, sizeof(adv_data_hrs));
+    CHECK_EQUAL(2, advertising_reports);
+}
+
 int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+
     // log into file using HCI_DUMP_PACKETLOGGER format
     const char * pklg_path = "hci_dump.pklg";
     hci_dump_posix_fs_open(pklg_path, HCI_DUMP_PACKETLOGGER);
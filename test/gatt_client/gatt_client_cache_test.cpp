@@ -0,0 +1,218 @@
+// *****************************************************************************
+//
+// gatt client cache tests
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "hci.h"
+#include "btstack_event.h"
+#include "btstack_tlv.h"
+#include "ble/att_db.h"
+#include "ble/gatt_client.h"
+#include "ble/le_device_db.h"
+#include "mock_btstack_tlv.h"
+#include "profile_cache.h"
+
+extern "C" void hci_setup_le_connection(uint16_t con_handle);
+extern "C" void mock_simulate_disconnection_complete(uint16_t con_handle);
+extern "C" uint16_t mock_att_request_count(void);
+
+static const hci_con_handle_t gatt_client_handle = 0x40;
+static bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+static sm_key_t  remote_irk;
+
+static uint8_t  events[2000];
+static uint16_t events_len;
+static int      query_complete;
+static uint8_t  query_status;
+
+static gatt_client_service_t services[10];
+static int num_services;
+static gatt_client_characteristic_t characteristics[10];
+static int num_characteristics;
+
+static void handle_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(channel);
+    // log query results, MTU is only exchanged once
+    if ((hci_event_packet_get_type(packet) != GATT_EVENT_MTU) && ((events_len + size) <= sizeof(events))){
+        memcpy(&events[events_len], packet, size);
+        events_len += size;
+    }
+    switch (hci_event_packet_get_type(packet)){
+        case GATT_EVENT_SERVICE_QUERY_RESULT:
+            gatt_event_service_query_result_get_service(packet, &services[num_services++]);
+            break;
+        case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+            gatt_event_characteristic_query_result_get_characteristic(packet, &characteristics[num_characteristics++]);
+            break;
+        case GATT_EVENT_QUERY_COMPLETE:
+            query_complete = 1;
+            query_status = gatt_event_query_complete_get_att_status(packet);
+            break;
+        default:
+            break;
+    }
+}
+
+TEST_GROUP(GATTClientCache){
+    mock_btstack_tlv_t tlv_context;
+    const btstack_tlv_t * tlv_impl;
+
+    void setup(void){
+        tlv_impl = mock_btstack_tlv_init_instance(&tlv_context);
+        btstack_tlv_set_instance(tlv_impl, &tlv_context);
+        le_device_db_init();
+        le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, remote_addr, remote_irk);
+        hci_setup_le_connection(gatt_client_handle);
+        reset_results();
+    }
+
+    void teardown(void){
+        mock_simulate_disconnection_complete(gatt_client_handle);
+        mock_btstack_tlv_deinit(&tlv_context);
+    }
+
+    void reset_results(void){
+        events_len = 0;
+        query_complete = 0;
+        query_status = 0xff;
+        num_services = 0;
+        num_characteristics = 0;
+    }
+
+    void reconnect(void){
+        mock_simulate_disconnection_complete(gatt_client_handle);
+        hci_setup_le_connection(gatt_client_handle);
+        reset_results();
+    }
+
+    void discover_all(void){
+        uint8_t status = gatt_client_discover_primary_services(&handle_event, gatt_client_handle);
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+        CHECK_EQUAL(1, query_complete);
+        CHECK_EQUAL(ATT_ERROR_SUCCESS, query_status);
+        int num_services_found = num_services;
+        int i;
+        for (i = 0; i < num_services_found; i++){
+            query_complete = 0;
+            status = gatt_client_discover_characteristics_for_service(&handle_event, gatt_client_handle, &services[i]);
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+            CHECK_EQUAL(1, query_complete);
+            CHECK_EQUAL(ATT_ERROR_SUCCESS, query_status);
+        }
+        int num_characteristics_found = num_characteristics;
+        for (i = 0; i < num_characteristics_found; i++){
+            query_complete = 0;
+            status = gatt_client_discover_characteristic_descriptors(&handle_event, gatt_client_handle, &characteristics[i]);
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+            CHECK_EQUAL(1, query_complete);
+            CHECK_EQUAL(ATT_ERROR_SUCCESS, query_status);
+        }
+    }
+};
+
+TEST(GATTClientCache, served_from_cache_with_identical_events){
+    discover_all();
+    CHECK_EQUAL(4, num_services);
+    CHECK_EQUAL(6, num_characteristics);
+    uint8_t first_events[sizeof(events)];
+    uint16_t first_events_len = events_len;
+    memcpy(first_events, events, events_len);
+
+    reset_results();
+    uint16_t request_count = mock_att_request_count();
+    discover_all();
+    CHECK_EQUAL(request_count, mock_att_request_count());
+    CHECK_EQUAL(first_events_len, events_len);
+    MEMCMP_EQUAL(first_events, events, events_len);
+}
+
+TEST(GATTClientCache, discover_by_uuid_from_cache){
+    discover_all();
+    uint16_t request_count = mock_att_request_count();
+
+    reset_results();
+    uint8_t status = gatt_client_discover_primary_services_by_uuid16(&handle_event, gatt_client_handle, 0xff20);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(1, num_services);
+    CHECK_EQUAL(ATT_SERVICE_FF20_START_HANDLE, services[0].start_group_handle);
+    CHECK_EQUAL(ATT_SERVICE_FF20_END_HANDLE,   services[0].end_group_handle);
+
+    reset_results();
+    services[0].start_group_handle = ATT_SERVICE_0000FF10_0000_1000_8000_00805F9B34FB_START_HANDLE;
+    services[0].end_group_handle   = ATT_SERVICE_0000FF10_0000_1000_8000_00805F9B34FB_END_HANDLE;
+    status = gatt_client_discover_characteristics_for_service_by_uuid16(&handle_event, gatt_client_handle, &services[0], 0xff11);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(1, num_characteristics);
+    CHECK_EQUAL(ATT_CHARACTERISTIC_FF11_01_VALUE_HANDLE, characteristics[0].value_handle);
+
+    CHECK_EQUAL(request_count, mock_att_request_count());
+}
+
+TEST(GATTClientCache, restored_after_reconnect){
+    discover_all();
+    uint8_t first_events[sizeof(events)];
+    uint16_t first_events_len = events_len;
+    memcpy(first_events, events, events_len);
+
+    reconnect();
+    uint16_t request_count = mock_att_request_count();
+    discover_all();
+    // only Database Hash read, MTU exchange state is kept by mock connection
+    CHECK_EQUAL(request_count + 1, mock_att_request_count());
+    CHECK_EQUAL(first_events_len, events_len);
+    MEMCMP_EQUAL(first_events, events, events_len);
+}
+
+TEST(GATTClientCache, outdated_after_identity_change){
+    discover_all();
+    reconnect();
+
+    // different device with same index
+    bd_addr_t other_addr;
+    memcpy(other_addr, remote_addr, 6);
+    other_addr[0]++;
+    le_device_db_remove(0);
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, other_addr, remote_irk);
+
+    uint16_t request_count = mock_att_request_count();
+    uint8_t status = gatt_client_discover_primary_services(&handle_event, gatt_client_handle);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+    CHECK_EQUAL(4, num_services);
+    CHECK(mock_att_request_count() > (request_count + 1));
+}
+
+TEST(GATTClientCache, invalidated_by_service_changed){
+    discover_all();
+
+    uint8_t indication[] = { ATT_HANDLE_VALUE_INDICATION, 0, 0, 0x01, 0x00, 0xff, 0xff };
+    little_endian_store_16(indication, 1, ATT_CHARACTERISTIC_GATT_SERVICE_CHANGED_01_VALUE_HANDLE);
+    gatt_client_att_packet_handler_fuzz(ATT_DATA_PACKET, gatt_client_handle, indication, sizeof(indication));
+
+    reset_results();
+    uint16_t request_count = mock_att_request_count();
+    uint8_t status = gatt_client_discover_primary_services(&handle_event, gatt_client_handle);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+    CHECK_EQUAL(1, query_complete);
+    CHECK_EQUAL(4, num_services);
+    // Database Hash and service discovery
+    CHECK(mock_att_request_count() > (request_count + 1));
+}
+
+int main (int argc, const char * argv[]){
+    att_set_db(profile_data);
+    gatt_client_init();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
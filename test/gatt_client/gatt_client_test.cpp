@@ -1134,6 +1134,35 @@ TEST(GATTClient, gatt_client_read_multiple_characteristic_values){
     CHECK_EQUAL(GATT_CLIENT_IN_WRONG_STATE, status);
 }
 
+TEST(GATTClient, gatt_client_read_multiple_variable_characteristic_values){
+	test = READ_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(1, result_counter);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(1, result_counter);
+
+	// each value is reported separately
+	uint16_t value_handles[] = {characteristics[0].value_handle, characteristics[0].value_handle};
+
+	reset_query_state();
+	status = gatt_client_read_multiple_variable_characteristic_values(handle_ble_client_event, gatt_client_handle, 2, value_handles);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(6, result_counter);
+
+	reset_query_state();
+    set_wrong_gatt_client_state();
+	status = gatt_client_read_multiple_variable_characteristic_values(handle_ble_client_event, gatt_client_handle, 2, value_handles);
+    CHECK_EQUAL(GATT_CLIENT_IN_WRONG_STATE, status);
+}
+
 TEST(GATTClient, gatt_client_write_value_of_characteristic_without_response){
 	reset_query_state();
 	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
@@ -24,6 +24,7 @@ static hci_connection_t hci_connection;
 
 static uint8_t packet_buffer[256];
 static uint16_t packet_buffer_len;
+static uint16_t att_request_count;
 
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
@@ -44,6 +45,15 @@ void mock_simulate_connected(void){
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
 
+void mock_simulate_disconnection_complete(uint16_t con_handle){
+	uint8_t packet[] = {HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, (uint8_t) (con_handle & 0xff), (uint8_t) (con_handle >> 8), ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION};
+	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
+}
+
+uint16_t mock_att_request_count(void){
+	return att_request_count;
+}
+
 void mock_simulate_scan_response(void){
 	uint8_t packet[] = {GAP_EVENT_ADVERTISING_REPORT, 0x13, 0xE2, 0x01, 0x34, 0xB1, 0xF7, 0xD1, 0x77, 0x9B, 0xCC, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
@@ -150,6 +160,7 @@ void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t chan
 uint8_t l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
 	att_connection_t att_connection;
 	att_init_connection(&att_connection);
+	att_request_count++;
 	uint8_t response_buffer[PREBUFFER_SIZE + TEST_MAX_MTU];
 	uint8_t * response = &response_buffer[PREBUFFER_SIZE];
 	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, response);
@@ -217,6 +217,47 @@ TEST(ATT_SERVER, att_server_notify){
     CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
 }
 
+TEST(ATT_SERVER, att_server_multiple_notify){
+    static uint8_t value_a[] = {0x55};
+    static uint8_t value_b[] = {0x66, 0x67};
+    uint16_t value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL);
+    uint16_t attribute_handles[] = { value_handle, value_handle };
+    const uint8_t * values_data[] = { value_a, value_b };
+    uint16_t values_len[] = { sizeof(value_a), sizeof(value_b) };
+    uint8_t status;
+
+    // invalid connection handle
+    status = att_server_multiple_notify(0x50, 2, attribute_handles, values_data, values_len);
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, status);
+
+    // L2CAP cannot send
+    l2cap_can_send_fixed_channel_packet_now_set_status(0);
+    status = att_server_multiple_notify(att_con_handle, 2, attribute_handles, values_data, values_len);
+    CHECK_EQUAL(BTSTACK_ACL_BUFFERS_FULL, status);
+    l2cap_can_send_fixed_channel_packet_now_set_status(1);
+
+    // first value does not fit into MTU
+    uint16_t long_values_len[] = { 30, sizeof(value_b) };
+    status = att_server_multiple_notify(att_con_handle, 2, attribute_handles, values_data, long_values_len);
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, status);
+
+    // second value does not fit into MTU, nothing is sent
+    static uint8_t value_c[18];
+    const uint8_t * values_data_ac[] = { value_a, value_c };
+    uint16_t values_len_ac[] = { sizeof(value_a), sizeof(value_c) };
+    status = att_server_multiple_notify(att_con_handle, 2, attribute_handles, values_data_ac, values_len_ac);
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, status);
+
+    // both values fit exactly into MTU: 1 + (4 + 1) + (4 + 13) = 23
+    values_len_ac[1] = 13;
+    status = att_server_multiple_notify(att_con_handle, 2, attribute_handles, values_data_ac, values_len_ac);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+
+    // correct command
+    status = att_server_multiple_notify(att_con_handle, 2, attribute_handles, values_data, values_len);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+}
+
 TEST(ATT_SERVER, att_server_get_mtu){
     // invalid connection handle
     uint8_t mtu = att_server_get_mtu(0x50);
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// compare records written by hci_dump_posix_fs_async with hci_dump_posix_fs, ignoring timestamps
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "hci_dump_posix_fs.h"
+#include "hci_dump_posix_fs_async.h"
+
+#define TEST_DUMP_ASYNC     "/tmp/hci_dump_async_test.log"
+#define TEST_DUMP_REFERENCE "/tmp/hci_dump_reference_test.log"
+
+typedef struct {
+    uint8_t  packet_type;
+    uint32_t flags;
+    uint32_t original_len;
+    std::vector<uint8_t> payload;
+} test_record_t;
+
+static std::vector<uint8_t> read_file(const char * path){
+    std::vector<uint8_t> data;
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) return data;
+    uint8_t buffer[1024];
+    size_t bytes_read;
+    while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0){
+        data.insert(data.end(), buffer, buffer + bytes_read);
+    }
+    fclose(file);
+    return data;
+}
+
+static bool file_exists(const char * path){
+    return access(path, F_OK) == 0;
+}
+
+static std::vector<test_record_t> parse_records(const char * path, hci_dump_format_t format){
+    std::vector<test_record_t> records;
+    std::vector<uint8_t> data = read_file(path);
+    uint32_t pos = 0;
+    if (format == HCI_DUMP_BTSNOOP){
+        CHECK(data.size() >= 16);
+        pos = 16;
+    }
+    while (pos < data.size()){
+        test_record_t record;
+        uint32_t payload_len;
+        switch (format){
+            case HCI_DUMP_PACKETLOGGER:
+                CHECK((pos + HCI_DUMP_HEADER_SIZE_PACKETLOGGER) <= data.size());
+                payload_len = big_endian_read_32(data.data(), pos) + 4 - HCI_DUMP_HEADER_SIZE_PACKETLOGGER;
+                record.packet_type  = data[pos + 12];
+                record.flags        = 0;
+                record.original_len = payload_len;
+                pos += HCI_DUMP_HEADER_SIZE_PACKETLOGGER;
+                break;
+            case HCI_DUMP_BTSNOOP:
+                CHECK((pos + HCI_DUMP_HEADER_SIZE_BTSNOOP + 1) <= data.size());
+                payload_len = big_endian_read_32(data.data(), pos + 4) - 1;
+                record.original_len = big_endian_read_32(data.data(), pos) - 1;
+                record.flags        = big_endian_read_32(data.data(), pos + 8);
+                record.packet_type  = data[pos + HCI_DUMP_HEADER_SIZE_BTSNOOP];
+                pos += HCI_DUMP_HEADER_SIZE_BTSNOOP + 1;
+                break;
+            default:
+                FAIL("format not supported");
+                return records;
+        }
+        CHECK((pos + payload_len) <= data.size());
+        record.payload.assign(data.begin() + pos, data.begin() + pos + payload_len);
+        pos += payload_len;
+        records.push_back(record);
+    }
+    return records;
+}
+
+static void check_records_equal(const std::vector<test_record_t> & expected, const std::vector<test_record_t> & actual){
+    CHECK_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++){
+        CHECK_EQUAL(expected[i].packet_type,  actual[i].packet_type);
+        CHECK_EQUAL(expected[i].flags,        actual[i].flags);
+        CHECK_EQUAL(expected[i].original_len, actual[i].original_len);
+        CHECK_EQUAL(expected[i].payload.size(), actual[i].payload.size());
+        MEMCMP_EQUAL(expected[i].payload.data(), actual[i].payload.data(), expected[i].payload.size());
+    }
+}
+
+static void log_test_message(const hci_dump_t * hci_dump_impl, const char * format, ...){
+    va_list argptr;
+    va_start(argptr, format);
+    (*hci_dump_impl->log_message)(HCI_DUMP_LOG_LEVEL_INFO, format, argptr);
+    va_end(argptr);
+}
+
+// deterministic mix of commands, events, ACL packets and log messages with various sizes
+static void log_test_packet(const hci_dump_t * hci_dump_impl, uint32_t nr){
+    static uint8_t packet[300];
+    static const uint8_t packet_types[] = { HCI_COMMAND_DATA_PACKET, HCI_EVENT_PACKET, HCI_ACL_DATA_PACKET, HCI_ACL_DATA_PACKET };
+    if ((nr % 7u) == 6u){
+        log_test_message(hci_dump_impl, "log message %u", nr);
+        return;
+    }
+    uint16_t len = 1u + ((nr * 37u) % sizeof(packet));
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        packet[i] = (uint8_t) (nr + i);
+    }
+    (*hci_dump_impl->log_packet)(packet_types[nr & 3u], (uint8_t) (nr & 1u), packet, len);
+}
+
+static void log_test_packets(const hci_dump_t * hci_dump_impl, uint32_t first, uint32_t count, uint32_t delay_us){
+    const struct timespec delay = { 0, (long) delay_us * 1000 };
+    uint32_t nr;
+    for (nr = first; nr < (first + count); nr++){
+        log_test_packet(hci_dump_impl, nr);
+        if (delay_us > 0){
+            nanosleep(&delay, NULL);
+        }
+    }
+}
+
+static std::vector<test_record_t> reference_records(hci_dump_format_t format, uint32_t first, uint32_t count){
+    CHECK_EQUAL(0, hci_dump_posix_fs_open(TEST_DUMP_REFERENCE, format));
+    log_test_packets(hci_dump_posix_fs_get_instance(), first, count, 0);
+    hci_dump_posix_fs_close();
+    return parse_records(TEST_DUMP_REFERENCE, format);
+}
+
+TEST_GROUP(HCI_DUMP_POSIX_FS_ASYNC){
+    const hci_dump_t * hci_dump_impl;
+    hci_dump_posix_fs_async_config_t config;
+    char path[300];
+
+    void setup(void){
+        hci_dump_impl = hci_dump_posix_fs_async_get_instance();
+        memset(&config, 0, sizeof(config));
+        unlink(TEST_DUMP_ASYNC);
+        unlink(TEST_DUMP_REFERENCE);
+        int i;
+        for (i = 1; i < 4; i++){
+            unlink(rotated_path(i));
+        }
+    }
+
+    const char * rotated_path(int nr){
+        snprintf(path, sizeof(path), "%s.%u", TEST_DUMP_ASYNC, nr);
+        return path;
+    }
+
+    void teardown(void){
+        hci_dump_posix_fs_async_close();
+    }
+};
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, PacketLoggerRecordOrder){
+    std::vector<test_record_t> expected = reference_records(HCI_DUMP_PACKETLOGGER, 0, 500);
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER, NULL));
+    log_test_packets(hci_dump_impl, 0, 500, 0);
+    hci_dump_posix_fs_async_close();
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_get_dropped_records());
+    check_records_equal(expected, parse_records(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER));
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, BTSnoopRecordOrder){
+    std::vector<test_record_t> expected = reference_records(HCI_DUMP_BTSNOOP, 0, 500);
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP, NULL));
+    log_test_packets(hci_dump_impl, 0, 500, 0);
+    hci_dump_posix_fs_async_close();
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_get_dropped_records());
+    // same file header
+    std::vector<uint8_t> reference = read_file(TEST_DUMP_REFERENCE);
+    std::vector<uint8_t> async = read_file(TEST_DUMP_ASYNC);
+    MEMCMP_EQUAL(reference.data(), async.data(), 16);
+    check_records_equal(expected, parse_records(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP));
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, RingBufferWrap){
+    std::vector<test_record_t> expected = reference_records(HCI_DUMP_PACKETLOGGER, 0, 300);
+    // small ring buffer, give writer thread time to catch up
+    config.buffer_size = 4096;
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER, &config));
+    log_test_packets(hci_dump_impl, 0, 300, 500);
+    hci_dump_posix_fs_async_close();
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_get_dropped_records());
+    check_records_equal(expected, parse_records(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER));
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, Rotation){
+    std::vector<test_record_t> expected = reference_records(HCI_DUMP_BTSNOOP, 0, 200);
+    config.max_file_size = 2000;
+    config.max_files = 3;
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP, &config));
+    log_test_packets(hci_dump_impl, 0, 200, 0);
+    hci_dump_posix_fs_async_close();
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_get_dropped_records());
+
+    // filename, filename.1, filename.2 are kept, each one with a file header and limited in size
+    CHECK_FALSE(file_exists(rotated_path(3)));
+    std::vector<test_record_t> actual;
+    int i;
+    for (i = 2; i >= 0; i--){
+        const char * file_path = (i == 0) ? TEST_DUMP_ASYNC : rotated_path(i);
+        std::vector<uint8_t> data = read_file(file_path);
+        CHECK(data.size() <= config.max_file_size);
+        std::vector<test_record_t> records = parse_records(file_path, HCI_DUMP_BTSNOOP);
+        CHECK(records.size() > 0);
+        actual.insert(actual.end(), records.begin(), records.end());
+    }
+    // last records in order
+    CHECK(actual.size() < expected.size());
+    std::vector<test_record_t> expected_tail(expected.end() - actual.size(), expected.end());
+    check_records_equal(expected_tail, actual);
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, Snaplen){
+    std::vector<test_record_t> expected = reference_records(HCI_DUMP_BTSNOOP, 0, 100);
+    config.snaplen = 16;
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP, &config));
+    log_test_packets(hci_dump_impl, 0, 100, 0);
+    hci_dump_posix_fs_async_close();
+
+    // packets are truncated, original length is kept
+    size_t i;
+    for (i = 0; i < expected.size(); i++){
+        if (expected[i].payload.size() > config.snaplen){
+            expected[i].payload.resize(config.snaplen);
+        }
+    }
+    check_records_equal(expected, parse_records(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP));
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, ResetDiscardsPreviousRecords){
+    CHECK_EQUAL(0, hci_dump_posix_fs_open(TEST_DUMP_REFERENCE, HCI_DUMP_PACKETLOGGER));
+    log_test_packets(hci_dump_posix_fs_get_instance(), 0, 100, 0);
+    (*hci_dump_posix_fs_get_instance()->reset)();
+    log_test_packets(hci_dump_posix_fs_get_instance(), 100, 20, 0);
+    hci_dump_posix_fs_close();
+    std::vector<test_record_t> expected = parse_records(TEST_DUMP_REFERENCE, HCI_DUMP_PACKETLOGGER);
+    CHECK_EQUAL(20, expected.size());
+
+    // reset while records are pending in ring buffer
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER, NULL));
+    log_test_packets(hci_dump_impl, 0, 100, 0);
+    (*hci_dump_impl->reset)();
+    log_test_packets(hci_dump_impl, 100, 20, 0);
+    hci_dump_posix_fs_async_close();
+    check_records_equal(expected, parse_records(TEST_DUMP_ASYNC, HCI_DUMP_PACKETLOGGER));
+}
+
+TEST(HCI_DUMP_POSIX_FS_ASYNC, ResetKeepsFileHeader){
+    CHECK_EQUAL(0, hci_dump_posix_fs_async_open(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP, NULL));
+    log_test_packets(hci_dump_impl, 0, 50, 0);
+    (*hci_dump_impl->reset)();
+    log_test_packets(hci_dump_impl, 50, 10, 0);
+    hci_dump_posix_fs_async_close();
+    std::vector<test_record_t> records = parse_records(TEST_DUMP_ASYNC, HCI_DUMP_BTSNOOP);
+    std::vector<uint8_t> data = read_file(TEST_DUMP_ASYNC);
+    MEMCMP_EQUAL("btsnoop", data.data(), 8);
+    // log messages are not stored in BTSnoop
+    CHECK_EQUAL(9, records.size());
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
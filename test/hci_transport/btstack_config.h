@@ -0,0 +1,25 @@
+//
+// btstack_config.h for HCI transport tests
+//
+
+#ifndef BTSTACK_CONFIG_H
+#define BTSTACK_CONFIG_H
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+#define ENABLE_H5
+#define ENABLE_HCI_TRANSPORT_H4_READ_AHEAD
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 100
+#define HCI_INCOMING_PRE_BUFFER_SIZE 6
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 4
+
+#endif
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// H4 read-ahead with fake UART driver that delivers received bytes in chunks
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "btstack_uart.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+#include "hci_transport_h4.h"
+
+// fake UART
+
+static void (*uart_block_received)(void);
+static void (*uart_bytes_received)(uint16_t num_bytes);
+static uint8_t * uart_read_buffer;
+static uint16_t  uart_read_len;
+static bool      uart_read_bytes;
+static uint32_t  uart_num_reads;
+
+static int uart_init(const btstack_uart_config_t * uart_config){
+    UNUSED(uart_config);
+    return 0;
+}
+
+static int uart_open(void){
+    return 0;
+}
+
+static int uart_close(void){
+    return 0;
+}
+
+static void uart_set_block_received(void (*block_handler)(void)){
+    uart_block_received = block_handler;
+}
+
+static void uart_set_block_sent(void (*block_handler)(void)){
+    UNUSED(block_handler);
+}
+
+static int uart_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+static void uart_receive_block(uint8_t * buffer, uint16_t len){
+    uart_read_buffer = buffer;
+    uart_read_len = len;
+    uart_read_bytes = false;
+    uart_num_reads++;
+}
+
+static void uart_send_block(const uint8_t * buffer, uint16_t length){
+    UNUSED(buffer);
+    UNUSED(length);
+}
+
+static void uart_set_bytes_received(void (*bytes_handler)(uint16_t num_bytes)){
+    uart_bytes_received = bytes_handler;
+}
+
+static void uart_receive_bytes(uint8_t * buffer, uint16_t max_len){
+    uart_read_buffer = buffer;
+    uart_read_len = max_len;
+    uart_read_bytes = true;
+    uart_num_reads++;
+}
+
+static const btstack_uart_t uart_driver = {
+    /* int  (*init)(hci_transport_config_uart_t * config); */         &uart_init,
+    /* int  (*open)(void); */                                         &uart_open,
+    /* int  (*close)(void); */                                        &uart_close,
+    /* void (*set_block_received)(void (*handler)(void)); */          &uart_set_block_received,
+    /* void (*set_block_sent)(void (*handler)(void)); */              &uart_set_block_sent,
+    /* int  (*set_baudrate)(uint32_t baudrate); */                    &uart_set_baudrate,
+    /* int  (*set_parity)(int parity); */                             NULL,
+    /* int  (*set_flowcontrol)(int flowcontrol); */                   NULL,
+    /* void (*receive_block)(uint8_t *buffer, uint16_t len); */       &uart_receive_block,
+    /* void (*send_block)(const uint8_t *buffer, uint16_t length); */ &uart_send_block,
+    /* int (*get_supported_sleep_modes); */                           NULL,
+    /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
+    /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*set_frame_received)(void (*handler)(uint16_t)); */      NULL,
+    /* void (*set_frame_sent)(void (*handler)(void)); */              NULL,
+    /* void (*receive_frame)(uint8_t *buffer, uint16_t len); */       NULL,
+    /* void (*send_frame)(const uint8_t *buffer, uint16_t length); */ NULL,
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      &uart_set_bytes_received,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   &uart_receive_bytes,
+};
+
+// same driver without streaming receive
+static btstack_uart_t uart_driver_block_only;
+
+// deliver data in chunks of at most chunk_size bytes, limited by the pending read
+static void uart_receive_data(const uint8_t * data, uint32_t len, uint16_t chunk_size){
+    while (len > 0){
+        CHECK(uart_read_len > 0);
+        uint16_t bytes_to_deliver = btstack_min(btstack_min(chunk_size, uart_read_len), len);
+        if (uart_read_bytes == false){
+            // block read needs exact size
+            bytes_to_deliver = uart_read_len;
+            CHECK(bytes_to_deliver <= len);
+        }
+        memcpy(uart_read_buffer, data, bytes_to_deliver);
+        data += bytes_to_deliver;
+        len  -= bytes_to_deliver;
+        uart_read_len = 0;
+        if (uart_read_bytes){
+            (*uart_bytes_received)(bytes_to_deliver);
+        } else {
+            (*uart_block_received)();
+        }
+    }
+}
+
+// packet handler stores H4 packets and modifies buffer around packet like the HCI layer does
+static std::vector<uint8_t> received_packets;
+static uint32_t num_received_packets;
+
+static void packet_handler(uint8_t packet_type, uint8_t * packet, uint16_t size){
+    received_packets.push_back(packet_type);
+    received_packets.insert(received_packets.end(), packet, packet + size);
+    num_received_packets++;
+    // pre-buffer is used by upper layers, strings are terminated in place
+    packet[-1] = 0xee;
+    packet[size] = 0;
+}
+
+static uint16_t add_event(std::vector<uint8_t> & stream, uint8_t event_code, uint8_t len){
+    stream.push_back(HCI_EVENT_PACKET);
+    stream.push_back(event_code);
+    stream.push_back(len);
+    uint8_t i;
+    for (i = 0; i < len; i++){
+        stream.push_back((uint8_t) (event_code + i));
+    }
+    return 3u + len;
+}
+
+static uint16_t add_acl(std::vector<uint8_t> & stream, uint16_t handle, uint16_t len){
+    stream.push_back(HCI_ACL_DATA_PACKET);
+    stream.push_back(handle & 0xff);
+    stream.push_back(handle >> 8);
+    stream.push_back(len & 0xff);
+    stream.push_back(len >> 8);
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        stream.push_back((uint8_t) (handle + i));
+    }
+    return 5u + len;
+}
+
+static uint16_t add_sco(std::vector<uint8_t> & stream, uint16_t handle, uint8_t len){
+    stream.push_back(HCI_SCO_DATA_PACKET);
+    stream.push_back(handle & 0xff);
+    stream.push_back(handle >> 8);
+    stream.push_back(len);
+    uint8_t i;
+    for (i = 0; i < len; i++){
+        stream.push_back((uint8_t) (0x80 + i));
+    }
+    return 4u + len;
+}
+
+// mix of packets with various sizes, incl. max size
+static void add_packets(std::vector<uint8_t> & stream, int count){
+    int i;
+    for (i = 0; i < count; i++){
+        switch (i % 4){
+            case 0:
+                add_event(stream, (uint8_t) (0x10 + i), (uint8_t) ((i * 13) % 256));
+                break;
+            case 1:
+                add_acl(stream, (uint16_t) (0x0040 + i), (uint16_t) ((i * 7) % (HCI_ACL_PAYLOAD_SIZE + 1)));
+                break;
+            case 2:
+                add_sco(stream, (uint16_t) (0x0100 + i), (uint8_t) ((i * 3) % 64));
+                break;
+            default:
+                add_acl(stream, (uint16_t) (0x0040 + i), HCI_ACL_PAYLOAD_SIZE);
+                break;
+        }
+    }
+}
+
+static const hci_transport_config_uart_t config = {
+    HCI_TRANSPORT_CONFIG_UART,
+    115200,
+    0,  // main baudrate
+    1,  // flow control
+    NULL,
+    BTSTACK_UART_PARITY_OFF,
+};
+
+TEST_GROUP(HCI_TRANSPORT_H4){
+    const hci_transport_t * transport;
+
+    void setup(void){
+        received_packets.clear();
+        num_received_packets = 0;
+        uart_read_len = 0;
+        uart_num_reads = 0;
+        open_transport(&uart_driver);
+    }
+
+    void open_transport(const btstack_uart_t * uart){
+        transport = hci_transport_h4_instance(uart);
+        transport->init(&config);
+        transport->register_packet_handler(&packet_handler);
+        transport->open();
+    }
+
+    void teardown(void){
+        transport->close();
+    }
+
+    void check_received(const std::vector<uint8_t> & expected, uint32_t expected_num_packets){
+        CHECK_EQUAL(expected_num_packets, num_received_packets);
+        CHECK_EQUAL(expected.size(), received_packets.size());
+        MEMCMP_EQUAL(expected.data(), received_packets.data(), expected.size());
+    }
+};
+
+TEST(HCI_TRANSPORT_H4, ReadAheadUsed){
+    CHECK_TRUE(uart_read_bytes);
+    CHECK_EQUAL(2 * (1 + HCI_INCOMING_PACKET_BUFFER_SIZE), uart_read_len);
+}
+
+TEST(HCI_TRANSPORT_H4, MultiplePacketsInSingleChunk){
+    std::vector<uint8_t> stream;
+    add_event(stream, 0x0e, 4);
+    add_acl(stream, 0x0040, 10);
+    add_sco(stream, 0x0100, 3);
+    uart_receive_data(stream.data(), stream.size(), 0xffff);
+    check_received(stream, 3);
+    // single read for all packets
+    CHECK_EQUAL(2, uart_num_reads);
+}
+
+TEST(HCI_TRANSPORT_H4, PacketSplitAcrossChunks){
+    std::vector<uint8_t> stream;
+    add_packets(stream, 40);
+    const uint16_t chunk_sizes[] = { 1, 2, 3, 4, 5, 7, 61, 259, 1000 };
+    unsigned int i;
+    for (i = 0; i < sizeof(chunk_sizes) / sizeof(uint16_t); i++){
+        received_packets.clear();
+        num_received_packets = 0;
+        uart_receive_data(stream.data(), stream.size(), chunk_sizes[i]);
+        check_received(stream, 40);
+    }
+}
+
+TEST(HCI_TRANSPORT_H4, PartialPacketAtEndOfBuffer){
+    // max size packets don't align with read-ahead buffer, partial packet is moved to the front
+    std::vector<uint8_t> stream;
+    int i;
+    for (i = 0; i < 10; i++){
+        add_acl(stream, 0x0040, HCI_ACL_PAYLOAD_SIZE);
+        add_event(stream, 0xff, 255);
+    }
+    uart_receive_data(stream.data(), stream.size(), 0xffff);
+    check_received(stream, 20);
+}
+
+TEST(HCI_TRANSPORT_H4, ResyncAfterInvalidPacketType){
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> stream;
+    add_event(stream, 0x0e, 4);
+    stream.push_back(0x77);
+    stream.push_back(0x00);
+    stream.push_back(0x55);
+    add_acl(stream, 0x0040, 10);
+    add_event(expected, 0x0e, 4);
+    add_acl(expected, 0x0040, 10);
+    uart_receive_data(stream.data(), stream.size(), 0xffff);
+    check_received(expected, 2);
+
+    // garbage split across chunks
+    received_packets.clear();
+    num_received_packets = 0;
+    uart_receive_data(stream.data(), stream.size(), 1);
+    check_received(expected, 2);
+}
+
+TEST(HCI_TRANSPORT_H4, ResyncAfterInvalidPacketLength){
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> stream;
+    // ACL header with payload length exceeding buffer is dropped, handle looks like event header
+    const uint8_t invalid_acl_header[] = { HCI_ACL_DATA_PACKET, HCI_EVENT_PACKET, 0x01, 0xff, 0xff };
+    stream.insert(stream.end(), invalid_acl_header, invalid_acl_header + sizeof(invalid_acl_header));
+    add_event(stream, 0x0e, 4);
+    add_event(expected, 0x0e, 4);
+    uart_receive_data(stream.data(), stream.size(), 3);
+    check_received(expected, 1);
+}
+
+TEST(HCI_TRANSPORT_H4, BlockReadWithoutReadAheadSupport){
+    transport->close();
+    uart_driver_block_only = uart_driver;
+    uart_driver_block_only.set_bytes_received = NULL;
+    uart_driver_block_only.receive_bytes = NULL;
+    open_transport(&uart_driver_block_only);
+    CHECK_FALSE(uart_read_bytes);
+
+    std::vector<uint8_t> stream;
+    add_packets(stream, 20);
+    uart_receive_data(stream.data(), stream.size(), 0xffff);
+    check_received(stream, 20);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
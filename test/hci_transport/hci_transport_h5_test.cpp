@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// H5 sliding window with fake UART peer and virtual time
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "btstack_crc.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+#include "btstack_uart.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+#include "hci_transport_h5.h"
+
+#define LINK_ACKNOWLEDGEMENT_TYPE 0x00
+#define LINK_CONTROL_PACKET_TYPE  0x0f
+
+// virtual run loop
+
+static uint32_t              current_time_ms;
+static btstack_linked_list_t timers;
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t * timer, void (*process)(btstack_timer_source_t * _timer)){
+    timer->process = process;
+}
+
+void btstack_run_loop_set_timer(btstack_timer_source_t * timer, uint32_t timeout_in_ms){
+    timer->timeout = current_time_ms + timeout_in_ms;
+}
+
+void btstack_run_loop_add_timer(btstack_timer_source_t * timer){
+    btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer);
+    btstack_linked_list_add(&timers, (btstack_linked_item_t *) timer);
+}
+
+int btstack_run_loop_remove_timer(btstack_timer_source_t * timer){
+    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer) ? 1 : 0;
+}
+
+uint32_t btstack_run_loop_get_time_ms(void){
+    return current_time_ms;
+}
+
+static void advance_time(uint32_t duration_ms){
+    uint32_t end_ms = current_time_ms + duration_ms;
+    while (current_time_ms < end_ms){
+        current_time_ms++;
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &timers);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            btstack_timer_source_t * timer = (btstack_timer_source_t *) btstack_linked_list_iterator_next(&it);
+            if (timer->timeout > current_time_ms) continue;
+            btstack_linked_list_iterator_remove(&it);
+            (*timer->process)(timer);
+            // handler might have modified list
+            btstack_linked_list_iterator_init(&it, &timers);
+        }
+    }
+}
+
+// fake UART: frames sent by host are collected, frames from peer are delivered into pending receive buffer
+
+typedef struct {
+    uint8_t  seq_nr;
+    uint8_t  ack_nr;
+    bool     reliable;
+    uint8_t  packet_type;
+    std::vector<uint8_t> payload;
+} test_frame_t;
+
+static void (*uart_frame_received)(uint16_t frame_size);
+static void (*uart_frame_sent)(void);
+static uint8_t * uart_receive_buffer;
+static uint16_t  uart_receive_len;
+static bool      uart_send_active;
+static std::vector<test_frame_t> host_frames;
+
+static int uart_init(const btstack_uart_config_t * uart_config){
+    UNUSED(uart_config);
+    return 0;
+}
+
+static int uart_open(void){
+    return 0;
+}
+
+static int uart_close(void){
+    return 0;
+}
+
+static int uart_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+static int uart_set_parity(int parity){
+    UNUSED(parity);
+    return 0;
+}
+
+static void uart_set_frame_received(void (*frame_handler)(uint16_t frame_size)){
+    uart_frame_received = frame_handler;
+}
+
+static void uart_set_frame_sent(void (*frame_handler)(void)){
+    uart_frame_sent = frame_handler;
+}
+
+static void uart_receive_frame(uint8_t * buffer, uint16_t len){
+    uart_receive_buffer = buffer;
+    uart_receive_len = len;
+}
+
+static void uart_send_frame(const uint8_t * frame, uint16_t frame_size){
+    CHECK_FALSE(uart_send_active);
+    uart_send_active = true;
+
+    // validate header and data integrity check
+    CHECK(frame_size >= 4);
+    CHECK_EQUAL(0xff, (uint8_t) (frame[0] + frame[1] + frame[2] + frame[3]));
+    uint16_t payload_len = (frame[1] >> 4) | (frame[2] << 4);
+    bool dic_present = (frame[0] & 0x40) != 0;
+    CHECK_EQUAL(4 + payload_len + (dic_present ? 2 : 0), frame_size);
+    if (dic_present){
+        CHECK_EQUAL(btstack_crc16_h5_calc(frame, 4 + payload_len), big_endian_read_16(frame, 4 + payload_len));
+    }
+
+    test_frame_t test_frame;
+    test_frame.seq_nr      = frame[0] & 0x07;
+    test_frame.ack_nr      = (frame[0] >> 3) & 0x07;
+    test_frame.reliable    = (frame[0] & 0x80) != 0;
+    test_frame.packet_type = frame[1] & 0x0f;
+    test_frame.payload.assign(&frame[4], &frame[4 + payload_len]);
+    host_frames.push_back(test_frame);
+}
+
+static const btstack_uart_t uart_driver = {
+    /* int  (*init)(hci_transport_config_uart_t * config); */         &uart_init,
+    /* int  (*open)(void); */                                         &uart_open,
+    /* int  (*close)(void); */                                        &uart_close,
+    /* void (*set_block_received)(void (*handler)(void)); */          NULL,
+    /* void (*set_block_sent)(void (*handler)(void)); */              NULL,
+    /* int  (*set_baudrate)(uint32_t baudrate); */                    &uart_set_baudrate,
+    /* int  (*set_parity)(int parity); */                             &uart_set_parity,
+    /* int  (*set_flowcontrol)(int flowcontrol); */                   NULL,
+    /* void (*receive_block)(uint8_t *buffer, uint16_t len); */       NULL,
+    /* void (*send_block)(const uint8_t *buffer, uint16_t length); */ NULL,
+    /* int (*get_supported_sleep_modes); */                           NULL,
+    /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
+    /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*set_frame_received)(void (*handler)(uint16_t)); */      &uart_set_frame_received,
+    /* void (*set_frame_sent)(void (*handler)(void)); */              &uart_set_frame_sent,
+    /* void (*receive_frame)(uint8_t *buffer, uint16_t len); */       &uart_receive_frame,
+    /* void (*send_frame)(const uint8_t *buffer, uint16_t length); */ &uart_send_frame,
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      NULL,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   NULL,
+};
+
+// complete all frames sent by host
+static void uart_complete_send(void){
+    while (uart_send_active){
+        uart_send_active = false;
+        (*uart_frame_sent)();
+    }
+}
+
+// peer
+
+static void peer_send_frame(uint8_t seq_nr, uint8_t ack_nr, bool reliable, uint8_t packet_type, const uint8_t * payload, uint16_t payload_len){
+    uint8_t frame[4 + HCI_INCOMING_PACKET_BUFFER_SIZE + 2];
+    frame[0] = (reliable ? seq_nr : 0) | (ack_nr << 3) | 0x40 | (reliable ? 0x80 : 0);
+    frame[1] = packet_type | ((payload_len & 0x0f) << 4);
+    frame[2] = payload_len >> 4;
+    frame[3] = 0xff - (frame[0] + frame[1] + frame[2]);
+    memcpy(&frame[4], payload, payload_len);
+    big_endian_store_16(frame, 4 + payload_len, btstack_crc16_h5_calc(frame, 4 + payload_len));
+    uint16_t frame_size = 4 + payload_len + 2;
+    CHECK(frame_size <= uart_receive_len);
+    memcpy(uart_receive_buffer, frame, frame_size);
+    (*uart_frame_received)(frame_size);
+}
+
+static void peer_send_control(const uint8_t * message, uint16_t message_len){
+    peer_send_frame(0, 0, false, LINK_CONTROL_PACKET_TYPE, message, message_len);
+}
+
+static void peer_send_ack(uint8_t ack_nr){
+    peer_send_frame(0, ack_nr, false, LINK_ACKNOWLEDGEMENT_TYPE, NULL, 0);
+}
+
+static void peer_send_event(uint8_t seq_nr, uint8_t ack_nr, uint8_t event_code){
+    const uint8_t event[] = { event_code, 1, seq_nr };
+    peer_send_frame(seq_nr, ack_nr, true, HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// upper stack
+
+static uint32_t num_packet_sent_events;
+static std::vector<uint8_t> received_event_codes;
+
+static void packet_handler(uint8_t packet_type, uint8_t * packet, uint16_t size){
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT){
+        num_packet_sent_events++;
+        return;
+    }
+    received_event_codes.push_back(packet[0]);
+}
+
+static const hci_transport_config_uart_t config = {
+    HCI_TRANSPORT_CONFIG_UART,
+    115200,
+    0,  // main baudrate
+    1,  // flow control
+    NULL,
+    BTSTACK_UART_PARITY_OFF,
+};
+
+TEST_GROUP(HCI_TRANSPORT_H5){
+    const hci_transport_t * transport;
+    // 4 bytes for H5 header in front of packet, 2 for data integrity check after
+    uint8_t acl_buffer[4 + HCI_ACL_BUFFER_SIZE + 2];
+
+    void setup(void){
+        current_time_ms = 0;
+        timers = NULL;
+        uart_send_active = false;
+        host_frames.clear();
+        received_event_codes.clear();
+        num_packet_sent_events = 0;
+        transport = hci_transport_h5_instance(&uart_driver);
+        transport->init(&config);
+        transport->register_packet_handler(&packet_handler);
+        transport->open();
+    }
+
+    void teardown(void){
+        uart_complete_send();
+        transport->close();
+    }
+
+    // sync and config, returns config field sent by host
+    uint8_t activate_link(uint8_t peer_window_size){
+        const uint8_t sync_response[] = { 0x02, 0x7d };
+        const uint8_t config_response[] = { 0x04, 0x7b, (uint8_t) (0x10 | peer_window_size) };
+        uart_complete_send();
+        peer_send_control(sync_response, sizeof(sync_response));
+        uart_complete_send();
+        // config with config field
+        const test_frame_t & config_frame = host_frames.back();
+        CHECK_EQUAL(LINK_CONTROL_PACKET_TYPE, config_frame.packet_type);
+        CHECK_EQUAL(3, config_frame.payload.size());
+        CHECK_EQUAL(0x03, config_frame.payload[0]);
+        uint8_t config_field = config_frame.payload[2];
+        peer_send_control(config_response, sizeof(config_response));
+        uart_complete_send();
+        CHECK_EQUAL(1, num_packet_sent_events);
+        host_frames.clear();
+        num_packet_sent_events = 0;
+        return config_field;
+    }
+
+    // send ACL packet with marker as first payload byte
+    void send_acl(uint8_t marker){
+        uint8_t * packet = &acl_buffer[4];
+        little_endian_store_16(packet, 0, 0x0001);
+        little_endian_store_16(packet, 2, 4);
+        packet[4] = marker;
+        packet[5] = 0;
+        packet[6] = 0;
+        packet[7] = 0;
+        CHECK_TRUE(transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+        CHECK_EQUAL(0, transport->send_packet(HCI_ACL_DATA_PACKET, packet, 8));
+        // upper stack may re-use buffer after HCI_EVENT_TRANSPORT_PACKET_SENT
+        uart_complete_send();
+        memset(acl_buffer, 0x55, sizeof(acl_buffer));
+    }
+
+    void check_acl_frame(const test_frame_t & frame, uint8_t seq_nr, uint8_t marker){
+        CHECK_TRUE(frame.reliable);
+        CHECK_EQUAL(HCI_ACL_DATA_PACKET, frame.packet_type);
+        CHECK_EQUAL(seq_nr, frame.seq_nr);
+        CHECK_EQUAL(8, frame.payload.size());
+        CHECK_EQUAL(marker, frame.payload[4]);
+    }
+
+    uint32_t resend_timeout_ms(void){
+        // 3 * time for largest packet + 50 ms
+        return (((HCI_INCOMING_PACKET_BUFFER_SIZE + 6) * 8 * 3000) / config.baudrate_init) + 50;
+    }
+};
+
+TEST(HCI_TRANSPORT_H5, ConfigAdvertisesSlidingWindow){
+    uint8_t config_field = activate_link(7);
+    CHECK_EQUAL(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE, config_field & 0x07);
+    // data integrity check supported
+    CHECK_EQUAL(0x10, config_field & 0x10);
+}
+
+TEST(HCI_TRANSPORT_H5, WindowLimitedByPeer){
+    activate_link(2);
+    send_acl(0);
+    CHECK_EQUAL(1, num_packet_sent_events);
+    send_acl(1);
+    // window full
+    CHECK_EQUAL(1, num_packet_sent_events);
+    CHECK_FALSE(transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+    CHECK_EQUAL(2, host_frames.size());
+}
+
+TEST(HCI_TRANSPORT_H5, SendWindowBeforeAck){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    uint8_t i;
+    for (i = 0; i < HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE; i++){
+        send_acl(i);
+    }
+    // all packets sent without ack, packet sent emitted while window not full
+    CHECK_EQUAL(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE, host_frames.size());
+    CHECK_EQUAL(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE - 1, num_packet_sent_events);
+    CHECK_FALSE(transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+    for (i = 0; i < HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE; i++){
+        check_acl_frame(host_frames[i], i, i);
+    }
+
+    // ack for first two packets frees window
+    peer_send_ack(2);
+    uart_complete_send();
+    CHECK_EQUAL(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE, num_packet_sent_events);
+    CHECK_TRUE(transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+}
+
+TEST(HCI_TRANSPORT_H5, OutOfOrderAcks){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        send_acl(i);
+    }
+    // newer ack before older one
+    peer_send_ack(3);
+    uart_complete_send();
+    peer_send_ack(1);
+    peer_send_ack(3);
+    uart_complete_send();
+
+    // only last packet is resent
+    host_frames.clear();
+    advance_time(resend_timeout_ms() + 1);
+    uart_complete_send();
+    CHECK_EQUAL(1, host_frames.size());
+    check_acl_frame(host_frames[0], 3, 3);
+
+    // stale ack doesn't release packet
+    peer_send_ack(2);
+    host_frames.clear();
+    advance_time(resend_timeout_ms() + 1);
+    uart_complete_send();
+    CHECK_EQUAL(1, host_frames.size());
+
+    peer_send_ack(4);
+    host_frames.clear();
+    advance_time(10 * resend_timeout_ms());
+    CHECK_EQUAL(0, host_frames.size());
+}
+
+TEST(HCI_TRANSPORT_H5, ResendAfterTimeout){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    send_acl(0x10);
+    send_acl(0x11);
+    send_acl(0x12);
+    host_frames.clear();
+
+    // no resend before timeout
+    advance_time(resend_timeout_ms() - 1);
+    CHECK_EQUAL(0, host_frames.size());
+
+    // all unacknowledged packets are resent with original content and sequence numbers
+    advance_time(2);
+    uart_complete_send();
+    CHECK_EQUAL(3, host_frames.size());
+    check_acl_frame(host_frames[0], 0, 0x10);
+    check_acl_frame(host_frames[1], 1, 0x11);
+    check_acl_frame(host_frames[2], 2, 0x12);
+}
+
+TEST(HCI_TRANSPORT_H5, LostFrameResent){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    send_acl(0x20);
+    send_acl(0x21);
+    send_acl(0x22);
+    advance_time(resend_timeout_ms() / 2);
+    // peer received only the first frame, drops out-of-sequence ones and acks first one again
+    peer_send_ack(1);
+    peer_send_ack(1);
+    host_frames.clear();
+    // resend timer restarted by ack
+    advance_time(resend_timeout_ms() - 1);
+    CHECK_EQUAL(0, host_frames.size());
+    advance_time(2);
+    uart_complete_send();
+    CHECK_EQUAL(2, host_frames.size());
+    check_acl_frame(host_frames[0], 1, 0x21);
+    check_acl_frame(host_frames[1], 2, 0x22);
+}
+
+TEST(HCI_TRANSPORT_H5, SequenceNumberWrap){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    uint8_t next_ack = 0;
+    uint8_t i;
+    for (i = 0; i < 20; i++){
+        if (!transport->can_send_packet_now(HCI_ACL_DATA_PACKET)){
+            // ack all but last packet
+            next_ack = (uint8_t) ((next_ack + HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE - 1) & 0x07);
+            peer_send_ack(next_ack);
+            uart_complete_send();
+        }
+        send_acl(i);
+        check_acl_frame(host_frames.back(), i & 0x07, i);
+    }
+}
+
+TEST(HCI_TRANSPORT_H5, ReceiveWindowDelaysAck){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    peer_send_event(0, 0, 0x80);
+    peer_send_event(1, 0, 0x81);
+    uart_complete_send();
+    CHECK_EQUAL(2, received_event_codes.size());
+    // ack is delayed while window is not full
+    CHECK_EQUAL(0, host_frames.size());
+    advance_time(20);
+    uart_complete_send();
+    CHECK_EQUAL(1, host_frames.size());
+    CHECK_EQUAL(LINK_ACKNOWLEDGEMENT_TYPE, host_frames[0].packet_type);
+    CHECK_EQUAL(2, host_frames[0].ack_nr);
+
+    // full window is acked right away
+    host_frames.clear();
+    uint8_t i;
+    for (i = 0; i < HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE; i++){
+        peer_send_event((2 + i) & 0x07, 0, 0x82 + i);
+    }
+    uart_complete_send();
+    CHECK_EQUAL(1, host_frames.size());
+    CHECK_EQUAL((2 + HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE) & 0x07, host_frames[0].ack_nr);
+}
+
+TEST(HCI_TRANSPORT_H5, AckCombinedWithOutgoingPacket){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    peer_send_event(0, 0, 0x80);
+    uart_complete_send();
+    send_acl(0x30);
+    CHECK_EQUAL(1, host_frames.size());
+    CHECK_EQUAL(1, host_frames[0].ack_nr);
+    // no separate ack
+    peer_send_ack(1);
+    advance_time(20);
+    uart_complete_send();
+    CHECK_EQUAL(1, host_frames.size());
+}
+
+TEST(HCI_TRANSPORT_H5, ReceiveOutOfSequence){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    peer_send_event(0, 0, 0x80);
+    // seq 1 lost, seq 2 is dropped and ack for expected seq is sent
+    peer_send_event(2, 0, 0x82);
+    uart_complete_send();
+    CHECK_EQUAL(1, received_event_codes.size());
+    CHECK_EQUAL(1, host_frames.size());
+    CHECK_EQUAL(LINK_ACKNOWLEDGEMENT_TYPE, host_frames[0].packet_type);
+    CHECK_EQUAL(1, host_frames[0].ack_nr);
+    // resent packets are accepted
+    peer_send_event(1, 0, 0x81);
+    peer_send_event(2, 0, 0x82);
+    CHECK_EQUAL(3, received_event_codes.size());
+    CHECK_EQUAL(0x82, received_event_codes[2]);
+}
+
+TEST(HCI_TRANSPORT_H5, ReceiveSequenceNumberWrap){
+    activate_link(HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE);
+    uint8_t i;
+    for (i = 0; i < 20; i++){
+        peer_send_event(i & 0x07, 0, i);
+        uart_complete_send();
+    }
+    CHECK_EQUAL(20, received_event_codes.size());
+    advance_time(20);
+    uart_complete_send();
+    CHECK_EQUAL(20 & 0x07, host_frames.back().ack_nr);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure AT command parser throughput for HF role on AG traffic recorded from a phone:
+// SLC setup, indicator updates during call setup, call list and phonebook download
+// Traffic is delivered in RFCOMM packets of up to RFCOMM_PACKET_SIZE bytes, once byte-wise and once buffer-wise
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_util.h"
+#include "classic/hfp.h"
+
+#define NUM_ITERATIONS 20000
+#define RFCOMM_PACKET_SIZE 127
+
+static const char * ag_traffic[] = {
+    "\r\n+BRSF: 3823\r\n",
+    "\r\nOK\r\n",
+    "\r\n+BCS: 2\r\n",
+    "\r\n+CIND: (\"call\",(0,1)),(\"callsetup\",(0-3)),(\"service\",(0-1)),(\"signal\",(0-5)),(\"roam\",(0,1)),(\"battchg\",(0-5)),(\"callheld\",(0-2))\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CHLD: (0,1,2,1x,2x,3,4)\r\n",
+    "\r\nOK\r\n",
+    "\r\n+BIND: (1,2)\r\n",
+    "\r\nOK\r\n",
+    "\r\n+COPS: 0,0,\"Telekom.de\"\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CNUM: ,\"+491701234567\",145,,4\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CIEV: 4,3\r\n",
+    "\r\n+CIEV: 6,4\r\n",
+    "\r\n+CIEV: 2,1\r\n",
+    "\r\nRING\r\n",
+    "\r\n+CLIP: \"+4930123456\",145,,,\"Doe, Jane\"\r\n",
+    "\r\nRING\r\n",
+    "\r\n+CLIP: \"+4930123456\",145,,,\"Doe, Jane\"\r\n",
+    "\r\n+CIEV: 1,1\r\n",
+    "\r\n+CIEV: 2,0\r\n",
+    "\r\n+VGS: 11\r\n",
+    "\r\n+CCWA: \"+4989765432\",145,1,\"Mustermann, Max\"\r\n",
+    "\r\n+CIEV: 2,1\r\n",
+    "\r\n+CLCC: 1,1,0,0,0,\"+4930123456\",145,\"Doe, Jane\"\r\n",
+    "\r\n+CLCC: 2,1,5,0,0,\"+4989765432\",145,\"Mustermann, Max\"\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CIEV: 7,1\r\n",
+    "\r\n+CIEV: 2,0\r\n",
+    "\r\n+CPBS: (\"ME\",\"SM\",\"DC\",\"RC\",\"MC\")\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CPBR: 1,\"+4930123456\",145,\"Doe, Jane\"\r\n",
+    "\r\n+CPBR: 2,\"+4989765432\",145,\"Mustermann, Max\"\r\n",
+    "\r\n+CPBR: 3,\"0800123123\",129,\"Customer Service Hotline\"\r\n",
+    "\r\n+CPBR: 4,\"+441234567890\",145,\"Smith, John (Office)\"\r\n",
+    "\r\n+CPBR: 5,\"+33123456789\",145,\"Dupont, Marie\"\r\n",
+    "\r\nOK\r\n",
+    "\r\n+CIEV: 1,0\r\n",
+    "\r\n+CIEV: 7,0\r\n",
+    "\r\n+CIEV: 5,0\r\n",
+    "\r\n+CIEV: 4,5\r\n",
+};
+
+static uint8_t  traffic[2048];
+static uint16_t traffic_len;
+static hfp_connection_t hfp_connection;
+static uint32_t lines;
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void init_traffic(void){
+    uint16_t i;
+    traffic_len = 0;
+    for (i = 0; i < (sizeof(ag_traffic) / sizeof(const char *)); i++){
+        uint16_t len = (uint16_t) strlen(ag_traffic[i]);
+        memcpy(&traffic[traffic_len], ag_traffic[i], len);
+        traffic_len += len;
+    }
+}
+
+static void init_connection(void){
+    memset(&hfp_connection, 0, sizeof(hfp_connection));
+    hfp_connection.state = HFP_SERVICE_LEVEL_CONNECTION_ESTABLISHED;
+}
+
+static int is_end_of_line(uint8_t byte){
+    return (byte == '\n') || (byte == '\r');
+}
+
+static void parse_bytewise(const uint8_t * packet, uint16_t size){
+    uint16_t pos;
+    for (pos = 0; pos < size; pos++){
+        hfp_parse(&hfp_connection, packet[pos], 1);
+        if (!is_end_of_line(packet[pos])) continue;
+        lines++;
+    }
+}
+
+static void parse_buffer(const uint8_t * packet, uint16_t size){
+    uint16_t pos = 0;
+    while (pos < size){
+        pos += hfp_parse_buffer(&hfp_connection, &packet[pos], size - pos, 1);
+        if (!is_end_of_line(packet[pos - 1])) continue;
+        lines++;
+    }
+}
+
+static void benchmark(const char * name, void (*parse)(const uint8_t * packet, uint16_t size)){
+    init_connection();
+    lines = 0;
+    double start = time_seconds();
+    uint32_t iteration;
+    for (iteration = 0; iteration < NUM_ITERATIONS; iteration++){
+        uint16_t pos;
+        for (pos = 0; pos < traffic_len; pos += RFCOMM_PACKET_SIZE){
+            (*parse)(&traffic[pos], btstack_min(RFCOMM_PACKET_SIZE, traffic_len - pos));
+        }
+    }
+    double duration = time_seconds() - start;
+    double bytes = (double) traffic_len * NUM_ITERATIONS;
+    printf("%-10s %8.2f MB/s, %6.1f ns per byte (%u lines)\n", name, bytes / duration / 1000000.0,
+           (duration * 1000000000.0) / bytes, lines);
+}
+
+int main(void){
+    init_traffic();
+    benchmark("byte-wise", &parse_bytewise);
+    benchmark("buffer", &parse_buffer);
+    return 0;
+}
@@ -76,16 +76,19 @@ static void hfp_at_parser_test_dump_line_buffer(void){
 #endif
 }
 
-static void parse_ag(const char * packet){
-    for (uint16_t pos = 0; pos < strlen(packet); pos++){
-        hfp_parse(&context, packet[pos], 0);
+static void parse_buffer(hfp_connection_t * connection, const char * packet, uint16_t size, int isHandsFree){
+    uint16_t pos = 0;
+    while (pos < size){
+        pos += hfp_parse_buffer(connection, (const uint8_t *) &packet[pos], size - pos, isHandsFree);
     }
 }
 
+static void parse_ag(const char * packet){
+    parse_buffer(&context, packet, (uint16_t) strlen(packet), 0);
+}
+
 static void parse_hf(const char * packet){
-    for (uint16_t pos = 0; pos < strlen(packet); pos++){
-        hfp_parse(&context, packet[pos], 1);
-    }
+    parse_buffer(&context, packet, (uint16_t) strlen(packet), 1);
 }
 
 TEST_GROUP(HFPParser){
@@ -651,6 +654,82 @@ TEST(HFPParser, custom_command_hf_with_assignment){
     hfp_at_parser_test_dump_line_buffer();
 }
 
+// AT traffic with quoted strings, empty fields, brackets and overlong values
+static const char * hfp_parse_buffer_ag_messages[] = {
+    "\r\nAT+BRSF=438\r\n",
+    "\r\nAT+BAC=1,2\r\n",
+    "\r\nAT+CIND=?\r\n",
+    "\r\nAT+CMER=3,0,0,1\r\n",
+    "\r\nAT+CHLD=?\r\n",
+    "\r\nAT+BIND=1,2\r\n",
+    "\r\nAT+BIEV=2,55\r\n",
+    "\r\nAT+VTS=5\r\n",
+    "\r\nATD>1234;\r\n",
+    "\r\nATD+49123456789;\r\n",
+    "\r\nAT+BVRA=1\r\n",
+    "\r\nAT+COPS=3,0\r\n",
+    "\r\nAT+BCS=2\r\nAT+VGS=9\r\nAT+VGM=11\r\n",
+    "\r\nAT+UNKNOWN=\"quoted, with separators (and) - ; \"\r\n",
+    "\r\nAT+VGS=012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789\r\n",
+};
+
+static const char * hfp_parse_buffer_hf_messages[] = {
+    "\r\n+BRSF: 1007\r\n\r\nOK\r\n",
+    "\r\n+CIND: (\"service\",(0,1)),(\"call\",(0,1)),(\"callsetup\",(0-3)),(\"battchg\",(0-5))\r\n",
+    "\r\n+CHLD: (0,1,1x,2,2x,3,4)\r\n",
+    "\r\n+CIEV: 3,1\r\n\r\n+CIEV: 2,0\r\n",
+    "\r\n+CLCC: 1,1,4,0,0,\"+49 123 456-789\",145,\"Jane Doe\"\r\n",
+    "\r\n+CLIP: \"1234567\",129,,,\"Max, Mustermann\"\r\n",
+    "\r\n+CCWA: \"7654321\",129,1\r\n",
+    "\r\n+CNUM: ,\"5551212\",129,,4\r\n",
+    "\r\n+COPS: 0,0,\"Operator Name\"\r\n",
+    "\r\n+BVRA: 1,1,12,0,\"Message text\"\r\n",
+    "\r\n+CME ERROR: 30\r\n",
+    "\r\nRING\r\n",
+    "\r\n+BINP: \"unterminated\r\n\r\nOK\r\n",
+};
+
+static void hfp_parse_buffer_check(const char * message, int isHandsFree){
+    static hfp_connection_t reference;
+    static hfp_connection_t buffered;
+    uint16_t size = (uint16_t) strlen(message);
+
+    memset(&reference, 0, sizeof(reference));
+    for (uint16_t pos = 0; pos < size; pos++){
+        hfp_parse(&reference, message[pos], isHandsFree);
+    }
+
+    // all fragmentations: in chunks of 1..size bytes
+    for (uint16_t chunk_size = 1; chunk_size <= size; chunk_size++){
+        memset(&buffered, 0, sizeof(buffered));
+        for (uint16_t pos = 0; pos < size; pos += chunk_size){
+            parse_buffer(&buffered, &message[pos], btstack_min(chunk_size, size - pos), isHandsFree);
+        }
+        MEMCMP_EQUAL(&reference, &buffered, sizeof(hfp_connection_t));
+    }
+}
+
+TEST(HFPParser, parse_buffer_matches_bytewise_ag){
+    for (uint16_t i = 0; i < sizeof(hfp_parse_buffer_ag_messages) / sizeof(const char *); i++){
+        hfp_parse_buffer_check(hfp_parse_buffer_ag_messages[i], 0);
+    }
+}
+
+TEST(HFPParser, parse_buffer_matches_bytewise_hf){
+    for (uint16_t i = 0; i < sizeof(hfp_parse_buffer_hf_messages) / sizeof(const char *); i++){
+        hfp_parse_buffer_check(hfp_parse_buffer_hf_messages[i], 1);
+    }
+}
+
+TEST(HFPParser, parse_buffer_stops_after_end_of_line){
+    const char * message = "+CIEV: 2,1\r\n+CIEV: 3,0\r\n";
+    uint16_t consumed = hfp_parse_buffer(&context, (const uint8_t *) message, (uint16_t) strlen(message), 1);
+    CHECK_EQUAL(11, consumed);
+    CHECK_EQUAL(HFP_CMD_TRANSFER_AG_INDICATOR_STATUS, context.command);
+    consumed = hfp_parse_buffer(&context, (const uint8_t *) &message[11], 2, 1);
+    CHECK_EQUAL(1, consumed);
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure packet loss concealment cost per lost frame for CVSD (CVSD_FS samples) and mSBC (SBC_FS samples)
+// Only the first frame of a burst runs the pattern match, so each loss is a single bad frame followed by good frames
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_cvsd_plc.h"
+#include "btstack_sbc_plc.h"
+
+#define NUM_LOST_FRAMES 200000
+#define GOOD_FRAMES_BETWEEN_LOSSES 4
+
+static btstack_cvsd_plc_state_t cvsd_plc_state;
+static btstack_sbc_plc_state_t  sbc_plc_state;
+
+static uint32_t signal_pos;
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+// voice-like test signal: two tones with slowly varying amplitude and some noise
+static void create_signal(int16_t * samples, uint16_t num_samples){
+    uint16_t i;
+    for (i = 0; i < num_samples; i++){
+        double t = signal_pos++;
+        double envelope = 0.5 + 0.4 * sin(t * 0.0007);
+        double value = envelope * (14000.0 * sin(t * 0.061) + 6000.0 * sin(t * 0.173)) + (double)((rand() % 1001) - 500);
+        samples[i] = (int16_t) value;
+    }
+}
+
+static void benchmark_cvsd(void){
+    int16_t in[CVSD_FS];
+    int16_t out[CVSD_FS];
+    btstack_cvsd_plc_init(&cvsd_plc_state);
+    signal_pos = 0;
+
+    double duration = 0.0;
+    uint32_t lost_frame;
+    for (lost_frame = 0; lost_frame < NUM_LOST_FRAMES; lost_frame++){
+        int i;
+        for (i = 0; i < GOOD_FRAMES_BETWEEN_LOSSES; i++){
+            create_signal(in, CVSD_FS);
+            btstack_cvsd_plc_good_frame(&cvsd_plc_state, CVSD_FS, in, out);
+        }
+        // signal continues after the lost frame
+        signal_pos += CVSD_FS;
+        double start = time_seconds();
+        btstack_cvsd_plc_bad_frame(&cvsd_plc_state, CVSD_FS, out);
+        duration += time_seconds() - start;
+    }
+    printf("CVSD PLC: %8.2f us per lost frame\n", (duration * 1000000.0) / NUM_LOST_FRAMES);
+}
+
+static void benchmark_sbc(void){
+    int16_t in[SBC_FS];
+    int16_t out[SBC_FS];
+    btstack_sbc_plc_init(&sbc_plc_state);
+    signal_pos = 0;
+
+    double duration = 0.0;
+    uint32_t lost_frame;
+    for (lost_frame = 0; lost_frame < NUM_LOST_FRAMES; lost_frame++){
+        int i;
+        for (i = 0; i < GOOD_FRAMES_BETWEEN_LOSSES; i++){
+            create_signal(in, SBC_FS);
+            btstack_sbc_plc_good_frame(&sbc_plc_state, in, out);
+        }
+        // zero input response of the decoder, approximated by the next input frame
+        create_signal(in, SBC_FS);
+        double start = time_seconds();
+        btstack_sbc_plc_bad_frame(&sbc_plc_state, in, out);
+        duration += time_seconds() - start;
+    }
+    printf("mSBC PLC: %8.2f us per lost frame\n", (duration * 1000000.0) / NUM_LOST_FRAMES);
+}
+
+int main(void){
+    benchmark_cvsd();
+    benchmark_sbc();
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Compare PLC pattern match against the original float cross correlation with approximated sqrt
+// Results are not bit-exact: ties and near-ties may select a different lag, the normalized
+// cross correlation of the selected lag must not be worse than the original one within float precision
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "classic/btstack_cvsd_plc.h"
+#include "classic/btstack_sbc_plc.h"
+
+#define MAX_CORRELATION_LOSS 1e-6
+
+static int16_t history[SBC_LHIST + SBC_FS + SBC_RT + SBC_OLAL];
+
+static uint32_t random_state;
+
+static uint32_t random_next(void){
+    random_state = random_state * 1664525u + 1013904223u;
+    return random_state;
+}
+
+static float reference_sqrt3(const float x){
+    union {
+        int i;
+        float x;
+    } u;
+    u.x = x;
+    u.i = (1<<29) + (u.i >> 1) - (1<<22);
+    u.x =       u.x + (x/u.x);
+    u.x = (0.25f*u.x) + (x/u.x);
+    return u.x;
+}
+
+static int reference_pattern_match(int16_t * y, int lhist, int m_len, int n_len){
+    float maxCn = -999999.0;
+    int   bestmatch = 0;
+    int   n;
+    for (n=0;n<n_len;n++){
+        int16_t * x = &y[lhist-m_len];
+        float num = 0;
+        float x2 = 0;
+        float y2 = 0;
+        int   m;
+        for (m=0;m<m_len;m++){
+            num+=((float)x[m])*y[n+m];
+            x2+=((float)x[m])*x[m];
+            y2+=((float)y[n+m])*y[n+m];
+        }
+        float Cn = num/reference_sqrt3(x2*y2);
+        if (Cn>maxCn){
+            bestmatch=n;
+            maxCn = Cn;
+        }
+    }
+    return bestmatch;
+}
+
+static double exact_correlation(int16_t * y, int lhist, int m_len, int n){
+    int16_t * x = &y[lhist-m_len];
+    double num = 0;
+    double x2 = 0;
+    double y2 = 0;
+    int m;
+    for (m=0;m<m_len;m++){
+        num += (double) x[m] * y[n+m];
+        x2  += (double) x[m] * x[m];
+        y2  += (double) y[n+m] * y[n+m];
+    }
+    if ((x2 == 0) || (y2 == 0)) return 0;
+    return num / sqrt(x2 * y2);
+}
+
+static void create_tone(double frequency, double amplitude, int noise){
+    unsigned int i;
+    for (i=0;i<sizeof(history)/sizeof(int16_t);i++){
+        double value = amplitude * sin(frequency * i);
+        if (noise > 0){
+            value += (double)((int)(random_next() % (2 * noise + 1)) - noise);
+        }
+        if (value >  32767.0) value =  32767.0;
+        if (value < -32768.0) value = -32768.0;
+        history[i] = (int16_t) value;
+    }
+}
+
+static void create_noise(void){
+    unsigned int i;
+    for (i=0;i<sizeof(history)/sizeof(int16_t);i++){
+        history[i] = (int16_t) (random_next() >> 16);
+    }
+}
+
+static void check_cvsd(void){
+    int reference = reference_pattern_match(history, CVSD_LHIST, CVSD_M, CVSD_N);
+    int bestmatch = btstack_cvsd_plc_pattern_match(history);
+    CHECK(bestmatch >= 0 && bestmatch < CVSD_N);
+    double loss = exact_correlation(history, CVSD_LHIST, CVSD_M, reference) - exact_correlation(history, CVSD_LHIST, CVSD_M, bestmatch);
+    CHECK(loss <= MAX_CORRELATION_LOSS);
+}
+
+static void check_sbc(void){
+    int reference = reference_pattern_match(history, SBC_LHIST, SBC_M, SBC_N);
+    int bestmatch = btstack_sbc_plc_pattern_match(history);
+    CHECK(bestmatch >= 0 && bestmatch < SBC_N);
+    double loss = exact_correlation(history, SBC_LHIST, SBC_M, reference) - exact_correlation(history, SBC_LHIST, SBC_M, bestmatch);
+    CHECK(loss <= MAX_CORRELATION_LOSS);
+}
+
+TEST_GROUP(PLC_PATTERN_MATCH){
+    void setup(void){
+        random_state = 0x12345678;
+    }
+};
+
+TEST(PLC_PATTERN_MATCH, Silence){
+    memset(history, 0, sizeof(history));
+    CHECK_EQUAL(0, btstack_cvsd_plc_pattern_match(history));
+    CHECK_EQUAL(0, btstack_sbc_plc_pattern_match(history));
+}
+
+TEST(PLC_PATTERN_MATCH, SineWave){
+    create_tone(0.0628, 29000.0, 0);
+    CHECK_EQUAL(reference_pattern_match(history, CVSD_LHIST, CVSD_M, CVSD_N), btstack_cvsd_plc_pattern_match(history));
+    CHECK_EQUAL(reference_pattern_match(history, SBC_LHIST, SBC_M, SBC_N), btstack_sbc_plc_pattern_match(history));
+}
+
+TEST(PLC_PATTERN_MATCH, TonesWithNoise){
+    int i;
+    for (i=0;i<200;i++){
+        create_tone(0.01 + 0.002 * i, 1000.0 + 150.0 * i, 50 + 10 * i);
+        check_cvsd();
+        check_sbc();
+    }
+}
+
+TEST(PLC_PATTERN_MATCH, WhiteNoise){
+    int i;
+    for (i=0;i<200;i++){
+        create_noise();
+        check_cvsd();
+        check_sbc();
+    }
+}
+
+TEST(PLC_PATTERN_MATCH, Clipped){
+    int i;
+    for (i=0;i<50;i++){
+        // overdriven tone contains -32768 samples, also within the template
+        create_tone(0.02 + 0.01 * i, 60000.0, 0);
+        check_cvsd();
+        check_sbc();
+    }
+}
+
+TEST(PLC_PATTERN_MATCH, SilentGap){
+    int i;
+    for (i=0;i<50;i++){
+        create_tone(0.03 + 0.005 * i, 20000.0, 100);
+        memset(&history[100], 0, 200 * sizeof(int16_t));
+        check_cvsd();
+        check_sbc();
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
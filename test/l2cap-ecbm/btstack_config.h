@@ -23,12 +23,14 @@
 #define ENABLE_LE_PERIPHERAL
 #define ENABLE_L2CAP_LE_CREDIT_BASED_FLOW_CONTROL_MODE
 #define ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+#define ENABLE_GATT_OVER_EATT
+#define ENABLE_ATT_DELAYED_RESPONSE
 
 // for ready-to-use hci channels
 #define FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
 
 // BTstack configuration. buffers, sizes, ...
-#define HCI_ACL_PAYLOAD_SIZE 52
+#define HCI_ACL_PAYLOAD_SIZE 100
 #define HCI_INCOMING_PRE_BUFFER_SIZE 4
 
 #endif
@@ -0,0 +1,502 @@
+
+// hal_cpu
+#include "hal_cpu.h"
+void hal_cpu_disable_irqs(void){}
+void hal_cpu_enable_irqs(void){}
+void hal_cpu_enable_irqs_and_sleep(void){}
+
+// mock_sm.c
+#include "ble/sm.h"
+void sm_add_event_handler(btstack_packet_callback_registration_t * callback_handler){}
+void sm_request_pairing(hci_con_handle_t con_handle){}
+int  sm_le_device_index(hci_con_handle_t con_handle ){ return -1; }
+irk_lookup_state_t sm_identity_resolving_state(hci_con_handle_t con_handle){ return IRK_LOOKUP_FAILED; }
+int  gap_reconnect_security_setup_active(hci_con_handle_t con_handle){ return 0; }
+
+// mock_hci_transport.h
+#include "hci_transport.h"
+void mock_hci_transport_receive_packet(uint8_t packet_type, const uint8_t * packet, uint16_t size);
+const hci_transport_t * mock_hci_transport_mock_get_instance(void);
+
+// mock_hci_transport.c, keeps last outgoing ACL packets
+#include <stddef.h>
+#define MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS 20
+static uint8_t  mock_hci_transport_outgoing_packets[MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS][HCI_ACL_PAYLOAD_SIZE + 4];
+static uint16_t mock_hci_transport_outgoing_packet_sizes[MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS];
+static uint16_t mock_hci_transport_num_outgoing_packets;
+
+static void (*mock_hci_transport_packet_handler)(uint8_t packet_type, uint8_t * packet, uint16_t size);
+static void mock_hci_transport_register_packet_handler(void (*packet_handler)(uint8_t packet_type, uint8_t * packet, uint16_t size)){
+    mock_hci_transport_packet_handler = packet_handler;
+}
+static int mock_hci_transport_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    if (packet_type != HCI_ACL_DATA_PACKET) return 0;
+    uint16_t index = mock_hci_transport_num_outgoing_packets % MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS;
+    memcpy(mock_hci_transport_outgoing_packets[index], packet, size);
+    mock_hci_transport_outgoing_packet_sizes[index] = size;
+    mock_hci_transport_num_outgoing_packets++;
+    return 0;
+}
+const hci_transport_t * mock_hci_transport_mock_get_instance(void){
+    static hci_transport_t mock_hci_transport = {
+        /*  .transport.name                          = */  "mock",
+        /*  .transport.init                          = */  NULL,
+        /*  .transport.open                          = */  NULL,
+        /*  .transport.close                         = */  NULL,
+        /*  .transport.register_packet_handler       = */  &mock_hci_transport_register_packet_handler,
+        /*  .transport.can_send_packet_now           = */  NULL,
+        /*  .transport.send_packet                   = */  &mock_hci_transport_send_packet,
+        /*  .transport.set_baudrate                  = */  NULL,
+    };
+    return &mock_hci_transport;
+}
+void mock_hci_transport_receive_packet(uint8_t packet_type, const uint8_t * packet, uint16_t size){
+    (*mock_hci_transport_packet_handler)(packet_type, (uint8_t *) packet, size);
+}
+
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "hci.h"
+#include "hci_dump.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop_embedded.h"
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "bluetooth_gatt.h"
+#include "ble/att_server.h"
+#include "ble/gatt_client.h"
+
+#define HCI_CON_HANDLE_TEST_LE 0x0005
+#define EATT_NUM_BEARERS       2
+#define EATT_REMOTE_CID_1      0x0041
+#define EATT_REMOTE_CID_2      0x0042
+#define EATT_MTU               100
+
+// hci dump that tracks L2CAP_EVENT_CAN_SEND_NOW
+static uint16_t can_send_now_cids[20];
+static uint16_t num_can_send_now_events;
+
+static void test_hci_dump_reset(void){
+}
+static void test_hci_dump_log_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len){
+    UNUSED(in);
+    UNUSED(len);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (packet[0] != L2CAP_EVENT_CAN_SEND_NOW) return;
+    if (num_can_send_now_events < (sizeof(can_send_now_cids) / sizeof(uint16_t))){
+        can_send_now_cids[num_can_send_now_events] = little_endian_read_16(packet, 2);
+    }
+    num_can_send_now_events++;
+}
+static void test_hci_dump_log_message(int log_level, const char * format, va_list argptr){
+    UNUSED(log_level);
+    UNUSED(format);
+    (void) argptr;
+}
+static const hci_dump_t test_hci_dump = {
+    &test_hci_dump_reset,
+    &test_hci_dump_log_packet,
+    &test_hci_dump_log_message,
+};
+
+static uint16_t count_can_send_now_events(uint16_t cid){
+    uint16_t count = 0;
+    uint16_t i;
+    for (i=0;i<num_can_send_now_events;i++){
+        if (can_send_now_cids[i] == cid) count++;
+    }
+    return count;
+}
+
+// L2CAP helper
+
+static void receive_l2cap_packet(uint16_t cid, const uint8_t * data, uint16_t len){
+    uint8_t packet[HCI_ACL_PAYLOAD_SIZE + 4];
+    little_endian_store_16(packet, 0, HCI_CON_HANDLE_TEST_LE | 0x2000);
+    little_endian_store_16(packet, 2, len + 4);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    memcpy(&packet[8], data, len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, len + 8);
+}
+
+// single K-Frame with SDU Length
+static void receive_att_pdu(uint16_t cid, const uint8_t * att_pdu, uint16_t len){
+    uint8_t k_frame[HCI_ACL_PAYLOAD_SIZE];
+    little_endian_store_16(k_frame, 0, len);
+    memcpy(&k_frame[2], att_pdu, len);
+    receive_l2cap_packet(cid, k_frame, len + 2);
+}
+
+// @return last outgoing L2CAP payload for cid or NULL
+static const uint8_t * get_outgoing_l2cap_payload(uint16_t cid, uint16_t * out_len){
+    uint16_t num_packets = btstack_min(mock_hci_transport_num_outgoing_packets, MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS);
+    uint16_t i;
+    for (i=1;i<=num_packets;i++){
+        uint16_t index = (mock_hci_transport_num_outgoing_packets - i) % MOCK_HCI_TRANSPORT_MAX_OUTGOING_PACKETS;
+        const uint8_t * packet = mock_hci_transport_outgoing_packets[index];
+        if (little_endian_read_16(packet, 6) != cid) continue;
+        *out_len = little_endian_read_16(packet, 4);
+        return &packet[8];
+    }
+    return NULL;
+}
+
+// ATT PDU from single K-Frame
+static const uint8_t * get_outgoing_att_pdu(uint16_t cid, uint16_t * out_len){
+    uint16_t len;
+    const uint8_t * k_frame = get_outgoing_l2cap_payload(cid, &len);
+    if (k_frame == NULL) return NULL;
+    CHECK_EQUAL(len - 2, little_endian_read_16(k_frame, 0));
+    *out_len = len - 2;
+    return &k_frame[2];
+}
+
+static void setup_encrypted_le_connection(void){
+    hci_setup_test_connections_fuzz();
+    hci_connection_t * hci_connection = hci_connection_for_handle(HCI_CON_HANDLE_TEST_LE);
+    hci_connection->sm_connection.sm_connection_encrypted = 1;
+    hci_connection->sm_connection.sm_actual_encryption_key_size = 16;
+}
+
+// ATT Server
+
+static uint16_t server_value_handle;
+static bool     server_value_ready[EATT_NUM_BEARERS];
+static uint16_t server_eatt_cids[EATT_NUM_BEARERS];
+static uint16_t server_request_cid;
+
+// server EATT bearers are accepted in order of the remote cids
+static int server_bearer_for_cid(uint16_t cid){
+    int i;
+    for (i=0;i<EATT_NUM_BEARERS;i++){
+        if (server_eatt_cids[i] == cid) return i;
+    }
+    return -1;
+}
+
+static uint16_t server_read_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    if (att_handle == ATT_READ_RESPONSE_PENDING) return 0;
+    if (att_handle != server_value_handle) return 0;
+    uint16_t cid = att_server_eatt_get_request_cid();
+    server_request_cid = cid;
+    int bearer = server_bearer_for_cid(cid);
+    if (bearer < 0) return 0;
+    if (server_value_ready[bearer] == false) return ATT_READ_RESPONSE_PENDING;
+    return att_read_callback_handle_byte(0x10 + bearer, offset, buffer, buffer_size);
+}
+
+// ECBM connection request for EATT with remote cids 0x41 and 0x42, MTU 100, MPS 48
+static const uint8_t eatt_le_conn_request[] = {
+        0x17, 0x01, 0x0c, 0x00, 0x27, 0x00, 0x64, 0x00, 0x30, 0x00, 0xff, 0xff, 0x41, 0x00, 0x42, 0x00
+};
+
+static uint8_t server_eatt_storage[2 * (sizeof(att_connection_t) + 200 + 3 * EATT_MTU)];
+
+TEST_GROUP(ATT_SERVER_EATT){
+    void setup(void){
+        btstack_memory_init();
+        btstack_run_loop_init(btstack_run_loop_embedded_get_instance());
+        hci_init(mock_hci_transport_mock_get_instance(), NULL);
+        l2cap_init();
+        hci_dump_init(&test_hci_dump);
+
+        att_db_util_init();
+        att_db_util_add_service_uuid16(ORG_BLUETOOTH_SERVICE_GENERIC_ACCESS);
+        server_value_handle = att_db_util_add_characteristic_uuid16(ORG_BLUETOOTH_CHARACTERISTIC_GAP_DEVICE_NAME,
+                ATT_PROPERTY_READ | ATT_PROPERTY_DYNAMIC, ATT_SECURITY_NONE, ATT_SECURITY_NONE, NULL, 0);
+        att_server_init(att_db_util_get_address(), &server_read_callback, NULL);
+        uint8_t status = att_server_eatt_init(EATT_NUM_BEARERS, server_eatt_storage, sizeof(server_eatt_storage));
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+
+        memset(server_value_ready, 0, sizeof(server_value_ready));
+        server_request_cid = 0xffff;
+        mock_hci_transport_num_outgoing_packets = 0;
+        num_can_send_now_events = 0;
+
+        // accept EATT bearers, get local cids from ECBM connection response
+        setup_encrypted_le_connection();
+        receive_l2cap_packet(L2CAP_CID_SIGNALING_LE, eatt_le_conn_request, sizeof(eatt_le_conn_request));
+        uint16_t len;
+        const uint8_t * response = get_outgoing_l2cap_payload(L2CAP_CID_SIGNALING_LE, &len);
+        CHECK(response != NULL);
+        CHECK_EQUAL(L2CAP_CREDIT_BASED_CONNECTION_RESPONSE, response[0]);
+        CHECK_EQUAL(0, little_endian_read_16(response, 10));
+        server_eatt_cids[0] = little_endian_read_16(response, 12);
+        server_eatt_cids[1] = little_endian_read_16(response, 14);
+        CHECK(server_eatt_cids[0] != 0);
+        CHECK(server_eatt_cids[1] != 0);
+    }
+    void teardown(void){
+        att_server_deinit();
+        l2cap_deinit();
+        hci_deinit();
+        btstack_memory_deinit();
+        btstack_run_loop_deinit();
+    }
+
+    void send_read_request(int bearer){
+        uint8_t read_request[3];
+        read_request[0] = ATT_READ_REQUEST;
+        little_endian_store_16(read_request, 1, server_value_handle);
+        receive_att_pdu(server_eatt_cids[bearer], read_request, sizeof(read_request));
+    }
+
+    // @return value of read response on remote cid or -1
+    int get_read_response(uint16_t remote_cid){
+        uint16_t len;
+        const uint8_t * att_pdu = get_outgoing_att_pdu(remote_cid, &len);
+        if (att_pdu == NULL) return -1;
+        CHECK_EQUAL(2, len);
+        CHECK_EQUAL(ATT_READ_RESPONSE, att_pdu[0]);
+        return att_pdu[1];
+    }
+};
+
+TEST(ATT_SERVER_EATT, MtuExchangeRejected){
+    const uint8_t mtu_request[] = { ATT_EXCHANGE_MTU_REQUEST, 0x00, 0x02 };
+    receive_att_pdu(server_eatt_cids[0], mtu_request, sizeof(mtu_request));
+    uint16_t len;
+    const uint8_t * att_pdu = get_outgoing_att_pdu(EATT_REMOTE_CID_1, &len);
+    CHECK(att_pdu != NULL);
+    const uint8_t expected_error[] = { ATT_ERROR_RESPONSE, ATT_EXCHANGE_MTU_REQUEST, 0x00, 0x00, ATT_ERROR_REQUEST_NOT_SUPPORTED };
+    CHECK_EQUAL(sizeof(expected_error), len);
+    MEMCMP_EQUAL(expected_error, att_pdu, len);
+}
+
+TEST(ATT_SERVER_EATT, RequestCid){
+    server_value_ready[0] = true;
+    server_value_ready[1] = true;
+    send_read_request(1);
+    CHECK_EQUAL(server_eatt_cids[1], server_request_cid);
+    send_read_request(0);
+    CHECK_EQUAL(server_eatt_cids[0], server_request_cid);
+    CHECK_EQUAL(0x10, get_read_response(EATT_REMOTE_CID_1));
+    CHECK_EQUAL(0x11, get_read_response(EATT_REMOTE_CID_2));
+}
+
+TEST(ATT_SERVER_EATT, ResponseReadyForBearer){
+    send_read_request(0);
+    send_read_request(1);
+    CHECK_EQUAL(-1, get_read_response(EATT_REMOTE_CID_1));
+    CHECK_EQUAL(-1, get_read_response(EATT_REMOTE_CID_2));
+
+    // complete request on second bearer first
+    server_value_ready[1] = true;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_eatt_response_ready(HCI_CON_HANDLE_TEST_LE, server_eatt_cids[1]));
+    CHECK_EQUAL(0x11, get_read_response(EATT_REMOTE_CID_2));
+    CHECK_EQUAL(-1, get_read_response(EATT_REMOTE_CID_1));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_eatt_response_ready(HCI_CON_HANDLE_TEST_LE, server_eatt_cids[1]));
+
+    server_value_ready[0] = true;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_eatt_response_ready(HCI_CON_HANDLE_TEST_LE, server_eatt_cids[0]));
+    CHECK_EQUAL(0x10, get_read_response(EATT_REMOTE_CID_1));
+
+    // unenhanced bearer has no pending request
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_eatt_response_ready(HCI_CON_HANDLE_TEST_LE, 0));
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, att_server_eatt_response_ready(HCI_CON_HANDLE_TEST_LE, 0x1234));
+}
+
+TEST(ATT_SERVER_EATT, ResponseReadyRetriesAllBearers){
+    send_read_request(0);
+    send_read_request(1);
+
+    // only request on first bearer can be completed
+    server_value_ready[0] = true;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_response_ready(HCI_CON_HANDLE_TEST_LE));
+    CHECK_EQUAL(0x10, get_read_response(EATT_REMOTE_CID_1));
+    CHECK_EQUAL(-1, get_read_response(EATT_REMOTE_CID_2));
+
+    // second bearer is still pending
+    server_value_ready[1] = true;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_response_ready(HCI_CON_HANDLE_TEST_LE));
+    CHECK_EQUAL(0x11, get_read_response(EATT_REMOTE_CID_2));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_response_ready(HCI_CON_HANDLE_TEST_LE));
+}
+
+// GATT Client
+
+static uint8_t  client_eatt_storage[EATT_NUM_BEARERS * 250];
+static uint16_t client_eatt_cids[EATT_NUM_BEARERS];
+static uint8_t  client_connected_status;
+static uint8_t  client_query_status;
+static uint16_t client_num_query_complete;
+
+static void client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case GATT_EVENT_CONNECTED:
+            client_connected_status = gatt_event_connected_get_status(packet);
+            break;
+        case GATT_EVENT_QUERY_COMPLETE:
+            client_query_status = gatt_event_query_complete_get_att_status(packet);
+            client_num_query_complete++;
+            break;
+        default:
+            break;
+    }
+}
+
+TEST_GROUP(GATT_CLIENT_EATT){
+    void setup(void){
+        btstack_memory_init();
+        btstack_run_loop_init(btstack_run_loop_embedded_get_instance());
+        hci_init(mock_hci_transport_mock_get_instance(), NULL);
+        l2cap_init();
+        hci_dump_init(&test_hci_dump);
+        gatt_client_init();
+        gatt_client_mtu_enable_auto_negotiation(0);
+        mock_hci_transport_num_outgoing_packets = 0;
+        num_can_send_now_events = 0;
+        client_connected_status = 0xff;
+        client_query_status = 0xff;
+        client_num_query_complete = 0;
+        setup_encrypted_le_connection();
+    }
+    void teardown(void){
+        l2cap_deinit();
+        hci_deinit();
+        btstack_memory_deinit();
+        btstack_run_loop_deinit();
+    }
+
+    // open EATT bearers, remote provides given credits
+    void connect(uint16_t credits){
+        uint8_t status = gatt_client_le_enhanced_connect(&client_packet_handler, HCI_CON_HANDLE_TEST_LE, EATT_NUM_BEARERS,
+                                                         client_eatt_storage, sizeof(client_eatt_storage));
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
+        uint16_t len;
+        const uint8_t * request = get_outgoing_l2cap_payload(L2CAP_CID_SIGNALING_LE, &len);
+        CHECK(request != NULL);
+        CHECK_EQUAL(L2CAP_CREDIT_BASED_CONNECTION_REQUEST, request[0]);
+        CHECK_EQUAL(PSM_EATT, little_endian_read_16(request, 4));
+        client_eatt_cids[0] = little_endian_read_16(request, 12);
+        client_eatt_cids[1] = little_endian_read_16(request, 14);
+
+        uint8_t response[16];
+        response[0] = L2CAP_CREDIT_BASED_CONNECTION_RESPONSE;
+        response[1] = request[1];
+        little_endian_store_16(response,  2, 12);
+        little_endian_store_16(response,  4, EATT_MTU);
+        little_endian_store_16(response,  6, 48);
+        little_endian_store_16(response,  8, credits);
+        little_endian_store_16(response, 10, 0);
+        little_endian_store_16(response, 12, EATT_REMOTE_CID_1);
+        little_endian_store_16(response, 14, EATT_REMOTE_CID_2);
+        receive_l2cap_packet(L2CAP_CID_SIGNALING_LE, response, sizeof(response));
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, client_connected_status);
+    }
+
+    uint8_t read_value(uint16_t value_handle){
+        return gatt_client_read_value_of_characteristic_using_value_handle(&client_packet_handler, HCI_CON_HANDLE_TEST_LE, value_handle);
+    }
+
+    // @return att handle of read request or 0
+    uint16_t get_read_request(uint16_t cid, bool k_frame){
+        uint16_t len;
+        const uint8_t * att_pdu = k_frame ? get_outgoing_att_pdu(cid, &len) : get_outgoing_l2cap_payload(cid, &len);
+        if (att_pdu == NULL) return 0;
+        CHECK_EQUAL(3, len);
+        CHECK_EQUAL(ATT_READ_REQUEST, att_pdu[0]);
+        return little_endian_read_16(att_pdu, 1);
+    }
+};
+
+TEST(GATT_CLIENT_EATT, BearerSelection){
+    connect(0xffff);
+
+    // unenhanced bearer first, then EATT bearers in order
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0011));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0012));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0013));
+    CHECK_EQUAL(0x0011, get_read_request(L2CAP_CID_ATTRIBUTE_PROTOCOL, false));
+    CHECK_EQUAL(0x0012, get_read_request(EATT_REMOTE_CID_1, true));
+    CHECK_EQUAL(0x0013, get_read_request(EATT_REMOTE_CID_2, true));
+
+    // all bearers busy
+    CHECK_EQUAL(GATT_CLIENT_IN_WRONG_STATE, read_value(0x0014));
+
+    // complete request on first EATT bearer, which is then used for next request
+    const uint8_t read_response[] = { ATT_READ_RESPONSE, 0x55 };
+    receive_att_pdu(client_eatt_cids[0], read_response, sizeof(read_response));
+    CHECK_EQUAL(1, client_num_query_complete);
+    CHECK_EQUAL(ATT_ERROR_SUCCESS, client_query_status);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0015));
+    CHECK_EQUAL(0x0015, get_read_request(EATT_REMOTE_CID_1, true));
+}
+
+TEST(GATT_CLIENT_EATT, BearerMtu){
+    connect(0xffff);
+    gatt_client_t * gatt_client;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gatt_client_get_client(HCI_CON_HANDLE_TEST_LE, &gatt_client));
+    gatt_client_t * eatt_client = (gatt_client_t *) gatt_client->eatt_clients;
+    CHECK(eatt_client != NULL);
+    // MTU is minimum of local and remote L2CAP MTU, unenhanced bearer unchanged
+    CHECK_EQUAL(EATT_MTU, eatt_client->mtu);
+    CHECK_EQUAL(ATT_DEFAULT_MTU, gatt_client->mtu);
+}
+
+TEST(GATT_CLIENT_EATT, IdleBearerDoesNotRequestCanSendNow){
+    // remote does not provide credits
+    connect(0);
+
+    // first request on unenhanced bearer, second gets stuck on first EATT bearer
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0011));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, read_value(0x0012));
+    CHECK_EQUAL(0, get_read_request(EATT_REMOTE_CID_1, true));
+
+    // request times out, bearer becomes idle while L2CAP is still sending
+    gatt_client_t * gatt_client;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gatt_client_get_client(HCI_CON_HANDLE_TEST_LE, &gatt_client));
+    gatt_client_t * eatt_client = (gatt_client_t *) gatt_client->eatt_clients;
+    CHECK_EQUAL(client_eatt_cids[0], eatt_client->eatt_cid);
+    eatt_client->gc_timeout.process(&eatt_client->gc_timeout);
+    CHECK_EQUAL(1, client_num_query_complete);
+    CHECK_EQUAL(ATT_ERROR_TIMEOUT, client_query_status);
+
+    // response on unenhanced bearer runs GATT Client for all bearers
+    const uint8_t read_response[] = { ATT_READ_RESPONSE, 0x55 };
+    receive_l2cap_packet(L2CAP_CID_ATTRIBUTE_PROTOCOL, read_response, sizeof(read_response));
+    CHECK_EQUAL(2, client_num_query_complete);
+    CHECK_EQUAL(ATT_ERROR_SUCCESS, client_query_status);
+
+    // credits for first EATT bearer allow to send pending SDU
+    const uint8_t credits[] = { L2CAP_FLOW_CONTROL_CREDIT_INDICATION, 0x02, 0x04, 0x00, EATT_REMOTE_CID_1, 0x00, 0x05, 0x00 };
+    receive_l2cap_packet(L2CAP_CID_SIGNALING_LE, credits, sizeof(credits));
+    CHECK_EQUAL(0x0012, get_read_request(EATT_REMOTE_CID_1, true));
+    CHECK_EQUAL(0, count_can_send_now_events(client_eatt_cids[0]));
+    CHECK_EQUAL(0, count_can_send_now_events(client_eatt_cids[1]));
+}
+
+TEST(GATT_CLIENT_EATT, IndicationOnIdleBearerConfirmed){
+    connect(0xffff);
+
+    // indication on idle EATT bearer is confirmed on the same bearer
+    const uint8_t indication[] = { ATT_HANDLE_VALUE_INDICATION, 0x20, 0x00, 0x55 };
+    receive_att_pdu(client_eatt_cids[1], indication, sizeof(indication));
+    uint16_t len;
+    const uint8_t * att_pdu = get_outgoing_att_pdu(EATT_REMOTE_CID_2, &len);
+    CHECK(att_pdu != NULL);
+    CHECK_EQUAL(1, len);
+    CHECK_EQUAL(ATT_HANDLE_VALUE_CONFIRMATION, att_pdu[0]);
+    CHECK(get_outgoing_att_pdu(EATT_REMOTE_CID_1, &len) == NULL);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -25,6 +25,7 @@
 #define ENABLE_LE_CENTRAL
 #define ENABLE_LE_PERIPHERAL
 #define ENABLE_LE_SIGNED_WRITE
+#define ENABLE_GATT_CLIENT_CACHE
 #define ENABLE_SDP_EXTRA_QUERIES
 
 // Link Key DB and LE Device DB using TLV on top of Flash Sector interface
@@ -46,6 +46,7 @@
 
 #include "ble/le_device_db.h"
 #include "ble/le_device_db_tlv.h"
+#include "ble/gatt_client.h"
 
 #include "btstack_util.h"
 #include "bluetooth.h"
@@ -212,6 +213,61 @@ TEST(LE_DEVICE_DB_TLV, ReplaceOldest){
     CHECK_EQUAL(num_entries, num_entries_test);
 }
 
+TEST(LE_DEVICE_DB_TLV, Generation){
+    uint32_t generation = le_device_db_generation();
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    CHECK_TRUE(generation != le_device_db_generation());
+
+    // encryption info does not affect generation
+    generation = le_device_db_generation();
+    uint8_t rand[8] = { 0 };
+    le_device_db_encryption_set((uint16_t) index, 0x1234, rand, sm_key_bb, 16, 0, 0, 0);
+    CHECK_EQUAL(generation, le_device_db_generation());
+
+    le_device_db_remove((uint16_t) index);
+    CHECK_TRUE(generation != le_device_db_generation());
+
+    // reload
+    generation = le_device_db_generation();
+    le_device_db_tlv_configure(btstack_tlv_impl, &btstack_tlv_context);
+    CHECK_TRUE(generation != le_device_db_generation());
+}
+
+TEST(LE_DEVICE_DB_TLV, RemoveDeletesGattClientCache){
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    CHECK_TRUE(index >= 0);
+    uint8_t cache[4] = { 1, 2, 3, 4 };
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(index), cache, sizeof(cache));
+    CHECK_EQUAL(sizeof(cache), btstack_tlv_impl->get_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(index), NULL, 0));
+
+    le_device_db_remove((uint16_t) index);
+    CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(index), NULL, 0));
+}
+
+TEST(LE_DEVICE_DB_TLV, ReplaceOldestDeletesGattClientCache){
+    bd_addr_t addr;
+    sm_key_t  sm_key;
+    int i;
+    for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
+        set_addr_and_sm_key(0x10 + i, addr, sm_key);
+        int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr, sm_key);
+        CHECK_TRUE(index >= 0);
+        uint8_t cache[2] = { 0x10, (uint8_t) i };
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(index), cache, sizeof(cache));
+    }
+    // re-adding existing device keeps its cache
+    set_addr_and_sm_key(0x11, addr, sm_key);
+    int existing_index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr, sm_key);
+    CHECK_EQUAL(2, btstack_tlv_impl->get_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(existing_index), NULL, 0));
+
+    // new device replaces oldest entry and drops its cache
+    set_addr_and_sm_key(0x80, addr, sm_key);
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr, sm_key);
+    CHECK_TRUE(index >= 0);
+    CHECK_TRUE(index != existing_index);
+    CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, GATT_CLIENT_CACHE_TLV_TAG(index), NULL, 0));
+}
+
 TEST(LE_DEVICE_DB_TLV, le_device_db_encryption_set_non_existing){
     uint16_t ediv = 16;
     int encryption_key_size = 10;
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Replay a flood of Network PDUs through mesh_network_received_message with relay enabled
+// Each PDU is received NUM_COPIES times from different neighbors, DUPLICATE_DELAY PDUs apart.
+// Duplicates not found in the network cache get relayed again.
+// Build with different MESH_NETWORK_CACHE_SIZE values to compare.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_crypto.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "mesh/adv_bearer.h"
+#include "mesh/gatt_bearer.h"
+#include "mesh/mesh_foundation.h"
+#include "mesh/mesh_iv_index_seq_number.h"
+#include "mesh/mesh_keys.h"
+#include "mesh/mesh_network.h"
+#include "mesh/mesh_node.h"
+#include "mock.h"
+
+#define NUM_SOURCES         64
+#define NUM_PDUS_PER_SOURCE 64
+#define NUM_PDUS            (NUM_SOURCES * NUM_PDUS_PER_SOURCE)
+#define NUM_COPIES          3
+#define DUPLICATE_DELAY     1000
+
+// default from mesh_network.c
+#ifndef MESH_NETWORK_CACHE_SIZE
+#define MESH_NETWORK_CACHE_SIZE 2
+#endif
+
+static uint8_t flood_pdu_data[NUM_PDUS][29];
+static uint8_t flood_pdu_len[NUM_PDUS];
+static int     flood_pdu_count;
+
+static int     adv_sent_pending;
+static bool    capture_flood;
+static uint32_t num_relayed;
+
+static btstack_packet_handler_t adv_packet_handler;
+void adv_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    adv_packet_handler = packet_handler;
+}
+void adv_bearer_request_can_send_now_for_network_pdu(void){
+    // simulate can send now
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+void adv_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size, uint8_t count, uint16_t interval){
+    UNUSED(count);
+    UNUSED(interval);
+    if (capture_flood){
+        memcpy(flood_pdu_data[flood_pdu_count], network_pdu, size);
+        flood_pdu_len[flood_pdu_count] = (uint8_t) size;
+        flood_pdu_count++;
+    } else {
+        num_relayed++;
+    }
+    adv_sent_pending = 1;
+}
+static void adv_bearer_emit_sent(void){
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_MESSAGE_SENT;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+
+void gatt_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    UNUSED(packet_handler);
+}
+void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t packet_handler){
+    UNUSED(packet_handler);
+}
+void gatt_bearer_request_can_send_now_for_network_pdu(void){
+}
+void gatt_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size){
+    UNUSED(network_pdu);
+    UNUSED(size);
+}
+
+static void network_higher_layer_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    switch (callback_type){
+        case MESH_NETWORK_PDU_RECEIVED:
+            // relay or free
+            mesh_network_message_processed_by_higher_layer(network_pdu);
+            break;
+        case MESH_NETWORK_PDU_SENT:
+            mesh_network_pdu_free(network_pdu);
+            break;
+        default:
+            break;
+    }
+}
+
+static void network_proxy_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    UNUSED(callback_type);
+    UNUSED(network_pdu);
+}
+
+static void process_pending(void){
+    while (true){
+        if (mock_process_hci_cmd()) continue;
+        if (adv_sent_pending){
+            adv_sent_pending = 0;
+            adv_bearer_emit_sent();
+            continue;
+        }
+        break;
+    }
+}
+
+static void load_network_key(void){
+    mesh_network_key_t * network_key = btstack_memory_mesh_network_key_get();
+    network_key->nid = 0x68;
+    const uint8_t encryption_key[] = { 0x09, 0x53, 0xfa, 0x93, 0xe7, 0xca, 0xac, 0x96, 0x38, 0xf5, 0x88, 0x20, 0x22, 0x0a, 0x39, 0x8e };
+    const uint8_t privacy_key[]    = { 0x8b, 0x84, 0xee, 0xde, 0xc1, 0x00, 0x06, 0x7d, 0x67, 0x09, 0x71, 0xdd, 0x2a, 0xa7, 0x00, 0xcf };
+    memcpy(network_key->encryption_key, encryption_key, 16);
+    memcpy(network_key->privacy_key, privacy_key, 16);
+    mesh_network_key_add(network_key);
+    mesh_subnet_setup_for_netkey_index(network_key->netkey_index);
+}
+
+static void create_flood(void){
+    // encrypt unsegmented access messages from NUM_SOURCES other nodes to a group address
+    const uint8_t transport_pdu_data[] = { 0x66, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a };
+    capture_flood = true;
+    int i;
+    for (i = 0; i < NUM_PDUS; i++){
+        uint16_t src = 0x0100 + (i % NUM_SOURCES);
+        uint32_t seq = 0x000100 + (i / NUM_SOURCES);
+        mesh_network_pdu_t * network_pdu = mesh_network_pdu_get();
+        mesh_network_setup_pdu(network_pdu, 0, 0x68, 0, 5, seq, src, 0xc000, transport_pdu_data, sizeof(transport_pdu_data));
+        mesh_network_send_pdu(network_pdu);
+        process_pending();
+    }
+    capture_flood = false;
+}
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void replay_flood(void){
+    int step;
+    for (step = 0; step < (flood_pdu_count + ((NUM_COPIES - 1) * DUPLICATE_DELAY)); step++){
+        int copy;
+        for (copy = 0; copy < NUM_COPIES; copy++){
+            int index = step - (copy * DUPLICATE_DELAY);
+            if ((index < 0) || (index >= flood_pdu_count)) continue;
+            mesh_network_received_message(flood_pdu_data[index], flood_pdu_len[index], 0);
+            process_pending();
+        }
+    }
+}
+
+int main(void){
+    // mesh_network logs every PDU to stdout, report results on stderr
+    if (freopen("/dev/null", "w", stdout) == NULL) return 1;
+
+    btstack_memory_init();
+    btstack_crypto_init();
+    mock_init();
+    mock_simulate_hci_state_working();
+    mesh_network_key_init();
+    mesh_network_init();
+    mesh_network_set_higher_layer_handler(&network_higher_layer_handler);
+    mesh_network_set_proxy_message_handler(&network_proxy_handler);
+    mesh_node_primary_element_address_set(0x0001);
+    mesh_set_iv_index(0x12345678);
+    mesh_foundation_relay_set(1);
+    load_network_key();
+
+    create_flood();
+
+    uint32_t num_received = NUM_COPIES * flood_pdu_count;
+    num_relayed = 0;
+    double start = time_seconds();
+    replay_flood();
+    double duration = time_seconds() - start;
+
+    fprintf(stderr, "MESH_NETWORK_CACHE_SIZE %5u: %8.0f PDUs/sec, %u received, %u relayed\n", MESH_NETWORK_CACHE_SIZE,
+            num_received / duration, num_received, num_relayed);
+    return 0;
+}
@@ -0,0 +1,234 @@
+// tests for the network message cache in mesh_network.c, build with small MESH_NETWORK_CACHE_SIZE
+// to exercise hash table collisions, backward shift deletion and FIFO eviction
+
+#include <stdio.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_crypto.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "mesh/adv_bearer.h"
+#include "mesh/gatt_bearer.h"
+#include "mesh/mesh_foundation.h"
+#include "mesh/mesh_iv_index_seq_number.h"
+#include "mesh/mesh_keys.h"
+#include "mesh/mesh_network.h"
+#include "mesh/mesh_node.h"
+#include "mock.h"
+
+#ifndef MESH_NETWORK_CACHE_SIZE
+#error "MESH_NETWORK_CACHE_SIZE required"
+#endif
+
+#define NUM_SOURCES 8
+#define NUM_PDUS    512
+
+static uint8_t network_pdu_data[NUM_PDUS][29];
+static uint8_t network_pdu_len[NUM_PDUS];
+static int     network_pdu_count;
+static bool    capture_pdus;
+static int     adv_sent_pending;
+
+static uint32_t num_pdus_received;
+
+static btstack_packet_handler_t adv_packet_handler;
+void adv_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    adv_packet_handler = packet_handler;
+}
+void adv_bearer_request_can_send_now_for_network_pdu(void){
+    // simulate can send now
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+void adv_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size, uint8_t count, uint16_t interval){
+    (void) count;
+    (void) interval;
+    if (capture_pdus){
+        memcpy(network_pdu_data[network_pdu_count], network_pdu, size);
+        network_pdu_len[network_pdu_count] = (uint8_t) size;
+        network_pdu_count++;
+    }
+    adv_sent_pending = 1;
+}
+static void adv_bearer_emit_sent(void){
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_MESSAGE_SENT;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+
+void gatt_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    (void) packet_handler;
+}
+void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t packet_handler){
+    (void) packet_handler;
+}
+void gatt_bearer_request_can_send_now_for_network_pdu(void){
+}
+void gatt_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size){
+    (void) network_pdu;
+    (void) size;
+}
+
+static void network_higher_layer_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    switch (callback_type){
+        case MESH_NETWORK_PDU_RECEIVED:
+            // not found in cache
+            num_pdus_received++;
+            mesh_network_message_processed_by_higher_layer(network_pdu);
+            break;
+        case MESH_NETWORK_PDU_SENT:
+            mesh_network_pdu_free(network_pdu);
+            break;
+        default:
+            break;
+    }
+}
+
+static void network_proxy_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    (void) callback_type;
+    (void) network_pdu;
+}
+
+static void process_pending(void){
+    while (true){
+        if (mock_process_hci_cmd()) continue;
+        if (adv_sent_pending){
+            adv_sent_pending = 0;
+            adv_bearer_emit_sent();
+            continue;
+        }
+        break;
+    }
+}
+
+static void load_network_key(void){
+    mesh_network_key_t * network_key = btstack_memory_mesh_network_key_get();
+    network_key->nid = 0x68;
+    const uint8_t encryption_key[] = { 0x09, 0x53, 0xfa, 0x93, 0xe7, 0xca, 0xac, 0x96, 0x38, 0xf5, 0x88, 0x20, 0x22, 0x0a, 0x39, 0x8e };
+    const uint8_t privacy_key[]    = { 0x8b, 0x84, 0xee, 0xde, 0xc1, 0x00, 0x06, 0x7d, 0x67, 0x09, 0x71, 0xdd, 0x2a, 0xa7, 0x00, 0xcf };
+    memcpy(network_key->encryption_key, encryption_key, 16);
+    memcpy(network_key->privacy_key, privacy_key, 16);
+    mesh_network_key_add(network_key);
+    mesh_subnet_setup_for_netkey_index(network_key->netkey_index);
+}
+
+// encrypt unsegmented access messages from NUM_SOURCES other nodes with the regular send path
+static void create_network_pdus(void){
+    const uint8_t transport_pdu_data[] = { 0x66, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a };
+    capture_pdus = true;
+    int i;
+    for (i = 0; i < NUM_PDUS; i++){
+        uint16_t src = 0x0100 + (i % NUM_SOURCES);
+        uint32_t seq = 0x000100 + (i / NUM_SOURCES);
+        mesh_network_pdu_t * network_pdu = mesh_network_pdu_get();
+        mesh_network_setup_pdu(network_pdu, 0, 0x68, 0, 5, seq, src, 0xc000, transport_pdu_data, sizeof(transport_pdu_data));
+        mesh_network_send_pdu(network_pdu);
+        process_pending();
+    }
+    capture_pdus = false;
+}
+
+// returns true if PDU was passed to higher layer, i.e. not found in cache
+static bool receive_pdu(int index){
+    uint32_t num_pdus_received_before = num_pdus_received;
+    mesh_network_received_message(network_pdu_data[index], network_pdu_len[index], 0);
+    process_pending();
+    return num_pdus_received != num_pdus_received_before;
+}
+
+// each test uses its own range of PDUs, as the cache cannot be reset
+static int next_pdu;
+static int allocate_pdus(int num_pdus){
+    int first = next_pdu;
+    next_pdu += num_pdus;
+    btstack_assert(next_pdu <= network_pdu_count);
+    return first;
+}
+
+// fill cache with other PDUs to evict everything
+static void flush_cache(void){
+    int first = allocate_pdus(MESH_NETWORK_CACHE_SIZE);
+    int i;
+    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++){
+        CHECK_TRUE(receive_pdu(first + i));
+    }
+}
+
+TEST_GROUP(MeshNetworkCache){
+    void setup(void){
+        flush_cache();
+    }
+};
+
+TEST(MeshNetworkCache, DuplicateDropped){
+    int first = allocate_pdus(2);
+    CHECK_TRUE(receive_pdu(first));
+    CHECK_FALSE(receive_pdu(first));
+    CHECK_TRUE(receive_pdu(first + 1));
+    CHECK_FALSE(receive_pdu(first));
+    CHECK_FALSE(receive_pdu(first + 1));
+}
+
+TEST(MeshNetworkCache, OldestEvicted){
+    int first = allocate_pdus(MESH_NETWORK_CACHE_SIZE + 1);
+    int i;
+    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++){
+        CHECK_TRUE(receive_pdu(first + i));
+    }
+    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++){
+        CHECK_FALSE(receive_pdu(first + i));
+    }
+    // full cache: adding one more evicts the oldest entry only
+    CHECK_TRUE(receive_pdu(first + MESH_NETWORK_CACHE_SIZE));
+    for (i = 1; i <= MESH_NETWORK_CACHE_SIZE; i++){
+        CHECK_FALSE(receive_pdu(first + i));
+    }
+    // oldest entry is received again and evicts the second oldest
+    CHECK_TRUE(receive_pdu(first));
+    CHECK_TRUE(receive_pdu(first + 1));
+}
+
+TEST(MeshNetworkCache, SlidingWindow){
+    // many evictions with a table of 2 * MESH_NETWORK_CACHE_SIZE slots cause collisions, so entries get
+    // shifted back on delete. all entries in the window must still be found, all evicted ones not
+    int num_pdus = 16 * MESH_NETWORK_CACHE_SIZE;
+    int first = allocate_pdus(num_pdus);
+    int i;
+    for (i = 0; i < num_pdus; i++){
+        CHECK_TRUE(receive_pdu(first + i));
+        int window_start = btstack_max(0, i + 1 - MESH_NETWORK_CACHE_SIZE);
+        int j;
+        for (j = window_start; j <= i; j++){
+            CHECK_FALSE(receive_pdu(first + j));
+        }
+    }
+    // all but the last MESH_NETWORK_CACHE_SIZE entries got evicted, each receive evicts the oldest cached entry
+    for (i = 0; i < num_pdus - MESH_NETWORK_CACHE_SIZE; i++){
+        CHECK_TRUE(receive_pdu(first + i));
+    }
+}
+
+int main (int argc, const char * argv[]){
+    btstack_memory_init();
+    btstack_crypto_init();
+    mock_init();
+    mock_simulate_hci_state_working();
+    mesh_network_key_init();
+    mesh_network_init();
+    mesh_network_set_higher_layer_handler(&network_higher_layer_handler);
+    mesh_network_set_proxy_message_handler(&network_proxy_handler);
+    mesh_node_primary_element_address_set(0x0001);
+    mesh_set_iv_index(0x12345678);
+    load_network_key();
+    create_network_pdus();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
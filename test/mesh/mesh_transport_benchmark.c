@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Receive unsegmented access messages on a node with many network and application keys
+// All NUM_NETWORK_KEYS network keys share the same NID and all NUM_APPLICATION_KEYS application keys
+// share the same AID. The matching keys are the last ones tried, so each PDU is validated against all of them.
+// Build with and without ENABLE_SOFTWARE_AES128 to compare HCI-style async crypto with the local multi-key path.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_crypto.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "mesh/adv_bearer.h"
+#include "mesh/gatt_bearer.h"
+#include "mesh/mesh_access.h"
+#include "mesh/mesh_foundation.h"
+#include "mesh/mesh_iv_index_seq_number.h"
+#include "mesh/mesh_keys.h"
+#include "mesh/mesh_lower_transport.h"
+#include "mesh/mesh_network.h"
+#include "mesh/mesh_node.h"
+#include "mesh/mesh_upper_transport.h"
+#include "mock.h"
+
+#define NUM_NETWORK_KEYS     16
+#define NUM_APPLICATION_KEYS 32
+#define NUM_PDUS             2000
+
+#define TEST_NID 0x68
+#define TEST_AID 0x26
+
+static uint8_t pdu_data[NUM_PDUS][29];
+static uint8_t pdu_len[NUM_PDUS];
+static int     pdu_count;
+
+static int      adv_sent_pending;
+static uint32_t num_access_messages;
+
+// btstack_memory pools are sized for a few keys only
+static mesh_network_key_t   network_keys[NUM_NETWORK_KEYS];
+static mesh_transport_key_t application_keys[NUM_APPLICATION_KEYS];
+
+static btstack_packet_handler_t adv_packet_handler;
+void adv_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    adv_packet_handler = packet_handler;
+}
+void adv_bearer_request_can_send_now_for_network_pdu(void){
+    // simulate can send now
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+void adv_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size, uint8_t count, uint16_t interval){
+    UNUSED(count);
+    UNUSED(interval);
+    memcpy(pdu_data[pdu_count], network_pdu, size);
+    pdu_len[pdu_count] = (uint8_t) size;
+    pdu_count++;
+    adv_sent_pending = 1;
+}
+static void adv_bearer_emit_sent(void){
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_MESSAGE_SENT;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+
+void gatt_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    UNUSED(packet_handler);
+}
+void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t packet_handler){
+    UNUSED(packet_handler);
+}
+void gatt_bearer_request_can_send_now_for_network_pdu(void){
+}
+void gatt_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size){
+    UNUSED(network_pdu);
+    UNUSED(size);
+}
+
+// copy from mesh_access.c, only upper transport pdus are sent
+uint16_t mesh_pdu_dst(mesh_pdu_t * pdu){
+    switch (pdu->pdu_type){
+        case MESH_PDU_TYPE_UPPER_SEGMENTED_ACCESS:
+        case MESH_PDU_TYPE_UPPER_UNSEGMENTED_ACCESS:
+            return ((mesh_upper_transport_pdu_t *) pdu)->dst;
+        default:
+            btstack_assert(false);
+            return MESH_ADDRESS_UNSASSIGNED;
+    }
+}
+
+static void access_message_handler(mesh_transport_callback_type_t callback_type, mesh_transport_status_t status, mesh_pdu_t * pdu){
+    UNUSED(status);
+    switch (callback_type){
+        case MESH_TRANSPORT_PDU_RECEIVED:
+            num_access_messages++;
+            mesh_upper_transport_message_processed_by_higher_layer(pdu);
+            break;
+        case MESH_TRANSPORT_PDU_SENT:
+            mesh_upper_transport_pdu_free(pdu);
+            break;
+        default:
+            break;
+    }
+}
+
+static void control_message_handler(mesh_transport_callback_type_t callback_type, mesh_transport_status_t status, mesh_pdu_t * pdu){
+    UNUSED(callback_type);
+    UNUSED(status);
+    UNUSED(pdu);
+}
+
+static void process_pending(void){
+    while (true){
+        if (mock_process_hci_cmd()) continue;
+        if (adv_sent_pending){
+            adv_sent_pending = 0;
+            adv_bearer_emit_sent();
+            continue;
+        }
+        break;
+    }
+}
+
+static void fill_key(uint8_t * key, uint8_t type, uint16_t index){
+    int i;
+    for (i = 0; i < 16; i++){
+        key[i] = (uint8_t) ((type << 4) ^ (index * 31) ^ (i * 7));
+    }
+}
+
+static void load_keys(void){
+    // network keys with same NID, netkey index NUM_NETWORK_KEYS-1 is used by the sender
+    uint16_t netkey_index;
+    for (netkey_index = 0; netkey_index < NUM_NETWORK_KEYS; netkey_index++){
+        mesh_network_key_t * network_key = &network_keys[netkey_index];
+        network_key->netkey_index = netkey_index;
+        network_key->nid = TEST_NID;
+        fill_key(network_key->encryption_key, 1, netkey_index);
+        fill_key(network_key->privacy_key, 2, netkey_index);
+        mesh_network_key_add(network_key);
+    }
+    mesh_subnet_setup_for_netkey_index(NUM_NETWORK_KEYS - 1);
+    // application keys with same AID bound to the last network key
+    uint16_t appkey_index;
+    for (appkey_index = 0; appkey_index < NUM_APPLICATION_KEYS; appkey_index++){
+        mesh_transport_key_t * application_key = &application_keys[appkey_index];
+        application_key->netkey_index = NUM_NETWORK_KEYS - 1;
+        application_key->appkey_index = appkey_index;
+        application_key->aid = TEST_AID;
+        application_key->akf = 1;
+        fill_key(application_key->key, 3, appkey_index);
+        mesh_transport_key_add(application_key);
+    }
+}
+
+static void create_pdus(void){
+    // unsegmented access messages from another node to a group address, encrypted with the last keys
+    const uint8_t access_pdu_data[] = { 0x82, 0x02, 0x01, 0x00, 0x01, 0x02, 0x03, 0x04 };
+    int i;
+    for (i = 0; i < NUM_PDUS; i++){
+        mesh_upper_transport_builder_t builder;
+        mesh_upper_transport_message_init(&builder, MESH_PDU_TYPE_UPPER_UNSEGMENTED_ACCESS);
+        mesh_upper_transport_message_add_data(&builder, access_pdu_data, sizeof(access_pdu_data));
+        mesh_pdu_t * pdu = (mesh_pdu_t *) mesh_upper_transport_message_finalize(&builder);
+        mesh_upper_transport_setup_access_pdu_header(pdu, NUM_NETWORK_KEYS - 1, NUM_APPLICATION_KEYS - 1, 5, 0x0100, 0xc000, 0);
+        mesh_upper_transport_send_access_pdu(pdu);
+        process_pending();
+    }
+}
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+int main(void){
+    // mesh stack logs every PDU to stdout, report results on stderr
+    if (freopen("/dev/null", "w", stdout) == NULL) return 1;
+
+    btstack_memory_init();
+    btstack_crypto_init();
+    mock_init();
+    mock_simulate_hci_state_working();
+    mesh_network_key_init();
+    mesh_network_init();
+    mesh_lower_transport_init();
+    mesh_upper_transport_init();
+    mesh_upper_transport_register_access_message_handler(&access_message_handler);
+    mesh_upper_transport_register_control_message_handler(&control_message_handler);
+    mesh_node_primary_element_address_set(0x0001);
+    mesh_set_iv_index(0x12345678);
+    load_keys();
+
+    create_pdus();
+
+    num_access_messages = 0;
+    double start = time_seconds();
+    int i;
+    for (i = 0; i < pdu_count; i++){
+        mesh_network_received_message(pdu_data[i], pdu_len[i], 0);
+        process_pending();
+    }
+    double duration = time_seconds() - start;
+
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+    const char * variant = "local AES128";
+#else
+    const char * variant = "async crypto";
+#endif
+    fprintf(stderr, "%s, %u network keys, %u application keys: %8.0f PDUs/sec, %u received, %u access messages\n",
+            variant, NUM_NETWORK_KEYS, NUM_APPLICATION_KEYS, pdu_count / duration, pdu_count, num_access_messages);
+    return 0;
+}
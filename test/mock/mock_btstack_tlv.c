@@ -41,7 +41,7 @@
 
 #include "mock_btstack_tlv.h"
 
-#define MAX_TLV_VALUE_SIZE 200
+#define MAX_TLV_VALUE_SIZE 2048
 #define DUMMY_SIZE 4
 typedef struct tlv_entry {
     void   * next;
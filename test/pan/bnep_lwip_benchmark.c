@@ -0,0 +1,545 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// iperf-style UDP throughput through bnep_lwip.c, BNEP, L2CAP and HCI with a loopback HCI transport
+// The loopback transport plays the remote PANU: it opens the L2CAP channel and the BNEP connection,
+// completes every outgoing ACL packet and injects incoming ACL packets with BNEP frames
+// RX: UDP datagrams from the remote are received by a lwIP UDP PCB
+// TX: UDP datagrams with PBUF_REF payload are broadcast by lwIP, resulting in a pbuf chain per frame
+// Before the benchmark, the content of received and sent frames is verified, including frames held by the
+// UDP receiver after input and Ethernet/VLAN headers split across pbufs. Returns 1 on failure.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/ieee.h"
+#include "lwip/udp.h"
+
+#include "bnep_lwip.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "bluetooth_psm.h"
+#include "bluetooth_sdp.h"
+#include "classic/bnep.h"
+#include "hci.h"
+#include "l2cap.h"
+
+#define NUM_DATAGRAMS 200000
+#define UDP_PAYLOAD_LEN 1400
+#define UDP_PORT 5001
+
+// classic connection created by hci_setup_test_connections_fuzz
+#define CON_HANDLE 0x0003
+#define REMOTE_CID 0x0040
+
+#define ACL_HEADER_LEN   4
+#define L2CAP_HEADER_LEN 4
+#define ETH_HEADER_LEN   14
+#define VLAN_TAG_LEN     4
+#define IP_HEADER_LEN    20
+#define UDP_HEADER_LEN   8
+
+#define NUM_HELD_DATAGRAMS 2
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// packets to inject, queued as transport must not call packet handler from send
+#define MAX_PENDING_PACKETS 8
+static uint8_t  pending_packets[MAX_PENDING_PACKETS][64];
+static uint16_t pending_packet_sizes[MAX_PENDING_PACKETS];
+static uint8_t  pending_packet_types[MAX_PENDING_PACKETS];
+static uint16_t pending_packets_num;
+static uint16_t pending_completed_packets;
+static bool     transport_packet_sent_pending;
+
+static uint16_t local_cid;
+static uint8_t  remote_sig_id = 1;
+static bool     bnep_channel_open;
+
+static uint32_t tx_frames;
+static uint32_t tx_bytes;
+static uint32_t rx_datagrams;
+static uint32_t rx_bytes;
+
+// content checks
+static uint32_t check_failures;
+static bool     rx_verify;
+static uint8_t  rx_expected_seed;
+static bool     rx_hold;
+static struct pbuf * rx_held[NUM_HELD_DATAGRAMS];
+static uint16_t rx_held_num;
+static uint8_t  tx_capture[HCI_ACL_PAYLOAD_SIZE + ACL_HEADER_LEN];
+static uint16_t tx_capture_len;
+
+static uint8_t  rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + ACL_HEADER_LEN + L2CAP_HEADER_LEN + 1 + 2 + IP_HEADER_LEN + UDP_HEADER_LEN + UDP_PAYLOAD_LEN];
+static uint8_t  ip_packet[IP_HEADER_LEN + UDP_HEADER_LEN + UDP_PAYLOAD_LEN];
+static uint8_t  tx_payload[UDP_PAYLOAD_LEN];
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static uint8_t * queue_packet(uint8_t packet_type, uint16_t size){
+    btstack_assert(pending_packets_num < MAX_PENDING_PACKETS);
+    btstack_assert(size <= sizeof(pending_packets[0]));
+    pending_packet_types[pending_packets_num] = packet_type;
+    pending_packet_sizes[pending_packets_num] = size;
+    return pending_packets[pending_packets_num++];
+}
+
+static void queue_signaling_packet(uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t len){
+    uint8_t * packet = queue_packet(HCI_ACL_DATA_PACKET, ACL_HEADER_LEN + L2CAP_HEADER_LEN + 4 + len);
+    little_endian_store_16(packet, 0, CON_HANDLE | 0x2000);
+    little_endian_store_16(packet, 2, L2CAP_HEADER_LEN + 4 + len);
+    little_endian_store_16(packet, 4, 4 + len);
+    little_endian_store_16(packet, 6, L2CAP_CID_SIGNALING);
+    packet[8] = code;
+    packet[9] = sig_id;
+    little_endian_store_16(packet, 10, len);
+    memcpy(&packet[12], data, len);
+}
+
+static void queue_bnep_packet(const uint8_t * data, uint16_t len){
+    uint8_t * packet = queue_packet(HCI_ACL_DATA_PACKET, ACL_HEADER_LEN + L2CAP_HEADER_LEN + len);
+    little_endian_store_16(packet, 0, CON_HANDLE | 0x2000);
+    little_endian_store_16(packet, 2, L2CAP_HEADER_LEN + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, local_cid);
+    memcpy(&packet[8], data, len);
+}
+
+static void handle_signaling_packet(const uint8_t * command){
+    uint8_t data[8];
+    switch (command[0]){
+        case CONNECTION_RESPONSE:
+            // dest cid, source cid, result, status
+            local_cid = little_endian_read_16(command, 4);
+            // our configure request with MTU option
+            little_endian_store_16(data, 0, local_cid);
+            little_endian_store_16(data, 2, 0);
+            data[4] = 0x01;     // MTU option
+            data[5] = 2;
+            little_endian_store_16(data, 6, HCI_ACL_PAYLOAD_SIZE - L2CAP_HEADER_LEN);
+            queue_signaling_packet(CONFIGURE_REQUEST, remote_sig_id++, data, 8);
+            break;
+        case CONFIGURE_REQUEST:
+            // accept: source cid, flags, result
+            little_endian_store_16(data, 0, local_cid);
+            little_endian_store_16(data, 2, 0);
+            little_endian_store_16(data, 4, 0);     // success
+            queue_signaling_packet(CONFIGURE_RESPONSE, command[1], data, 6);
+            break;
+        case INFORMATION_REQUEST:
+            // info type, result = not supported
+            little_endian_store_16(data, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(data, 2, 1);
+            queue_signaling_packet(INFORMATION_RESPONSE, command[1], data, 4);
+            break;
+        default:
+            break;
+    }
+}
+
+static int hci_transport_loopback_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return transport_packet_sent_pending ? 0 : 1;
+}
+
+static int hci_transport_loopback_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    transport_packet_sent_pending = true;
+    if (packet_type != HCI_ACL_DATA_PACKET) return 0;
+    pending_completed_packets++;
+    uint16_t cid = little_endian_read_16(packet, 6);
+    if (cid == L2CAP_CID_SIGNALING){
+        handle_signaling_packet(&packet[8]);
+    } else {
+        tx_frames++;
+        tx_bytes += little_endian_read_16(packet, 4);
+        btstack_assert(size <= (int) sizeof(tx_capture));
+        memcpy(tx_capture, packet, size);
+        tx_capture_len = (uint16_t) size;
+    }
+    return 0;
+}
+
+static void hci_transport_loopback_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+// asynchronous transport, HCI_EVENT_TRANSPORT_PACKET_SENT is emitted by process_pending_packets
+static const hci_transport_t hci_transport_loopback = {
+        /* const char * name; */                                        "LOOPBACK",
+        /* void   (*init) (const void *transport_config); */            NULL,
+        /* int    (*open)(void); */                                     NULL,
+        /* int    (*close)(void); */                                    NULL,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_loopback_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_loopback_can_send_packet_now,
+        /* int    (*send_packet)(...); */                               &hci_transport_loopback_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+// confirm sent packet, complete sent ACL packets and deliver queued packets
+static void process_pending_packets(void){
+    while (transport_packet_sent_pending || (pending_packets_num > 0) || (pending_completed_packets > 0)){
+        if (transport_packet_sent_pending){
+            const uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+            transport_packet_sent_pending = false;
+            packet_handler(HCI_EVENT_PACKET, (uint8_t *) event, sizeof(event));
+            continue;
+        }
+        if (pending_completed_packets > 0){
+            uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5, 1, 0, 0, 0, 0};
+            little_endian_store_16(event, 3, CON_HANDLE);
+            little_endian_store_16(event, 5, pending_completed_packets);
+            pending_completed_packets = 0;
+            packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+            continue;
+        }
+        uint8_t packet[HCI_INCOMING_PRE_BUFFER_SIZE + sizeof(pending_packets[0])];
+        uint16_t size = pending_packet_sizes[0];
+        uint8_t  packet_type = pending_packet_types[0];
+        memcpy(&packet[HCI_INCOMING_PRE_BUFFER_SIZE], pending_packets[0], size);
+        pending_packets_num--;
+        memmove(&pending_packets[0], &pending_packets[1], pending_packets_num * sizeof(pending_packets[0]));
+        memmove(&pending_packet_sizes[0], &pending_packet_sizes[1], pending_packets_num * sizeof(uint16_t));
+        memmove(&pending_packet_types[0], &pending_packet_types[1], pending_packets_num);
+        packet_handler(packet_type, &packet[HCI_INCOMING_PRE_BUFFER_SIZE], size);
+    }
+}
+
+static void bnep_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != BNEP_EVENT_CHANNEL_OPENED) return;
+    bnep_channel_open = bnep_event_channel_opened_get_status(packet) == ERROR_CODE_SUCCESS;
+}
+
+static void check(bool ok, const char * what){
+    if (ok) return;
+    printf("FAILED: %s\n", what);
+    check_failures++;
+}
+
+static void fill_pattern(uint8_t * buffer, uint16_t len, uint8_t seed){
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        buffer[i] = (uint8_t) (seed + i);
+    }
+}
+
+static bool pbuf_has_pattern(struct pbuf * p, uint8_t seed){
+    uint8_t expected[UDP_PAYLOAD_LEN];
+    uint8_t actual[UDP_PAYLOAD_LEN];
+    if (p->tot_len != UDP_PAYLOAD_LEN) return false;
+    fill_pattern(expected, UDP_PAYLOAD_LEN, seed);
+    pbuf_copy_partial(p, actual, UDP_PAYLOAD_LEN, 0);
+    return memcmp(expected, actual, UDP_PAYLOAD_LEN) == 0;
+}
+
+static void udp_receive_handler(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port){
+    UNUSED(arg);
+    UNUSED(pcb);
+    UNUSED(addr);
+    UNUSED(port);
+    rx_datagrams++;
+    rx_bytes += p->tot_len;
+    if (rx_verify){
+        check(pbuf_has_pattern(p, rx_expected_seed), "RX payload");
+    }
+    // keep pbuf like an application that processes the datagram later
+    if (rx_hold && (rx_held_num < NUM_HELD_DATAGRAMS)){
+        rx_held[rx_held_num++] = p;
+        return;
+    }
+    pbuf_free(p);
+}
+
+static void open_bnep_channel(void){
+    uint8_t data[4];
+    // L2CAP Connection Request for BNEP
+    little_endian_store_16(data, 0, BLUETOOTH_PSM_BNEP);
+    little_endian_store_16(data, 2, REMOTE_CID);
+    queue_signaling_packet(CONNECTION_REQUEST, remote_sig_id++, data, 4);
+    process_pending_packets();
+
+    // BNEP Setup Connection Request from PANU to NAP
+    uint8_t setup_request[] = { 0x01, 0x01, 2, 0, 0, 0, 0 };
+    big_endian_store_16(setup_request, 3, BLUETOOTH_SERVICE_CLASS_NAP);
+    big_endian_store_16(setup_request, 5, BLUETOOTH_SERVICE_CLASS_PANU);
+    queue_bnep_packet(setup_request, sizeof(setup_request));
+    process_pending_packets();
+}
+
+// IPv4 UDP datagram from remote 192.168.7.2 to 192.168.7.1 with payload pattern starting at seed
+static void create_ip_packet(uint8_t seed){
+    memset(ip_packet, 0, sizeof(ip_packet));
+    ip_packet[0] = 0x45;
+    big_endian_store_16(ip_packet, 2, sizeof(ip_packet));
+    ip_packet[8] = 64;
+    ip_packet[9] = IP_PROTO_UDP;
+    uint8_t src_ip[] = { 192, 168, 7, 2 };
+    uint8_t dst_ip[] = { 192, 168, 7, 1 };
+    memcpy(&ip_packet[12], src_ip, 4);
+    memcpy(&ip_packet[16], dst_ip, 4);
+    uint16_t checksum = inet_chksum(ip_packet, IP_HEADER_LEN);
+    memcpy(&ip_packet[10], &checksum, 2);
+    // UDP header without checksum
+    big_endian_store_16(ip_packet, IP_HEADER_LEN + 0, UDP_PORT);
+    big_endian_store_16(ip_packet, IP_HEADER_LEN + 2, UDP_PORT);
+    big_endian_store_16(ip_packet, IP_HEADER_LEN + 4, UDP_HEADER_LEN + UDP_PAYLOAD_LEN);
+    fill_pattern(&ip_packet[IP_HEADER_LEN + UDP_HEADER_LEN], UDP_PAYLOAD_LEN, seed);
+}
+
+static void inject_datagram(void){
+    // BNEP processes frames in place, rebuild headers and payload
+    uint8_t * packet = &rx_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    uint16_t bnep_len = 1 + 2 + sizeof(ip_packet);
+    little_endian_store_16(packet, 0, CON_HANDLE | 0x2000);
+    little_endian_store_16(packet, 2, L2CAP_HEADER_LEN + bnep_len);
+    little_endian_store_16(packet, 4, bnep_len);
+    little_endian_store_16(packet, 6, local_cid);
+    packet[8] = 0x02;   // BNEP compressed ethernet
+    big_endian_store_16(packet, 9, 0x0800);   // IPv4
+    memcpy(&packet[11], ip_packet, sizeof(ip_packet));
+    packet_handler(HCI_ACL_DATA_PACKET, packet, ACL_HEADER_LEN + L2CAP_HEADER_LEN + bnep_len);
+}
+
+static void check_rx(void){
+    struct udp_pcb * pcb = udp_new();
+    udp_bind(pcb, IP_ADDR_ANY, UDP_PORT);
+    udp_recv(pcb, &udp_receive_handler, NULL);
+    rx_verify = true;
+    rx_datagrams = 0;
+
+    // datagrams passed by reference into HCI buffer
+    uint8_t seed;
+    for (seed = 1; seed <= 3; seed++){
+        create_ip_packet(seed);
+        rx_expected_seed = seed;
+        inject_datagram();
+    }
+    check(rx_datagrams == 3, "RX datagrams");
+
+    // datagrams kept by receiver have to be moved out of the HCI buffer, which gets reused
+    rx_hold = true;
+    for (seed = 0; seed < NUM_HELD_DATAGRAMS; seed++){
+        create_ip_packet(0x10 + seed);
+        rx_expected_seed = 0x10 + seed;
+        inject_datagram();
+    }
+    rx_hold = false;
+    check(rx_held_num == NUM_HELD_DATAGRAMS, "RX datagrams held");
+    memset(rx_buffer, 0, sizeof(rx_buffer));
+    for (seed = 0; seed < rx_held_num; seed++){
+        check(pbuf_has_pattern(rx_held[seed], 0x10 + seed), "RX payload of held datagram");
+        pbuf_free(rx_held[seed]);
+    }
+    rx_held_num = 0;
+
+    // spare buffer is available again
+    create_ip_packet(0x20);
+    rx_expected_seed = 0x20;
+    inject_datagram();
+    check(rx_datagrams == 3 + NUM_HELD_DATAGRAMS + 1, "RX datagrams after held datagrams released");
+
+    rx_verify = false;
+    udp_remove(pcb);
+}
+
+// send ethernet frame as pbuf chain with fragments of given lengths, last fragment gets the remainder
+static void send_ethernet_frame(const uint8_t * frame, uint16_t frame_len, const uint16_t * fragment_lens, uint16_t num_fragments){
+    struct pbuf * chain = NULL;
+    uint16_t pos = 0;
+    uint16_t i;
+    for (i = 0; i < num_fragments; i++){
+        uint16_t len = (i == (num_fragments - 1u)) ? (frame_len - pos) : fragment_lens[i];
+        struct pbuf * p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+        p->payload = (void *) &frame[pos];
+        if (chain == NULL){
+            chain = p;
+        } else {
+            pbuf_cat(chain, p);
+        }
+        pos += len;
+    }
+    tx_capture_len = 0;
+    netif_default->linkoutput(netif_default, chain);
+    pbuf_free(chain);
+    process_pending_packets();
+}
+
+static void check_tx_fragments(bool vlan, const uint16_t * fragment_lens, uint16_t num_fragments, const char * what){
+    uint8_t frame[ETH_HEADER_LEN + VLAN_TAG_LEN + 100];
+    uint16_t pos = 0;
+    // broadcast from a different source, sent as BNEP General Ethernet
+    memset(&frame[pos], 0xff, 6);
+    pos += 6;
+    const uint8_t source[] = { 0x02, 0x11, 0x22, 0x33, 0x44, 0x55 };
+    memcpy(&frame[pos], source, 6);
+    pos += 6;
+    if (vlan){
+        big_endian_store_16(frame, pos, ETHTYPE_VLAN);
+        big_endian_store_16(frame, pos + 2, 0x0123);
+        pos += VLAN_TAG_LEN;
+    }
+    big_endian_store_16(frame, pos, ETHTYPE_IP);
+    pos += 2;
+    uint16_t payload_len = sizeof(frame) - pos;
+    fill_pattern(&frame[pos], payload_len, 0x30);
+
+    // reference: unfragmented frame
+    const uint16_t single = sizeof(frame);
+    send_ethernet_frame(frame, sizeof(frame), &single, 1);
+    uint8_t  reference[sizeof(tx_capture)];
+    uint16_t reference_len = tx_capture_len;
+    memcpy(reference, tx_capture, reference_len);
+
+    // BNEP General Ethernet: type, destination, source, protocol type, (VLAN TCI + protocol type), payload
+    uint16_t bnep_pos = ACL_HEADER_LEN + L2CAP_HEADER_LEN;
+    check(reference_len == (bnep_pos + 1 + sizeof(frame)), what);
+    check(reference[bnep_pos] == 0x00, what);
+    check(memcmp(&reference[bnep_pos + 1], frame, 12) == 0, what);
+    check(memcmp(&reference[reference_len - payload_len], &frame[sizeof(frame) - payload_len], payload_len) == 0, what);
+
+    // same frame split into fragments
+    send_ethernet_frame(frame, sizeof(frame), fragment_lens, num_fragments);
+    check((tx_capture_len == reference_len) && (memcmp(tx_capture, reference, reference_len) == 0), what);
+}
+
+static void check_tx(void){
+    // split within source address and within ethertype
+    const uint16_t split_ethernet_header[] = { 10, 3 };
+    check_tx_fragments(false, split_ethernet_header, 3, "TX ethernet header split across fragments");
+    // split within VLAN tag
+    const uint16_t split_vlan_tag[] = { 13, 2, 1, 2 };
+    check_tx_fragments(true, split_vlan_tag, 5, "TX VLAN tag split across fragments");
+    // one byte per fragment for the headers
+    const uint16_t split_bytes[] = { 1, 1, 1, 1, 1, 1, 1 };
+    check_tx_fragments(true, split_bytes, 8, "TX headers in single byte fragments");
+}
+
+static void benchmark_rx(void){
+    struct udp_pcb * pcb = udp_new();
+    udp_bind(pcb, IP_ADDR_ANY, UDP_PORT);
+    udp_recv(pcb, &udp_receive_handler, NULL);
+
+    create_ip_packet(0x55);
+    rx_datagrams = 0;
+    rx_bytes = 0;
+    double start = time_seconds();
+    uint32_t i;
+    for (i = 0; i < NUM_DATAGRAMS; i++){
+        inject_datagram();
+    }
+    double duration = time_seconds() - start;
+    printf("RX: %8.1f Mbit/s, %6.0f ns per frame (%u datagrams)\n", (8.0 * rx_bytes) / duration / 1000000.0,
+           (duration * 1000000000.0) / NUM_DATAGRAMS, rx_datagrams);
+
+    udp_remove(pcb);
+}
+
+static void benchmark_tx(void){
+    struct udp_pcb * pcb = udp_new();
+    ip_addr_t broadcast;
+    IP4_ADDR(ip_2_ip4(&broadcast), 192, 168, 7, 255);
+    memset(tx_payload, 0x55, sizeof(tx_payload));
+
+    tx_frames = 0;
+    tx_bytes = 0;
+    double start = time_seconds();
+    uint32_t i;
+    for (i = 0; i < NUM_DATAGRAMS; i++){
+        struct pbuf * p = pbuf_alloc(PBUF_TRANSPORT, sizeof(tx_payload), PBUF_REF);
+        p->payload = tx_payload;
+        udp_sendto(pcb, p, &broadcast, UDP_PORT);
+        pbuf_free(p);
+        process_pending_packets();
+    }
+    double duration = time_seconds() - start;
+    printf("TX: %8.1f Mbit/s, %6.0f ns per frame (%u frames)\n", (8.0 * NUM_DATAGRAMS * UDP_PAYLOAD_LEN) / duration / 1000000.0,
+           (duration * 1000000000.0) / NUM_DATAGRAMS, tx_frames);
+
+    udp_remove(pcb);
+}
+
+int main(void){
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    hci_init(&hci_transport_loopback, NULL);
+    hci_simulate_working_fuzz();
+    hci_setup_test_connections_fuzz();
+    l2cap_init();
+    bnep_init();
+    bnep_set_required_security_level(LEVEL_0);
+
+    lwip_init();
+    bnep_lwip_init();
+    bnep_lwip_register_service(BLUETOOTH_SERVICE_CLASS_NAP, 1691);
+    bnep_lwip_register_packet_handler(&bnep_event_handler);
+
+    open_bnep_channel();
+    if (!bnep_channel_open){
+        printf("BNEP channel not open\n");
+        return 1;
+    }
+
+    check_rx();
+    check_tx();
+    if (check_failures > 0){
+        printf("%u checks failed\n", check_failures);
+        return 1;
+    }
+    printf("Content checks passed\n");
+
+    benchmark_rx();
+    benchmark_tx();
+    return 0;
+}
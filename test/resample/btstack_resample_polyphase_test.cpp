@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_resample_polyphase.h"
+
+#define NUM_FRAMES 1000
+
+static btstack_resample_polyphase_t resample;
+
+static int16_t input_buffer[NUM_FRAMES * 2];
+static int16_t output_buffer[(NUM_FRAMES * 2 + 10) * 2];
+static int16_t output_buffer_reference[(NUM_FRAMES * 2 + 10) * 2];
+
+static const btstack_resample_polyphase_quality_t qualities[] = {
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_LOW,
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_MEDIUM,
+    BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH,
+};
+
+static void create_sine(int num_channels, double amplitude){
+    int i;
+    for (i = 0; i < NUM_FRAMES; i++){
+        int channel;
+        for (channel = 0; channel < num_channels; channel++){
+            input_buffer[i * num_channels + channel] = (int16_t) (amplitude * sin(0.1 * i + channel));
+        }
+    }
+}
+
+TEST_GROUP(ResamplePolyphase){
+    void setup(void){
+        memset(input_buffer, 0, sizeof(input_buffer));
+        memset(output_buffer, 0, sizeof(output_buffer));
+        memset(output_buffer_reference, 0, sizeof(output_buffer_reference));
+    }
+};
+
+TEST(ResamplePolyphase, IdentityFrameCount){
+    unsigned int i;
+    for (i = 0; i < sizeof(qualities) / sizeof(qualities[0]); i++){
+        btstack_resample_polyphase_init(&resample, 1, qualities[i]);
+        uint32_t num_frames = 0;
+        int block;
+        for (block = 0; block < 10; block++){
+            num_frames += btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES / 10, output_buffer);
+        }
+        CHECK_EQUAL(NUM_FRAMES, num_frames);
+    }
+}
+
+TEST(ResamplePolyphase, FactorFrameCount){
+    btstack_resample_polyphase_init(&resample, 2, BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH);
+    btstack_resample_polyphase_set_factor(&resample, 0x8000);
+    CHECK_EQUAL(2 * NUM_FRAMES, btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer));
+    btstack_resample_polyphase_set_factor(&resample, 0x20000);
+    CHECK_EQUAL(NUM_FRAMES / 2, btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer));
+}
+
+TEST(ResamplePolyphase, DcGain){
+    int i;
+    for (i = 0; i < NUM_FRAMES; i++){
+        input_buffer[i] = 10000;
+    }
+    unsigned int j;
+    for (j = 0; j < sizeof(qualities) / sizeof(qualities[0]); j++){
+        btstack_resample_polyphase_init(&resample, 1, qualities[j]);
+        btstack_resample_polyphase_set_factor(&resample, 0x10000 + 33);
+        uint16_t num_frames = btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer);
+        // skip filter delay
+        for (i = BTSTACK_RESAMPLE_POLYPHASE_MAX_TAPS; i < num_frames; i++){
+            CHECK(abs(output_buffer[i] - 10000) <= 1);
+        }
+    }
+}
+
+TEST(ResamplePolyphase, BlockSizeIndependent){
+    create_sine(2, 30000.0);
+    btstack_resample_polyphase_init(&resample, 2, BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH);
+    btstack_resample_polyphase_set_factor(&resample, 0x10000 - 1234);
+    uint16_t num_frames_reference = btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer_reference);
+
+    btstack_resample_polyphase_init(&resample, 2, BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH);
+    btstack_resample_polyphase_set_factor(&resample, 0x10000 - 1234);
+    uint16_t num_frames = 0;
+    uint32_t pos = 0;
+    while (pos < NUM_FRAMES){
+        uint32_t block_frames = NUM_FRAMES - pos;
+        if (block_frames > 7){
+            block_frames = 7;
+        }
+        num_frames += btstack_resample_polyphase_block(&resample, &input_buffer[pos * 2], block_frames, &output_buffer[num_frames * 2]);
+        pos += block_frames;
+    }
+    CHECK_EQUAL(num_frames_reference, num_frames);
+    MEMCMP_EQUAL(output_buffer_reference, output_buffer, num_frames * 2 * sizeof(int16_t));
+}
+
+TEST(ResamplePolyphase, ChannelsIndependent){
+    int i;
+    for (i = 0; i < NUM_FRAMES; i++){
+        input_buffer[i * 2] = (int16_t) (20000.0 * sin(0.3 * i));
+    }
+    btstack_resample_polyphase_init(&resample, 2, BTSTACK_RESAMPLE_POLYPHASE_QUALITY_MEDIUM);
+    btstack_resample_polyphase_set_factor(&resample, 0x10000 + 100);
+    uint16_t num_frames = btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer);
+    int energy = 0;
+    for (i = 0; i < num_frames; i++){
+        CHECK_EQUAL(0, output_buffer[i * 2 + 1]);
+        energy |= output_buffer[i * 2];
+    }
+    CHECK(energy != 0);
+}
+
+TEST(ResamplePolyphase, Saturation){
+    create_sine(1, 32767.0);
+    int i;
+    for (i = 0; i < NUM_FRAMES; i += 2){
+        input_buffer[i] = (input_buffer[i] > 0) ? 32767 : -32768;
+    }
+    btstack_resample_polyphase_init(&resample, 1, BTSTACK_RESAMPLE_POLYPHASE_QUALITY_HIGH);
+    btstack_resample_polyphase_set_factor(&resample, 0x10000 + 500);
+    uint16_t num_frames = btstack_resample_polyphase_block(&resample, input_buffer, NUM_FRAMES, output_buffer);
+    CHECK(num_frames > 0);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
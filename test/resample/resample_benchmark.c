@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Compare linear and polyphase resampling for a drift compensation factor:
+// - THD+N of resampled sine waves at 48 kHz
+// - throughput for 48 kHz stereo in frames/sec and number of real-time streams per core
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_resample.h"
+#include "btstack_resample_polyphase.h"
+
+#define SAMPLE_RATE     48000
+#define NUM_CHANNELS    2
+#define BLOCK_FRAMES    128
+#define NUM_BLOCKS      (SAMPLE_RATE * 2 / BLOCK_FRAMES)
+#define NUM_THROUGHPUT_FRAMES (SAMPLE_RATE * 200)
+// input 1000 ppm faster than output
+#define SRC_STEP        (0x10000 + 66)
+// skip filter delay and settle time
+#define SKIP_FRAMES     64
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef enum {
+    ENGINE_LINEAR = 0,
+    ENGINE_POLYPHASE_LOW,
+    ENGINE_POLYPHASE_MEDIUM,
+    ENGINE_POLYPHASE_HIGH,
+    ENGINE_NUM
+} engine_t;
+
+static const char * engine_names[] = {
+    "linear",
+    "polyphase low",
+    "polyphase medium",
+    "polyphase high",
+};
+
+static btstack_resample_t           resample_linear;
+static btstack_resample_polyphase_t resample_polyphase;
+
+static int16_t input_buffer[BLOCK_FRAMES * NUM_CHANNELS];
+// output frames per block <= input frames + 1
+static int16_t output_buffer[(BLOCK_FRAMES + 2) * NUM_CHANNELS];
+static int16_t result_buffer[(NUM_BLOCKS * (BLOCK_FRAMES + 2)) * NUM_CHANNELS];
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void engine_init(engine_t engine){
+    switch (engine){
+        case ENGINE_LINEAR:
+            btstack_resample_init(&resample_linear, NUM_CHANNELS);
+            btstack_resample_set_factor(&resample_linear, SRC_STEP);
+            break;
+        default:
+            btstack_resample_polyphase_init(&resample_polyphase, NUM_CHANNELS, (btstack_resample_polyphase_quality_t) (engine - ENGINE_POLYPHASE_LOW));
+            btstack_resample_polyphase_set_factor(&resample_polyphase, SRC_STEP);
+            break;
+    }
+}
+
+static uint16_t engine_process(engine_t engine, const int16_t * input, uint32_t num_frames, int16_t * output){
+    if (engine == ENGINE_LINEAR){
+        return btstack_resample_block(&resample_linear, input, num_frames, output);
+    }
+    return btstack_resample_polyphase_block(&resample_polyphase, input, num_frames, output);
+}
+
+// THD+N: remove best-fitting sine at expected output frequency, report residual relative to signal power
+static double thd_n_db(engine_t engine, double frequency){
+    const double amplitude = 16384.0;
+    engine_init(engine);
+    uint32_t input_pos = 0;
+    uint32_t result_frames = 0;
+    int block;
+    for (block = 0; block < NUM_BLOCKS; block++){
+        int i;
+        for (i = 0; i < BLOCK_FRAMES; i++){
+            double value = amplitude * sin(2.0 * M_PI * frequency * input_pos++ / SAMPLE_RATE);
+            input_buffer[i * NUM_CHANNELS]     = (int16_t) lrint(value);
+            input_buffer[i * NUM_CHANNELS + 1] = (int16_t) lrint(value);
+        }
+        uint16_t frames = engine_process(engine, input_buffer, BLOCK_FRAMES, output_buffer);
+        memcpy(&result_buffer[result_frames * NUM_CHANNELS], output_buffer, frames * NUM_CHANNELS * sizeof(int16_t));
+        result_frames += frames;
+    }
+
+    // least squares fit of a * sin + b * cos + c over whole periods
+    const double omega = 2.0 * M_PI * frequency / SAMPLE_RATE * ((double) SRC_STEP / 0x10000);
+    uint32_t num_frames = result_frames - SKIP_FRAMES;
+    num_frames = (uint32_t) (floor(num_frames * omega / (2.0 * M_PI)) * (2.0 * M_PI) / omega);
+    double sum_sin = 0.0;
+    double sum_cos = 0.0;
+    double sum = 0.0;
+    uint32_t n;
+    for (n = 0; n < num_frames; n++){
+        double y = result_buffer[(SKIP_FRAMES + n) * NUM_CHANNELS];
+        sum_sin += y * sin(omega * n);
+        sum_cos += y * cos(omega * n);
+        sum += y;
+    }
+    double a = 2.0 * sum_sin / num_frames;
+    double b = 2.0 * sum_cos / num_frames;
+    double c = sum / num_frames;
+    double signal_power = 0.0;
+    double noise_power = 0.0;
+    for (n = 0; n < num_frames; n++){
+        double fit = a * sin(omega * n) + b * cos(omega * n) + c;
+        double error = result_buffer[(SKIP_FRAMES + n) * NUM_CHANNELS] - fit;
+        signal_power += fit * fit;
+        noise_power += error * error;
+    }
+    return 10.0 * log10(noise_power / signal_power);
+}
+
+static void throughput(engine_t engine){
+    uint32_t i;
+    for (i = 0; i < BLOCK_FRAMES * NUM_CHANNELS; i++){
+        input_buffer[i] = (int16_t) (8000.0 * sin(0.05 * i));
+    }
+    engine_init(engine);
+    uint32_t output_frames = 0;
+    double start = time_seconds();
+    uint32_t frames;
+    for (frames = 0; frames < NUM_THROUGHPUT_FRAMES; frames += BLOCK_FRAMES){
+        output_frames += engine_process(engine, input_buffer, BLOCK_FRAMES, output_buffer);
+    }
+    double duration = time_seconds() - start;
+    double frames_per_second = NUM_THROUGHPUT_FRAMES / duration;
+    printf("%-17s %12.0f frames/sec, %8.1f x real-time 48 kHz stereo streams (%u frames)\n", engine_names[engine],
+           frames_per_second, frames_per_second / SAMPLE_RATE, output_frames);
+}
+
+int main(void){
+    static const double frequencies[] = { 1000.0, 5000.0, 10000.0, 15000.0 };
+    const int num_frequencies = sizeof(frequencies) / sizeof(double);
+    int engine;
+    int i;
+
+    printf("THD+N in dB for sine at -6 dBFS, factor %.6f\n", (double) SRC_STEP / 0x10000);
+    printf("%-17s", "");
+    for (i = 0; i < num_frequencies; i++){
+        printf(" %7.0f Hz", frequencies[i]);
+    }
+    printf("\n");
+    for (engine = 0; engine < ENGINE_NUM; engine++){
+        printf("%-17s", engine_names[engine]);
+        for (i = 0; i < num_frequencies; i++){
+            printf(" %10.1f", thd_n_db((engine_t) engine, frequencies[i]));
+        }
+        printf("\n");
+    }
+
+    printf("\nThroughput, blocks of %u frames\n", BLOCK_FRAMES);
+    for (engine = 0; engine < ENGINE_NUM; engine++){
+        throughput((engine_t) engine);
+    }
+    return 0;
+}
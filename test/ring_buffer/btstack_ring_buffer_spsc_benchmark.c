@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Compare lock-free btstack_ring_buffer_spsc with btstack_ring_buffer protected by a mutex
+// for passing audio buffers between two threads:
+// - latency: time from write of a timestamped buffer until the polling consumer reads it
+// - throughput: bytes/sec for back-to-back buffers
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_ring_buffer.h"
+#include "btstack_ring_buffer_spsc.h"
+
+// 512 stereo frames as used by btstack_audio_portaudio
+#define BUFFER_SIZE     2048
+#define NUM_BUFFERS     5
+#define NUM_LATENCY_BUFFERS     20000
+#define NUM_THROUGHPUT_BUFFERS 500000
+
+typedef enum {
+    MODE_SPSC = 0,
+    MODE_MUTEX,
+} benchmark_mode_t;
+
+static uint8_t storage[NUM_BUFFERS * BUFFER_SIZE];
+static btstack_ring_buffer_spsc_t ring_buffer_spsc;
+static btstack_ring_buffer_t      ring_buffer;
+static pthread_mutex_t            ring_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static benchmark_mode_t  mode;
+static uint32_t num_buffers;
+static int      measure_latency;
+static double   latencies[NUM_LATENCY_BUFFERS];
+
+static uint64_t time_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+static int buffer_write(const uint8_t * buffer){
+    if (mode == MODE_SPSC){
+        uint32_t region_length;
+        uint8_t * region = btstack_ring_buffer_spsc_write_reserve(&ring_buffer_spsc, &region_length);
+        if (region_length < BUFFER_SIZE) return 0;
+        memcpy(region, buffer, BUFFER_SIZE);
+        btstack_ring_buffer_spsc_write_commit(&ring_buffer_spsc, BUFFER_SIZE);
+        return 1;
+    }
+    pthread_mutex_lock(&ring_buffer_mutex);
+    int ok = btstack_ring_buffer_bytes_free(&ring_buffer) >= BUFFER_SIZE;
+    if (ok){
+        btstack_ring_buffer_write(&ring_buffer, (uint8_t *) buffer, BUFFER_SIZE);
+    }
+    pthread_mutex_unlock(&ring_buffer_mutex);
+    return ok;
+}
+
+static int buffer_read(uint8_t * buffer){
+    if (mode == MODE_SPSC){
+        uint32_t region_length;
+        const uint8_t * region = btstack_ring_buffer_spsc_read_reserve(&ring_buffer_spsc, &region_length);
+        if (region_length < BUFFER_SIZE) return 0;
+        memcpy(buffer, region, BUFFER_SIZE);
+        btstack_ring_buffer_spsc_read_commit(&ring_buffer_spsc, BUFFER_SIZE);
+        return 1;
+    }
+    uint32_t number_of_bytes_read = 0;
+    pthread_mutex_lock(&ring_buffer_mutex);
+    if (btstack_ring_buffer_bytes_available(&ring_buffer) >= BUFFER_SIZE){
+        btstack_ring_buffer_read(&ring_buffer, buffer, BUFFER_SIZE, &number_of_bytes_read);
+    }
+    pthread_mutex_unlock(&ring_buffer_mutex);
+    return number_of_bytes_read == BUFFER_SIZE;
+}
+
+static void * producer(void * context){
+    (void) context;
+    uint8_t buffer[BUFFER_SIZE];
+    memset(buffer, 0x55, sizeof(buffer));
+    uint32_t i;
+    for (i = 0; i < num_buffers; i++){
+        if (measure_latency){
+            // one buffer in flight
+            struct timespec pause = { 0, 20000 };
+            nanosleep(&pause, NULL);
+            uint64_t now = time_ns();
+            memcpy(buffer, &now, sizeof(now));
+        }
+        while (buffer_write(buffer) == 0){
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void * consumer(void * context){
+    (void) context;
+    uint8_t buffer[BUFFER_SIZE];
+    uint32_t i;
+    for (i = 0; i < num_buffers; i++){
+        while (buffer_read(buffer) == 0){
+            sched_yield();
+        }
+        if (measure_latency){
+            uint64_t sent;
+            memcpy(&sent, buffer, sizeof(sent));
+            latencies[i] = (double) (time_ns() - sent) / 1000.0;
+        }
+    }
+    return NULL;
+}
+
+static double run(benchmark_mode_t run_mode, uint32_t run_num_buffers, int run_measure_latency){
+    mode = run_mode;
+    num_buffers = run_num_buffers;
+    measure_latency = run_measure_latency;
+    btstack_ring_buffer_spsc_init(&ring_buffer_spsc, storage, sizeof(storage));
+    btstack_ring_buffer_init(&ring_buffer, storage, sizeof(storage));
+    pthread_t producer_thread;
+    pthread_t consumer_thread;
+    uint64_t start = time_ns();
+    pthread_create(&consumer_thread, NULL, &consumer, NULL);
+    pthread_create(&producer_thread, NULL, &producer, NULL);
+    pthread_join(producer_thread, NULL);
+    pthread_join(consumer_thread, NULL);
+    return (double) (time_ns() - start) / 1000000000.0;
+}
+
+static int compare_double(const void * a, const void * b){
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void benchmark(benchmark_mode_t benchmark_mode, const char * name){
+    run(benchmark_mode, NUM_LATENCY_BUFFERS, 1);
+    qsort(latencies, NUM_LATENCY_BUFFERS, sizeof(double), &compare_double);
+    double duration = run(benchmark_mode, NUM_THROUGHPUT_BUFFERS, 0);
+    printf("%-7s latency median %7.2f us, 99%% %7.2f us, max %9.2f us, throughput %8.1f MB/s\n", name,
+           latencies[NUM_LATENCY_BUFFERS / 2], latencies[(NUM_LATENCY_BUFFERS * 99) / 100], latencies[NUM_LATENCY_BUFFERS - 1],
+           ((double) NUM_THROUGHPUT_BUFFERS * BUFFER_SIZE) / duration / 1000000.0);
+}
+
+int main(void){
+    printf("%u byte buffers, polling consumer\n", BUFFER_SIZE);
+    benchmark(MODE_SPSC,  "spsc");
+    benchmark(MODE_MUTEX, "mutex");
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_ring_buffer_spsc.h"
+#include "btstack_util.h"
+
+#define STRESS_NUM_BYTES 20000000
+
+static uint8_t storage[10];
+
+uint32_t btstack_min(uint32_t a, uint32_t b){
+    return a < b ? a : b;
+}
+
+TEST_GROUP(RingBufferSPSC){
+    btstack_ring_buffer_spsc_t ring_buffer;
+    uint32_t storage_size;
+
+    void setup(void){
+        storage_size = sizeof(storage);
+        memset(storage, 0, storage_size);
+        btstack_ring_buffer_spsc_init(&ring_buffer, storage, storage_size);
+    }
+};
+
+TEST(RingBufferSPSC, EmptyBuffer){
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(storage_size, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    uint32_t region_length;
+    btstack_ring_buffer_spsc_read_reserve(&ring_buffer, &region_length);
+    CHECK_EQUAL(0, region_length);
+    uint8_t * region = btstack_ring_buffer_spsc_write_reserve(&ring_buffer, &region_length);
+    POINTERS_EQUAL(storage, region);
+    CHECK_EQUAL(storage_size, region_length);
+}
+
+TEST(RingBufferSPSC, WriteRead){
+    uint8_t test_write_data[] = {1, 2, 3, 4, 5};
+    uint8_t test_read_data[sizeof(test_write_data)];
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+    CHECK_EQUAL(sizeof(test_write_data), btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(storage_size - sizeof(test_write_data), btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+
+    uint32_t number_of_bytes_read = 0;
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+    CHECK_EQUAL(sizeof(test_read_data), number_of_bytes_read);
+    MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+}
+
+TEST(RingBufferSPSC, WriteFullBuffer){
+    uint8_t test_write_data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t test_read_data[sizeof(test_write_data)];
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+    CHECK_EQUAL(storage_size, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 1));
+
+    uint32_t number_of_bytes_read = 0;
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+    CHECK_EQUAL(sizeof(test_read_data), number_of_bytes_read);
+    MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+}
+
+TEST(RingBufferSPSC, ReadMoreThanAvailable){
+    uint8_t test_write_data[] = {1, 2, 3};
+    uint8_t test_read_data[8];
+    btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data));
+    uint32_t number_of_bytes_read = 0;
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+    CHECK_EQUAL(sizeof(test_write_data), number_of_bytes_read);
+    MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+}
+
+TEST(RingBufferSPSC, WrapAround){
+    uint8_t test_write_data[] = {1, 2, 3, 4, 5, 6, 7};
+    uint8_t test_read_data[sizeof(test_write_data)];
+    uint32_t number_of_bytes_read = 0;
+    int i;
+    for (i = 0; i < 10; i++){
+        test_write_data[0] = (uint8_t) i;
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+        btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+        CHECK_EQUAL(sizeof(test_read_data), number_of_bytes_read);
+        MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+    }
+}
+
+TEST(RingBufferSPSC, ReserveCommit){
+    uint8_t test_write_data[] = {1, 2, 3, 4, 5, 6};
+    uint8_t test_read_data[sizeof(test_write_data)];
+    uint32_t number_of_bytes_read = 0;
+    uint32_t region_length;
+
+    // move indices to position 6
+    btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data));
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+
+    // free space wraps around: contiguous region until end of storage
+    uint8_t * write_region = btstack_ring_buffer_spsc_write_reserve(&ring_buffer, &region_length);
+    POINTERS_EQUAL(&storage[6], write_region);
+    CHECK_EQUAL(4, region_length);
+    memcpy(write_region, test_write_data, 4);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 4);
+
+    write_region = btstack_ring_buffer_spsc_write_reserve(&ring_buffer, &region_length);
+    POINTERS_EQUAL(&storage[0], write_region);
+    CHECK_EQUAL(6, region_length);
+    memcpy(write_region, &test_write_data[4], 2);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 2);
+    CHECK_EQUAL(6, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+
+    // data wraps around: contiguous region until end of storage
+    const uint8_t * read_region = btstack_ring_buffer_spsc_read_reserve(&ring_buffer, &region_length);
+    POINTERS_EQUAL(&storage[6], read_region);
+    CHECK_EQUAL(4, region_length);
+    MEMCMP_EQUAL(test_write_data, read_region, 4);
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, 4);
+
+    read_region = btstack_ring_buffer_spsc_read_reserve(&ring_buffer, &region_length);
+    POINTERS_EQUAL(&storage[0], read_region);
+    CHECK_EQUAL(2, region_length);
+    MEMCMP_EQUAL(&test_write_data[4], read_region, 2);
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, 2);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(storage_size, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+}
+
+// multi-threaded stress test: producer writes a byte sequence in varying chunk sizes using write and
+// write_reserve/commit, consumer verifies it using read and read_reserve/commit
+
+static uint8_t stress_storage[257];
+static btstack_ring_buffer_spsc_t stress_ring_buffer;
+static uint32_t stress_errors;
+
+static void * stress_producer(void * context){
+    (void) context;
+    uint8_t chunk[64];
+    uint32_t sequence = 0;
+    uint32_t chunk_length = 1;
+    while (sequence < STRESS_NUM_BYTES){
+        chunk_length = (chunk_length * 7 + 3) % sizeof(chunk) + 1;
+        if (chunk_length > (STRESS_NUM_BYTES - sequence)){
+            chunk_length = STRESS_NUM_BYTES - sequence;
+        }
+        if ((sequence & 1) == 0){
+            uint32_t i;
+            for (i = 0; i < chunk_length; i++){
+                chunk[i] = (uint8_t) (sequence + i);
+            }
+            if (btstack_ring_buffer_spsc_write(&stress_ring_buffer, chunk, chunk_length) != ERROR_CODE_SUCCESS){
+                sched_yield();
+                continue;
+            }
+            sequence += chunk_length;
+        } else {
+            uint32_t region_length;
+            uint8_t * region = btstack_ring_buffer_spsc_write_reserve(&stress_ring_buffer, &region_length);
+            if (region_length == 0){
+                sched_yield();
+                continue;
+            }
+            if (region_length > chunk_length){
+                region_length = chunk_length;
+            }
+            uint32_t i;
+            for (i = 0; i < region_length; i++){
+                region[i] = (uint8_t) (sequence + i);
+            }
+            btstack_ring_buffer_spsc_write_commit(&stress_ring_buffer, region_length);
+            sequence += region_length;
+        }
+    }
+    return NULL;
+}
+
+static void * stress_consumer(void * context){
+    (void) context;
+    uint8_t chunk[64];
+    uint32_t sequence = 0;
+    uint32_t chunk_length = 1;
+    while (sequence < STRESS_NUM_BYTES){
+        chunk_length = (chunk_length * 5 + 1) % sizeof(chunk) + 1;
+        uint32_t i;
+        if ((sequence & 2) == 0){
+            uint32_t number_of_bytes_read;
+            btstack_ring_buffer_spsc_read(&stress_ring_buffer, chunk, chunk_length, &number_of_bytes_read);
+            if (number_of_bytes_read == 0){
+                sched_yield();
+                continue;
+            }
+            for (i = 0; i < number_of_bytes_read; i++){
+                if (chunk[i] != (uint8_t) (sequence + i)){
+                    stress_errors++;
+                }
+            }
+            sequence += number_of_bytes_read;
+        } else {
+            uint32_t region_length;
+            const uint8_t * region = btstack_ring_buffer_spsc_read_reserve(&stress_ring_buffer, &region_length);
+            if (region_length == 0){
+                sched_yield();
+                continue;
+            }
+            if (region_length > chunk_length){
+                region_length = chunk_length;
+            }
+            for (i = 0; i < region_length; i++){
+                if (region[i] != (uint8_t) (sequence + i)){
+                    stress_errors++;
+                }
+            }
+            btstack_ring_buffer_spsc_read_commit(&stress_ring_buffer, region_length);
+            sequence += region_length;
+        }
+    }
+    return NULL;
+}
+
+TEST(RingBufferSPSC, StressTwoThreads){
+    // odd storage size to test wrap-around at all positions
+    btstack_ring_buffer_spsc_init(&stress_ring_buffer, stress_storage, sizeof(stress_storage));
+    stress_errors = 0;
+    pthread_t producer;
+    pthread_t consumer;
+    CHECK_EQUAL(0, pthread_create(&consumer, NULL, &stress_consumer, NULL));
+    CHECK_EQUAL(0, pthread_create(&producer, NULL, &stress_producer, NULL));
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    CHECK_EQUAL(0, stress_errors);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&stress_ring_buffer));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
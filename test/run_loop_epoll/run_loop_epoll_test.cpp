@@ -0,0 +1,258 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_epoll.h"
+#include "btstack_util.h"
+
+#ifdef __linux__
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// fails test if run loop does not exit in time
+#define WATCHDOG_TIMEOUT_MS 2000
+
+static btstack_timer_source_t watchdog_timer;
+static bool watchdog_fired;
+
+static btstack_timer_source_t timers[4];
+static int timer_order[4];
+static int timer_count;
+
+static btstack_data_source_t data_source;
+static int pipe_fds[2];
+static int read_count;
+static int write_count;
+static bool remove_in_callback;
+
+static btstack_context_callback_registration_t callback_registration;
+static bool callback_executed;
+
+static void watchdog_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    watchdog_fired = true;
+    btstack_run_loop_trigger_exit();
+}
+
+static void exit_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_run_loop_trigger_exit();
+}
+
+static void timer_handler(btstack_timer_source_t * ts){
+    timer_order[timer_count++] = (int) (intptr_t) btstack_run_loop_get_timer_context(ts);
+}
+
+static void start_timer(btstack_timer_source_t * ts, uint32_t timeout_ms, void (*process)(btstack_timer_source_t * ts), int id){
+    btstack_run_loop_set_timer_handler(ts, process);
+    btstack_run_loop_set_timer_context(ts, (void *) (intptr_t) id);
+    btstack_run_loop_set_timer(ts, timeout_ms);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void run(void){
+    watchdog_fired = false;
+    start_timer(&watchdog_timer, WATCHDOG_TIMEOUT_MS, &watchdog_handler, 0);
+    btstack_run_loop_execute();
+    btstack_run_loop_remove_timer(&watchdog_timer);
+}
+
+static void data_source_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    uint8_t buffer[16];
+    switch (callback_type){
+        case DATA_SOURCE_CALLBACK_READ:
+            read_count++;
+            (void) read(ds->source.fd, buffer, sizeof(buffer));
+            if (remove_in_callback){
+                btstack_run_loop_remove_data_source(ds);
+            }
+            btstack_run_loop_trigger_exit();
+            break;
+        case DATA_SOURCE_CALLBACK_WRITE:
+            write_count++;
+            btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+            btstack_run_loop_trigger_exit();
+            break;
+        default:
+            break;
+    }
+}
+
+static void write_pipe(void){
+    const uint8_t data = 0x55;
+    CHECK_EQUAL(1, write(pipe_fds[1], &data, 1));
+}
+
+// run loop until exit handler after given time
+static void run_for(uint32_t time_ms){
+    btstack_timer_source_t exit_timer;
+    start_timer(&exit_timer, time_ms, &exit_handler, 0);
+    run();
+    btstack_run_loop_remove_timer(&exit_timer);
+}
+
+static void callback_handler(void * context){
+    UNUSED(context);
+    callback_executed = true;
+    btstack_run_loop_trigger_exit();
+}
+
+static void * thread_main(void * arg){
+    UNUSED(arg);
+    btstack_run_loop_execute_on_main_thread(&callback_registration);
+    return NULL;
+}
+
+TEST_GROUP(RunLoopEpoll){
+    void setup(void){
+        btstack_run_loop_init(btstack_run_loop_epoll_get_instance());
+        memset(&data_source, 0, sizeof(data_source));
+        memset(timers, 0, sizeof(timers));
+        timer_count = 0;
+        read_count = 0;
+        write_count = 0;
+        remove_in_callback = false;
+        callback_executed = false;
+        CHECK_EQUAL(0, pipe(pipe_fds));
+        btstack_run_loop_set_data_source_fd(&data_source, pipe_fds[0]);
+        btstack_run_loop_set_data_source_handler(&data_source, &data_source_handler);
+    }
+    void teardown(void){
+        btstack_run_loop_remove_data_source(&data_source);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        btstack_run_loop_deinit();
+    }
+};
+
+TEST(RunLoopEpoll, TimersInOrder){
+    start_timer(&timers[0], 30, &timer_handler, 3);
+    start_timer(&timers[1], 10, &timer_handler, 1);
+    start_timer(&timers[2], 20, &timer_handler, 2);
+    run_for(50);
+    CHECK_FALSE(watchdog_fired);
+    CHECK_EQUAL(3, timer_count);
+    CHECK_EQUAL(1, timer_order[0]);
+    CHECK_EQUAL(2, timer_order[1]);
+    CHECK_EQUAL(3, timer_order[2]);
+}
+
+TEST(RunLoopEpoll, TimersSameTimeoutFifo){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int i;
+    for (i = 0; i < 4; i++){
+        btstack_run_loop_set_timer_handler(&timers[i], &timer_handler);
+        btstack_run_loop_set_timer_context(&timers[i], (void *) (intptr_t) i);
+        timers[i].timeout = now + 10;
+        btstack_run_loop_add_timer(&timers[i]);
+    }
+    run_for(30);
+    CHECK_EQUAL(4, timer_count);
+    for (i = 0; i < 4; i++){
+        CHECK_EQUAL(i, timer_order[i]);
+    }
+}
+
+TEST(RunLoopEpoll, TimerRemove){
+    start_timer(&timers[0], 10, &timer_handler, 1);
+    start_timer(&timers[1], 15, &timer_handler, 2);
+    start_timer(&timers[2], 20, &timer_handler, 3);
+    CHECK_TRUE(btstack_run_loop_remove_timer(&timers[1]));
+    CHECK_FALSE(btstack_run_loop_remove_timer(&timers[1]));
+    run_for(40);
+    CHECK_EQUAL(2, timer_count);
+    CHECK_EQUAL(1, timer_order[0]);
+    CHECK_EQUAL(3, timer_order[1]);
+}
+
+TEST(RunLoopEpoll, DataSourceRead){
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&data_source);
+    // adding twice is ignored
+    btstack_run_loop_add_data_source(&data_source);
+    write_pipe();
+    run();
+    CHECK_FALSE(watchdog_fired);
+    CHECK_EQUAL(1, read_count);
+}
+
+TEST(RunLoopEpoll, DataSourceEnableAfterAdd){
+    btstack_run_loop_add_data_source(&data_source);
+    write_pipe();
+    run_for(20);
+    CHECK_EQUAL(0, read_count);
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    run();
+    CHECK_FALSE(watchdog_fired);
+    CHECK_EQUAL(1, read_count);
+}
+
+TEST(RunLoopEpoll, DataSourceDisable){
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&data_source);
+    btstack_run_loop_disable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    write_pipe();
+    run_for(20);
+    CHECK_EQUAL(0, read_count);
+    // write callback for pipe write end
+    btstack_data_source_t write_data_source;
+    memset(&write_data_source, 0, sizeof(write_data_source));
+    btstack_run_loop_set_data_source_fd(&write_data_source, pipe_fds[1]);
+    btstack_run_loop_set_data_source_handler(&write_data_source, &data_source_handler);
+    btstack_run_loop_add_data_source(&write_data_source);
+    btstack_run_loop_enable_data_source_callbacks(&write_data_source, DATA_SOURCE_CALLBACK_WRITE);
+    run();
+    CHECK_FALSE(watchdog_fired);
+    CHECK_EQUAL(1, write_count);
+    CHECK_EQUAL(0, read_count);
+    btstack_run_loop_remove_data_source(&write_data_source);
+}
+
+TEST(RunLoopEpoll, DataSourceRemove){
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&data_source);
+    CHECK_TRUE(btstack_run_loop_remove_data_source(&data_source));
+    CHECK_FALSE(btstack_run_loop_remove_data_source(&data_source));
+    // enable while not in run loop
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    write_pipe();
+    run_for(20);
+    CHECK_EQUAL(0, read_count);
+    // add again
+    btstack_run_loop_add_data_source(&data_source);
+    run();
+    CHECK_FALSE(watchdog_fired);
+    CHECK_EQUAL(1, read_count);
+}
+
+TEST(RunLoopEpoll, DataSourceRemoveInCallback){
+    remove_in_callback = true;
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&data_source);
+    write_pipe();
+    write_pipe();
+    run();
+    CHECK_EQUAL(1, read_count);
+    write_pipe();
+    run_for(20);
+    CHECK_EQUAL(1, read_count);
+}
+
+TEST(RunLoopEpoll, ExecuteOnMainThread){
+    pthread_t thread;
+    callback_registration.callback = &callback_handler;
+    callback_registration.context  = NULL;
+    CHECK_EQUAL(0, pthread_create(&thread, NULL, &thread_main, NULL));
+    run();
+    pthread_join(thread, NULL);
+    CHECK_FALSE(watchdog_fired);
+    CHECK_TRUE(callback_executed);
+}
+
+#endif
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
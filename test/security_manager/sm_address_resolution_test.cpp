@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL BLUEKITCHEN
+ * GMBH OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// *****************************************************************************
+//
+// test address resolution cache of security manager
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_crypto.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop_embedded.h"
+#include "btstack_util.h"
+#include "ble/le_device_db.h"
+#include "ble/sm.h"
+#include "hci_cmd.h"
+
+extern "C" {
+    void mock_init(void);
+    void mock_simulate_hci_state_working(void);
+    void mock_simulate_hci_event(uint8_t * packet, uint16_t size);
+    uint8_t * mock_packet_buffer(void);
+    void mock_clear_packet_buffer(void);
+}
+
+// le_device_db that counts accesses to stored devices
+
+typedef struct {
+    int addr_type;
+    bd_addr_t addr;
+    sm_key_t irk;
+} test_le_device_t;
+
+static test_le_device_t test_le_devices[MAX_NR_LE_DEVICE_DB_ENTRIES];
+static uint32_t test_le_device_db_generation;
+static int test_le_device_db_info_calls;
+
+void le_device_db_init(void){
+    int i;
+    for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
+        test_le_devices[i].addr_type = BD_ADDR_TYPE_UNKNOWN;
+    }
+    test_le_device_db_generation++;
+}
+
+void le_device_db_set_local_bd_addr(bd_addr_t bd_addr){
+    (void) bd_addr;
+}
+
+int le_device_db_count(void){
+    int i;
+    int counter = 0;
+    for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
+        if (test_le_devices[i].addr_type != BD_ADDR_TYPE_UNKNOWN) counter++;
+    }
+    return counter;
+}
+
+int le_device_db_max_count(void){
+    return MAX_NR_LE_DEVICE_DB_ENTRIES;
+}
+
+uint32_t le_device_db_generation(void){
+    return test_le_device_db_generation;
+}
+
+void le_device_db_remove(int index){
+    test_le_devices[index].addr_type = BD_ADDR_TYPE_UNKNOWN;
+    test_le_device_db_generation++;
+}
+
+int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
+    int i;
+    for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
+        if (test_le_devices[i].addr_type != BD_ADDR_TYPE_UNKNOWN) continue;
+        test_le_devices[i].addr_type = addr_type;
+        memcpy(test_le_devices[i].addr, addr, 6);
+        memcpy(test_le_devices[i].irk, irk, 16);
+        test_le_device_db_generation++;
+        return i;
+    }
+    return -1;
+}
+
+void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk){
+    test_le_device_db_info_calls++;
+    if (addr_type) *addr_type = test_le_devices[index].addr_type;
+    if (addr) memcpy(addr, test_le_devices[index].addr, 6);
+    if (irk) memcpy(irk, test_le_devices[index].irk, 16);
+}
+
+void le_device_db_encryption_set(int index, uint16_t ediv, uint8_t rand[8], sm_key_t ltk, int key_size, int authenticated, int authorized, int secure_connection){
+}
+
+void le_device_db_encryption_get(int index, uint16_t * ediv, uint8_t rand[8], sm_key_t ltk, int * key_size, int * authenticated, int * authorized, int * secure_connection){
+    if (ltk) memset(ltk, 0, 16);
+}
+
+void le_device_db_local_csrk_set(int index, sm_key_t csrk){
+}
+
+void le_device_db_local_csrk_get(int index, sm_key_t csrk){
+    memset(csrk, 0, 16);
+}
+
+void le_device_db_remote_csrk_set(int index, sm_key_t csrk){
+}
+
+void le_device_db_remote_csrk_get(int index, sm_key_t csrk){
+    memset(csrk, 0, 16);
+}
+
+uint32_t le_device_db_remote_counter_get(int index){
+    return 0;
+}
+
+void le_device_db_remote_counter_set(int index, uint32_t counter){
+}
+
+uint32_t le_device_db_local_counter_get(int index){
+    return 0;
+}
+
+void le_device_db_local_counter_set(int index, uint32_t counter){
+}
+
+void le_device_db_dump(void){
+}
+
+// address resolution results
+
+static uint8_t  resolving_event;
+static uint16_t resolving_index;
+
+static void sm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    (void) channel;
+    (void) size;
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED:
+            resolving_event = SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED;
+            resolving_index = sm_event_identity_resolving_succeeded_get_index(packet);
+            break;
+        case SM_EVENT_IDENTITY_RESOLVING_FAILED:
+            resolving_event = SM_EVENT_IDENTITY_RESOLVING_FAILED;
+            break;
+        default:
+            break;
+    }
+}
+
+static btstack_packet_callback_registration_t sm_event_callback_registration;
+
+// answer HCI LE Rand commands, e.g. for EC key generation, until SM is idle
+static void process_hci_commands(void){
+    while (true){
+        btstack_run_loop_embedded_execute_once();
+        uint8_t * packet = mock_packet_buffer();
+        if (little_endian_read_16(packet, 0) != hci_le_rand.opcode) break;
+        mock_clear_packet_buffer();
+        uint8_t rand_event[] = { 0x0e, 0x0c, 0x01, 0x18, 0x20, 0x00, 0x2f, 0x04, 0x82, 0x84, 0x72, 0x46, 0x9c, 0x93 };
+        mock_simulate_hci_event(rand_event, sizeof(rand_event));
+    }
+}
+
+// resolvable private address: prand (MSB = 01) || ah(irk, prand)
+static void create_resolvable_private_address(const sm_key_t irk, uint8_t prand_lsb, bd_addr_t address){
+    sm_key_t r_prime;
+    sm_key_t ah;
+    memset(r_prime, 0, 16);
+    r_prime[13] = 0x40;
+    r_prime[14] = 0x12;
+    r_prime[15] = prand_lsb;
+    btstack_aes128_calc(irk, r_prime, ah);
+    memcpy(&address[0], &r_prime[13], 3);
+    memcpy(&address[3], &ah[13], 3);
+}
+
+static uint8_t resolve(bd_addr_t address){
+    resolving_event = 0;
+    test_le_device_db_info_calls = 0;
+    sm_address_resolution_lookup(BD_ADDR_TYPE_LE_RANDOM, address);
+    process_hci_commands();
+    return resolving_event;
+}
+
+TEST_GROUP(SecurityManagerAddressResolution){
+    sm_key_t irk_a;
+    sm_key_t irk_b;
+    bd_addr_t identity_a;
+    bd_addr_t identity_b;
+    bd_addr_t rpa_a;
+    bd_addr_t rpa_b;
+    int index_a;
+
+    void setup(void){
+        static bool first = true;
+        if (first){
+            first = false;
+            btstack_memory_init();
+            btstack_run_loop_init(btstack_run_loop_embedded_get_instance());
+            sm_init();
+            sm_event_callback_registration.callback = &sm_packet_handler;
+            sm_add_event_handler(&sm_event_callback_registration);
+        }
+        le_device_db_init();
+        mock_init();
+        mock_simulate_hci_state_working();
+        process_hci_commands();
+
+        memset(irk_a, 0xaa, 16);
+        memset(irk_b, 0xbb, 16);
+        memset(identity_a, 0x0a, 6);
+        memset(identity_b, 0x0b, 6);
+        create_resolvable_private_address(irk_a, 1, rpa_a);
+        create_resolvable_private_address(irk_b, 2, rpa_b);
+        // device without IRK stored before
+        bd_addr_t identity_no_irk;
+        sm_key_t  irk_none;
+        memset(identity_no_irk, 0x01, 6);
+        memset(irk_none, 0, 16);
+        le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, identity_no_irk, irk_none);
+        index_a = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, identity_a, irk_a);
+    }
+};
+
+TEST(SecurityManagerAddressResolution, Resolve){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_a));
+    CHECK_EQUAL(index_a, resolving_index);
+    CHECK_TRUE(test_le_device_db_info_calls > index_a);
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_b));
+    CHECK_TRUE(test_le_device_db_info_calls > 0);
+}
+
+TEST(SecurityManagerAddressResolution, CacheHit){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_a));
+    int info_calls_lookup = test_le_device_db_info_calls;
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_a));
+    CHECK_EQUAL(index_a, resolving_index);
+    // only identity address for event is read
+    CHECK_EQUAL(1, test_le_device_db_info_calls);
+    CHECK_TRUE(test_le_device_db_info_calls < info_calls_lookup);
+}
+
+TEST(SecurityManagerAddressResolution, CacheHitNegative){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_b));
+    CHECK_EQUAL(MAX_NR_LE_DEVICE_DB_ENTRIES, test_le_device_db_info_calls);
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_b));
+    CHECK_EQUAL(0, test_le_device_db_info_calls);
+}
+
+TEST(SecurityManagerAddressResolution, InvalidateNegativeOnAdd){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_b));
+    // device added by app, not by pairing
+    int index_b = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, identity_b, irk_b);
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_b));
+    CHECK_EQUAL(index_b, resolving_index);
+}
+
+TEST(SecurityManagerAddressResolution, InvalidateNegativeOnReload){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_b));
+    // reload with different content, e.g. le_device_db_tlv_configure()
+    memcpy(test_le_devices[index_a].addr, identity_b, 6);
+    memcpy(test_le_devices[index_a].irk, irk_b, 16);
+    test_le_device_db_generation++;
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_b));
+    CHECK_EQUAL(index_a, resolving_index);
+}
+
+TEST(SecurityManagerAddressResolution, InvalidatePositiveOnRemove){
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, resolve(rpa_a));
+    le_device_db_remove(index_a);
+    CHECK_EQUAL(SM_EVENT_IDENTITY_RESOLVING_FAILED, resolve(rpa_a));
+    CHECK_TRUE(test_le_device_db_info_calls > 0);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
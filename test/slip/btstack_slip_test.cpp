@@ -0,0 +1,124 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "btstack_util.h"
+#include "btstack_slip.h"
+
+#include <stdlib.h>
+
+// encode frame with byte-oriented encoder
+static uint16_t encode_bytewise(const uint8_t * data, uint16_t len, uint8_t * buffer){
+    uint16_t pos = 0;
+    btstack_slip_encoder_start(data, len);
+    while (btstack_slip_encoder_has_data()){
+        buffer[pos++] = btstack_slip_encoder_get_byte();
+    }
+    return pos;
+}
+
+// encode frame with block encoder using chunks of given size
+static uint16_t encode_blockwise(const uint8_t * data, uint16_t len, uint8_t * buffer, uint16_t chunk_size){
+    uint16_t pos = 0;
+    btstack_slip_encoder_start(data, len);
+    while (true){
+        uint16_t bytes_encoded = btstack_slip_encoder_encode_block(&buffer[pos], chunk_size);
+        if (bytes_encoded == 0) break;
+        CHECK(bytes_encoded <= chunk_size);
+        pos += bytes_encoded;
+    }
+    return pos;
+}
+
+static void fill_random(uint8_t * data, uint16_t len, int special_permille){
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        if ((rand() % 1000) < special_permille){
+            data[i] = (rand() & 1) ? BTSTACK_SLIP_SOF : 0xdb;
+        } else {
+            data[i] = (uint8_t) rand();
+        }
+    }
+}
+
+TEST_GROUP(SLIP){
+    uint8_t data[1000];
+    uint8_t encoded[2100];
+    uint8_t decoded[1000];
+    void setup(void){
+        srand(1);
+    }
+};
+
+TEST(SLIP, EncodeEscapes){
+    const uint8_t input[]    = { 0x01, 0xc0, 0x02, 0xdb, 0x03 };
+    const uint8_t expected[] = { 0xc0, 0x01, 0xdb, 0xdc, 0x02, 0xdb, 0xdd, 0x03, 0xc0 };
+    uint16_t len = encode_blockwise(input, sizeof(input), encoded, sizeof(encoded));
+    CHECK_EQUAL(sizeof(expected), len);
+    MEMCMP_EQUAL(expected, encoded, len);
+}
+
+TEST(SLIP, EncodeMatchesBytewise){
+    uint8_t reference[2100];
+    const uint16_t chunk_sizes[] = { 1, 2, 3, 7, 128, 2100 };
+    int round;
+    for (round = 0; round < 200; round++){
+        uint16_t len = 1 + (rand() % sizeof(data));
+        fill_random(data, len, (round % 4) * 100);
+        uint16_t reference_len = encode_bytewise(data, len, reference);
+        uint16_t i;
+        for (i = 0; i < sizeof(chunk_sizes) / sizeof(uint16_t); i++){
+            uint16_t encoded_len = encode_blockwise(data, len, encoded, chunk_sizes[i]);
+            CHECK_EQUAL(reference_len, encoded_len);
+            MEMCMP_EQUAL(reference, encoded, encoded_len);
+        }
+    }
+}
+
+TEST(SLIP, DecodeBlock){
+    int round;
+    for (round = 0; round < 200; round++){
+        uint16_t len = 1 + (rand() % sizeof(data));
+        fill_random(data, len, (round % 4) * 100);
+        uint16_t encoded_len = encode_bytewise(data, len, encoded);
+
+        // feed in random chunks
+        btstack_slip_decoder_init(decoded, sizeof(decoded));
+        uint16_t pos = 0;
+        while (btstack_slip_decoder_frame_size() == 0){
+            CHECK(pos < encoded_len);
+            uint16_t chunk_len = (uint16_t) btstack_min(1 + (rand() % 50), encoded_len - pos);
+            pos += btstack_slip_decoder_process_block(&encoded[pos], chunk_len);
+        }
+        CHECK_EQUAL(encoded_len, pos);
+        CHECK_EQUAL(len, btstack_slip_decoder_frame_size());
+        MEMCMP_EQUAL(data, decoded, len);
+    }
+}
+
+TEST(SLIP, DecodeBlockStopsAfterFrame){
+    const uint8_t input[] = { 0xc0, 0x01, 0x02, 0xc0, 0xc0, 0x03, 0xdb, 0xdc, 0xc0};
+    btstack_slip_decoder_init(decoded, sizeof(decoded));
+    uint16_t bytes_processed = btstack_slip_decoder_process_block(input, sizeof(input));
+    CHECK_EQUAL(4, bytes_processed);
+    CHECK_EQUAL(2, btstack_slip_decoder_frame_size());
+    BYTES_EQUAL(0x01, decoded[0]);
+    BYTES_EQUAL(0x02, decoded[1]);
+
+    btstack_slip_decoder_init(decoded, sizeof(decoded));
+    bytes_processed = btstack_slip_decoder_process_block(&input[4], sizeof(input) - 4);
+    CHECK_EQUAL(sizeof(input) - 4, bytes_processed);
+    CHECK_EQUAL(2, btstack_slip_decoder_frame_size());
+    BYTES_EQUAL(0x03, decoded[0]);
+    BYTES_EQUAL(0xc0, decoded[1]);
+}
+
+TEST(SLIP, DecodeBlockFrameTooLong){
+    fill_random(data, 100, 0);
+    uint16_t encoded_len = encode_bytewise(data, 100, encoded);
+    btstack_slip_decoder_init(decoded, 50);
+    btstack_slip_decoder_process_block(encoded, encoded_len);
+    CHECK(btstack_slip_decoder_frame_size() < 100);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
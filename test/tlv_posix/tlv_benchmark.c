@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// Measure startup time and store latency of btstack_tlv_posix with 10k tags
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack_tlv.h"
+#include "btstack_tlv_posix.h"
+#include "btstack_util.h"
+
+#define BENCHMARK_DB "/tmp/tlv_benchmark.tlv"
+#define NUM_TAGS     10000
+#define NUM_STORES   100000
+#define NUM_SYNCED_STORES 200
+#define VALUE_SIZE   16
+
+static btstack_tlv_posix_t tlv_context;
+static const btstack_tlv_t * tlv_impl;
+
+static double time_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + ((double) now.tv_nsec / 1000000000.0);
+}
+
+static void open_db(void){
+    double start = time_seconds();
+    tlv_impl = btstack_tlv_posix_init_instance(&tlv_context, BENCHMARK_DB);
+    double duration = time_seconds() - start;
+    printf("startup: %8.3f ms, %u entries, file size %u\n", duration * 1000.0, tlv_context.num_entries, tlv_context.file_size);
+}
+
+static void close_db(void){
+    fclose(tlv_context.file);
+    btstack_tlv_posix_deinit(&tlv_context);
+}
+
+static void store_random_tags(uint32_t num_stores){
+    uint8_t value[VALUE_SIZE];
+    double start = time_seconds();
+    uint32_t i;
+    for (i = 0; i < num_stores; i++){
+        uint32_t tag = (uint32_t) rand() % NUM_TAGS;
+        memset(value, (int) i, sizeof(value));
+        tlv_impl->store_tag(&tlv_context, tag, value, sizeof(value));
+    }
+    double duration = time_seconds() - start;
+    printf("store:   %8.3f us per tag (%u stores), file size %u\n", (duration * 1000000.0) / num_stores, num_stores, tlv_context.file_size);
+}
+
+int main(void){
+    uint8_t value[VALUE_SIZE];
+    unlink(BENCHMARK_DB);
+
+    // populate
+    open_db();
+    uint32_t tag;
+    for (tag = 0; tag < NUM_TAGS; tag++){
+        memset(value, (int) tag, sizeof(value));
+        tlv_impl->store_tag(&tlv_context, tag, value, sizeof(value));
+    }
+    close_db();
+
+    // overwrite tags, flush only
+    open_db();
+    store_random_tags(NUM_STORES);
+    close_db();
+
+    // overwrite tags, fsync after each store
+    open_db();
+    btstack_tlv_posix_set_writes_per_sync(&tlv_context, 1);
+    store_random_tags(NUM_SYNCED_STORES);
+    close_db();
+
+    // overwrite tags, fsync after 32 stores
+    open_db();
+    btstack_tlv_posix_set_writes_per_sync(&tlv_context, 32);
+    store_random_tags(NUM_SYNCED_STORES);
+    close_db();
+
+    open_db();
+    close_db();
+
+    unlink(BENCHMARK_DB);
+    return 0;
+}
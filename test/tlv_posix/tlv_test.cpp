@@ -10,6 +10,7 @@
 #include "btstack_config.h"
 #include "btstack_debug.h"
 #include <unistd.h>
+#include <sys/stat.h>
 
 #define TEST_DB "/tmp/test.tlv"
 
@@ -184,6 +185,71 @@ TEST(BSTACK_TLV, TestWriteDeleteResetReadDeleteRead){
     CHECK_EQUAL(size, 0);
 }
 
+static uint32_t file_size(const char * path){
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    return (uint32_t) st.st_size;
+}
+
+TEST(BSTACK_TLV, TestCompaction){
+    uint32_t tag = TAG('a','b','c','d');
+    uint8_t  data[8];
+    memcpy(data, "01234567", 8);
+
+    int i;
+    for (i=0;i<1000;i++){
+        data[0] = (uint8_t) i;
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, data, 8);
+    }
+
+    // 1000 entries of 16 bytes each would be 16000 bytes
+    CHECK_EQUAL(file_size(TEST_DB), btstack_tlv_context.file_size);
+    CHECK(btstack_tlv_context.file_size < 8192);
+
+    reopen_db();
+
+    uint8_t buffer[8];
+    int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, tag, buffer, sizeof(buffer));
+    CHECK_EQUAL(8, size);
+    MEMCMP_EQUAL(data, buffer, 8);
+}
+
+TEST(BSTACK_TLV, TestManyTags){
+    uint32_t i;
+    uint8_t  buffer[4];
+    for (i=0;i<1000;i++){
+        big_endian_store_32(buffer, 0, i);
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, i, buffer, 4);
+    }
+    for (i=1;i<1000;i+=2){
+        btstack_tlv_impl->delete_tag(&btstack_tlv_context, i);
+    }
+
+    reopen_db();
+
+    for (i=0;i<1000;i++){
+        int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, i, buffer, sizeof(buffer));
+        if (i & 1){
+            CHECK_EQUAL(0, size);
+        } else {
+            CHECK_EQUAL(4, size);
+            CHECK_EQUAL(i, big_endian_read_32(buffer, 0));
+        }
+    }
+}
+
+TEST(BSTACK_TLV, TestSync){
+    uint32_t tag = TAG('a','b','c','d');
+    uint8_t  buffer = 7;
+    btstack_tlv_posix_set_writes_per_sync(&btstack_tlv_context, 2);
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+    CHECK_EQUAL(1, btstack_tlv_context.writes_since_sync);
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+    CHECK_EQUAL(0, btstack_tlv_context.writes_since_sync);
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, &buffer, 1);
+    btstack_tlv_posix_sync(&btstack_tlv_context);
+    CHECK_EQUAL(0, btstack_tlv_context.writes_since_sync);
+}
 
 int main (int argc, const char * argv[]){
     // log into file using HCI_DUMP_PACKETLOGGER format
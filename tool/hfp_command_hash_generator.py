@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+import os
+import re
+import sys
+
+# Perfect hash for the AT command tables in src/classic/hfp.c
+# Reads hfp_ag_command_table and hfp_hf_command_table and searches for a seed such that
+# FNV-1a(seed, command) followed by Fibonacci hashing maps every entry to a different slot.
+# Output replaces the hash tables in src/classic/hfp.c
+
+HFP_COMMAND_HASH_BITS = 6
+HFP_COMMAND_HASH_SIZE = 1 << HFP_COMMAND_HASH_BITS
+VALUES_PER_LINE = 16
+MAX_SEEDS = 1000000
+
+FNV_OFFSET_BASIS = 0x811c9dc5
+FNV_PRIME = 0x01000193
+FIBONACCI_MULTIPLIER = 0x9e3779b1
+
+def fnv1a(seed, text):
+    hash = seed
+    for c in text.encode('ascii'):
+        hash = ((hash ^ c) * FNV_PRIME) & 0xffffffff
+    return hash
+
+def slot(seed, text):
+    return ((fnv1a(seed, text) * FIBONACCI_MULTIPLIER) & 0xffffffff) >> (32 - HFP_COMMAND_HASH_BITS)
+
+def read_table(source, name):
+    match = re.search(r'static hfp_command_entry_t ' + name + r'\[\] = \{(.*?)\n\};', source, re.S)
+    if match is None:
+        sys.exit('%s not found' % name)
+    return re.findall(r'\{\s*"([^"]*)"\s*,', match.group(1))
+
+def find_seed(commands):
+    for i in range(MAX_SEEDS):
+        seed = (FNV_OFFSET_BASIS + i) & 0xffffffff
+        slots = set()
+        for command in commands:
+            index = slot(seed, command)
+            if index in slots:
+                break
+            slots.add(index)
+        else:
+            return seed
+    sys.exit('no seed found, increase HFP_COMMAND_HASH_BITS')
+
+def print_table(role, commands):
+    seed = find_seed(commands)
+    slots = [0xff] * HFP_COMMAND_HASH_SIZE
+    for index, command in enumerate(commands):
+        slots[slot(seed, command)] = index
+    print('#define HFP_%s_COMMAND_HASH_SEED 0x%08xu' % (role.upper(), seed))
+    print('static const uint8_t hfp_%s_command_hash[HFP_COMMAND_HASH_SIZE] = {' % role)
+    for i in range(0, HFP_COMMAND_HASH_SIZE, VALUES_PER_LINE):
+        print('    ' + ', '.join('0x%02x' % v for v in slots[i:i+VALUES_PER_LINE]) + ',')
+    print('};')
+
+btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
+with open(btstack_root + '/src/classic/hfp.c', 'r') as fin:
+    source = fin.read()
+
+print('// generated by tool/hfp_command_hash_generator.py')
+print('#define HFP_COMMAND_HASH_BITS %u' % HFP_COMMAND_HASH_BITS)
+print('#define HFP_COMMAND_HASH_SIZE (1 << HFP_COMMAND_HASH_BITS)')
+print_table('ag', read_table(source, 'hfp_ag_command_table'))
+print_table('hf', read_table(source, 'hfp_hf_command_table'))
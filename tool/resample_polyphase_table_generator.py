@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+import math
+
+# Kaiser windowed sinc filters for btstack_resample_polyphase.c
+# For each quality: NUM_PHASES + 1 rows of num_taps Q15 coefficients, row p delays by p / NUM_PHASES samples
+# Each row is normalized to unity DC gain. Output replaces the tables in src/btstack_resample_polyphase.c
+
+NUM_PHASES = 64
+VALUES_PER_LINE = 8
+
+# name, taps, cutoff relative to Nyquist, Kaiser beta
+qualities = [
+    ('low',    8, 0.75, 5.0),
+    ('medium', 16, 0.85, 7.0),
+    ('high',   32, 0.91, 9.0),
+]
+
+def bessel_i0(x):
+    result = 1.0
+    term = 1.0
+    k = 1
+    while term > 1e-12 * result:
+        term *= (x / (2.0 * k)) ** 2
+        result += term
+        k += 1
+    return result
+
+def sinc(x):
+    if x == 0.0:
+        return 1.0
+    return math.sin(math.pi * x) / (math.pi * x)
+
+def create_row(num_taps, cutoff, beta, delay):
+    center = num_taps / 2 - 1 + delay
+    row = []
+    for k in range(num_taps):
+        t = k - center
+        # window spans num_taps samples around center
+        r = t / (num_taps / 2)
+        window = bessel_i0(beta * math.sqrt(1.0 - r * r)) / bessel_i0(beta) if abs(r) < 1.0 else 0.0
+        row.append(cutoff * sinc(cutoff * t) * window)
+    gain = sum(row)
+    quantized = [int(round(value / gain * 32768)) for value in row]
+    # fix rounding to keep unity DC gain, clamp to int16
+    quantized[num_taps // 2 - 1 + (1 if delay >= 0.5 else 0)] += 32768 - sum(quantized)
+    return [max(-32768, min(32767, value)) for value in quantized]
+
+if __name__ == "__main__":
+    for (name, num_taps, cutoff, beta) in qualities:
+        print('// %u taps, cutoff %.2f, Kaiser beta %.1f' % (num_taps, cutoff, beta))
+        print('static const int16_t btstack_resample_polyphase_coefficients_%s[(BTSTACK_RESAMPLE_POLYPHASE_NUM_PHASES + 1) * %u] = {' % (name, num_taps))
+        for phase in range(NUM_PHASES + 1):
+            row = create_row(num_taps, cutoff, beta, phase / NUM_PHASES)
+            assert sum(abs(value) for value in row) < 65536
+            for start in range(0, num_taps, VALUES_PER_LINE):
+                print('    ' + ' '.join('%6d,' % value for value in row[start:start + VALUES_PER_LINE]))
+        print('};')
+        print('')